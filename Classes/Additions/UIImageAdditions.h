@@ -42,5 +42,14 @@
 - (UIImage*) rotate:(UIImageOrientation)orient;
 - (UIImage*) addImageReflection:(CGFloat)reflectionFraction;
 
+/*!
+* @method removeAllDerivedImages
+* @abstract Empties the cache of scaled, rounded and reflected images.
+* @discussion The results of those methods are kept in a cache that is shared by the whole process. It
+* holds on to the source images, is bounded by the amount of bytes its images hold and is emptied
+* when the application receives a memory warning.
+*/
++ (void) removeAllDerivedImages;
+
 @end
 
@@ -34,85 +34,240 @@
 
 #import "UIImageAdditions.h"
 
+#import "SGImageBuffer.h"
+#import "SGImageCache.h"
+
+#import <pthread.h>
+
+// The native layout of the device, which CoreGraphics draws fastest
+#define kSGImageBitmapInfo          (kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Little)
+
+#define kSGDerivedImageCacheBudget  (2 * 1024 * 1024)   /* bytes */
+
+enum {
+    kSGDerivedImage_Scaled = 1,
+    kSGDerivedImage_Rounded,
+    kSGDerivedImage_Reflected,
+};
+
+static SGImageCache* derivedImageCache = NULL;
+static pthread_once_t derivedImageCacheOnce = PTHREAD_ONCE_INIT;
 
 @implementation UIImage (SGAREnvironment)
 
-static CGRect swapWidthAndHeight(CGRect rect)
+static void releaseImageBuffer(void* info, const void* data, size_t size)
 {
-    CGFloat  swap = rect.size.width;
+    SGImageBufferFree((SGImageBuffer*)info);
+}
+
+static SGImageBuffer* imageBufferWithCGImage(CGImageRef image)
+{
+    if(!image)
+        return NULL;
+    
+    SGImageBuffer* buffer = SGImageBufferNew(CGImageGetWidth(image), CGImageGetHeight(image));
+    if(!buffer)
+        return NULL;
+    
+    // This is the only time that the pixels go through CoreGraphics
+    CGRect rect = CGRectMake(0.0, 0.0, buffer->width, buffer->height);
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(buffer->pixels, buffer->width, buffer->height, 8,
+                                                 buffer->bytesPerRow, colorSpace, kSGImageBitmapInfo);
+    CGColorSpaceRelease(colorSpace);
     
-    rect.size.width  = rect.size.height;
-    rect.size.height = swap;
+    CGContextClearRect(context, rect);
+    CGContextDrawImage(context, rect, image);
+    CGContextRelease(context);
     
-    return rect;
+    return buffer;
 }
 
-static void addRoundedRectToPath(CGContextRef context, CGRect rect, float ovalWidth, float ovalHeight)
+static SGImageBuffer* uprightImageBufferWithImage(UIImage* image)
 {
-	float fw, fh;
-	if (ovalWidth == 0 || ovalHeight == 0) {
-		CGContextAddRect(context, rect);
-		return;
-	}
+    SGImageBuffer* buffer = imageBufferWithCGImage(image.CGImage);
+    if(!buffer || image.imageOrientation == UIImageOrientationUp)
+        return buffer;
     
-	CGContextSaveGState(context);
-	CGContextTranslateCTM (context, CGRectGetMinX(rect), CGRectGetMinY(rect));
-	CGContextScaleCTM (context, ovalWidth, ovalHeight);
-	fw = CGRectGetWidth (rect) / ovalWidth;
-	fh = CGRectGetHeight (rect) / ovalHeight;
-	CGContextMoveToPoint(context, fw, fh/2);
-	CGContextAddArcToPoint(context, fw, fh, fw/2, fh, 1);
-	CGContextAddArcToPoint(context, 0, fh, 0, fh/2, 1);
-	CGContextAddArcToPoint(context, 0, 0, fw/2, 0, 1);
-	CGContextAddArcToPoint(context, fw, 0, fw, fh/2, 1);
-	CGContextClosePath(context);
-	CGContextRestoreGState(context);
+    SGImageBuffer* upright;
+    switch(image.imageOrientation) {
+        case UIImageOrientationLeft:
+        case UIImageOrientationLeftMirrored:
+        case UIImageOrientationRight:
+        case UIImageOrientationRightMirrored:
+            upright = SGImageBufferNew(buffer->height, buffer->width);
+            break;
+        default:
+            upright = SGImageBufferNew(buffer->width, buffer->height);
+            break;
+    }
+    
+    SGImageBufferTransform(buffer, upright, (SGImageOrientation)image.imageOrientation);
+    SGImageBufferFree(buffer);
+    
+    return upright;
 }
 
-+ (UIImage*) imageWithImage:(UIImage*)image scaledToSize:(CGSize)newSize;
+/* The image takes ownership of the buffer and shares its pixels */
+static UIImage* imageWithImageBuffer(SGImageBuffer* buffer)
 {
+    if(!buffer)
+        return nil;
+    
+    CGDataProviderRef provider = CGDataProviderCreateWithData(buffer, buffer->pixels,
+                                                              buffer->bytesPerRow * buffer->height,
+                                                              releaseImageBuffer);
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGImageRef imageRef = CGImageCreate(buffer->width, buffer->height, 8, 32, buffer->bytesPerRow,
+                                        colorSpace, kSGImageBitmapInfo, provider, NULL, false,
+                                        kCGRenderingIntentDefault);
+    CGColorSpaceRelease(colorSpace);
+    CGDataProviderRelease(provider);
     
-    UIImage* newImage = nil;
-    if(image) {
-        
-        UIGraphicsBeginImageContext(newSize);
-        [image drawInRect:CGRectMake(0.0, 0.0, newSize.width, newSize.height)];
-        newImage = UIGraphicsGetImageFromCurrentImageContext();
-        UIGraphicsEndImageContext();
-        
+    UIImage* image = [UIImage imageWithCGImage:imageRef];
+    CGImageRelease(imageRef);
+    
+    return image;
+}
+
+static SGImageBuffer* scaledImageBufferWithImage(UIImage* image, CGSize size)
+{
+    SGImageBuffer* scaled = SGImageBufferNew((int)roundf(size.width), (int)roundf(size.height));
+    if(!scaled)
+        return NULL;
+    
+    SGImageBuffer* buffer = uprightImageBufferWithImage(image);
+    if(!buffer) {
+        SGImageBufferFree(scaled);
+        return NULL;
     }
     
-    return newImage;
+    // The bilinear filter widens to cover every pixel when it shrinks an image
+    SGImageBufferScale(buffer, scaled, kSGImageFilter_Bilinear);
+    SGImageBufferFree(buffer);
+    
+    return scaled;
 }
 
-+ (UIImage*) roundedImageWithImage:(UIImage*)img cornerWidth:(int)width cornerHeight:(int)height scaleSize:(CGSize)size
+static UIImage* reflectedImageWithImage(UIImage* image, CGFloat reflectionFraction)
 {
-    img = [[UIImage imageWithImage:img scaledToSize:size] retain];
+    SGImageBuffer* buffer = uprightImageBufferWithImage(image);
+    if(!buffer)
+        return nil;
     
-	int w = img.size.width;
-	int h = img.size.height;
-	
-	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
-	CGContextRef context = CGBitmapContextCreate(NULL, w, h, 8, 4 * w, colorSpace, kCGImageAlphaPremultipliedFirst);
+    int reflectionHeight = buffer->height * reflectionFraction;
+    SGImageBuffer* result = SGImageBufferNew(buffer->width, buffer->height + reflectionHeight);
+    SGImageBufferReflect(buffer, result);
+    SGImageBufferFree(buffer);
     
-	CGRect drawRect = CGRectMake(0.0, 0.0, w, h);
+    return imageWithImageBuffer(result);
+}
+
+#pragma mark -
+#pragma mark Derived images 
+
+static void retainObject(void* object)
+{
+    [(id)object retain];
+}
+
+static void releaseObject(void* object)
+{
+    [(id)object release];
+}
+
+static void retainSource(const void* source)
+{
+    [(id)(void*)source retain];
+}
+
+static void releaseSource(const void* source)
+{
+    [(id)(void*)source release];
+}
+
+static void createDerivedImageCache(void)
+{
+    // The sources are retained so that no other image can take their address
+    SGImageCacheCallbacks callbacks = { retainObject, releaseObject, retainSource, releaseSource };
+    derivedImageCache = SGImageCacheNew(kSGDerivedImageCacheBudget, &callbacks);
+    
+    [[NSNotificationCenter defaultCenter] addObserver:[UIImage class]
+                                             selector:@selector(removeAllDerivedImages)
+                                                 name:UIApplicationDidReceiveMemoryWarningNotification
+                                               object:nil];
+}
+
+static void* makeDerivedImage(const SGImageCacheKey* key, void* context, size_t* cost)
+{
+    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
     
-	CGContextBeginPath(context);
-	addRoundedRectToPath(context, drawRect, width, height);
-	CGContextClip(context);
-	
-	CGContextDrawImage(context, drawRect, img.CGImage);
-	
-	CGImageRef imageMasked = CGBitmapContextCreateImage(context);
-	CGContextRelease(context);
-	CGColorSpaceRelease(colorSpace);
-	[img release];
-	
-	UIImage* image = [UIImage imageWithCGImage:imageMasked];
-	
-	CGImageRelease(imageMasked);
-	
-	return image;
+    UIImage* source = (UIImage*)key->source;
+    const float* parameters = key->parameters;
+    SGImageBuffer* buffer = NULL;
+    UIImage* image = nil;
+    switch(key->operation) {
+        case kSGDerivedImage_Scaled:
+            image = imageWithImageBuffer(scaledImageBufferWithImage(source, CGSizeMake(parameters[0], parameters[1])));
+            break;
+        case kSGDerivedImage_Rounded:
+            buffer = scaledImageBufferWithImage(source, CGSizeMake(parameters[0], parameters[1]));
+            if(buffer)
+                SGImageBufferRoundCorners(buffer, parameters[2], parameters[3]);
+            image = imageWithImageBuffer(buffer);
+            break;
+        case kSGDerivedImage_Reflected:
+            image = reflectedImageWithImage(source, parameters[0]);
+            break;
+    }
+    
+    // The entry keeps its source alive, so the source is paid for as well.
+    // A source that several entries share is counted once by each of them.
+    CGImageRef imageRef = image.CGImage;
+    CGImageRef sourceRef = source.CGImage;
+    if(imageRef)
+        *cost = CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
+    if(imageRef && sourceRef)
+        *cost += CGImageGetBytesPerRow(sourceRef) * CGImageGetHeight(sourceRef);
+    
+    [image retain];
+    [pool release];
+    
+    return image;
+}
+
+/*
+* Every source and set of parameters is only worked on once, even when several
+* threads ask for the same image at the same time.
+*/
+static UIImage* derivedImage(UIImage* source, int operation, float a, float b, float c, float d)
+{
+    if(!source)
+        return nil;
+    
+    pthread_once(&derivedImageCacheOnce, createDerivedImageCache);
+    
+    SGImageCacheKey key = { source, operation, { a, b, c, d } };
+    return [(UIImage*)SGImageCacheCopyOrMake(derivedImageCache, &key, makeDerivedImage, NULL) autorelease];
+}
+
++ (void) removeAllDerivedImages
+{
+    if(derivedImageCache)
+        SGImageCacheClear(derivedImageCache);
+}
+
+#pragma mark -
+#pragma mark Operations 
+
++ (UIImage*) imageWithImage:(UIImage*)image scaledToSize:(CGSize)newSize;
+{
+    return derivedImage(image, kSGDerivedImage_Scaled, newSize.width, newSize.height, 0.0f, 0.0f);
+}
+
++ (UIImage*) roundedImageWithImage:(UIImage*)img cornerWidth:(int)width cornerHeight:(int)height scaleSize:(CGSize)size
+{
+    return derivedImage(img, kSGDerivedImage_Rounded, size.width, size.height, width, height);
 }
 
 - (UIImage*) scaleImageToSize:(CGSize)newSize
@@ -122,146 +277,39 @@ static void addRoundedRectToPath(CGContextRef context, CGRect rect, float ovalWi
 
 - (UIImage*) rotate:(UIImageOrientation)orient
 {
-    CGRect             bnds = CGRectZero;
-    UIImage*           copy = nil;
-    CGContextRef       ctxt = nil;
-    CGImageRef         imag = self.CGImage;
-    CGRect             rect = CGRectZero;
-    CGAffineTransform  tran = CGAffineTransformIdentity;
-	
-    rect.size.width  = CGImageGetWidth(imag);
-    rect.size.height = CGImageGetHeight(imag);
+    if(orient == UIImageOrientationUp || orient > UIImageOrientationRightMirrored) {
+        // Up would get you an exact copy of the original and
+        // anything else is not an orientation
+        assert(false);
+        return nil;
+    }
     
-    bnds = rect;
+    SGImageBuffer* buffer = imageBufferWithCGImage(self.CGImage);
+    if(!buffer)
+        return nil;
     
-    switch (orient)
-    {
-        case UIImageOrientationUp:
-			// would get you an exact copy of the original
-			assert(false);
-			return nil;
-			
-        case UIImageOrientationUpMirrored:
-			tran = CGAffineTransformMakeTranslation(rect.size.width, 0.0);
-			tran = CGAffineTransformScale(tran, -1.0, 1.0);
-			break;
-			
-        case UIImageOrientationDown:
-			tran = CGAffineTransformMakeTranslation(rect.size.width,
-													rect.size.height);
-			tran = CGAffineTransformRotate(tran, M_PI);
-			break;
-			
-        case UIImageOrientationDownMirrored:
-			tran = CGAffineTransformMakeTranslation(0.0, rect.size.height);
-			tran = CGAffineTransformScale(tran, 1.0, -1.0);
-			break;
-			
+    SGImageBuffer* rotated;
+    switch(orient) {
         case UIImageOrientationLeft:
-			bnds = swapWidthAndHeight(bnds);
-			tran = CGAffineTransformMakeTranslation(0.0, rect.size.width);
-			tran = CGAffineTransformRotate(tran, 3.0 * M_PI / 2.0);
-			break;
-			
         case UIImageOrientationLeftMirrored:
-			bnds = swapWidthAndHeight(bnds);
-			tran = CGAffineTransformMakeTranslation(rect.size.height,
-													rect.size.width);
-			tran = CGAffineTransformScale(tran, -1.0, 1.0);
-			tran = CGAffineTransformRotate(tran, 3.0 * M_PI / 2.0);
-			break;
-			
         case UIImageOrientationRight:
-			bnds = swapWidthAndHeight(bnds);
-			tran = CGAffineTransformMakeTranslation(rect.size.height, 0.0);
-			tran = CGAffineTransformRotate(tran, M_PI / 2.0);
-			break;
-			
         case UIImageOrientationRightMirrored:
-			bnds = swapWidthAndHeight(bnds);
-			tran = CGAffineTransformMakeScale(-1.0, 1.0);
-			tran = CGAffineTransformRotate(tran, M_PI / 2.0);
-			break;
-			
+            rotated = SGImageBufferNew(buffer->height, buffer->width);
+            break;
         default:
-			// orientation value supplied is invalid
-			assert(false);
-			return nil;
+            rotated = SGImageBufferNew(buffer->width, buffer->height);
+            break;
     }
-	
-    UIGraphicsBeginImageContext(bnds.size);
-    ctxt = UIGraphicsGetCurrentContext();
-	
-    switch (orient)
-    {
-        case UIImageOrientationLeft:
-        case UIImageOrientationLeftMirrored:
-        case UIImageOrientationRight:
-        case UIImageOrientationRightMirrored:
-			CGContextScaleCTM(ctxt, -1.0, 1.0);
-			CGContextTranslateCTM(ctxt, -rect.size.height, 0.0);
-			break;
-			
-        default:
-			CGContextScaleCTM(ctxt, 1.0, -1.0);
-			CGContextTranslateCTM(ctxt, 0.0, -rect.size.height);
-			break;
-    }
-	
-    CGContextConcatCTM(ctxt, tran);
-    CGContextDrawImage(UIGraphicsGetCurrentContext(), rect, imag);
     
-    copy = UIGraphicsGetImageFromCurrentImageContext();
-    UIGraphicsEndImageContext();
-	
-    return copy;
+    SGImageBufferTransform(buffer, rotated, (SGImageOrientation)orient);
+    SGImageBufferFree(buffer);
+    
+    return imageWithImageBuffer(rotated);
 }
 
 - (UIImage*) addImageReflection:(CGFloat)reflectionFraction 
 {
-	int reflectionHeight = self.size.height * reflectionFraction;
-	
-	CGImageRef gradientMaskImage = NULL;
-	
-    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceGray();
-    CGContextRef gradientBitmapContext = CGBitmapContextCreate(nil, 1, reflectionHeight,
-                                                               8, 0, colorSpace, kCGImageAlphaNone);
-    
-    CGFloat colors[] = {0.0, 1.0, 1.0, 1.0};
-    
-    CGGradientRef grayScaleGradient = CGGradientCreateWithColorComponents(colorSpace, colors, NULL, 2);
-    CGColorSpaceRelease(colorSpace);
-    
-    CGPoint gradientStartPoint = CGPointMake(0, reflectionHeight);
-    CGPoint gradientEndPoint = CGPointZero;
-    
-    CGContextDrawLinearGradient(gradientBitmapContext, grayScaleGradient, gradientStartPoint,
-                                gradientEndPoint, kCGGradientDrawsAfterEndLocation);
-	CGGradientRelease(grayScaleGradient);
-	
-	CGContextSetGrayFillColor(gradientBitmapContext, 0.0, 0.5);
-	CGContextFillRect(gradientBitmapContext, CGRectMake(0, 0, 1, reflectionHeight));
-    
-    gradientMaskImage = CGBitmapContextCreateImage(gradientBitmapContext);
-    CGContextRelease(gradientBitmapContext);
-	
-    CGImageRef reflectionImage = CGImageCreateWithMask(self.CGImage, gradientMaskImage);
-    CGImageRelease(gradientMaskImage);
-	
-	CGSize size = CGSizeMake(self.size.width, self.size.height + reflectionHeight);
-	
-	UIGraphicsBeginImageContext(size);
-	
-	[self drawAtPoint:CGPointZero];
-	CGContextRef context = UIGraphicsGetCurrentContext();
-	CGContextDrawImage(context, CGRectMake(0, self.size.height, self.size.width, reflectionHeight), reflectionImage);
-	
-	UIImage* result = UIGraphicsGetImageFromCurrentImageContext();
-	UIGraphicsEndImageContext();
-    CGImageRelease(reflectionImage);
-	
-	return result;
+    return derivedImage(self, kSGDerivedImage_Reflected, reflectionFraction, 0.0f, 0.0f, 0.0f);
 }
 
-
 @end
@@ -56,6 +56,11 @@
 * control which bucket is being displayed make sure to call @link reloadBucketAtIndex: reloadBucketAtIndex: @/link. Only a single
 * bucket is displayed at any given time in the AR view. There is no limitation to the amount of annotations a bucket can have.
 *
+* Buckets are loaded when they are first needed. The buckets next to @link bucketIndex bucketIndex @/link are prefetched,
+* along with their views and textures, so moving to them does not have to wait on the data source. Only a limited amount
+* of buckets are kept in memory; see @link maximumAmountOfLoadedBuckets maximumAmountOfLoadedBuckets @/link and
+* @link maximumLoadedBucketSize maximumLoadedBucketSize @/link.
+*
 * There is one minor "gotcha". If you want to access the navigation bar directly, you have to use @link navBar navBar @/link. All other calls to
 * the navigation view controller that involve the navigation bar (e.g. setNagivationBarHidden:) will be routed to the proper one. This little tweak
 * is needed in order to display a navigation bar properly in the view.
@@ -80,9 +85,18 @@
 
     NSInteger bucketIndex;
 
+    NSInteger maximumAmountOfLoadedBuckets;
+    NSUInteger maximumLoadedBucketSize;
+
     @private
     NSMutableArray* annotations;
- 	NSMutableArray* buckets;
+ 	NSMutableDictionary* buckets;
+    NSMutableDictionary* bucketViews;
+    NSMutableArray* loadedBucketIndexes;
+    NSMutableIndexSet* prefetchingBucketIndexes;
+    NSOperationQueue* prefetchQueue;
+    NSUInteger bucketGeneration;
+    NSInteger numberOfBuckets;
  
 #if !__IPHONE_4_0
 
@@ -114,12 +128,28 @@
 */
 @property (nonatomic, readonly) NSInteger bucketIndex;
 
+/*!
+* @property
+* @abstract The maximum amount of buckets that are kept in memory. The default is 3.
+* @discussion The bucket at @link bucketIndex bucketIndex @/link is always kept. The buckets that are
+* farthest from it are released first; of two buckets that are equally far, the one that was used least
+* recently goes first.
+*/
+@property (nonatomic, assign) NSInteger maximumAmountOfLoadedBuckets;
+
+/*!
+* @property
+* @abstract The maximum amount of bytes that loaded buckets can use for their annotations and
+* prefetched textures. The default is 0, which means there is no limit.
+*/
+@property (nonatomic, assign) NSUInteger maximumLoadedBucketSize;
+
 /*!
 * @method reloadAllBuckets
 * @abstract ￼ Runs through the entire process of collecting and displaying @link //simplegeo/ooc/cl/SGRecordAnnotation record annotations @/link
 * in the @link arView arView @/link.
 * @discussion If any record annotations have been registered with the @link SGARViewController SGARViewController @/link,
-* they will be released.
+* they will be released. Only the first bucket is loaded right away; its neighbour is prefetched.
 */
 - (void) reloadAllBuckets;
 
@@ -133,6 +163,7 @@
 /*!
 * @method loadNextBucket
 * @abstract ￼Loads the next bucket of record annotations that were imported with @link reloadAllBuckets reloadAllBuckets @/link.
+* @discussion If the bucket has been prefetched, the views that were created for it are used.
 * @result ￼YES if there is an available bucket. Otherwise, NO.
 */
 - (BOOL) loadNextBucket;
@@ -216,6 +247,7 @@
 /*!
 * @method viewController:annotationsForBucketAtIndex:
 * @abstract Asks for all the annotations that will be placed in the bucket.
+* @discussion When a bucket is prefetched, this method is called on a background thread.
 * @param viewController ￼The @link SGARViewController SGARViewController @/link that needs a bucket to be filled.
 * @param bucketIndex ￼The index of the bucket to be filled.
 * @result ￼ An array of @link //simplegeo/ooc/cl/SGRecordAnnotation SGRecordAnnotations @/link that will be placed in the bucket.
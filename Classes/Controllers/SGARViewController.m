@@ -36,10 +36,20 @@
 #import "SGMovableStack.h"
 #import "SGARView.h"
 #import "SGRadar.h"
+#import "SGAnnotationView.h"
+#import "SGTexture.h"
 
 @interface SGARViewController (Private)
 
 - (void) loadObjectsIntoBucket:(NSInteger)index;
+- (NSArray*) bucketAtIndex:(NSInteger)index;
+- (void) addBucket:(NSArray*)bucket atIndex:(NSInteger)index;
+- (void) prefetchBucketsAroundIndex:(NSInteger)index;
+- (void) prefetchBucket:(NSDictionary*)request;
+- (void) didPrefetchBucket:(NSDictionary*)bucketInfo;
+- (void) evictBuckets;
+- (void) removeAllBuckets;
+- (NSUInteger) sizeOfBucketAtIndex:(NSNumber*)index;
 - (void) setupViewableObjects;
 - (void) sortViewableObjects;
 
@@ -49,14 +59,24 @@
 
 @implementation SGARViewController
 
-@synthesize arView, dataSource, bucketIndex;
+@synthesize arView, dataSource, bucketIndex, maximumAmountOfLoadedBuckets, maximumLoadedBucketSize;
 
 - (id) init
 {
     if(self = [super init]) {
         super.title = @"ARView";
-        buckets = [[NSMutableArray alloc] init];
+        buckets = [[NSMutableDictionary alloc] init];
+        bucketViews = [[NSMutableDictionary alloc] init];
+        loadedBucketIndexes = [[NSMutableArray alloc] init];
+        prefetchingBucketIndexes = [[NSMutableIndexSet alloc] init];
+        prefetchQueue = [[NSOperationQueue alloc] init];
+        [prefetchQueue setMaxConcurrentOperationCount:1];
+        numberOfBuckets = 0;
         bucketIndex = -1;
+        bucketGeneration = 0;
+        
+        maximumAmountOfLoadedBuckets = 3;
+        maximumLoadedBucketSize = 0;
 
         isModal = NO;
 
@@ -109,38 +129,36 @@
 
 - (void) reloadAllBuckets
 {
-    [buckets removeAllObjects];
+    [self removeAllBuckets];
     
-    NSInteger numberOfBuckets = [dataSource viewControllerNumberOfBuckets:self];
-    
-    NSArray* bucket;
-    for(int i = 0; i < numberOfBuckets; i++) {
-        bucket = [dataSource viewController:self annotationsForBucketAtIndex:i];
-        [buckets addObject:bucket];
-    }
-         
-    bucketIndex = 0;
+    numberOfBuckets = [dataSource viewControllerNumberOfBuckets:self];
+    bucketIndex = numberOfBuckets > 0 ? 0 : -1;
     
     [arView reloadData];
+    [self prefetchBucketsAroundIndex:bucketIndex];
 }
 
 - (void) reloadBucketAtIndex:(NSInteger)newBucketIndex
 {
-    if(newBucketIndex < [buckets count] && newBucketIndex >= 0) {
-        [buckets replaceObjectAtIndex:bucketIndex withObject:[dataSource viewController:self
-                                                           annotationsForBucketAtIndex:newBucketIndex]];
+    if(newBucketIndex < numberOfBuckets && newBucketIndex >= 0) {
+        NSNumber* key = [NSNumber numberWithInteger:newBucketIndex];
+        [buckets removeObjectForKey:key];
+        [bucketViews removeObjectForKey:key];
+        [loadedBucketIndexes removeObject:key];
         
         bucketIndex = newBucketIndex;
         
         [arView reloadData];
+        [self prefetchBucketsAroundIndex:bucketIndex];
     }
 }
 
 - (BOOL) loadNextBucket
 {
-    if(bucketIndex >= 0 && bucketIndex < [buckets count] - 1) {
+    if(bucketIndex >= 0 && bucketIndex < numberOfBuckets - 1) {
         bucketIndex++;
         [arView reloadData];
+        [self prefetchBucketsAroundIndex:bucketIndex];
 
         return YES;
     }
@@ -153,6 +171,7 @@
     if(bucketIndex > 0) {
         bucketIndex--;
         [arView reloadData];
+        [self prefetchBucketsAroundIndex:bucketIndex];
 
         return YES;
     }
@@ -160,6 +179,187 @@
     return NO;
 }
 
+- (NSArray*) bucketAtIndex:(NSInteger)index
+{
+    if(index < 0 || index >= numberOfBuckets)
+        return nil;
+    
+    NSNumber* key = [NSNumber numberWithInteger:index];
+    NSArray* bucket = [buckets objectForKey:key];
+    if(!bucket) {
+        bucket = [dataSource viewController:self annotationsForBucketAtIndex:index];
+        [self addBucket:bucket atIndex:index];
+    }
+    
+    // The most recently used bucket is kept at the end
+    [loadedBucketIndexes removeObject:key];
+    [loadedBucketIndexes addObject:key];
+    
+    return bucket;
+}
+
+- (void) addBucket:(NSArray*)bucket atIndex:(NSInteger)index
+{
+    NSNumber* key = [NSNumber numberWithInteger:index];
+    [buckets setObject:(bucket ? bucket : [NSArray array]) forKey:key];
+    [loadedBucketIndexes removeObject:key];
+    [loadedBucketIndexes addObject:key];
+    
+    [self evictBuckets];
+}
+
+- (void) prefetchBucketsAroundIndex:(NSInteger)index
+{
+    NSInteger neighbours[2] = {index + 1, index - 1};
+    NSInteger neighbour;
+    NSInvocationOperation* operation;
+    NSDictionary* request;
+    // Leave room for the current bucket
+    for(int i = 0; i < 2 && i < maximumAmountOfLoadedBuckets - 1; i++) {
+        neighbour = neighbours[i];
+        if(neighbour < 0 || neighbour >= numberOfBuckets)
+            continue;
+        
+        if([buckets objectForKey:[NSNumber numberWithInteger:neighbour]] || [prefetchingBucketIndexes containsIndex:neighbour])
+            continue;
+        
+        // The generation tells a bucket of the current data set from
+        // one that was still being fetched when it was reloaded.
+        [prefetchingBucketIndexes addIndex:neighbour];
+        request = [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithInteger:neighbour], @"index",
+                   [NSNumber numberWithUnsignedInteger:bucketGeneration], @"generation", nil];
+        operation = [[NSInvocationOperation alloc] initWithTarget:self
+                                                         selector:@selector(prefetchBucket:)
+                                                           object:request];
+        [prefetchQueue addOperation:operation];
+        [operation release];
+    }
+}
+
+- (void) prefetchBucket:(NSDictionary*)request
+{
+    // Called on the prefetch queue
+    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+    
+    NSNumber* index = [request objectForKey:@"index"];
+    NSArray* bucket = [dataSource viewController:self annotationsForBucketAtIndex:[index integerValue]];
+    NSDictionary* bucketInfo = [NSDictionary dictionaryWithObjectsAndKeys:index, @"index",
+                                [request objectForKey:@"generation"], @"generation",
+                                (bucket ? bucket : [NSArray array]), @"annotations", nil];
+    [self performSelectorOnMainThread:@selector(didPrefetchBucket:) withObject:bucketInfo waitUntilDone:NO];
+    
+    [pool release];
+}
+
+- (void) didPrefetchBucket:(NSDictionary*)bucketInfo
+{
+    // A bucket of a data set that was reloaded since is dropped. Its index
+    // may already be prefetched again for the new data set.
+    if([[bucketInfo objectForKey:@"generation"] unsignedIntegerValue] != bucketGeneration)
+        return;
+    
+    NSNumber* key = [bucketInfo objectForKey:@"index"];
+    NSInteger index = [key integerValue];
+    [prefetchingBucketIndexes removeIndex:index];
+    
+    // The bucket might have been loaded on demand or moved out of
+    // reach while it was being fetched.
+    if([buckets objectForKey:key] || index < bucketIndex - 1 || index > bucketIndex + 1 || index >= numberOfBuckets)
+        return;
+    
+    // Views and their textures are created ahead of time so the
+    // AR view can pick them up when it switches to the bucket.
+    NSArray* bucket = [bucketInfo objectForKey:@"annotations"];
+    NSMutableDictionary* views = [NSMutableDictionary dictionaryWithCapacity:[bucket count]];
+    SGAnnotationView* view;
+    for(id<MKAnnotation> annotation in bucket) {
+        view = [dataSource viewController:self viewForAnnotation:annotation atBucketIndex:index];
+        if(view) {
+            if(!view.annotation)
+                view.annotation = annotation;
+            
+            [view texture];
+            [views setObject:view forKey:[NSValue valueWithNonretainedObject:annotation]];
+        }
+    }
+    
+    [bucketViews setObject:views forKey:key];
+    [self addBucket:bucket atIndex:index];
+}
+
+- (void) evictBuckets
+{
+    NSUInteger totalSize = 0;
+    if(maximumLoadedBucketSize)
+        for(NSNumber* key in loadedBucketIndexes)
+            totalSize += [self sizeOfBucketAtIndex:key];
+    
+    NSNumber* victim;
+    NSInteger distance, victimDistance;
+    while([loadedBucketIndexes count] > maximumAmountOfLoadedBuckets ||
+          (maximumLoadedBucketSize && totalSize > maximumLoadedBucketSize)) {
+        
+        // The bucket that is farthest from the current one goes first. Ties
+        // are broken by the one that was used least recently.
+        victim = nil;
+        victimDistance = 0;
+        for(NSNumber* key in loadedBucketIndexes) {
+            distance = labs([key integerValue] - bucketIndex);
+            if(distance > victimDistance) {
+                victim = key;
+                victimDistance = distance;
+            }
+        }
+        
+        // Only the current bucket is left
+        if(!victim)
+            break;
+        
+        if(maximumLoadedBucketSize)
+            totalSize -= [self sizeOfBucketAtIndex:victim];
+        
+        [buckets removeObjectForKey:victim];
+        [bucketViews removeObjectForKey:victim];
+        [loadedBucketIndexes removeObject:victim];
+    }
+}
+
+- (void) removeAllBuckets
+{
+    // Operations that are already running cannot be stopped, so
+    // their buckets are told apart by the generation.
+    [prefetchQueue cancelAllOperations];
+    [prefetchingBucketIndexes removeAllIndexes];
+    bucketGeneration++;
+    [buckets removeAllObjects];
+    [bucketViews removeAllObjects];
+    [loadedBucketIndexes removeAllObjects];
+}
+
+- (NSUInteger) sizeOfBucketAtIndex:(NSNumber*)index
+{
+    NSUInteger size = [[buckets objectForKey:index] count] * sizeof(id);
+    
+    SGTexture* texture;
+    NSUInteger bytesPerPixel;
+    for(SGAnnotationView* view in [[bucketViews objectForKey:index] objectEnumerator]) {
+        if(view.needNewTexture)
+            continue;
+        
+        texture = view.texture;
+        if(texture.pixelFormat == kSGTexturePixelFormat_RGBA8888)
+            bytesPerPixel = 4;
+        else if(texture.pixelFormat == kSGTexturePixelFormat_RGB565)
+            bytesPerPixel = 2;
+        else
+            bytesPerPixel = 1;
+        
+        size += texture.width * texture.height * bytesPerPixel;
+    }
+    
+    return size;
+}
+
 #pragma mark -
 #pragma mark UIViewController overrides 
 
@@ -282,16 +482,23 @@
  
 - (NSArray*) arView:(SGARView*)aView annotationsAtLocation:(CLLocation*)location
 {
-    NSArray* array = nil;
-    
-    if(bucketIndex < [buckets count] && bucketIndex >= 0)
-        array = [buckets objectAtIndex:bucketIndex];
-    
-    return array;
+    return [self bucketAtIndex:bucketIndex];
 }
 
 - (SGAnnotationView*) arView:(SGARView*)aView viewForAnnotation:(id<MKAnnotation>)annotation
 {
+    // Use the view that was prefetched with the bucket. Once the view
+    // is handed over, the AR view is in charge of it.
+    NSMutableDictionary* views = [bucketViews objectForKey:[NSNumber numberWithInteger:bucketIndex]];
+    NSValue* key = [NSValue valueWithNonretainedObject:annotation];
+    SGAnnotationView* view = [views objectForKey:key];
+    if(view) {
+        [[view retain] autorelease];
+        [views removeObjectForKey:key];
+        
+        return view;
+    }
+    
     return [dataSource viewController:self
                     viewForAnnotation:annotation
                         atBucketIndex:bucketIndex];
@@ -299,7 +506,7 @@
 
 - (NSInteger) amountOfBuckets
 {
-    return [buckets count];
+    return numberOfBuckets;
 }
 
 - (void) arView:(SGARView *)arView didAddAnnotationViews:(NSArray*)annotaitonViews
@@ -311,8 +518,13 @@
 
 - (void) dealloc
 {
+    [prefetchQueue cancelAllOperations];
+    [prefetchQueue release];
     [annotations release];
     [buckets release];
+    [bucketViews release];
+    [loadedBucketIndexes release];
+    [prefetchingBucketIndexes release];
 
 #if !__IPHONE_4_0
 
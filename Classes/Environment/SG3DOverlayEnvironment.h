@@ -34,10 +34,33 @@
 
 #import "SG3DOverlayView.h"
 #import "AccelerometerFilter.h"
+#import "SGAllocationTracker.h"
+#import "SGAnnotationStore.h"
+#import "SGLocationFilter.h"
+#import "SGOrientationPredictor.h"
+#import "SGScene.h"
+#import "SGSensorManager.h"
+#import "SGSensorRing.h"
+#import "SGARResponder.h"
 
 @class SGAnnotationView;
 @class SGARView;
 
+/* the SGARResponder callbacks that the environment sends */
+typedef enum {
+    kSGResponderEvent_SingleTap = 0,
+    kSGResponderEvent_SingleTapCancelled,
+    kSGResponderEvent_DoubleTap,
+    kSGResponderEvent_TapEnded,
+    kSGResponderEvent_TwoFingerTap,
+    kSGResponderEvent_Pinch,
+    kSGResponderEvent_Pull,
+    kSGResponderEvent_Move,
+    kSGResponderEvent_HorizontalSwipe,
+    kSGResponderEvent_VerticalSwipe,
+    kSGResponderEvent_Count
+} SGResponderEvent;
+
 /*!
 * @class SG3DOverlayEnvironment
 * @abstract This class is in charge of drawing all of the OpenGL components while producing
@@ -55,12 +78,13 @@
 * The floating @link //simplegeo/ooc/cl/SGAnnotationView SGAnnotationViews @/link apply their own matrix
 * transformations in order to be display in the 3D world properly.
 */
-@interface SG3DOverlayEnvironment : NSObject <SG3DOverlayViewDelegate, UIAccelerometerDelegate, CLLocationManagerDelegate> {
+@interface SG3DOverlayEnvironment : NSObject <SG3DOverlayViewDelegate, SGSensorManagerDelegate> {
     
     CGFloat fovy;
     
     NSMutableArray* responders;
-    CLLocationManager* locationManager;
+    NSMutableArray* responderTables[kSGResponderEvent_Count];
+    SGSensorManager* sensorManager;
     SGARView* arView;
     
     CGFloat cameraStepDistance;
@@ -75,12 +99,62 @@
     double roll;
     double heading;
     
-    CLLocation* currentLocation;
+    // The sensor callbacks only queue their samples. Every frame drains
+    // them in the order that they were taken, so the filters see all of them.
+    SGSensorRing accelerationRing;
+    SGSensorRing headingRing;
+    SGSensorRing locationRing;
+    
+    // The camera is turned to where the device is expected to
+    // be pointing once the frame is on screen.
+    SGOrientationPredictor orientationPredictor;
+    NSString* orientationTracePath;
+    
+    // The filtered location is kept in plain values so that a
+    // frame which moves the origin does not allocate.
+    BOOL hasLocation;
+    CLLocationCoordinate2D locationCoordinate;
+    CLLocationDistance locationAltitude;
+    CLLocationAccuracy locationAccuracy;
+    SGLocationFilter locationFilter;
     
-    NSMutableArray* annotationViews;
+    SGAnnotationStore* annotationStore;
     NSMutableArray* containers;
     
+    NSMutableSet* insertedAnnotationViews;
+    NSMutableSet* removedAnnotationViews;
+    NSMutableSet* updatedAnnotationViews;
+    BOOL annotationViewsNeedSort;
+    
     SGAnnotationView* selectedView;
+    UIView* tentativeInspectedView;
+    
+    CFMutableDictionaryRef clusterBadges;
+    
+    // The scene is prepared by the worker, or here when it is turned off
+    SGSceneWorker* sceneWorker;
+    SGScene* scene;
+    SGSceneInput sceneInput;
+    SGSceneSnapshot sceneSnapshot;
+    const SGSceneSnapshot* snapshot;
+    unsigned int sceneRevision;
+    unsigned int sceneFrame;
+    int amountOfBillboards;
+    
+    // Splits the projection of very large stores between the cores
+    SGTaskPool* taskPool;
+    
+    NSInteger amountOfMovedAnnotationViews;
+    NSInteger amountOfHiddenAnnotationViews;
+    NSInteger amountOfAllocationsPerFrame;
+    NSInteger amountOfTextureBindsPerFrame;
+    NSInteger amountOfStateChangesPerFrame;
+    NSInteger amountOfDrawCallsPerFrame;
+    NSInteger amountOfSkippedGLCallsPerFrame;
+    
+    CFTimeInterval startTime;
+    NSTimeInterval timeToFirstFrame;
+    NSTimeInterval mainThreadTimePerFrame;
     
     CGFloat cameraXCoord;
     CGFloat cameraZCoord;
@@ -102,18 +176,116 @@
 * the camera is asked to move.
 * @discussion At this time, the camera is only asked to move
 * when either the @link @link //simplegeo/ooc/cl/SG3DOverlayEnvironment SG3DOverlayEnvrionment @/link
-* generates a pinch, pull or double tap control event. See @link //simplegeo/ooc/intf/SG3DOverlayViewDelegate SG3DOverlayViewDelegate @/link.
+* generates a pinch, pull or double tap control event. A pinch or pull moves the camera
+* one step for every 5 pixels that the fingers travel, however often the touches arrive. See @link //simplegeo/ooc/intf/SG3DOverlayViewDelegate SG3DOverlayViewDelegate @/link.
 * Also, @link //simplegeo/ooc/instp/SGARView/enableWalking enableWalking @/link must be set to YES in order
 * for the camera distance to be applied to the environment when the proper control signals are generated.
 */
 @property (nonatomic, assign) CGFloat cameraStepDistance;
 
+/*!
+* @property amountOfMovedAnnotationViews
+* @abstract The amount of annotation views that were lifted or offset by the
+* declutter pass during the last frame.
+* @discussion See @link //simplegeo/ooc/instp/SGARView/enableDecluttering enableDecluttering @/link.
+*/
+@property (nonatomic, readonly) NSInteger amountOfMovedAnnotationViews;
+
+/*!
+* @property amountOfHiddenAnnotationViews
+* @abstract The amount of annotation views that were hidden by the declutter
+* pass during the last frame.
+* @discussion See @link //simplegeo/ooc/instp/SGARView/enableDecluttering enableDecluttering @/link.
+*/
+@property (nonatomic, readonly) NSInteger amountOfHiddenAnnotationViews;
+
+/*!
+* @property amountOfAvoidedLocationUpdates
+* @abstract The amount of location fixes that did not move the scene.
+* @discussion Fixes are smoothed and filtered for outliers before they are used. The smoothed location
+* only replaces the current one once it has moved further than a threshold that grows with its uncertainty.
+* Every accepted fix that stays within the threshold saves the environment from re-projecting its annotation views.
+*/
+@property (nonatomic, readonly) NSInteger amountOfAvoidedLocationUpdates;
+
+/*!
+* @property amountOfAllocationsPerFrame
+* @abstract The amount of heap allocations that were made by the render thread while drawing the last frame.
+* @discussion Allocations are only counted when @link //simplegeo/ooc/instp/SGARView/allocationTracking allocationTracking @/link
+* is turned on. Textures are drawn again whenever an annotation view changes, so a frame that follows such a change
+* is expected to allocate. Every other frame should not.
+*/
+@property (nonatomic, readonly) NSInteger amountOfAllocationsPerFrame;
+
+/*!
+* @property amountOfTextureBindsPerFrame
+* @abstract The amount of textures that were bound while drawing the last frame.
+* @discussion Binding the texture that is already bound is skipped and not counted.
+*/
+@property (nonatomic, readonly) NSInteger amountOfTextureBindsPerFrame;
+
+/*!
+* @property amountOfStateChangesPerFrame
+* @abstract The amount of OpenGL capabilities and client states that were enabled or disabled while drawing the last frame.
+*/
+@property (nonatomic, readonly) NSInteger amountOfStateChangesPerFrame;
+
+/*!
+* @property amountOfDrawCallsPerFrame
+* @abstract The amount of draw calls that were made while drawing the last frame.
+*/
+@property (nonatomic, readonly) NSInteger amountOfDrawCallsPerFrame;
+
+/*!
+* @property amountOfSkippedGLCallsPerFrame
+* @abstract The amount of binds and state changes that were skipped in the last frame because they would not have changed anything.
+*/
+@property (nonatomic, readonly) NSInteger amountOfSkippedGLCallsPerFrame;
+
+/*!
+* @property timeToFirstFrame
+* @abstract The amount of seconds between @link initiate initiate @/link and the end of the first frame
+* that drew the annotation views.
+* @discussion The time is logged together with the amount of textures that came from the billboard cache.
+* It is 0 until such a frame has been drawn. See @link //simplegeo/ooc/instp/SGAnnotationView/billboardIdentifier billboardIdentifier @/link.
+*/
+@property (nonatomic, readonly) NSTimeInterval timeToFirstFrame;
+
+/*!
+* @property mainThreadTimePerFrame
+* @abstract The amount of seconds that @link drawView: drawView: @/link takes, averaged over the last frames.
+* @discussion With @link //simplegeo/ooc/instp/SGARView/enableConcurrentScenePreparation enableConcurrentScenePreparation @/link
+* turned on, the placement of the annotation views is prepared on a worker thread and is left out of this time.
+*/
+@property (nonatomic, readonly) NSTimeInterval mainThreadTimePerFrame;
+
+/*!
+* @property orientationPredictionHorizon
+* @abstract The amount of seconds between the newest sensor sample and the time that a frame is expected
+* to be on screen, averaged over the last frames.
+*/
+@property (nonatomic, readonly) NSTimeInterval orientationPredictionHorizon;
+
+/*!
+* @property orientationPredictionError
+* @abstract The root mean square error, in degrees, of the predicted orientations once the sensors caught up with them.
+*/
+@property (nonatomic, readonly) double orientationPredictionError;
+
+/*!
+* @property orientationHoldError
+* @abstract The root mean square error, in degrees, that the last sensor values would have had in place of the predictions.
+*/
+@property (nonatomic, readonly) double orientationHoldError;
+
 /*!
 * @property responders
 * @abstract Contains all the @link //simplegeo/ooc/intf/SGARResponder SGARResponders @/link that
 * have been added via @link //simplegeo/ooc/instm/SGARView/addResponder: addResponder: @/link.
+* @discussion Responders have to be added through @link addResponder: addResponder: @/link in order
+* to receive events.
 */
-@property (nonatomic, readonly) NSMutableArray* responders;
+@property (nonatomic, readonly) NSArray* responders;
 
 /*!
 * @property locationManager
@@ -121,6 +293,14 @@
 */
 @property (nonatomic, readonly) CLLocationManager* locationManager;
 
+/*!
+* @property sensorManager
+* @abstract The @link //simplegeo/ooc/cl/SGSensorManager SGSensorManager @/link that starts and stops
+* the sensors that this class listens to.
+* @discussion The sensors are started by @link initiate initiate @/link and stopped by @link cleanUp cleanUp @/link.
+*/
+@property (nonatomic, readonly) SGSensorManager* sensorManager;
+
 /*!
 * @property arView
 * @abstract The @link //simplegeo/ooc/SGARView SGARView @/link that this class
@@ -132,7 +312,8 @@
 * @method addAnnotationViews:
 * @abstract ￼Adds an array of @link //simplegeo/ooc/cl/SGAnnotationView SGAnnotationViews @/link
 * to be rendered in the OpenGL environment.
-* @discussion ￼This method is invoked by @link //simplegeo/ooc/instm/SGARView/reloadData reloadData @/link.
+* @discussion ￼The views replace every view that is in the environment. This method is invoked by
+* @link //simplegeo/ooc/instm/SGARView/clear clear @/link; reloading only inserts and removes the views that changed.
 * @param views￼
 */
 - (void) addAnnotationViews:(NSArray*)views;
@@ -145,4 +326,51 @@
 */
 - (void) addAnnotationView:(SGAnnotationView*)view;
 
+/*!
+* @method insertAnnotationViews:
+* @abstract Inserts an array of @link //simplegeo/ooc/cl/SGAnnotationView SGAnnotationViews @/link
+* into the OpenGL environment and the radar.
+* @discussion The views are not added right away. They are placed in their sorted position at the
+* start of the next frame. Only the inserted views are touched; the rest of the environment is left as is.
+* This method is invoked by @link //simplegeo/ooc/instm/SGARView/insertAnnotations: insertAnnotations: @/link.
+* @param views The views to insert.
+*/
+- (void) insertAnnotationViews:(NSArray*)views;
+
+/*!
+* @method removeAnnotationViews:
+* @abstract Removes an array of @link //simplegeo/ooc/cl/SGAnnotationView SGAnnotationViews @/link
+* from the OpenGL environment and the radar at the start of the next frame.
+* @discussion This method is invoked by @link //simplegeo/ooc/instm/SGARView/removeAnnotations: removeAnnotations: @/link.
+* @param views The views to remove.
+*/
+- (void) removeAnnotationViews:(NSArray*)views;
+
+/*!
+* @method updateAnnotationViews:
+* @abstract Moves an array of @link //simplegeo/ooc/cl/SGAnnotationView SGAnnotationViews @/link to
+* the sorted position of their annotation's current coordinate at the start of the next frame.
+* @discussion This method is invoked by @link //simplegeo/ooc/instm/SGARView/updateAnnotations: updateAnnotations: @/link.
+* @param views The views whose annotations have changed.
+*/
+- (void) updateAnnotationViews:(NSArray*)views;
+
+/*!
+* @method addResponder:
+* @abstract Adds a @link //simplegeo/ooc/intf/SGARResponder SGARResponder @/link that is notified
+* of gestures in the OpenGL environment.
+* @discussion The callbacks that the responder implements are looked up once, here, and the
+* responder is only sent the gestures that it handles. A responder that gains or loses callbacks
+* at runtime has to be removed and added again.
+* @param responder The responder to add.
+*/
+- (void) addResponder:(id<SGARResponder>)responder;
+
+/*!
+* @method removeResponder:
+* @abstract Removes a @link //simplegeo/ooc/intf/SGARResponder SGARResponder @/link.
+* @param responder The responder to remove.
+*/
+- (void) removeResponder:(id<SGARResponder>)responder;
+
 @end
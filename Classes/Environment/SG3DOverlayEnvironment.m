@@ -32,6 +32,8 @@
 //  Created by Derek Smith.
 //
 
+#import <QuartzCore/QuartzCore.h>
+
 #import "SGARView.h"
 #import "SGAnnotationView.h"
 #import "SGRadar.h"
@@ -46,41 +48,87 @@
 #import "SGTexture.h"
 #import "SGMetrics.h"
 #import "SGMath.h"
+#import "SGFastTrig.h"
+#import "SGGLState.h"
 #import "GLU+iPhone.h"
 
 #define kAccelerometer_Rate               30.0
+#define kSGCluster_CellSize               (kSGMeter * 5.0f)
+#define kSGFrameTimeSmoothing             0.1       /* weight of the last frame in mainThreadTimePerFrame */
+#define kSGPinchStepLength                5.0f      /* pixels of finger spread per camera step */
 
 // Get the average height of a person
 static GLfloat yEyePosition = kSGMeter * 1.7018f;
 
+static SEL SGResponderEventSelector(SGResponderEvent event)
+{
+    switch(event) {
+        case kSGResponderEvent_SingleTap:           return @selector(ARSingleTap:);
+        case kSGResponderEvent_SingleTapCancelled:  return @selector(ARSingleTapCancelled:);
+        case kSGResponderEvent_DoubleTap:           return @selector(ARDoubleTap:);
+        case kSGResponderEvent_TapEnded:            return @selector(ARTapEndedAtPoint:);
+        case kSGResponderEvent_TwoFingerTap:        return @selector(ARSingleTapAtPoint:andPoint:);
+        case kSGResponderEvent_Pinch:               return @selector(ARPinchAtPoint:andPoint:withDistance:);
+        case kSGResponderEvent_Pull:                return @selector(ARPullAtPoint:andPoint:withDistance:);
+        case kSGResponderEvent_Move:                return @selector(ARMoveFromPoint:toPoint:);
+        case kSGResponderEvent_HorizontalSwipe:     return @selector(ARHorizontalSwipeAtPoint:toPoint:);
+        case kSGResponderEvent_VerticalSwipe:       return @selector(ARVerticalSwipeAtPoint:toPoint:);
+        default:                                    return NULL;
+    }
+}
+
 @interface SG3DOverlayEnvironment (Private)
 
+- (void) drainSensors;
+- (void) addAccelerationSample:(const SGSensorSample*)sample;
+- (void) addHeadingSample:(const SGSensorSample*)sample;
+- (void) addLocationSample:(const SGSensorSample*)sample;
+- (void) updateOrientationTrace;
+- (double) orientationErrorWithFunction:(double (*)(const SGOrientationPredictor*, int))function;
+- (void) prepareScene;
+- (void) submitScene;
+- (void) fillSceneInput:(SGSceneInput*)input framesAhead:(int)framesAhead;
 - (void) drawLocatableObjects;
+- (void) drawBillboards;
+- (void) drawTextureForAnnotationView:(SGAnnotationView*)annotationView;
+- (SGTexture*) badgeTextureForCount:(int)count;
 - (void) moveCameraForward:(BOOL)forward withDistance:(CGFloat)distance;
 - (CGRect) getCapturableAreaFromPoint:(CGPoint)fromPoint toPoint:(CGPoint)toPoint;
 
-- (SGPoint3*) unprojectWindowPoint:(CGPoint)point;
+- (SGPoint3) unprojectWindowPoint:(CGPoint)point;
 - (SGAnnotationView*) closestAnnotationViewForPoint:(CGPoint)point;
 
 - (void) sortAnnotationViews;
-- (double) getAnnotationViewDistance:(SGAnnotationView*)annotationView;
+- (void) applyAnnotationViewChanges;
+- (void) removeAllAnnotationViews;
 
 @end
 
 @implementation SG3DOverlayEnvironment
 
-@synthesize locationManager, responders, arView, cameraStepDistance, fovy;
+@synthesize sensorManager, responders, arView, cameraStepDistance, fovy;
+@synthesize amountOfMovedAnnotationViews, amountOfHiddenAnnotationViews, amountOfAllocationsPerFrame, timeToFirstFrame, mainThreadTimePerFrame;
+@synthesize amountOfTextureBindsPerFrame, amountOfStateChangesPerFrame, amountOfDrawCallsPerFrame, amountOfSkippedGLCallsPerFrame;
 
 - (id) init
 {
     if(self = [super init]) {
         responders = [[NSMutableArray alloc] init];
+        for(int i = 0; i < kSGResponderEvent_Count; i++)
+            responderTables[i] = [[NSMutableArray alloc] init];
 
-        locationManager = [[CLLocationManager alloc] init];
-        locationManager.delegate = self;
+        sensorManager = [[SGSensorManager alloc] init];
+        sensorManager.delegate = self;
             
-        currentLocation = nil;
+        hasLocation = NO;
+        SGLocationFilterReset(&locationFilter);
         filter = [[LowpassFilter alloc] initWithSampleRate:kAccelerometer_Rate cutoffFrequency:1.5];
+        SGSensorRingInit(&accelerationRing);
+        SGSensorRingInit(&headingRing);
+        SGSensorRingInit(&locationRing);
+        orientationPredictor.trace = NULL;
+        SGOrientationPredictorReset(&orientationPredictor);
+        orientationTracePath = nil;
         
         pitch = 0.0f;
         yaw = 0.0f;
@@ -92,8 +140,38 @@ static GLfloat yEyePosition = kSGMeter * 1.7018f;
         cameraZCoord = 0.0f;
         cameraStepDistance = 1.0f;
 
-        annotationViews = [[NSMutableArray alloc] init];
+        annotationStore = SGAnnotationStoreNew(kSGMeter, kSGAnnotation_MinimumDistance, kSGAnnotation_MaximumDistance);
         containers = [[NSMutableArray alloc] init];
+        
+        insertedAnnotationViews = [[NSMutableSet alloc] init];
+        removedAnnotationViews = [[NSMutableSet alloc] init];
+        updatedAnnotationViews = [[NSMutableSet alloc] init];
+        annotationViewsNeedSort = NO;
+        
+        // Badges are keyed by their count so looking one up does not allocate
+        clusterBadges = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        
+        sceneWorker = NULL;
+        scene = NULL;
+        taskPool = NULL;
+        SGSceneInputInit(&sceneInput);
+        SGSceneSnapshotInit(&sceneSnapshot);
+        snapshot = NULL;
+        sceneRevision = 0;
+        sceneFrame = 0;
+        amountOfBillboards = 0;
+        
+        amountOfMovedAnnotationViews = 0;
+        amountOfHiddenAnnotationViews = 0;
+        amountOfAllocationsPerFrame = 0;
+        amountOfTextureBindsPerFrame = 0;
+        amountOfStateChangesPerFrame = 0;
+        amountOfDrawCallsPerFrame = 0;
+        amountOfSkippedGLCallsPerFrame = 0;
+        
+        startTime = 0.0;
+        timeToFirstFrame = 0.0;
+        mainThreadTimePerFrame = 0.0;
                 
         modelMatrix = (GLfloat*)malloc(sizeof(GLfloat) * 16);
         projectionMatrix = (GLfloat*)malloc(sizeof(GLfloat) * 16);
@@ -104,32 +182,26 @@ static GLfloat yEyePosition = kSGMeter * 1.7018f;
 }
 
 #pragma mark -
-#pragma mark Sort functions  
+#pragma mark Accessor methods 
 
-int sortRecordByDistance(id view1, id view2, void* blah) {
-	SGAnnotationView* v1 = (SGAnnotationView*)view1;
-	SGAnnotationView* v2 = (SGAnnotationView*)view2;
-    
-    double d1 = v1.distance;
-    double d2 = v2.distance;
-    
-	NSComparisonResult result;
-	if(d2 > d1)
-		result = NSOrderedDescending;
-	else if(d1 > d2)
-		result = NSOrderedAscending;
-    else 
-        result = NSOrderedSame;
-    
-	return result;
+- (CLLocationManager*) locationManager
+{
+    return sensorManager.locationManager;
 }
 
-#pragma mark -
-#pragma mark Accessor methods 
+- (NSInteger) amountOfAvoidedLocationUpdates
+{
+    return locationFilter.avoidedUpdates;
+}
 
 - (void) addAnnotationViews:(NSArray*)views
 {
-    [annotationViews removeAllObjects];
+    [self removeAllAnnotationViews];
+    
+    // The new data set replaces anything that has not been applied yet
+    [insertedAnnotationViews removeAllObjects];
+    [removedAnnotationViews removeAllObjects];
+    [updatedAnnotationViews removeAllObjects];
 
     // Add the annotations view to the radar and ar views
     if(arView.radar) 
@@ -138,17 +210,100 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
     for(SGAnnotationView* view in views)
         [self addAnnotationView:view];
     
-    [self sortAnnotationViews];
+    sceneRevision++;
 }
 
 - (void) addAnnotationView:(SGAnnotationView*)annotationView
 {
-    [annotationViews addObject:annotationView];
+    if(annotationView.store == annotationStore)
+        return;
+    
+    // The store does not retain its objects
+    [annotationView retain];
+    
+    CLLocationCoordinate2D coordinate = annotationView.annotation.coordinate;
+    annotationView.handle = SGAnnotationStoreAdd(annotationStore, coordinate.latitude, coordinate.longitude,
+                                                 annotationView.altitude, annotationView);
+    annotationView.store = annotationStore;
+    
+    SGAnnotationStoreSetFlag(annotationStore, annotationView.handle, kSGAnnotationFlag_Captured, annotationView.isCaptured);
+    SGAnnotationStoreSetFlag(annotationStore, annotationView.handle, kSGAnnotationFlag_Hidden, !annotationView.annotation);
 }
 
 - (void) removeLocatableObject:(SGAnnotationView*)annotationView
 {
-    [annotationViews removeObject:annotationView];
+    if(annotationView.store != annotationStore)
+        return;
+    
+    annotationView.store = NULL;
+    SGAnnotationStoreRemove(annotationStore, annotationView.handle);
+    annotationView.handle = kSGAnnotationHandle_Invalid;
+    [annotationView release];
+}
+
+- (void) removeAllAnnotationViews
+{
+    SGAnnotationView* annotationView;
+    for(int i = 0; i < annotationStore->count; i++) {
+        annotationView = (SGAnnotationView*)annotationStore->objects[i];
+        annotationView.store = NULL;
+        annotationView.handle = kSGAnnotationHandle_Invalid;
+        [annotationView release];
+    }
+    
+    // The billboards of the last frame refer to handles that are no longer valid
+    SGAnnotationStoreClear(annotationStore);
+    sceneRevision++;
+}
+
+- (void) insertAnnotationViews:(NSArray*)views
+{
+    for(SGAnnotationView* view in views) {
+        // A view that was removed and then handed back out by the data source
+        // never leaves the environment; it only needs to be moved.
+        if([removedAnnotationViews containsObject:view]) {
+            [removedAnnotationViews removeObject:view];
+            [updatedAnnotationViews addObject:view];
+        } else
+            [insertedAnnotationViews addObject:view];
+    }
+}
+
+- (void) removeAnnotationViews:(NSArray*)views
+{
+    for(SGAnnotationView* view in views) {
+        [updatedAnnotationViews removeObject:view];
+        
+        if([insertedAnnotationViews containsObject:view])
+            [insertedAnnotationViews removeObject:view];
+        else
+            [removedAnnotationViews addObject:view];
+    }
+}
+
+- (void) updateAnnotationViews:(NSArray*)views
+{
+    for(SGAnnotationView* view in views)
+        if(![insertedAnnotationViews containsObject:view] && ![removedAnnotationViews containsObject:view])
+            [updatedAnnotationViews addObject:view];
+}
+
+- (void) addResponder:(id<SGARResponder>)responder
+{
+    [responders addObject:responder];
+    
+    // Gestures only go to the responders that handle them
+    for(int i = 0; i < kSGResponderEvent_Count; i++)
+        if([responder respondsToSelector:SGResponderEventSelector(i)])
+            [responderTables[i] addObject:responder];
+}
+
+- (void) removeResponder:(id<SGARResponder>)responder
+{
+    for(int i = 0; i < kSGResponderEvent_Count; i++)
+        [responderTables[i] removeObjectIdenticalTo:responder];
+    
+    [responders removeObject:responder];
 }
 
 #pragma mark -
@@ -156,23 +311,19 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
 
 - (void) initiate
 {
-    [[UIAccelerometer sharedAccelerometer] setUpdateInterval:(1.0 / kAccelerometer_Rate)];
-	[[UIAccelerometer sharedAccelerometer] setDelegate:self];
-    
     fovy = 65.0f;
     
-    locationManager.delegate = self;
-    [locationManager startUpdatingHeading];
-    [locationManager startUpdatingLocation];
-    locationManager.distanceFilter = kCLDistanceFilterNone;
-    locationManager.desiredAccuracy = kCLLocationAccuracyBest;
+    startTime = CACurrentMediaTime();
+    timeToFirstFrame = 0.0;
+    
+    sensorManager.walking = arView.enableWalking;
+    [sensorManager start];
 }
 
 - (void) cleanUp
 {
     fovy = 0.0f;
-    [locationManager stopUpdatingHeading];
-    locationManager.delegate = nil;
+    [sensorManager stop];
 }
 
 - (void) setupView:(SG3DOverlayView*)view
@@ -189,11 +340,11 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
     
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
     
-    glEnable(GL_BLEND);
+    SGGLStateEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_NORMAL_ARRAY);
+    SGGLStateEnableClientState(GL_VERTEX_ARRAY);
+    SGGLStateEnableClientState(GL_NORMAL_ARRAY);
     
     if(arView.radar)
         [arView bringSubviewToFront:arView.radar];
@@ -201,28 +352,85 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
 
 - (void) drawView:(SG3DOverlayView*)view
 {
+    CFTimeInterval frameStart = CACurrentMediaTime();
+    
+    SGAllocationTracking allocationTracking = arView.allocationTracking;
+    SGAllocationTrackerSetMode(allocationTracking);
+    if(allocationTracking != kSGAllocationTracking_None) {
+        SGAllocationTrackerInstall();
+        SGAllocationTrackerBeginFrame();
+    }
+    
+    SGGLStateBeginFrame();
+    [self drainSensors];
+    [self updateOrientationTrace];
+    SGOrientationPredictorBeginFrame(&orientationPredictor, frameStart);
+    
+    [self applyAnnotationViewChanges];
+    [self prepareScene];
+    
+    // The frame is drawn with the camera that its scene was prepared for
+    const SGSceneCamera* camera = &snapshot->camera;
+    
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
         
     glMatrixMode(GL_MODELVIEW);
-    glRotatef(90.0f * roll, 0.0f, 0.0f, 1.0f);
-    glRotatef(-90.0f * pitch, 1.0f, 0.0f, 0.0f); 
-    glRotatef(heading, 0.0f, 1.0f, 0.0f);
+    glRotatef(90.0f * camera->roll, 0.0f, 0.0f, 1.0f);
+    glRotatef(-90.0f * camera->pitch, 1.0f, 0.0f, 0.0f); 
+    glRotatef(camera->heading, 0.0f, 1.0f, 0.0f);
     
-    glTranslatef(0.0f, -yEyePosition, 0.0f);
+    glTranslatef(0.0f, -camera->height, 0.0f);
         
-    [arView drawComponent:kSGChromeComponent_Gridlines heading:heading roll:roll];
+    [arView drawComponent:kSGChromeComponent_Gridlines heading:camera->heading roll:camera->roll];
     
     glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-    glTranslatef(-cameraXCoord, 0.0f, -cameraZCoord);
+    glTranslatef(-camera->x, 0.0f, -camera->z);
     [self drawLocatableObjects];
     glGetFloatv(GL_MODELVIEW_MATRIX, modelMatrix);                           
     
+    // Every billboard gets its texture the first time it is drawn
+    if(startTime && amountOfBillboards) {
+        timeToFirstFrame = CACurrentMediaTime() - startTime;
+        startTime = 0.0;
+        
+        SGBillboardCache* billboardCache = [SGAnnotationView billboardCache];
+        SGLog(@"SG3DOverlayEnvironment - First frame of %i billboards drawn after %.0f ms; %i textures were cached, %i were rendered",
+              amountOfBillboards, timeToFirstFrame * 1000.0,
+              billboardCache ? billboardCache->hits : 0, billboardCache ? billboardCache->misses : 0);
+        
+        SGStartupProfileEnd(arView.startupProfile, kSGStartupPhase_FirstFrame, CACurrentMediaTime());
+        SGLog(@"SG3DOverlayEnvironment - Startup phases\n%@", arView.startupReport);
+    }
+    
     if(arView.enableWalking)
         arView.walkingOffset = CGPointMake(cameraXCoord, -cameraZCoord);
     
-    [arView drawComponent:kSGChromeComponent_Radar heading:heading roll:roll];
-    [arView drawComponent:kSGChromeComponent_MovableStack heading:heading roll:roll];    
+    arView.existingRadar.sceneSnapshot = snapshot;
+    [arView drawComponent:kSGChromeComponent_Radar heading:camera->heading roll:camera->roll];
+    [arView drawComponent:kSGChromeComponent_MovableStack heading:camera->heading roll:camera->roll];    
+    
+    [self submitScene];
+    
+    if(allocationTracking != kSGAllocationTracking_None) {
+        SGAllocationCounts counts = SGAllocationTrackerEndFrame();
+        amountOfAllocationsPerFrame = counts.allocations;
+        
+        NSAssert2(allocationTracking != kSGAllocationTracking_Assert || !counts.allocations,
+                  @"SG3DOverlayEnvironment - %u allocations were made while drawing the frame; the first was %u bytes",
+                  counts.allocations, (unsigned int)counts.firstSize);
+    } else
+        amountOfAllocationsPerFrame = 0;
+    
+    SGGLCounts glCounts = SGGLStateEndFrame();
+    amountOfTextureBindsPerFrame = glCounts.binds;
+    amountOfStateChangesPerFrame = glCounts.stateChanges;
+    amountOfDrawCallsPerFrame = glCounts.drawCalls;
+    amountOfSkippedGLCallsPerFrame = glCounts.skipped;
+    
+    NSTimeInterval frameTime = CACurrentMediaTime() - frameStart;
+    mainThreadTimePerFrame = mainThreadTimePerFrame ?
+        mainThreadTimePerFrame + (frameTime - mainThreadTimePerFrame) * kSGFrameTimeSmoothing : frameTime;
 }
 
 #pragma mark -
@@ -232,6 +440,9 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
 {
     SGLog(@"SGGesture - Single tap at %f,%f", point.x, point.y);
     
+    [tentativeInspectedView release];
+    tentativeInspectedView = nil;
+    
     UIView* inspectedView = nil;
     // Chrome manager gets first dibs on touch events
     if(![arView hitTestAtPoint:point withEvent:kSGControlEvent_Touch]) {
@@ -249,6 +460,9 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
                     
                         [arView addSubview:viewToInspect];
                         inspectedView = viewToInspect;
+                        
+                        // Kept in case the tap turns out to be part of a double tap
+                        tentativeInspectedView = [viewToInspect retain];
                     } else {
                         // No inspection was declared
                         inspectedView = nil;
@@ -257,10 +471,29 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
             }         
         }  
     
-        for(id<SGARResponder> responder in responders)
-            if([responder respondsToSelector:@selector(ARSingleTap:)])
-               [responder ARSingleTap:point];
+        for(id<SGARResponder> responder in responderTables[kSGResponderEvent_SingleTap])
+            [responder ARSingleTap:point];
+    }
+}
+
+- (void) view:(SG3DOverlayView*)view ARSingleTapCancelled:(CGPoint)point
+{
+    SGLog(@"SGGesture - Single tap at %f,%f cancelled", point.x, point.y);
+    
+    // Take back the inspection that the single tap started
+    if(tentativeInspectedView) {
+        [tentativeInspectedView removeFromSuperview];
+        if([tentativeInspectedView isKindOfClass:[SGAnnotationView class]])
+            ((SGAnnotationView*)tentativeInspectedView).isCaptured = NO;
+        
+        [tentativeInspectedView release];
+        tentativeInspectedView = nil;
     }
+    
+    selectedView = nil;
+    
+    for(id<SGARResponder> responder in responderTables[kSGResponderEvent_SingleTapCancelled])
+        [responder ARSingleTapCancelled:point];
 }
 
 - (void) view:(SG3DOverlayView*)view ARDoubleTap:(CGPoint)point
@@ -270,9 +503,8 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
     if(![arView hitTestAtPoint:point withEvent:kSGControlEvent_DoubleTouch])  {
         [self moveCameraForward:YES withDistance:50.0f];
 
-        for(id<SGARResponder>responder in responders)
-            if([responder respondsToSelector:@selector(ARDoubleTap:)])
-                [responder ARDoubleTap:point];
+        for(id<SGARResponder> responder in responderTables[kSGResponderEvent_DoubleTap])
+            [responder ARDoubleTap:point];
     }
 }
 
@@ -284,9 +516,8 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
         if(selectedView)
             selectedView = nil;
 
-        for(id<SGARResponder>responder in responders)
-            if([responder respondsToSelector:@selector(ARTapEndedAtPoint:)])
-                [responder ARTapEndedAtPoint:point];
+        for(id<SGARResponder> responder in responderTables[kSGResponderEvent_TapEnded])
+            [responder ARTapEndedAtPoint:point];
     }
 }
 
@@ -294,22 +525,23 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
 {
     SGLog(@"SGGesture - Pinch at %f,%f and %f,%f", pointOne.x, pointOne.y, pointTwo.x, pointTwo.y);
     
-    [self moveCameraForward:NO withDistance:cameraStepDistance * kSGMeter];
-    
-    for(id<SGARResponder> responder in responders)
-        if([responder respondsToSelector:@selector(ARPinchAtPoint:andPoint:withDistance:)])
-            [responder ARPinchAtPoint:pointOne andPoint:pointTwo withDistance:distance];
+    for(id<SGARResponder> responder in responderTables[kSGResponderEvent_Pinch])
+        [responder ARPinchAtPoint:pointOne andPoint:pointTwo withDistance:distance];
 }
 
 - (void) view:(SG3DOverlayView*)view ARPullAtPoint:(CGPoint)pointOne andPoint:(CGPoint)pointTwo withDistance:(CGFloat)distance
 {
     SGLog(@"SGGesture - Pull at %f,%f and %f,%f", pointOne.x, pointOne.y, pointTwo.x, pointTwo.y);
     
-    [self moveCameraForward:YES withDistance:cameraStepDistance * kSGMeter];
-    
-    for(id<SGARResponder> responder in responders)
-        if([responder respondsToSelector:@selector(ARPullAtPoint:andPoint:withDistance:)])
-            [responder ARPullAtPoint:pointOne andPoint:pointTwo withDistance:distance];
+    for(id<SGARResponder> responder in responderTables[kSGResponderEvent_Pull])
+        [responder ARPullAtPoint:pointOne andPoint:pointTwo withDistance:distance];
+}
+
+- (void) view:(SG3DOverlayView*)view ARZoomWithVelocity:(CGFloat)velocity duration:(NSTimeInterval)duration
+{
+    // The camera takes a step for every few pixels that the fingers spread
+    [self moveCameraForward:velocity > 0.0f
+               withDistance:fabsf(velocity) * duration / kSGPinchStepLength * cameraStepDistance * kSGMeter];
 }
 
 - (void) view:(SG3DOverlayView*)view ARSingleTapAtPoint:(CGPoint)pointOne andPoint:(CGPoint)pointTwo
@@ -318,9 +550,8 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
     
     [self moveCameraForward:NO withDistance:cameraStepDistance * kSGMeter * 5.0];
 
-    for(id<SGARResponder> responder in responders)
-        if([responder respondsToSelector:@selector(ARSingleTapAtPoint:andPoint:)])
-           [responder ARSingleTapAtPoint:pointOne andPoint:pointTwo];
+    for(id<SGARResponder> responder in responderTables[kSGResponderEvent_TwoFingerTap])
+        [responder ARSingleTapAtPoint:pointOne andPoint:pointTwo];
             
 }
 
@@ -328,18 +559,16 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
 {
     SGLog(@"SGGesture - Horizontal swipe at %f,%f to %f,%f", fromPoint.x, fromPoint.y, toPoint.x, toPoint.y);
     
-    for(id<SGARResponder> responder in responders)
-        if([responder respondsToSelector:@selector(ARHorizontalSwipeAtPoint:toPoint:)])
-           [responder ARHorizontalSwipeAtPoint:fromPoint toPoint:toPoint];
+    for(id<SGARResponder> responder in responderTables[kSGResponderEvent_HorizontalSwipe])
+        [responder ARHorizontalSwipeAtPoint:fromPoint toPoint:toPoint];
 }
 
 - (void) view:(SG3DOverlayView*)view ARVerticalSwipeAtPoint:(CGPoint)fromPoint toPoint:(CGPoint)toPoint
 {
     SGLog(@"SGGesture - Vertical swipe at %f,%f to %f,%f", fromPoint.x, fromPoint.y, toPoint.x, toPoint.y);
     
-    for(id<SGARResponder> responder in responders)
-        if([responder respondsToSelector:@selector(ARVerticalSwipeAtPoint:toPoint:)])
-            [responder ARVerticalSwipeAtPoint:fromPoint toPoint:toPoint];
+    for(id<SGARResponder> responder in responderTables[kSGResponderEvent_VerticalSwipe])
+        [responder ARVerticalSwipeAtPoint:fromPoint toPoint:toPoint];
 }
 
 - (void) view:(SG3DOverlayView*)view ARMoveFromPoint:(CGPoint)fromPoint toPoint:(CGPoint)toPoint
@@ -358,9 +587,8 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
         [arView.movableStack addAnnotationView:annotationView];                
     }
 
-    for(id<SGARResponder> responder in responders)
-        if([responder respondsToSelector:@selector(ARMoveFromPoint:toPoint:)])
-            [responder ARMoveFromPoint:fromPoint toPoint:toPoint];
+    for(id<SGARResponder> responder in responderTables[kSGResponderEvent_Move])
+        [responder ARMoveFromPoint:fromPoint toPoint:toPoint];
 }
 
 - (void) view:(SG3DOverlayView*)view ARMoveEndedAtPoint:(CGPoint)point
@@ -383,98 +611,362 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
 #pragma mark UIAccelerometer delegate methods
 
 - (void) accelerometer:(UIAccelerometer*)accelerometer didAccelerate:(UIAcceleration*)acceleration
+{
+    SGSensorSample sample;
+    sample.timestamp = acceleration.timestamp;
+    sample.values[kSGAccelerationSample_X] = acceleration.x;
+    sample.values[kSGAccelerationSample_Y] = acceleration.y;
+    sample.values[kSGAccelerationSample_Z] = acceleration.z;
+    SGSensorRingPush(&accelerationRing, &sample);
+}
+
+#pragma mark -
+#pragma mark CLLocationManager delegate methods 
+ 
+- (void) locationManager:(CLLocationManager*)manager didUpdateToLocation:(CLLocation*)newLocation fromLocation:(CLLocation*)oldLocation
+{
+    // Dates are moved onto the clock of the accelerometer so the streams can be ordered
+    SGSensorSample sample;
+    sample.timestamp = CACurrentMediaTime() + [newLocation.timestamp timeIntervalSinceNow];
+    sample.values[kSGLocationSample_Latitude] = newLocation.coordinate.latitude;
+    sample.values[kSGLocationSample_Longitude] = newLocation.coordinate.longitude;
+    sample.values[kSGLocationSample_Altitude] = newLocation.altitude;
+    sample.values[kSGLocationSample_HorizontalAccuracy] = newLocation.horizontalAccuracy;
+    sample.values[kSGLocationSample_VerticalAccuracy] = newLocation.verticalAccuracy;
+    sample.values[kSGLocationSample_Timestamp] = [newLocation.timestamp timeIntervalSinceReferenceDate];
+    SGSensorRingPush(&locationRing, &sample);
+}
+
+- (void) locationManager:(CLLocationManager*)manager didFailWithError:(NSError*)error
+{
+    SGLog(@"SG3DOverlayEnvironment - Unable to retreive location");
+}
+
+- (void) locationManager:(CLLocationManager*)manager didUpdateHeading:(CLHeading*)newHeading
+{
+    SGSensorSample sample;
+    sample.timestamp = CACurrentMediaTime() + [newHeading.timestamp timeIntervalSinceNow];
+    sample.values[kSGHeadingSample_TrueHeading] = newHeading.trueHeading;
+    sample.values[kSGHeadingSample_Accuracy] = newHeading.headingAccuracy;
+    SGSensorRingPush(&headingRing, &sample);
+}
+
+#pragma mark -
+#pragma mark Sensor methods 
+
+- (void) drainSensors
+{
+    SGSensorRing* rings[3] = {&accelerationRing, &headingRing, &locationRing};
+    const SGSensorSample* oldest;
+    SGSensorSample sample;
+    double earliest = 0.0;
+    int next;
+    
+    // The samples of the three streams are merged by their timestamps
+    // so that a heading is corrected with the roll at its own time.
+    while(1) {
+        next = -1;
+        for(int i = 0; i < 3; i++) {
+            oldest = SGSensorRingPeek(rings[i]);
+            if(oldest && (next < 0 || oldest->timestamp < earliest)) {
+                next = i;
+                earliest = oldest->timestamp;
+            }
+        }
+        
+        if(next < 0 || !SGSensorRingPop(rings[next], &sample))
+            break;
+        
+        if(next == 0)
+            [self addAccelerationSample:&sample];
+        else if(next == 1)
+            [self addHeadingSample:&sample];
+        else
+            [self addLocationSample:&sample];
+    }
+}
+
+- (void) addAccelerationSample:(const SGSensorSample*)sample
 {
     double kAccelerationThreshold = 2.2;
     
-    if(fabsf(acceleration.x) > kAccelerationThreshold || fabsf(acceleration.y) > kAccelerationThreshold || fabsf(acceleration.z) > kAccelerationThreshold)
+    double x = sample->values[kSGAccelerationSample_X];
+    double y = sample->values[kSGAccelerationSample_Y];
+    double z = sample->values[kSGAccelerationSample_Z];
+    if(fabs(x) > kAccelerationThreshold || fabs(y) > kAccelerationThreshold || fabs(z) > kAccelerationThreshold)
         [self ARViewDidShake:nil];
     else {
-        [filter addAcceleration:acceleration];
+        [filter addAccelerationX:x y:y z:z];
     
         pitch = filter.z;
         roll = filter.x;
         yaw = filter.y;
+        
+        SGOrientationPredictorAddSample(&orientationPredictor, kSGOrientationAxis_Pitch, sample->timestamp, pitch);
+        SGOrientationPredictorAddSample(&orientationPredictor, kSGOrientationAxis_Roll, sample->timestamp, roll);
     }
 }
 
-#pragma mark -
-#pragma mark CLLocationManager delegate methods 
- 
-- (void) locationManager:(CLLocationManager*)manager didUpdateToLocation:(CLLocation*)newLocation fromLocation:(CLLocation*)oldLocation
+- (void) addHeadingSample:(const SGSensorSample*)sample
 {
-    if(currentLocation)
-        [currentLocation release];
+    heading = sample->values[kSGHeadingSample_TrueHeading];
+    heading += -90.0 * roll;
     
-    currentLocation = [newLocation retain];
+    SGOrientationPredictorAddSample(&orientationPredictor, kSGOrientationAxis_Heading, sample->timestamp, heading);
 }
 
-- (void) locationManager:(CLLocationManager*)manager didFailWithError:(NSError*)error
+- (void) addLocationSample:(const SGSensorSample*)sample
 {
-    SGLog(@"SG3DOverlayEnvironment - Unable to retreive location");
+    SGLocationFix fix;
+    fix.latitude = sample->values[kSGLocationSample_Latitude];
+    fix.longitude = sample->values[kSGLocationSample_Longitude];
+    fix.horizontalAccuracy = sample->values[kSGLocationSample_HorizontalAccuracy];
+    fix.timestamp = sample->values[kSGLocationSample_Timestamp];
+    
+    // Jitter and outliers stop here. The scene is only re-projected
+    // once the device has actually moved.
+    if(!SGLocationFilterAddFix(&locationFilter, &fix))
+        return;
+    
+    hasLocation = YES;
+    locationCoordinate.latitude = locationFilter.latitude;
+    locationCoordinate.longitude = locationFilter.longitude;
+    locationAltitude = sample->values[kSGLocationSample_Altitude];
+    locationAccuracy = SGLocationFilterAccuracy(&locationFilter);
+    sceneRevision++;
+    annotationViewsNeedSort = YES;
 }
 
-- (void) locationManager:(CLLocationManager*)manager didUpdateHeading:(CLHeading*)newHeading
+- (void) updateOrientationTrace
 {
-    heading = newHeading.trueHeading;
-    heading += -90.0 * roll;
+    NSString* path = arView.orientationTracePath;
+    if(path == orientationTracePath || [path isEqualToString:orientationTracePath])
+        return;
+    
+    if(orientationPredictor.trace)
+        fclose(orientationPredictor.trace);
+    orientationPredictor.trace = path ? fopen([path fileSystemRepresentation], "w") : NULL;
+    if(path && !orientationPredictor.trace)
+        SGLog(@"SG3DOverlayEnvironment - Unable to record the orientation trace to %@", path);
+    
+    [orientationTracePath release];
+    orientationTracePath = [path copy];
+}
+
+- (double) orientationErrorWithFunction:(double (*)(const SGOrientationPredictor*, int))function
+{
+    // Pitch and roll are in g, which the camera turns by 90 degrees
+    double headingError = function(&orientationPredictor, kSGOrientationAxis_Heading);
+    double pitchError = 90.0 * function(&orientationPredictor, kSGOrientationAxis_Pitch);
+    double rollError = 90.0 * function(&orientationPredictor, kSGOrientationAxis_Roll);
+    return sqrt((headingError * headingError + pitchError * pitchError + rollError * rollError) / 3.0);
+}
+
+- (NSTimeInterval) orientationPredictionHorizon
+{
+    return orientationPredictor.horizon;
+}
+
+- (double) orientationPredictionError
+{
+    return [self orientationErrorWithFunction:SGOrientationPredictorError];
+}
+
+- (double) orientationHoldError
+{
+    return [self orientationErrorWithFunction:SGOrientationPredictorHoldError];
 }
 
 #pragma mark -
 #pragma mark Draw methods 
 
+- (void) prepareScene
+{
+    // A single core never starts a thread of the pool
+    if(!taskPool) {
+        taskPool = SGTaskPoolNew(0);
+        annotationStore->taskPool = taskPool;
+    }
+    
+    snapshot = NULL;
+    if(arView.enableConcurrentScenePreparation) {
+        if(!sceneWorker) {
+            sceneWorker = SGSceneWorkerNew();
+            if(sceneWorker)
+                sceneWorker->scene->taskPool = taskPool;
+        }
+        
+        // The latest frame that the worker has finished
+        if(sceneWorker)
+            snapshot = SGSceneWorkerAcquire(sceneWorker);
+    } else if(sceneWorker) {
+        SGSceneWorkerFree(sceneWorker);
+        sceneWorker = NULL;
+    }
+    
+    // Before the worker has finished its first frame, or without
+    // a worker, the frame is prepared here.
+    if(!snapshot) {
+        if(!scene) {
+            scene = SGSceneNew();
+            scene->taskPool = taskPool;
+        }
+        
+        [self fillSceneInput:&sceneInput framesAhead:0];
+        SGScenePrepare(scene, &sceneInput, &sceneSnapshot);
+        snapshot = &sceneSnapshot;
+    }
+}
+
+- (void) submitScene
+{
+    // The worker prepares the next frame while this one is on screen,
+    // so its camera is predicted a frame further ahead.
+    if(sceneWorker) {
+        [self fillSceneInput:SGSceneWorkerBeginInput(sceneWorker) framesAhead:1];
+        SGSceneWorkerCommitInput(sceneWorker);
+    }
+}
+
+- (void) fillSceneInput:(SGSceneInput*)input framesAhead:(int)framesAhead
+{
+    if(hasLocation)
+        SGSceneInputCopyStore(input, annotationStore);
+    else
+        input->count = 0;
+    
+    input->frame = ++sceneFrame;
+    
+    // Capturing a view changes a flag of the store but not sceneRevision
+    input->revision = sceneRevision + annotationStore->flagRevision;
+    
+    SGSceneCamera* camera = &input->camera;
+    if(arView.enableOrientationPrediction) {
+        double presentTime = SGOrientationPredictorPresentTime(&orientationPredictor, framesAhead);
+        camera->pitch = SGOrientationPredictorPredict(&orientationPredictor, kSGOrientationAxis_Pitch, presentTime);
+        camera->roll = SGOrientationPredictorPredict(&orientationPredictor, kSGOrientationAxis_Roll, presentTime);
+        camera->heading = SGOrientationPredictorPredict(&orientationPredictor, kSGOrientationAxis_Heading, presentTime);
+    } else {
+        camera->pitch = pitch;
+        camera->roll = roll;
+        camera->heading = heading;
+    }
+    camera->x = cameraXCoord;
+    camera->z = cameraZCoord;
+    camera->height = yEyePosition;
+    camera->fovy = fovy;
+    camera->zNear = 0.5f;
+    camera->zFar = kSGSphere_Radius + 10.0f;
+    memcpy(camera->viewport, viewport, sizeof(camera->viewport));
+    
+    input->clustering = arView.enableClustering;
+    input->clusterTolerance = arView.clusterTolerance;
+    input->clusterCellSize = kSGCluster_CellSize;
+    input->decluttering = arView.enableDecluttering;
+    input->touchScale = kSGSphere_Radius / 2.0f;
+    
+    SGRadar* radar = arView.existingRadar;
+    if(radar && !radar.hidden) {
+        input->radarWidth = radar.bounds.size.width;
+        input->radarHeight = radar.bounds.size.height;
+        input->radarScale = (radar.frame.size.width / 2.0f) / kSGSphere_Radius;
+        input->radarOffsetX = radar.walkingOffset.x;
+        input->radarOffsetY = radar.walkingOffset.y;
+    } else
+        input->radarWidth = 0.0f;
+}
+
 - (void) drawLocatableObjects
 {
-    if(currentLocation) {
-        GLfloat xCoord, zCoord, yCoord, bearing;
-        double distance;
-        SGTexture* texture;
-        id<MKAnnotation> annotation;
-        for(SGAnnotationView* annotationView in annotationViews) {
-            annotation = annotationView.annotation;
-            if(annotation && !annotationView.isCaptured) {                
-                bearing = [currentLocation getBearingFromCoordinate:annotation.coordinate] - 90.0;
-                distance = [self getAnnotationViewDistance:annotationView];
-                
-                zCoord = distance * sin(DEGREES_TO_RADIANS(bearing));
-                xCoord = distance * cos(DEGREES_TO_RADIANS(bearing));
-                yCoord = kSGMeter * annotationView.altitude;
-                
-                glPushMatrix();
-                
-                glTranslatef(xCoord, yCoord, zCoord);
-                glRotatef(-(bearing + 90.0), 0.0, 1.0, 0.0);
-                
-                // If the texture becomes to close to the camera, we need
-                // to scale it approprietly
-                if(distance < 3.0 * kSGMeter)
-                    glScalef(distance / 300.0f, distance / 300.0f, 1.0f);
-                
-                if(annotationView.enableOpenGL)
-                    [annotationView drawAnnotationView];
-                else {
-                    texture = annotationView.texture;
-            
-                    if(texture) {    
-                        glEnable(GL_TEXTURE_2D);
-                        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-                        [texture drawAtPoint:CGPointMake(0.0, -texture.size.height / 2.0)];
-                        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-                        glDisable(GL_TEXTURE_2D);
-                    }
-                }
-                
-                glPopMatrix();
-                
-                annotationView.bearing = bearing + 90.0;
-                annotationView.distance = distance;
-            
-                // Save later for touch calculations
-                annotationView.point->x = xCoord;
-                annotationView.point->y = yCoord;
-                annotationView.point->z = zCoord;
-            }                   
+    amountOfBillboards = 0;
+    if(hasLocation)
+        [self drawBillboards];
+    
+    amountOfMovedAnnotationViews = snapshot->moved;
+    amountOfHiddenAnnotationViews = snapshot->hidden;
+}
+
+- (void) drawBillboards
+{
+    SGAnnotationView* annotationView;
+    const SGSceneBillboard* billboard;
+    SGTexture* texture;
+    CGSize size;
+    GLfloat angle;
+    float sine, cosine;
+    int index;
+    for(int i = 0; i < snapshot->amountOfBillboards; i++) {
+        billboard = &snapshot->billboards[i];
+        if(billboard->hidden)
+            continue;
+        
+        // The entry may have been removed or captured since the frame was prepared
+        index = SGAnnotationStoreIndex(annotationStore, billboard->handle);
+        if(index < 0 || SGAnnotationStoreTestFlag(annotationStore, index, kSGAnnotationFlag_Captured))
+            continue;
+
+        annotationView = (SGAnnotationView*)annotationStore->objects[index];
+        angle = -(billboard->bearing + 90.0);
+        amountOfBillboards++;
+
+        glPushMatrix();
+
+        glTranslatef(billboard->x, billboard->y, billboard->z);
+        glRotatef(angle, 0.0, 1.0, 0.0);
+        glTranslatef(billboard->offsetX, billboard->offsetY, 0.0);
+
+        // If the texture becomes to close to the camera, we need
+        // to scale it approprietly
+        if(billboard->distance < 3.0 * kSGMeter)
+            glScalef(billboard->distance / 300.0f, billboard->distance / 300.0f, 1.0f);
+
+        [self drawTextureForAnnotationView:annotationView];
+
+        // Clusters are labeled with the amount of annotations that they hold
+        texture = annotationView.texture;
+        if(billboard->count > 1 && texture) {
+            SGTexture* badge = [self badgeTextureForCount:billboard->count];
+            SGGLStateEnable(GL_TEXTURE_2D);
+            SGGLStateEnableClientState(GL_TEXTURE_COORD_ARRAY);
+            [badge drawAtPoint:CGPointMake(texture.size.width / 2.0, 0.0)];
         }
 
+        glPopMatrix();
+
+        // Save later for decluttering and touch calculations
+        size = annotationView.enableOpenGL ? annotationView.bounds.size : texture.size;
+        annotationStore->widths[index] = size.width;
+        annotationStore->heights[index] = size.height;
+
+        SGFastSinCos(DEGREES_TO_RADIANS(angle), &sine, &cosine, kSGTrigAccuracy_Medium);
+        annotationView.point->x = billboard->x + billboard->offsetX * cosine;
+        annotationView.point->y = billboard->y + billboard->offsetY;
+        annotationView.point->z = billboard->z - billboard->offsetX * sine;
+    }
+    
+    // The grid lines of the next frame are drawn without texturing
+    SGGLStateDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    SGGLStateDisable(GL_TEXTURE_2D);
+}
+
+- (void) drawTextureForAnnotationView:(SGAnnotationView*)annotationView
+{
+    if(annotationView.enableOpenGL) {
+        // Views that draw themselves start without texturing and
+        // may leave any state behind.
+        SGGLStateDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        SGGLStateDisable(GL_TEXTURE_2D);
+        [annotationView drawAnnotationView];
+        SGGLStateInvalidate();
+    } else {
+        SGTexture* texture = annotationView.texture;
+        
+        // Texturing stays on from one billboard to the next
+        if(texture) {    
+            SGGLStateEnable(GL_TEXTURE_2D);
+            SGGLStateEnableClientState(GL_TEXTURE_COORD_ARRAY);
+            [texture drawAtPoint:CGPointMake(0.0, -texture.size.height / 2.0)];
+        }
     }
 }
 
@@ -485,8 +977,10 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
         if(!forward)
             bearing = 180.0 + bearing;
         
-        CGFloat zCoord = -distance * cos(DEGREES_TO_RADIANS(bearing));
-        CGFloat xCoord = distance * sin(DEGREES_TO_RADIANS(bearing));    
+        float sine, cosine;
+        SGFastSinCos(DEGREES_TO_RADIANS(bearing), &sine, &cosine, kSGTrigAccuracy_Medium);
+        CGFloat zCoord = -distance * cosine;
+        CGFloat xCoord = distance * sine;
     
         CGFloat futureCameraXCoord = cameraXCoord + xCoord;
         CGFloat futureCameraZCoord = cameraZCoord + zCoord;
@@ -507,53 +1001,20 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
 
 - (SGAnnotationView*) closestAnnotationViewForPoint:(CGPoint)point
 {
-    CGRect boundingBox;
-    CGPoint windowPoint;
-    CGFloat z, width, height, delta;
-    SGAnnotationView* closestView = nil;
-    for(SGAnnotationView* view in annotationViews) {
-        gluProject(view.point->x, view.point->y, view.point->z,
-                   modelMatrix, projectionMatrix, viewport,
-                   &windowPoint.x, &windowPoint.y, &z);
-        
-        windowPoint.y = viewport[3] - windowPoint.y;
-        
-        // Make sure the view is not captured and is on the correct
-        // side of the screen.
-        if(z < 1.0f && !view.isCaptured) {            
-            delta = (kSGSphere_Radius / 2.0) / view.distance;
-        
-            // Do some scaling based on the distance.
-            width = view.texture.size.width * delta;
-            height = view.texture.size.height * delta;
-
-            // Allows for a larger touch space
-            if(width < 40.0)
-                width = 40.0;
-            
-            if(height < 40.0)
-                height = 40.0;
-        
-            boundingBox = CGRectMake(windowPoint.x - (width / 2.0f), 
-                                     windowPoint.y,
-                                     width, 
-                                     height);
-        
-            // Check to see that the point is located in the bounding box
-            if(CGRectContainsPoint(boundingBox, point)) {
-                // Make sure to grab the closest view
-                if(!closestView || (closestView && closestView.distance < view.distance)) {
-                    SGLog(@"SG3DOverlayEnironment - View touched at %f %f", point.x, point.y);
-                    closestView = view;
-                }                
-            }
-        }
-    }
+    if(!snapshot)
+        return nil;
     
-    return closestView;
+    // Touches are tested against the frame that is on screen
+    const SGSceneBillboard* billboard = SGSceneSnapshotTouch(snapshot, point.x, point.y);
+    int index = billboard ? SGAnnotationStoreIndex(annotationStore, billboard->handle) : -1;
+    if(index < 0 || SGAnnotationStoreTestFlag(annotationStore, index, kSGAnnotationFlag_Captured))
+        return nil;
+    
+    SGLog(@"SG3DOverlayEnironment - View touched at %f %f", point.x, point.y);
+    return (SGAnnotationView*)annotationStore->objects[index];
 }
 
-- (SGPoint3*) unprojectWindowPoint:(CGPoint)winPos
+- (SGPoint3) unprojectWindowPoint:(CGPoint)winPos
 {
     //opengl origin is at the bottom not at the top
     winPos.y = (float)viewport[3] - winPos.y;
@@ -603,47 +1064,117 @@ int sortRecordByDistance(id view1, id view2, void* blah) {
     fY += cY;
     fZ += cZ;
     
-    return V3New(fX, fY, fZ);
+    SGPoint3 point = { fX, fY, fZ };
+    return point;
 }
 
 - (void) sortAnnotationViews
 {
-    if(annotationViews && [annotationViews count]) {
-        // Calculate the distance from the current location
-        for(SGAnnotationView* annotationView in annotationViews)
-            annotationView.distance = [self getAnnotationViewDistance:annotationView];
-        
-        [annotationViews sortUsingFunction:sortRecordByDistance context:nil];
-    }
+    // Every entry is re-projected from the current location in
+    // a single pass over the store and then sorted again.
+    if(hasLocation)
+        SGAnnotationStoreSetOrigin(annotationStore, locationCoordinate.latitude, locationCoordinate.longitude);
+    else
+        SGAnnotationStoreSort(annotationStore);
+    
+    sceneRevision++;
+    annotationViewsNeedSort = NO;
 }
 
-- (double) getAnnotationViewDistance:(SGAnnotationView*)annotationView
+- (void) applyAnnotationViewChanges
 {
-    CLLocation* viewLocation = [[CLLocation alloc] initWithLatitude:annotationView.annotation.coordinate.latitude 
-                                                           longitude:annotationView.annotation.coordinate.longitude];
+    // This is paid once per location update instead of every frame
+    if(annotationViewsNeedSort)
+        [self sortAnnotationViews];
+    
+    if(![insertedAnnotationViews count] && ![removedAnnotationViews count] && ![updatedAnnotationViews count])
+        return;
     
-    // The distance returned is in meters; however, we want to convert them
-    // into the metric that we are using.
-    double distance = [currentLocation distanceToLocation:viewLocation] * kSGMeter;    
-    if(distance > kSGAnnotation_MaximumDistance)
-        distance = kSGAnnotation_MaximumDistance;
-    else if(distance < kSGAnnotation_MinimumDistance)
-        distance = kSGAnnotation_MinimumDistance;
+    for(SGAnnotationView* annotationView in removedAnnotationViews)
+        [self removeLocatableObject:annotationView];
     
-    [viewLocation release];
+    CLLocationCoordinate2D coordinate;
+    for(SGAnnotationView* annotationView in updatedAnnotationViews) {
+        coordinate = annotationView.annotation.coordinate;
+        SGAnnotationStoreMove(annotationStore, annotationView.handle, coordinate.latitude, coordinate.longitude,
+                              annotationView.altitude);
+        SGAnnotationStoreSetFlag(annotationStore, annotationView.handle, kSGAnnotationFlag_Hidden, !annotationView.annotation);
+    }
     
-    return distance;
+    for(SGAnnotationView* annotationView in insertedAnnotationViews)
+        [self addAnnotationView:annotationView];
+    
+    SGRadar* radar = arView.existingRadar;
+    if(radar) {
+        [radar removeAnnotationViews:removedAnnotationViews];
+        [radar insertAnnotationViews:insertedAnnotationViews];
+    }
+    
+    [insertedAnnotationViews removeAllObjects];
+    [removedAnnotationViews removeAllObjects];
+    [updatedAnnotationViews removeAllObjects];
+    
+    // Removing an entry moves the last one into its place
+    sceneRevision++;
+}
+
+- (SGTexture*) badgeTextureForCount:(int)count
+{
+    const void* key = (const void*)(intptr_t)count;
+    SGTexture* badge = (SGTexture*)CFDictionaryGetValue(clusterBadges, key);
+    if(!badge) {
+        NSString* text = [NSString stringWithFormat:@"%i", count];
+        UIFont* font = [UIFont boldSystemFontOfSize:14.0];
+        CGSize textSize = [text sizeWithFont:font];
+        CGSize size = CGSizeMake(textSize.width + 12.0 > 24.0 ? textSize.width + 12.0 : 24.0, 24.0);
+        
+        UIGraphicsBeginImageContext(size);
+        [[UIColor redColor] setFill];
+        [[UIBezierPath bezierPathWithRoundedRect:CGRectMake(0.0, 0.0, size.width, size.height)
+                                    cornerRadius:size.height / 2.0] fill];
+        [[UIColor whiteColor] set];
+        [text drawAtPoint:CGPointMake((size.width - textSize.width) / 2.0, (size.height - textSize.height) / 2.0)
+                 withFont:font];
+        UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+        UIGraphicsEndImageContext();
+        
+        badge = [[[SGTexture alloc] initWithImage:image] autorelease];
+        if(badge)
+            CFDictionarySetValue(clusterBadges, key, badge);
+    }
+    
+    return badge;
 }
 
 - (void) dealloc
 {
-    [locationManager release];
+    // The radar and the worker are let go of while arView is still held
+    if(snapshot)
+        arView.existingRadar.sceneSnapshot = NULL;
+    SGSceneWorkerFree(sceneWorker);
+    SGSceneFree(scene);
+    SGTaskPoolFree(taskPool);
+    
+    [sensorManager release];
     [responders release];
+    for(int i = 0; i < kSGResponderEvent_Count; i++)
+        [responderTables[i] release];
     [arView release];
     [filter release];
-    [currentLocation release];
-    [annotationViews release];
+    [tentativeInspectedView release];
+    [self removeAllAnnotationViews];
+    SGAnnotationStoreFree(annotationStore);
     [containers release];
+    [insertedAnnotationViews release];
+    [removedAnnotationViews release];
+    [updatedAnnotationViews release];
+    CFRelease(clusterBadges);
+    
+    SGSceneInputDestroy(&sceneInput);
+    SGSceneSnapshotDestroy(&sceneSnapshot);
+    if(orientationPredictor.trace)
+        fclose(orientationPredictor.trace);
+    [orientationTracePath release];
         
     [super dealloc];
 }
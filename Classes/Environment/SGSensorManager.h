@@ -0,0 +1,160 @@
+//
+//  SGSensorManager.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import <UIKit/UIKit.h>
+#import <CoreLocation/CoreLocation.h>
+
+/* counts callbacks over a sliding window of one minute */
+typedef struct SGCallbackCounterStruct {
+    double windowStart;
+    unsigned int current;
+    unsigned int previous;
+} SGCallbackCounter;
+
+/*!
+* @protocol SGSensorManagerDelegate
+* @abstract Receives the sensor callbacks that are forwarded by a
+* @link //simplegeo/ooc/cl/SGSensorManager SGSensorManager @/link.
+*/
+@protocol SGSensorManagerDelegate <UIAccelerometerDelegate, CLLocationManagerDelegate>
+
+@end
+
+/*!
+* @class SGSensorManager
+* @abstract Owns the accelerometer, location and heading updates that drive the AR enviornment.
+* @discussion The sensors only run while the manager is both started and visible. The accelerometer
+* is sampled at a high rate while the device is moving and at a low rate once it has been still for a while.
+* Since lowpass filters are tuned to the high rate, they smooth more heavily while the device is still.
+* Location updates use the best accuracy while the device is moving or while walking is enabled;
+* otherwise they are relaxed to the nearest ten meters.
+*/
+@interface SGSensorManager : NSObject <UIAccelerometerDelegate, CLLocationManagerDelegate> {
+    
+    id<SGSensorManagerDelegate> delegate;
+    CLLocationManager* locationManager;
+    
+    BOOL visible;
+    BOOL walking;
+    
+    @private
+    BOOL started;
+    BOOL running;
+    
+    BOOL moving;
+    double lastMotionTime;
+    double motionEnergy;
+    UIAccelerationValue gravity[3];
+    double accelerometerRate;
+    
+    SGCallbackCounter accelerometerCounter;
+    SGCallbackCounter locationCounter;
+    SGCallbackCounter headingCounter;
+}
+
+/*!
+* @property delegate
+* @abstract The object that the sensor callbacks are forwarded to.
+*/
+@property (nonatomic, assign) id<SGSensorManagerDelegate> delegate;
+
+/*!
+* @property locationManager
+* @abstract The location manager that provides location and heading updates.
+*/
+@property (nonatomic, readonly) CLLocationManager* locationManager;
+
+/*!
+* @property visible
+* @abstract Whether the AR view is on screen. The sensors are stopped while this is NO. The default is YES.
+*/
+@property (nonatomic, assign) BOOL visible;
+
+/*!
+* @property walking
+* @abstract Whether the user is expected to walk around. Keeps location updates at the best accuracy
+* and the accelerometer at the high rate. The default is NO.
+*/
+@property (nonatomic, assign) BOOL walking;
+
+/*!
+* @property isRunning
+* @abstract Whether the sensors are currently delivering updates.
+*/
+@property (nonatomic, readonly, getter=isRunning) BOOL running;
+
+/*!
+* @property isMoving
+* @abstract Whether the accelerometer has detected that the device is moving.
+*/
+@property (nonatomic, readonly, getter=isMoving) BOOL moving;
+
+/*!
+* @property accelerometerRate
+* @abstract The rate, in Hz, that the accelerometer is currently sampled at.
+*/
+@property (nonatomic, readonly) double accelerometerRate;
+
+/*!
+* @property accelerometerCallbacksPerMinute
+* @abstract The amount of accelerometer callbacks that were received over the last minute.
+*/
+@property (nonatomic, readonly) double accelerometerCallbacksPerMinute;
+
+/*!
+* @property locationCallbacksPerMinute
+* @abstract The amount of location callbacks that were received over the last minute.
+*/
+@property (nonatomic, readonly) double locationCallbacksPerMinute;
+
+/*!
+* @property headingCallbacksPerMinute
+* @abstract The amount of heading callbacks that were received over the last minute.
+*/
+@property (nonatomic, readonly) double headingCallbacksPerMinute;
+
+/*!
+* @method start
+* @abstract Starts the accelerometer, location and heading updates.
+* @discussion If the manager is not @link visible visible @/link, the sensors are started once it becomes visible.
+*/
+- (void) start;
+
+/*!
+* @method stop
+* @abstract Stops all sensor updates.
+*/
+- (void) stop;
+
+@end
@@ -0,0 +1,284 @@
+//
+//  SGSensorManager.m
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGSensorManager.h"
+
+#define kSGSensor_HighAccelerometerRate     30.0
+#define kSGSensor_LowAccelerometerRate      10.0
+#define kSGSensor_GravityFilter             0.1
+#define kSGSensor_MotionFilter              0.2
+#define kSGSensor_MotionThreshold           0.002       /* g squared */
+#define kSGSensor_StillDelay                3.0         /* seconds */
+#define kSGSensor_StillDistanceFilter       10.0        /* meters */
+#define kSGCallbackCounterWindow            60.0        /* seconds */
+
+static void SGCallbackCounterReset(SGCallbackCounter* counter, double now) {
+    counter->windowStart = now;
+    counter->current = 0;
+    counter->previous = 0;
+}
+
+static void SGCallbackCounterRoll(SGCallbackCounter* counter, double now) {
+    double elapsed = now - counter->windowStart;
+    if(elapsed >= kSGCallbackCounterWindow) {
+        counter->previous = elapsed >= 2.0 * kSGCallbackCounterWindow ? 0 : counter->current;
+        counter->current = 0;
+        counter->windowStart += floor(elapsed / kSGCallbackCounterWindow) * kSGCallbackCounterWindow;
+    }
+}
+
+static void SGCallbackCounterAdd(SGCallbackCounter* counter, double now) {
+    SGCallbackCounterRoll(counter, now);
+    counter->current++;
+}
+
+static double SGCallbackCounterRate(SGCallbackCounter* counter, double now) {
+    SGCallbackCounterRoll(counter, now);
+    
+    // The previous window is weighed by how much of it still
+    // falls within the last minute.
+    double fraction = (now - counter->windowStart) / kSGCallbackCounterWindow;
+    return counter->previous * (1.0 - fraction) + counter->current;
+}
+
+@interface SGSensorManager (Private)
+
+- (void) updateSensors;
+- (void) startSensors;
+- (void) stopSensors;
+- (void) detectMotion:(UIAcceleration*)acceleration;
+
+@end
+
+@implementation SGSensorManager
+@synthesize delegate, locationManager, visible, walking, running, moving, accelerometerRate;
+@dynamic accelerometerCallbacksPerMinute, locationCallbacksPerMinute, headingCallbacksPerMinute;
+
+- (id) init
+{
+    if(self = [super init]) {
+        delegate = nil;
+        
+        locationManager = [[CLLocationManager alloc] init];
+        locationManager.delegate = self;
+        
+        visible = YES;
+        walking = NO;
+        started = NO;
+        running = NO;
+        
+        moving = YES;
+        lastMotionTime = 0.0;
+        motionEnergy = 0.0;
+        gravity[0] = gravity[1] = gravity[2] = 0.0;
+        accelerometerRate = kSGSensor_HighAccelerometerRate;
+        
+        double now = CFAbsoluteTimeGetCurrent();
+        SGCallbackCounterReset(&accelerometerCounter, now);
+        SGCallbackCounterReset(&locationCounter, now);
+        SGCallbackCounterReset(&headingCounter, now);
+    }
+    
+    return self;
+}
+
+#pragma mark -
+#pragma mark Accessor methods 
+
+- (void) setVisible:(BOOL)isVisible
+{
+    visible = isVisible;
+    [self updateSensors];
+}
+
+- (void) setWalking:(BOOL)isWalking
+{
+    walking = isWalking;
+    [self updateSensors];
+}
+
+- (double) accelerometerCallbacksPerMinute
+{
+    return SGCallbackCounterRate(&accelerometerCounter, CFAbsoluteTimeGetCurrent());
+}
+
+- (double) locationCallbacksPerMinute
+{
+    return SGCallbackCounterRate(&locationCounter, CFAbsoluteTimeGetCurrent());
+}
+
+- (double) headingCallbacksPerMinute
+{
+    return SGCallbackCounterRate(&headingCounter, CFAbsoluteTimeGetCurrent());
+}
+
+#pragma mark -
+#pragma mark Lifecycle methods 
+
+- (void) start
+{
+    started = YES;
+    [self updateSensors];
+}
+
+- (void) stop
+{
+    started = NO;
+    [self updateSensors];
+}
+
+- (void) updateSensors
+{
+    if(started && visible) {
+        if(!running)
+            [self startSensors];
+        
+        double rate = (moving || walking) ? kSGSensor_HighAccelerometerRate : kSGSensor_LowAccelerometerRate;
+        if(rate != accelerometerRate) {
+            accelerometerRate = rate;
+            [[UIAccelerometer sharedAccelerometer] setUpdateInterval:(1.0 / accelerometerRate)];
+        }
+        
+        // Small changes in location hardly matter while standing still
+        if(moving || walking) {
+            locationManager.desiredAccuracy = kCLLocationAccuracyBest;
+            locationManager.distanceFilter = kCLDistanceFilterNone;
+        } else {
+            locationManager.desiredAccuracy = kCLLocationAccuracyNearestTenMeters;
+            locationManager.distanceFilter = kSGSensor_StillDistanceFilter;
+        }
+    } else if(running)
+        [self stopSensors];
+}
+
+- (void) startSensors
+{
+    running = YES;
+    
+    // Assume motion until the accelerometer says otherwise
+    moving = YES;
+    lastMotionTime = CFAbsoluteTimeGetCurrent();
+    motionEnergy = 0.0;
+    gravity[0] = gravity[1] = gravity[2] = 0.0;
+    
+    [[UIAccelerometer sharedAccelerometer] setUpdateInterval:(1.0 / accelerometerRate)];
+    [[UIAccelerometer sharedAccelerometer] setDelegate:self];
+    
+    locationManager.delegate = self;
+    [locationManager startUpdatingHeading];
+    [locationManager startUpdatingLocation];
+}
+
+- (void) stopSensors
+{
+    running = NO;
+    
+    if([UIAccelerometer sharedAccelerometer].delegate == self)
+        [[UIAccelerometer sharedAccelerometer] setDelegate:nil];
+    
+    [locationManager stopUpdatingHeading];
+    [locationManager stopUpdatingLocation];
+}
+
+- (void) detectMotion:(UIAcceleration*)acceleration
+{
+    double now = CFAbsoluteTimeGetCurrent();
+    UIAccelerationValue values[3] = {acceleration.x, acceleration.y, acceleration.z};
+    
+    // Whatever is left once gravity has been removed is motion
+    double energy = 0.0;
+    double delta;
+    for(int i = 0; i < 3; i++) {
+        gravity[i] += kSGSensor_GravityFilter * (values[i] - gravity[i]);
+        delta = values[i] - gravity[i];
+        energy += delta * delta;
+    }
+    
+    motionEnergy += kSGSensor_MotionFilter * (energy - motionEnergy);
+    
+    BOOL wasMoving = moving;
+    if(motionEnergy > kSGSensor_MotionThreshold) {
+        moving = YES;
+        lastMotionTime = now;
+    } else if(now - lastMotionTime > kSGSensor_StillDelay)
+        moving = NO;
+    
+    if(moving != wasMoving)
+        [self updateSensors];
+}
+
+#pragma mark -
+#pragma mark Sensor delegate methods 
+
+- (void) accelerometer:(UIAccelerometer*)accelerometer didAccelerate:(UIAcceleration*)acceleration
+{
+    SGCallbackCounterAdd(&accelerometerCounter, CFAbsoluteTimeGetCurrent());
+    [self detectMotion:acceleration];
+    
+    if([delegate respondsToSelector:@selector(accelerometer:didAccelerate:)])
+        [delegate accelerometer:accelerometer didAccelerate:acceleration];
+}
+
+- (void) locationManager:(CLLocationManager*)manager didUpdateToLocation:(CLLocation*)newLocation fromLocation:(CLLocation*)oldLocation
+{
+    SGCallbackCounterAdd(&locationCounter, CFAbsoluteTimeGetCurrent());
+    
+    if([delegate respondsToSelector:@selector(locationManager:didUpdateToLocation:fromLocation:)])
+        [delegate locationManager:manager didUpdateToLocation:newLocation fromLocation:oldLocation];
+}
+
+- (void) locationManager:(CLLocationManager*)manager didUpdateHeading:(CLHeading*)newHeading
+{
+    SGCallbackCounterAdd(&headingCounter, CFAbsoluteTimeGetCurrent());
+    
+    if([delegate respondsToSelector:@selector(locationManager:didUpdateHeading:)])
+        [delegate locationManager:manager didUpdateHeading:newHeading];
+}
+
+- (void) locationManager:(CLLocationManager*)manager didFailWithError:(NSError*)error
+{
+    if([delegate respondsToSelector:@selector(locationManager:didFailWithError:)])
+        [delegate locationManager:manager didFailWithError:error];
+}
+
+- (void) dealloc
+{
+    [self stopSensors];
+    locationManager.delegate = nil;
+    [locationManager release];
+    
+    [super dealloc];
+}
+
+@end
@@ -0,0 +1,202 @@
+//
+//  SGAllocationTracker.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGAllocationTracker.h"
+
+#import <pthread.h>
+#import <stdio.h>
+#import <string.h>
+
+#ifdef __APPLE__
+#import <malloc/malloc.h>
+#import <mach/mach.h>
+#endif
+
+static SGAllocationTracking mode = kSGAllocationTracking_None;
+static SGAllocationCounts counts;
+static pthread_t frameThread;
+static volatile int inFrame = 0;
+
+/* the counts of the pass that the calling thread is in, if any */
+static pthread_key_t passKey;
+static pthread_once_t passKeyOnce = PTHREAD_ONCE_INIT;
+static volatile int hasPassKey = 0;
+
+/* the hooks must not allocate themselves, so they only touch these counters */
+static int isWatched(void) {
+    return inFrame && mode != kSGAllocationTracking_None && pthread_equal(pthread_self(), frameThread);
+}
+
+static SGAllocationCounts* currentPass(void) {
+    if(!hasPassKey || mode == kSGAllocationTracking_None)
+        return NULL;
+    
+    return (SGAllocationCounts*)pthread_getspecific(passKey);
+}
+
+static void createPassKey(void) {
+    pthread_key_create(&passKey, NULL);
+    hasPassKey = 1;
+}
+
+void SGAllocationTrackerBreak(size_t size) {
+    // Keeps the call from being optimized away so a breakpoint can be set
+    __asm__ volatile("" : : "r"(size) : "memory");
+}
+
+void SGAllocationTrackerRecordAllocation(size_t size) {
+    SGAllocationCounts* target = isWatched() ? &counts : currentPass();
+    if(!target)
+        return;
+    
+    if(!target->allocations)
+        target->firstSize = size;
+    
+    target->allocations++;
+    target->bytes += size;
+    
+    if(mode == kSGAllocationTracking_Assert)
+        SGAllocationTrackerBreak(size);
+}
+
+void SGAllocationTrackerRecordFree(void) {
+    SGAllocationCounts* target = isWatched() ? &counts : currentPass();
+    if(target)
+        target->frees++;
+}
+
+#ifdef __APPLE__
+
+static malloc_zone_t originalZone;
+static int installed = 0;
+
+static void* trackedMalloc(malloc_zone_t* zone, size_t size) {
+    SGAllocationTrackerRecordAllocation(size);
+    return originalZone.malloc(zone, size);
+}
+
+static void* trackedCalloc(malloc_zone_t* zone, size_t amount, size_t size) {
+    SGAllocationTrackerRecordAllocation(amount * size);
+    return originalZone.calloc(zone, amount, size);
+}
+
+static void* trackedValloc(malloc_zone_t* zone, size_t size) {
+    SGAllocationTrackerRecordAllocation(size);
+    return originalZone.valloc(zone, size);
+}
+
+static void* trackedRealloc(malloc_zone_t* zone, void* pointer, size_t size) {
+    SGAllocationTrackerRecordAllocation(size);
+    return originalZone.realloc(zone, pointer, size);
+}
+
+static void trackedFree(malloc_zone_t* zone, void* pointer) {
+    if(pointer)
+        SGAllocationTrackerRecordFree();
+    originalZone.free(zone, pointer);
+}
+
+int SGAllocationTrackerInstall(void) {
+    if(installed)
+        return 1;
+    
+    malloc_zone_t* zone = malloc_default_zone();
+    memcpy(&originalZone, zone, sizeof(malloc_zone_t));
+    
+    // Newer zones are made read-only once they are created
+    int readOnly = zone->version >= 8;
+    vm_address_t page = (vm_address_t)zone & ~(vm_page_size - 1);
+    vm_size_t length = ((vm_address_t)zone + sizeof(malloc_zone_t)) - page;
+    if(readOnly && vm_protect(mach_task_self(), page, length, 0, VM_PROT_READ | VM_PROT_WRITE) != KERN_SUCCESS)
+        return 0;
+    
+    zone->malloc = trackedMalloc;
+    zone->calloc = trackedCalloc;
+    zone->valloc = trackedValloc;
+    zone->realloc = trackedRealloc;
+    zone->free = trackedFree;
+    
+    if(readOnly)
+        vm_protect(mach_task_self(), page, length, 0, VM_PROT_READ);
+    installed = 1;
+    
+    return 1;
+}
+
+#else
+
+int SGAllocationTrackerInstall(void) {
+    return 0;
+}
+
+#endif
+
+void SGAllocationTrackerSetMode(SGAllocationTracking newMode) {
+    mode = newMode;
+}
+
+void SGAllocationTrackerBeginFrame(void) {
+    memset(&counts, 0, sizeof(SGAllocationCounts));
+    frameThread = pthread_self();
+    inFrame = 1;
+}
+
+SGAllocationCounts SGAllocationTrackerEndFrame(void) {
+    inFrame = 0;
+    
+    return counts;
+}
+
+void SGAllocationTrackerBeginPass(SGAllocationCounts* passCounts) {
+    pthread_once(&passKeyOnce, createPassKey);
+    memset(passCounts, 0, sizeof(SGAllocationCounts));
+    pthread_setspecific(passKey, passCounts);
+}
+
+void SGAllocationTrackerEndPass(void) {
+    if(hasPassKey)
+        pthread_setspecific(passKey, NULL);
+}
+
+void SGAllocationTrackerMergePass(const SGAllocationCounts* passCounts) {
+    if(!isWatched())
+        return;
+    
+    if(!counts.allocations)
+        counts.firstSize = passCounts->firstSize;
+    
+    counts.allocations += passCounts->allocations;
+    counts.frees += passCounts->frees;
+    counts.bytes += passCounts->bytes;
+}
@@ -0,0 +1,91 @@
+//
+//  SGAllocationTracker.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import <stdlib.h>
+
+/*
+* Counts heap allocations made on the render thread between two frame
+* markers. On Darwin the tracker hooks the default malloc zone, which also
+* sees every Objective-C object that is allocated. Elsewhere nothing is hooked
+* and allocators report through SGAllocationTrackerRecordAllocation.
+*
+* Allocations on other threads are ignored; only the thread that called
+* SGAllocationTrackerBeginFrame is watched until the frame ends. A thread that
+* does work for the frame, like the scene worker, counts it in a pass of its
+* own, which is merged into the frame that uses the result.
+*/
+
+typedef enum {
+    kSGAllocationTracking_None = 0,     /* nothing is counted */
+    kSGAllocationTracking_Count,        /* allocations are counted per frame */
+    kSGAllocationTracking_Assert        /* every allocation during a frame is flagged */
+} SGAllocationTracking;
+
+typedef struct SGAllocationCountsStruct {
+    unsigned int allocations;
+    unsigned int frees;
+    size_t bytes;
+    size_t firstSize;           /* size of the first allocation in the frame */
+} SGAllocationCounts;
+
+/* hook the allocator; returns 1 if allocations are seen automatically, 0 otherwise */
+extern int SGAllocationTrackerInstall(void);
+
+/* choose whether allocations are counted or flagged */
+extern void SGAllocationTrackerSetMode(SGAllocationTracking mode);
+
+/* start watching the calling thread */
+extern void SGAllocationTrackerBeginFrame(void);
+
+/* stop watching and return what was allocated since the frame began */
+extern SGAllocationCounts SGAllocationTrackerEndFrame(void);
+
+/* count the allocations of the calling thread in passCounts until the pass ends; passCounts is reset */
+extern void SGAllocationTrackerBeginPass(SGAllocationCounts* passCounts);
+
+/* stop counting the allocations of the calling thread */
+extern void SGAllocationTrackerEndPass(void);
+
+/* add the counts of a pass to the frame that is being watched; called from the watched thread */
+extern void SGAllocationTrackerMergePass(const SGAllocationCounts* passCounts);
+
+/* report an allocation or a free made by the calling thread */
+extern void SGAllocationTrackerRecordAllocation(size_t size);
+extern void SGAllocationTrackerRecordFree(void);
+
+/*
+* called for every allocation that is made during a frame in assert mode.
+* Set a breakpoint on this function to find out where the allocation came from.
+*/
+extern void SGAllocationTrackerBreak(size_t size);
@@ -0,0 +1,80 @@
+//
+//  SGAnnotationFetchOperation.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import <CoreLocation/CoreLocation.h>
+
+@class SGARView;
+@protocol SGARViewDataSource;
+
+/*!
+* @class SGAnnotationFetchOperation
+* @abstract Pulls pages of annotations from the data source of an
+* @link //simplegeo/ooc/cl/SGARView SGARView @/link on a background thread.
+* @discussion Each page is handed back to the AR view on the main thread as soon as it
+* is returned. Once the operation is cancelled, no more pages are requested and the pages
+* that are still in flight are dropped. The AR view and its data source are retained when the
+* operation is created and released on the main thread, so the view is never deallocated while
+* a page is loading.
+*/
+@interface SGAnnotationFetchOperation : NSOperation
+{
+    SGARView* arView;
+    CLLocation* location;
+    
+    @private
+    id<SGARViewDataSource> dataSource;
+}
+
+/*!
+* @property
+* @abstract The AR view that the annotations are loaded for.
+*/
+@property (nonatomic, readonly) SGARView* arView;
+
+/*!
+* @property
+* @abstract The location that the annotations are loaded for.
+*/
+@property (nonatomic, readonly) CLLocation* location;
+
+/*!
+* @method initWithARView:location:
+* @abstract Creates an operation that loads the annotations at a location.
+* @param view The AR view whose data source will be asked for annotations.
+* @param newLocation The location to load annotations for.
+* @result A new operation.
+*/
+- (id) initWithARView:(SGARView*)view location:(CLLocation*)newLocation;
+
+@end
@@ -0,0 +1,125 @@
+//
+//  SGAnnotationFetchOperation.m
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGAnnotationFetchOperation.h"
+#import "SGARView.h"
+
+@interface SGAnnotationFetchOperation (Private)
+
+- (void) deliverAnnotations:(NSArray*)annotations;
+- (void) finish;
+- (void) releaseARView;
+
+@end
+
+@interface SGARView (SGAnnotationFetchOperation)
+
+- (void) fetchOperation:(SGAnnotationFetchOperation*)operation didLoadAnnotations:(NSArray*)annotations;
+- (void) fetchOperationDidFinish:(SGAnnotationFetchOperation*)operation;
+
+@end
+
+@implementation SGAnnotationFetchOperation
+@synthesize arView, location;
+
+- (id) initWithARView:(SGARView*)view location:(CLLocation*)newLocation
+{
+    if(self = [super init]) {
+        // The data source is read here since the view is not
+        // touched off the main thread.
+        arView = [view retain];
+        dataSource = [view.dataSource retain];
+        location = [newLocation retain];
+    }
+    
+    return self;
+}
+
+- (void) main
+{
+    NSAutoreleasePool* pool;
+    NSArray* annotations = nil;
+    for(NSInteger page = 0; ![self isCancelled]; page++) {
+        pool = [[NSAutoreleasePool alloc] init];
+        
+        annotations = [dataSource arView:arView annotationsAtLocation:location page:page];
+        if(annotations && [annotations count] && ![self isCancelled])
+            [self performSelectorOnMainThread:@selector(deliverAnnotations:) withObject:annotations waitUntilDone:NO];
+        
+        [pool release];
+        
+        if(!annotations)
+            break;
+    }
+    
+    [self performSelectorOnMainThread:@selector(finish) withObject:nil waitUntilDone:NO];
+}
+
+- (void) deliverAnnotations:(NSArray*)annotations
+{
+    // Cancellation happens on the main thread, so nothing
+    // can slip past this check.
+    if(![self isCancelled])
+        [arView fetchOperation:self didLoadAnnotations:annotations];
+}
+
+- (void) finish
+{
+    if(![self isCancelled])
+        [arView fetchOperationDidFinish:self];
+    
+    [self releaseARView];
+}
+
+- (void) releaseARView
+{
+    [dataSource release];
+    dataSource = nil;
+    [arView release];
+    arView = nil;
+}
+
+- (void) dealloc
+{
+    [location release];
+    
+    // An operation that was cancelled before it ran never finishes
+    // and may be released by the queue's thread.
+    [(NSObject*)dataSource performSelectorOnMainThread:@selector(release) withObject:nil waitUntilDone:NO];
+    [arView performSelectorOnMainThread:@selector(release) withObject:nil waitUntilDone:NO];
+    
+    [super dealloc];
+}
+
+@end
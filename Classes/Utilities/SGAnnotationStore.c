@@ -0,0 +1,383 @@
+//
+//  SGAnnotationStore.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGAnnotationStore.h"
+#import "SGMath.h"
+#import "SGFastTrig.h"
+
+#import <stdlib.h>
+#import <string.h>
+#import <math.h>
+
+#define kSGAnnotationStore_InitialCapacity  64
+#define kSGAnnotationStore_EarthRadius      6371009.0
+#define kSGAnnotationStore_ProjectionGrain  2048    /* entries per task */
+
+typedef struct SGAnnotationSortKeyStruct {
+    float distance;
+    int slot;
+} SGAnnotationSortKey;
+
+#define FLAG_WORDS(__CAPACITY__)    (((__CAPACITY__) + 31) >> 5)
+
+static void growEntries(SGAnnotationStore* store) {
+    int oldWords = FLAG_WORDS(store->capacity);
+    int capacity = store->capacity ? store->capacity * 2 : kSGAnnotationStore_InitialCapacity;
+    int words = FLAG_WORDS(capacity);
+    
+    store->latitudes = (double*)realloc(store->latitudes, sizeof(double) * capacity);
+    store->longitudes = (double*)realloc(store->longitudes, sizeof(double) * capacity);
+    store->altitudes = (float*)realloc(store->altitudes, sizeof(float) * capacity);
+    store->distances = (float*)realloc(store->distances, sizeof(float) * capacity);
+    store->bearings = (float*)realloc(store->bearings, sizeof(float) * capacity);
+    store->x = (float*)realloc(store->x, sizeof(float) * capacity);
+    store->z = (float*)realloc(store->z, sizeof(float) * capacity);
+    store->widths = (float*)realloc(store->widths, sizeof(float) * capacity);
+    store->heights = (float*)realloc(store->heights, sizeof(float) * capacity);
+    store->objects = (void**)realloc(store->objects, sizeof(void*) * capacity);
+    store->handles = (SGAnnotationHandle*)realloc(store->handles, sizeof(SGAnnotationHandle) * capacity);
+    store->order = (int*)realloc(store->order, sizeof(int) * capacity);
+    store->sortKeys = (SGAnnotationSortKey*)realloc(store->sortKeys, sizeof(SGAnnotationSortKey) * capacity);
+    
+    for(int flag = 0; flag < kSGAnnotationFlag_Count; flag++) {
+        store->flags[flag] = (unsigned int*)realloc(store->flags[flag], sizeof(unsigned int) * words);
+        memset(store->flags[flag] + oldWords, 0, sizeof(unsigned int) * (words - oldWords));
+    }
+    
+    store->capacity = capacity;
+}
+
+static int allocateSlot(SGAnnotationStore* store) {
+    if(store->amountOfFreeSlots)
+        return store->freeSlots[--store->amountOfFreeSlots];
+    
+    if(store->slotCount == store->slotCapacity) {
+        int capacity = store->slotCapacity ? store->slotCapacity * 2 : kSGAnnotationStore_InitialCapacity;
+        store->slots = (int*)realloc(store->slots, sizeof(int) * capacity);
+        store->generations = (unsigned int*)realloc(store->generations, sizeof(unsigned int) * capacity);
+        store->freeSlots = (int*)realloc(store->freeSlots, sizeof(int) * capacity);
+        memset(store->generations + store->slotCapacity, 0, sizeof(unsigned int) * (capacity - store->slotCapacity));
+        store->slotCapacity = capacity;
+    }
+    
+    return store->slotCount++;
+}
+
+static void setFlagBit(SGAnnotationStore* store, int index, int flag, int value) {
+    unsigned int mask = 1u << (index & 31);
+    if(value)
+        store->flags[flag][index >> 5] |= mask;
+    else
+        store->flags[flag][index >> 5] &= ~mask;
+}
+
+static void projectEntry(SGAnnotationStore* store, int index) {
+    double distance, bearing;
+    float east, north;
+    if(store->hasOrigin) {
+        // The differences are taken in double so that nearby annotations keep
+        // their precision; the trig itself only needs float.
+        float deltaLat = (store->latitudes[index] - store->originLatitude) * M_PI / 180.0;
+        float deltaLon = (store->longitudes[index] - store->originLongitude) * M_PI / 180.0;
+        
+        float sinFirstLat, cosFirstLat, sinSecondLat, cosSecondLat;
+        float sinHalfLat, cosHalfLat, sinHalfLon, cosHalfLon;
+        SGFastSinCos(store->originLatitude * M_PI / 180.0, &sinFirstLat, &cosFirstLat, kSGTrigAccuracy_High);
+        SGFastSinCos(store->latitudes[index] * M_PI / 180.0, &sinSecondLat, &cosSecondLat, kSGTrigAccuracy_High);
+        SGFastSinCos(deltaLat / 2.0f, &sinHalfLat, &cosHalfLat, kSGTrigAccuracy_High);
+        SGFastSinCos(deltaLon / 2.0f, &sinHalfLon, &cosHalfLon, kSGTrigAccuracy_High);
+        
+        // Same initial bearing as -[CLLocation getBearingFromCoordinate:], with
+        // cos(lat1) sin(lat2) - sin(lat1) cos(lat2) cos(dLon) rewritten in half
+        // angles so that it does not cancel for annotations down the street.
+        float sinHalfLon2 = sinHalfLon * sinHalfLon;
+        east = 2.0f * sinHalfLon * cosHalfLon * cosSecondLat;
+        north = 2.0f * sinHalfLat * cosHalfLat + 2.0f * sinFirstLat * cosSecondLat * sinHalfLon2;
+        bearing = SGFastAtan2(east, north, kSGTrigAccuracy_High) * 180.0 / M_PI;
+        if(bearing < 0.0)
+            bearing += 360.0;
+        
+        // Haversine
+        float a = sinHalfLat * sinHalfLat + cosFirstLat * cosSecondLat * sinHalfLon2;
+        distance = 2.0 * SGFastAsin(sqrtf(a < 1.0f ? a : 1.0f), kSGTrigAccuracy_High) *
+                   kSGAnnotationStore_EarthRadius * store->scale;
+    } else {
+        bearing = 0.0;
+        distance = store->maximumDistance;
+        east = 0.0f;
+        north = 1.0f;
+    }
+    
+    if(distance > store->maximumDistance)
+        distance = store->maximumDistance;
+    else if(distance < store->minimumDistance)
+        distance = store->minimumDistance;
+    
+    // The environment measures its angles from the x axis, which points
+    // east, while z points south. The direction of the bearing is already
+    // at hand so there is no need to go back through an angle.
+    float length = sqrtf(east * east + north * north);
+    if(length <= 0.0f) {
+        east = 0.0f;
+        north = length = 1.0f;
+    }
+    
+    store->distances[index] = distance;
+    store->bearings[index] = bearing;
+    store->x[index] = distance * east / length;
+    store->z[index] = -distance * north / length;
+}
+
+/* first position in the order whose distance is not greater than the one given */
+static int orderPositionForDistance(const SGAnnotationStore* store, int amount, float distance) {
+    int low = 0;
+    int high = amount;
+    int middle;
+    while(low < high) {
+        middle = low + (high - low) / 2;
+        if(store->distances[store->slots[store->order[middle]]] > distance)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    
+    return low;
+}
+
+static void insertIntoOrder(SGAnnotationStore* store, int amount, int slot) {
+    int position = orderPositionForDistance(store, amount, store->distances[store->slots[slot]]);
+    memmove(store->order + position + 1, store->order + position, sizeof(int) * (amount - position));
+    store->order[position] = slot;
+}
+
+static void removeFromOrder(SGAnnotationStore* store, int amount, int slot) {
+    float distance = store->distances[store->slots[slot]];
+    int position;
+    for(position = orderPositionForDistance(store, amount, distance); position < amount; position++)
+        if(store->order[position] == slot || store->distances[store->slots[store->order[position]]] != distance)
+            break;
+    
+    if(position == amount || store->order[position] != slot)
+        for(position = 0; position < amount && store->order[position] != slot; position++);
+    
+    if(position < amount)
+        memmove(store->order + position, store->order + position + 1, sizeof(int) * (amount - position - 1));
+}
+
+SGAnnotationStore* SGAnnotationStoreNew(float scale, float minimumDistance, float maximumDistance) {
+    SGAnnotationStore* store = (SGAnnotationStore*)calloc(1, sizeof(SGAnnotationStore));
+    store->scale = scale;
+    store->minimumDistance = minimumDistance;
+    store->maximumDistance = maximumDistance;
+    growEntries(store);
+    
+    return store;
+}
+
+void SGAnnotationStoreFree(SGAnnotationStore* store) {
+    if(!store)
+        return;
+    
+    free(store->latitudes);
+    free(store->longitudes);
+    free(store->altitudes);
+    free(store->distances);
+    free(store->bearings);
+    free(store->x);
+    free(store->z);
+    free(store->widths);
+    free(store->heights);
+    free(store->objects);
+    free(store->handles);
+    free(store->order);
+    free(store->sortKeys);
+    for(int flag = 0; flag < kSGAnnotationFlag_Count; flag++)
+        free(store->flags[flag]);
+    
+    free(store->slots);
+    free(store->generations);
+    free(store->freeSlots);
+    free(store);
+}
+
+void SGAnnotationStoreClear(SGAnnotationStore* store) {
+    for(int slot = 0; slot < store->slotCount; slot++)
+        if(store->slots[slot] >= 0) {
+            store->slots[slot] = -1;
+            store->generations[slot]++;
+            store->freeSlots[store->amountOfFreeSlots++] = slot;
+        }
+    
+    for(int flag = 0; flag < kSGAnnotationFlag_Count; flag++)
+        memset(store->flags[flag], 0, sizeof(unsigned int) * FLAG_WORDS(store->capacity));
+    
+    store->count = 0;
+}
+
+SGAnnotationHandle SGAnnotationStoreAdd(SGAnnotationStore* store, double latitude, double longitude,
+                                        float altitude, void* object) {
+    if(store->count == store->capacity)
+        growEntries(store);
+    
+    int slot = allocateSlot(store);
+    int index = store->count++;
+    SGAnnotationHandle handle = ((SGAnnotationHandle)store->generations[slot] << kSGAnnotationStore_SlotBits) | slot;
+    
+    store->slots[slot] = index;
+    store->latitudes[index] = latitude;
+    store->longitudes[index] = longitude;
+    store->altitudes[index] = altitude;
+    store->widths[index] = 0.0f;
+    store->heights[index] = 0.0f;
+    store->objects[index] = object;
+    store->handles[index] = handle;
+    for(int flag = 0; flag < kSGAnnotationFlag_Count; flag++)
+        setFlagBit(store, index, flag, 0);
+    
+    projectEntry(store, index);
+    insertIntoOrder(store, index, slot);
+    
+    return handle;
+}
+
+int SGAnnotationStoreIndex(const SGAnnotationStore* store, SGAnnotationHandle handle) {
+    if(handle == kSGAnnotationHandle_Invalid)
+        return -1;
+    
+    int slot = SGAnnotationHandleSlot(handle);
+    if(slot >= store->slotCount || store->generations[slot] != (unsigned int)(handle >> kSGAnnotationStore_SlotBits))
+        return -1;
+    
+    return store->slots[slot];
+}
+
+void SGAnnotationStoreRemove(SGAnnotationStore* store, SGAnnotationHandle handle) {
+    int index = SGAnnotationStoreIndex(store, handle);
+    if(index < 0)
+        return;
+    
+    int slot = handle & kSGAnnotationStore_SlotMask;
+    removeFromOrder(store, store->count, slot);
+    
+    // Fill the hole with the last entry
+    int last = --store->count;
+    if(index != last) {
+        store->latitudes[index] = store->latitudes[last];
+        store->longitudes[index] = store->longitudes[last];
+        store->altitudes[index] = store->altitudes[last];
+        store->distances[index] = store->distances[last];
+        store->bearings[index] = store->bearings[last];
+        store->x[index] = store->x[last];
+        store->z[index] = store->z[last];
+        store->widths[index] = store->widths[last];
+        store->heights[index] = store->heights[last];
+        store->objects[index] = store->objects[last];
+        store->handles[index] = store->handles[last];
+        for(int flag = 0; flag < kSGAnnotationFlag_Count; flag++)
+            setFlagBit(store, index, flag, SGAnnotationStoreTestFlag(store, last, flag));
+        
+        store->slots[store->handles[index] & kSGAnnotationStore_SlotMask] = index;
+    }
+    
+    for(int flag = 0; flag < kSGAnnotationFlag_Count; flag++)
+        setFlagBit(store, last, flag, 0);
+    
+    store->slots[slot] = -1;
+    store->generations[slot]++;
+    store->freeSlots[store->amountOfFreeSlots++] = slot;
+}
+
+void SGAnnotationStoreMove(SGAnnotationStore* store, SGAnnotationHandle handle,
+                           double latitude, double longitude, float altitude) {
+    int index = SGAnnotationStoreIndex(store, handle);
+    if(index < 0)
+        return;
+    
+    int slot = handle & kSGAnnotationStore_SlotMask;
+    removeFromOrder(store, store->count, slot);
+    
+    store->latitudes[index] = latitude;
+    store->longitudes[index] = longitude;
+    store->altitudes[index] = altitude;
+    projectEntry(store, index);
+    
+    insertIntoOrder(store, store->count - 1, slot);
+}
+
+void SGAnnotationStoreSetFlag(SGAnnotationStore* store, SGAnnotationHandle handle,
+                              SGAnnotationFlag flag, int value) {
+    int index = SGAnnotationStoreIndex(store, handle);
+    if(index >= 0 && SGAnnotationStoreTestFlag(store, index, flag) != (value != 0)) {
+        setFlagBit(store, index, flag, value);
+        store->flagRevision++;
+    }
+}
+
+/* entries only write to their own index, so ranges can be projected at the same time */
+static void projectEntries(void* context, int begin, int end) {
+    SGAnnotationStore* store = (SGAnnotationStore*)context;
+    for(int i = begin; i < end; i++)
+        projectEntry(store, i);
+}
+
+void SGAnnotationStoreSetOrigin(SGAnnotationStore* store, double latitude, double longitude) {
+    store->originLatitude = latitude;
+    store->originLongitude = longitude;
+    store->hasOrigin = 1;
+    
+    SGTaskPoolParallelFor(store->taskPool, store->count, kSGAnnotationStore_ProjectionGrain, projectEntries, store);
+    
+    SGAnnotationStoreSort(store);
+}
+
+static int compareSortKeys(const void* first, const void* second) {
+    float d1 = ((const SGAnnotationSortKey*)first)->distance;
+    float d2 = ((const SGAnnotationSortKey*)second)->distance;
+    
+    return d1 < d2 ? 1 : (d1 > d2 ? -1 : 0);
+}
+
+void SGAnnotationStoreSort(SGAnnotationStore* store) {
+    // Starting from the last order leaves little to do after a small move
+    SGAnnotationSortKey* keys = store->sortKeys;
+    for(int i = 0; i < store->count; i++) {
+        keys[i].slot = store->order[i];
+        keys[i].distance = store->distances[store->slots[store->order[i]]];
+    }
+    
+    SGSort(keys, store->count, sizeof(SGAnnotationSortKey), compareSortKeys);
+    
+    for(int i = 0; i < store->count; i++)
+        store->order[i] = keys[i].slot;
+}
@@ -0,0 +1,150 @@
+//
+//  SGAnnotationStore.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGTaskPool.h"
+
+/*
+* A struct-of-arrays store for the render state of annotations. Every
+* attribute lives in its own contiguous array so the loops that project,
+* sort, cluster and pick annotations stream through memory without touching
+* the views themselves. Entries are packed; removing one moves the last entry
+* into its place. Handles stay valid until the entry they refer to is removed.
+*
+* The store keeps a list of slots that is sorted by distance, from the
+* farthest to the closest, which is the order billboards are drawn in.
+*/
+
+/*
+* A handle holds the slot of its entry in the low bits and the generation of
+* the slot in the high bits. Generations are wide enough that a reload every
+* frame would take years to hand out a stale handle's value again.
+*/
+typedef unsigned long long SGAnnotationHandle;
+
+#define kSGAnnotationHandle_Invalid         0xFFFFFFFFFFFFFFFFULL
+#define kSGAnnotationStore_SlotBits         32
+#define kSGAnnotationStore_SlotMask         0xFFFFFFFFULL
+
+/* the slot of a handle, which is unique among the entries of a store */
+#define SGAnnotationHandleSlot(__HANDLE__)  ((int)((__HANDLE__) & kSGAnnotationStore_SlotMask))
+
+/* flags that are kept as bitsets, one bit per entry */
+typedef enum {
+    kSGAnnotationFlag_Captured = 0,
+    kSGAnnotationFlag_Hidden,
+    kSGAnnotationFlag_Count
+} SGAnnotationFlag;
+
+typedef struct SGAnnotationStoreStruct {
+    int count;
+    int capacity;
+    
+    /* entries */
+    double* latitudes;
+    double* longitudes;
+    float* altitudes;
+    float* distances;           /* from the origin in environment units */
+    float* bearings;            /* degrees clockwise from north */
+    float* x;
+    float* z;
+    float* widths;              /* size of the last drawn texture in pixels */
+    float* heights;
+    void** objects;
+    SGAnnotationHandle* handles;
+    unsigned int* flags[kSGAnnotationFlag_Count];
+    unsigned int flagRevision;  /* changes whenever a flag of an entry is set or cleared */
+    
+    /* handle slots */
+    int* slots;                 /* slot -> entry or -1 */
+    unsigned int* generations;
+    int* freeSlots;
+    int amountOfFreeSlots;
+    int slotCount;
+    int slotCapacity;
+    
+    /* slots sorted by descending distance */
+    int* order;
+    struct SGAnnotationSortKeyStruct* sortKeys;
+    
+    /* projection */
+    double originLatitude;
+    double originLongitude;
+    int hasOrigin;
+    float scale;                /* environment units per meter */
+    float minimumDistance;
+    float maximumDistance;
+    
+    /* splits the projection of large stores between the cores; NULL projects on the caller */
+    SGTaskPool* taskPool;
+} SGAnnotationStore;
+
+#define SGAnnotationStoreTestFlag(__STORE__, __INDEX__, __FLAG__) \
+    (((__STORE__)->flags[(__FLAG__)][(__INDEX__) >> 5] >> ((__INDEX__) & 31)) & 1)
+
+/* the entry at position i of the back to front order */
+#define SGAnnotationStoreOrderedIndex(__STORE__, __I__) \
+    ((__STORE__)->slots[(__STORE__)->order[(__I__)]])
+
+/* create an empty store; distances are multiplied by scale and clamped to [minimum, maximum] */
+extern SGAnnotationStore* SGAnnotationStoreNew(float scale, float minimumDistance, float maximumDistance);
+
+/* release all memory held by the store; the objects are not touched */
+extern void SGAnnotationStoreFree(SGAnnotationStore* store);
+
+/* remove every entry and invalidate every handle */
+extern void SGAnnotationStoreClear(SGAnnotationStore* store);
+
+/* add an entry and place it in the sorted order */
+extern SGAnnotationHandle SGAnnotationStoreAdd(SGAnnotationStore* store, double latitude, double longitude,
+                                               float altitude, void* object);
+
+/* remove an entry; the handle is no longer valid afterwards */
+extern void SGAnnotationStoreRemove(SGAnnotationStore* store, SGAnnotationHandle handle);
+
+/* change the coordinate of an entry and move it to its new place in the sorted order */
+extern void SGAnnotationStoreMove(SGAnnotationStore* store, SGAnnotationHandle handle,
+                                  double latitude, double longitude, float altitude);
+
+/* returns the entry that a handle refers to or -1 if the handle is no longer valid */
+extern int SGAnnotationStoreIndex(const SGAnnotationStore* store, SGAnnotationHandle handle);
+
+/* set or clear a flag of the entry that a handle refers to */
+extern void SGAnnotationStoreSetFlag(SGAnnotationStore* store, SGAnnotationHandle handle,
+                                     SGAnnotationFlag flag, int value);
+
+/* project every entry from a new origin and sort them again */
+extern void SGAnnotationStoreSetOrigin(SGAnnotationStore* store, double latitude, double longitude);
+
+/* sort the entries by their current distance */
+extern void SGAnnotationStoreSort(SGAnnotationStore* store);
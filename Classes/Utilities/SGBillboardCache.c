@@ -0,0 +1,238 @@
+//
+//  SGBillboardCache.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGBillboardCache.h"
+
+#import <fcntl.h>
+#import <string.h>
+#import <unistd.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+
+#define ALIGN(__OFFSET__)       (((__OFFSET__) + kSGBillboardCache_Alignment - 1) & ~(uint64_t)(kSGBillboardCache_Alignment - 1))
+#define SLOT(__HASH__, __COUNT__)   ((uint32_t)(__HASH__) & ((__COUNT__) - 1))
+
+/* slots stop being handed out once the table is three quarters full so that probes stay short */
+#define MAXIMUM_COUNT(__HEADER__)   ((__HEADER__)->slotCount / 4 * 3)
+
+static uint32_t slotCountForSize(size_t size) {
+    uint32_t count = 16;
+    while(count < size / kSGBillboardCache_BytesPerSlot)
+        count *= 2;
+    
+    return count;
+}
+
+static uint64_t dataOffsetForSlotCount(uint32_t slotCount) {
+    return ALIGN(sizeof(SGBillboardCacheHeader) + (uint64_t)slotCount * sizeof(SGBillboardCacheSlot));
+}
+
+/* 0 for a format that is not stored */
+static uint64_t bytesPerPixel(uint32_t format) {
+    switch(format) {
+        case kSGBillboardCache_RGBA8888:    return 4;
+        case kSGBillboardCache_RGB565:      return 2;
+        case kSGBillboardCache_A8:          return 1;
+        default:                            return 0;
+    }
+}
+
+/* whether the pixels of a slot are enough for glTexImage2D to read the entire texture */
+static int coversTexture(uint32_t format, uint64_t width, uint64_t height, uint64_t length) {
+    uint64_t bytes = bytesPerPixel(format);
+    return bytes && length >= width * height * bytes;
+}
+
+/* whether the file was left by a cache of the same layout and every slot points at pixels that were written */
+static int isValid(const SGBillboardCache* cache, uint32_t slotCount) {
+    const SGBillboardCacheHeader* header = cache->header;
+    if(header->magic != kSGBillboardCache_Magic || header->version != kSGBillboardCache_Version ||
+       header->size != cache->size || header->slotCount != slotCount ||
+       header->dataOffset != dataOffsetForSlotCount(slotCount) ||
+       header->dataEnd < header->dataOffset || header->dataEnd > cache->size ||
+       header->count > MAXIMUM_COUNT(header) || header->full)
+        return 0;
+    
+    const SGBillboardCacheSlot* slot;
+    uint32_t count = 0;
+    for(uint32_t i = 0; i < slotCount; i++) {
+        slot = &cache->slots[i];
+        if(!slot->hash)
+            continue;
+        
+        if(slot->offset < header->dataOffset || slot->offset % kSGBillboardCache_Alignment ||
+           slot->offset + slot->length > header->dataEnd ||
+           !coversTexture(slot->format, slot->width, slot->height, slot->length))
+            return 0;
+        
+        count++;
+    }
+    
+    return count == header->count;
+}
+
+static void reset(SGBillboardCache* cache, uint32_t slotCount) {
+    SGBillboardCacheHeader* header = cache->header;
+    memset(cache->map, 0, dataOffsetForSlotCount(slotCount));
+    
+    header->magic = kSGBillboardCache_Magic;
+    header->version = kSGBillboardCache_Version;
+    header->size = cache->size;
+    header->slotCount = slotCount;
+    header->count = 0;
+    header->dataOffset = dataOffsetForSlotCount(slotCount);
+    header->dataEnd = header->dataOffset;
+    header->full = 0;
+}
+
+SGBillboardCache* SGBillboardCacheOpen(const char* path, size_t size) {
+    uint32_t slotCount = slotCountForSize(size);
+    if(dataOffsetForSlotCount(slotCount) >= size)
+        return NULL;
+    
+    int file = open(path, O_RDWR | O_CREAT, 0644);
+    if(file < 0)
+        return NULL;
+    
+    // A file of another size is left over from another configuration
+    struct stat status;
+    if(fstat(file, &status) || (size_t)status.st_size != size) {
+        if(ftruncate(file, 0) || ftruncate(file, size)) {
+            close(file);
+            return NULL;
+        }
+    }
+    
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if(map == MAP_FAILED) {
+        close(file);
+        return NULL;
+    }
+    
+    SGBillboardCache* cache = (SGBillboardCache*)calloc(1, sizeof(SGBillboardCache));
+    cache->file = file;
+    cache->map = (unsigned char*)map;
+    cache->size = size;
+    cache->header = (SGBillboardCacheHeader*)map;
+    cache->slots = (SGBillboardCacheSlot*)(cache->map + sizeof(SGBillboardCacheHeader));
+    
+    if(!isValid(cache, slotCount))
+        reset(cache, slotCount);
+    
+    return cache;
+}
+
+void SGBillboardCacheClose(SGBillboardCache* cache) {
+    if(!cache)
+        return;
+    
+    munmap(cache->map, cache->size);
+    close(cache->file);
+    free(cache);
+}
+
+int SGBillboardCacheFind(SGBillboardCache* cache, uint64_t hash, SGBillboardCacheEntry* entry) {
+    if(!hash)
+        return 0;
+    
+    uint32_t slotCount = cache->header->slotCount;
+    const SGBillboardCacheSlot* slot;
+    for(uint32_t i = SLOT(hash, slotCount); cache->slots[i].hash; i = SLOT(i + 1, slotCount)) {
+        slot = &cache->slots[i];
+        if(slot->hash == hash) {
+            entry->pixels = cache->map + slot->offset;
+            entry->length = slot->length;
+            entry->format = slot->format;
+            entry->width = slot->width;
+            entry->height = slot->height;
+            entry->contentWidth = slot->contentWidth;
+            entry->contentHeight = slot->contentHeight;
+            cache->hits++;
+            
+            return 1;
+        }
+    }
+    
+    cache->misses++;
+    return 0;
+}
+
+int SGBillboardCacheStore(SGBillboardCache* cache, uint64_t hash, int format,
+                          int width, int height, int contentWidth, int contentHeight,
+                          const void* pixels, size_t length) {
+    SGBillboardCacheHeader* header = cache->header;
+    if(!hash || width < 0 || height < 0 || width > UINT16_MAX || height > UINT16_MAX || length > UINT32_MAX ||
+       format < 0 || !coversTexture(format, width, height, length))
+        return 0;
+    
+    uint32_t i = SLOT(hash, header->slotCount);
+    for(; cache->slots[i].hash; i = SLOT(i + 1, header->slotCount))
+        if(cache->slots[i].hash == hash)
+            return 0;
+    
+    uint64_t offset = ALIGN(header->dataEnd);
+    if(header->count >= MAXIMUM_COUNT(header) || offset > cache->size || length > cache->size - offset) {
+        header->full = 1;
+        cache->rejections++;
+        return 0;
+    }
+    
+    memcpy(cache->map + offset, pixels, length);
+    
+    SGBillboardCacheSlot* slot = &cache->slots[i];
+    slot->offset = offset;
+    slot->length = (uint32_t)length;
+    slot->format = format;
+    slot->width = width;
+    slot->height = height;
+    slot->contentWidth = contentWidth;
+    slot->contentHeight = contentHeight;
+    header->dataEnd = offset + length;
+    header->count++;
+    
+    // The slot only becomes visible once everything it points at is in place
+    __sync_synchronize();
+    slot->hash = hash;
+    cache->stores++;
+    
+    return 1;
+}
+
+uint64_t SGBillboardCacheHash(uint64_t hash, const void* bytes, size_t length) {
+    const unsigned char* byte = (const unsigned char*)bytes;
+    for(size_t i = 0; i < length; i++)
+        hash = (hash ^ byte[i]) * 0x100000001b3ULL;
+    
+    return hash;
+}
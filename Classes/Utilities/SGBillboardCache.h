@@ -0,0 +1,132 @@
+//
+//  SGBillboardCache.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import <stdint.h>
+#import <stdlib.h>
+
+/*
+* A cache of pre-rasterized billboards that outlives the application. The
+* pixels of a texture are kept exactly as they are handed to glTexImage2D, so
+* a billboard that was cached by an earlier run can be uploaded straight from
+* the file without being rendered or converted again.
+*
+* The cache is a single file that is mapped into memory. It starts with a
+* header, followed by an open addressing table of slots that is keyed by a
+* 64-bit hash of whatever the billboard was drawn from, and then by the pixels
+* themselves, which are appended one after the other. The hash of a slot is
+* written after its pixels, so a billboard that was interrupted while being
+* stored is never found.
+*
+* Pixels are never moved or overwritten while the cache is open, so the
+* pointers that it hands out stay valid until it is closed. Once the file is
+* full nothing else is stored; a full or damaged file starts over the next
+* time it is opened. The cache is not thread safe.
+*/
+
+#define kSGBillboardCache_Magic         0x53474243      /* "SGBC" */
+#define kSGBillboardCache_Version       1
+#define kSGBillboardCache_DefaultSize   (8 * 1024 * 1024)   /* bytes */
+#define kSGBillboardCache_BytesPerSlot  4096            /* bytes of pixels per slot of the table */
+#define kSGBillboardCache_Alignment     16              /* bytes */
+
+/* the pixel formats that are stored, which are those of SGTexturePixelFormat */
+#define kSGBillboardCache_RGBA8888      0               /* 4 bytes per pixel */
+#define kSGBillboardCache_RGB565        1               /* 2 bytes per pixel */
+#define kSGBillboardCache_A8            2               /* 1 byte per pixel */
+
+/* the seed of SGBillboardCacheHash */
+#define kSGBillboardCache_HashSeed      0xcbf29ce484222325ULL
+
+typedef struct SGBillboardCacheHeaderStruct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;                  /* of the file */
+    uint32_t slotCount;             /* always a power of two */
+    uint32_t count;
+    uint64_t dataOffset;            /* where the pixels start */
+    uint64_t dataEnd;               /* where the next pixels go */
+    uint32_t full;                  /* a billboard did not fit */
+    uint32_t reserved[5];
+} SGBillboardCacheHeader;
+
+typedef struct SGBillboardCacheSlotStruct {
+    uint64_t hash;                  /* 0 if the slot is empty */
+    uint64_t offset;
+    uint32_t length;
+    uint32_t format;
+    uint16_t width, height;         /* of the texture */
+    uint16_t contentWidth, contentHeight;
+} SGBillboardCacheSlot;
+
+/* a billboard that was found; the pixels belong to the cache */
+typedef struct SGBillboardCacheEntryStruct {
+    const void* pixels;
+    size_t length;
+    int format;
+    int width;
+    int height;
+    int contentWidth;
+    int contentHeight;
+} SGBillboardCacheEntry;
+
+typedef struct SGBillboardCacheStruct {
+    int file;
+    unsigned char* map;
+    size_t size;
+    
+    SGBillboardCacheHeader* header;
+    SGBillboardCacheSlot* slots;
+    
+    /* statistics */
+    int hits;
+    int misses;
+    int stores;
+    int rejections;                 /* billboards that did not fit */
+} SGBillboardCache;
+
+/* maps the file at the path, creating it with the size if needed; NULL if it can not */
+extern SGBillboardCache* SGBillboardCacheOpen(const char* path, size_t size);
+extern void SGBillboardCacheClose(SGBillboardCache* cache);
+
+/* fills the entry for the hash and returns 1, or returns 0 on a miss */
+extern int SGBillboardCacheFind(SGBillboardCache* cache, uint64_t hash, SGBillboardCacheEntry* entry);
+
+/* copies a billboard into the cache; returns 0 if it is full, the hash is 0 or already present,
+   or the format is unknown or the pixels do not cover the texture */
+extern int SGBillboardCacheStore(SGBillboardCache* cache, uint64_t hash, int format,
+                                 int width, int height, int contentWidth, int contentHeight,
+                                 const void* pixels, size_t length);
+
+/* folds bytes into a 64-bit FNV-1a hash, starting from kSGBillboardCache_HashSeed */
+extern uint64_t SGBillboardCacheHash(uint64_t hash, const void* bytes, size_t length);
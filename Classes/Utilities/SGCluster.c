@@ -0,0 +1,245 @@
+//
+//  SGCluster.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCluster.h"
+#import "SGMath.h"
+
+#import <stdlib.h>
+#import <math.h>
+
+#define kSGClusterMaxLevels             12
+
+typedef struct SGClusterCellStruct {
+    unsigned long long key;
+    int node;
+} SGClusterCell;
+
+static int compareCells(const void* a, const void* b) {
+    unsigned long long k1 = ((const SGClusterCell*)a)->key;
+    unsigned long long k2 = ((const SGClusterCell*)b)->key;
+    return k1 < k2 ? -1 : (k1 > k2 ? 1 : 0);
+}
+
+static int compareDepths(const void* a, const void* b) {
+    float d1 = ((const SGClusterDepth*)a)->depth;
+    float d2 = ((const SGClusterDepth*)b)->depth;
+    return d1 > d2 ? -1 : (d1 < d2 ? 1 : 0);
+}
+
+static void ensureNodeCapacity(SGClusterTree* tree, int capacity) {
+    if(tree->nodeCapacity < capacity) {
+        tree->nodeCapacity = capacity;
+        tree->nodes = (SGClusterNode*)realloc(tree->nodes, sizeof(SGClusterNode) * capacity);
+        tree->children = (int*)realloc(tree->children, sizeof(int) * capacity);
+        tree->roots = (int*)realloc(tree->roots, sizeof(int) * capacity);
+        tree->stack = (int*)realloc(tree->stack, sizeof(int) * capacity);
+        tree->depths = (SGClusterDepth*)realloc(tree->depths, sizeof(SGClusterDepth) * capacity);
+        tree->cells = (SGClusterCell*)realloc(tree->cells, sizeof(SGClusterCell) * capacity);
+        tree->level = (int*)realloc(tree->level, sizeof(int) * capacity);
+    }
+}
+
+SGClusterTree* SGClusterTreeNew(void) {
+    return (SGClusterTree*)calloc(1, sizeof(SGClusterTree));
+}
+
+void SGClusterTreeFree(SGClusterTree* tree) {
+    if(tree) {
+        free(tree->nodes);
+        free(tree->children);
+        free(tree->roots);
+        free(tree->stack);
+        free(tree->depths);
+        free(tree->cells);
+        free(tree->level);
+        free(tree);
+    }
+}
+
+void SGClusterTreeBuild(SGClusterTree* tree, const float* x, const float* z, const float* distance,
+                        int count, float cellSize) {
+    tree->nodeCount = 0;
+    tree->childCount = 0;
+    tree->rootCount = 0;
+    tree->leafCount = count;
+    
+    if(count <= 0)
+        return;
+    
+    // A tree with n leaves never has more than 2n - 1 nodes.
+    ensureNodeCapacity(tree, count * 2);
+    
+    int i;
+    SGClusterNode* node;
+    for(i = 0; i < count; i++) {
+        node = &tree->nodes[i];
+        node->x = x[i];
+        node->z = z[i];
+        node->radius = 0.0f;
+        node->count = 1;
+        node->representative = i;
+        node->firstChild = -1;
+        node->childCount = 0;
+        tree->roots[i] = i;
+    }
+    
+    tree->nodeCount = count;
+    tree->rootCount = count;
+    
+    SGClusterCell* cells = tree->cells;
+    int* level = tree->level;
+    float size = cellSize > 0.0f ? cellSize : 1.0f;
+    int levelCount, start, end, j, child;
+    long long cx, cz;
+    float dx, dz, extent;
+    SGClusterNode* childNode;
+    for(int depth = 0; depth < kSGClusterMaxLevels && tree->rootCount > 1; depth++) {
+        for(i = 0; i < tree->rootCount; i++) {
+            node = &tree->nodes[tree->roots[i]];
+            cx = (long long)floorf(node->x / size);
+            cz = (long long)floorf(node->z / size);
+            cells[i].key = ((unsigned long long)(cx & 0xFFFFFFFFLL) << 32) | (unsigned long long)(cz & 0xFFFFFFFFLL);
+            cells[i].node = tree->roots[i];
+        }
+        
+        SGSort(cells, tree->rootCount, sizeof(SGClusterCell), compareCells);
+        
+        levelCount = 0;
+        for(start = 0; start < tree->rootCount; start = end) {
+            end = start + 1;
+            while(end < tree->rootCount && cells[end].key == cells[start].key)
+                end++;
+            
+            // A lonely node is carried up to the next level untouched.
+            if(end - start == 1) {
+                level[levelCount++] = cells[start].node;
+                continue;
+            }
+            
+            node = &tree->nodes[tree->nodeCount];
+            node->x = 0.0f;
+            node->z = 0.0f;
+            node->radius = 0.0f;
+            node->count = 0;
+            node->representative = -1;
+            node->firstChild = tree->childCount;
+            node->childCount = end - start;
+            
+            for(j = start; j < end; j++) {
+                child = cells[j].node;
+                childNode = &tree->nodes[child];
+                tree->children[tree->childCount++] = child;
+                
+                node->x += childNode->x * childNode->count;
+                node->z += childNode->z * childNode->count;
+                node->count += childNode->count;
+                
+                if(node->representative < 0 || 
+                   distance[childNode->representative] < distance[node->representative])
+                    node->representative = childNode->representative;
+            }
+            
+            node->x /= node->count;
+            node->z /= node->count;
+            
+            for(j = start; j < end; j++) {
+                childNode = &tree->nodes[cells[j].node];
+                dx = childNode->x - node->x;
+                dz = childNode->z - node->z;
+                extent = sqrtf(dx * dx + dz * dz) + childNode->radius;
+                if(extent > node->radius)
+                    node->radius = extent;
+            }
+            
+            level[levelCount++] = tree->nodeCount++;
+        }
+        
+        for(i = 0; i < levelCount; i++)
+            tree->roots[i] = level[i];
+        
+        tree->rootCount = levelCount;
+        size *= 2.0f;
+    }
+}
+
+int SGClusterTreeCut(SGClusterTree* tree, float cameraX, float cameraZ, float tolerance,
+                     int* outNodes, int maxNodes) {
+    int emitted = 0;
+    int top = 0;
+    int i, index;
+    float dx, dz, d;
+    SGClusterNode* node;
+    
+    for(i = 0; i < tree->rootCount; i++)
+        tree->stack[top++] = tree->roots[i];
+    
+    while(top && emitted < maxNodes) {
+        index = tree->stack[--top];
+        node = &tree->nodes[index];
+        
+        if(node->firstChild < 0) {
+            outNodes[emitted++] = index;
+            continue;
+        }
+        
+        dx = node->x - cameraX;
+        dz = node->z - cameraZ;
+        d = sqrtf(dx * dx + dz * dz);
+        
+        if(d > node->radius && node->radius < d * tolerance)
+            outNodes[emitted++] = index;
+        else
+            for(i = 0; i < node->childCount; i++)
+                tree->stack[top++] = tree->children[node->firstChild + i];
+    }
+    
+    return emitted;
+}
+
+void SGClusterTreeSortBackToFront(SGClusterTree* tree, int* nodes, int count, float cameraX, float cameraZ) {
+    int i;
+    float dx, dz;
+    SGClusterDepth* depths = tree->depths;
+    for(i = 0; i < count; i++) {
+        dx = tree->nodes[nodes[i]].x - cameraX;
+        dz = tree->nodes[nodes[i]].z - cameraZ;
+        depths[i].depth = dx * dx + dz * dz;
+        depths[i].node = nodes[i];
+    }
+    
+    SGSort(depths, count, sizeof(SGClusterDepth), compareDepths);
+    
+    for(i = 0; i < count; i++)
+        nodes[i] = depths[i].node;
+}
@@ -0,0 +1,104 @@
+//
+//  SGCluster.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+/*
+* A hierarchical clustering of annotations that are laid out on the
+* ground plane of the AR environment. The hierarchy is built once whenever
+* the positions of the annotations change (e.g. a new location fix) and is
+* cut every frame based on the position of the camera. Nodes whose extent
+* subtends less than the given angular tolerance are drawn as a single
+* cluster; nodes that are too large are split into their children. The work
+* done per frame is bounded by the number of clusters that are visited.
+*/
+
+typedef struct SGClusterNodeStruct {
+    float x, z;                 /* count-weighted centroid of the node */
+    float radius;               /* radius of the circle containing every member */
+    int count;                  /* number of annotations held by the node */
+    int representative;         /* index of the member that is closest to the origin */
+    int firstChild;             /* index into SGClusterTree.children; -1 for leaves */
+    int childCount;
+} SGClusterNode;
+
+typedef struct SGClusterDepthStruct {
+    float depth;
+    int node;
+} SGClusterDepth;
+
+typedef struct SGClusterTreeStruct {
+    SGClusterNode* nodes;
+    int nodeCount;
+    int nodeCapacity;
+    
+    int* children;
+    int childCount;
+    
+    int* roots;
+    int rootCount;
+    
+    int* stack;
+    SGClusterDepth* depths;
+    
+    /* scratch space for building, kept so rebuilding does not allocate */
+    struct SGClusterCellStruct* cells;
+    int* level;
+    
+    /* the amount of annotations, which are also the first leafCount nodes */
+    int leafCount;
+} SGClusterTree;
+
+/* create a new, empty cluster tree */
+extern SGClusterTree* SGClusterTreeNew(void);
+
+/* release all memory held by the tree */
+extern void SGClusterTreeFree(SGClusterTree* tree);
+
+/* 
+* rebuild the hierarchy for count annotations located at (x[i], z[i]). distance[i] is
+* used to pick the representative of a cluster. cellSize is the size of the grid cell
+* used to merge the first level; every following level doubles the cell size.
+*/
+extern void SGClusterTreeBuild(SGClusterTree* tree, const float* x, const float* z, const float* distance,
+                               int count, float cellSize);
+
+/*
+* cut the hierarchy as seen from (cameraX, cameraZ). A node is emitted when it is a leaf
+* or when radius / distance-to-camera is below tolerance (in radians). The indices of the
+* emitted nodes are written to outNodes and the amount that was written is returned.
+*/
+extern int SGClusterTreeCut(SGClusterTree* tree, float cameraX, float cameraZ, float tolerance,
+                            int* outNodes, int maxNodes);
+
+/* sort the nodes returned by SGClusterTreeCut from the farthest to the closest to (cameraX, cameraZ) */
+extern void SGClusterTreeSortBackToFront(SGClusterTree* tree, int* nodes, int count, float cameraX, float cameraZ);
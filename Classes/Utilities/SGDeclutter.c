@@ -0,0 +1,206 @@
+//
+//  SGDeclutter.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGDeclutter.h"
+
+#import <stdlib.h>
+#import <string.h>
+#import <math.h>
+
+/* candidate offsets expressed in label widths and heights; negative y lifts the label */
+static const float kSGDeclutterCandidates[][2] = {
+    { 0.0f, 0.0f },
+    { 0.0f, -0.5f },
+    { 0.0f, -1.0f },
+    { 0.5f, 0.0f },
+    { -0.5f, 0.0f },
+    { 0.5f, -0.5f },
+    { -0.5f, -0.5f },
+    { 0.0f, -1.5f },
+};
+
+#define kSGDeclutterAmountOfCandidates  (int)(sizeof(kSGDeclutterCandidates) / sizeof(kSGDeclutterCandidates[0]))
+
+typedef struct {
+    int minColumn, maxColumn;
+    int minRow, maxRow;
+} SGDeclutterSpan;
+
+static int spanForRect(SGDeclutterGrid* grid, float x, float y, float width, float height, SGDeclutterSpan* span) {
+    span->minColumn = (int)floorf(x / grid->cellSize);
+    span->maxColumn = (int)ceilf((x + width) / grid->cellSize) - 1;
+    span->minRow = (int)floorf(y / grid->cellSize);
+    span->maxRow = (int)ceilf((y + height) / grid->cellSize) - 1;
+    
+    if(span->maxColumn < 0 || span->maxRow < 0 || span->minColumn >= grid->columns || span->minRow >= grid->rows)
+        return 0;
+    
+    if(span->minColumn < 0)
+        span->minColumn = 0;
+    if(span->minRow < 0)
+        span->minRow = 0;
+    if(span->maxColumn >= grid->columns)
+        span->maxColumn = grid->columns - 1;
+    if(span->maxRow >= grid->rows)
+        span->maxRow = grid->rows - 1;
+    
+    return 1;
+}
+
+static int spanIsFree(SGDeclutterGrid* grid, SGDeclutterSpan* span) {
+    int row, column;
+    unsigned int* cells;
+    for(row = span->minRow; row <= span->maxRow; row++) {
+        cells = grid->cells + row * grid->columns;
+        for(column = span->minColumn; column <= span->maxColumn; column++)
+            if(cells[column] == grid->stamp)
+                return 0;
+    }
+    
+    return 1;
+}
+
+static void occupySpan(SGDeclutterGrid* grid, SGDeclutterSpan* span) {
+    int row, column;
+    unsigned int* cells;
+    for(row = span->minRow; row <= span->maxRow; row++) {
+        cells = grid->cells + row * grid->columns;
+        for(column = span->minColumn; column <= span->maxColumn; column++)
+            cells[column] = grid->stamp;
+    }
+}
+
+SGDeclutterGrid* SGDeclutterGridNew(float width, float height, float cellSize) {
+    SGDeclutterGrid* grid = (SGDeclutterGrid*)calloc(1, sizeof(SGDeclutterGrid));
+    grid->cellSize = cellSize > 0.0f ? cellSize : 16.0f;
+    SGDeclutterGridBegin(grid, width, height);
+    return grid;
+}
+
+void SGDeclutterGridFree(SGDeclutterGrid* grid) {
+    if(grid) {
+        free(grid->cells);
+        free(grid);
+    }
+}
+
+void SGDeclutterGridBegin(SGDeclutterGrid* grid, float width, float height) {
+    int columns = (int)ceilf(width / grid->cellSize);
+    int rows = (int)ceilf(height / grid->cellSize);
+    if(columns < 1)
+        columns = 1;
+    if(rows < 1)
+        rows = 1;
+    
+    if(columns != grid->columns || rows != grid->rows || !grid->cells) {
+        free(grid->cells);
+        grid->columns = columns;
+        grid->rows = rows;
+        grid->cells = (unsigned int*)calloc(columns * rows, sizeof(unsigned int));
+        grid->stamp = 0;
+    }
+    
+    // Bumping the stamp empties every cell without touching them.
+    grid->stamp++;
+    if(!grid->stamp) {
+        memset(grid->cells, 0, sizeof(unsigned int) * columns * rows);
+        grid->stamp = 1;
+    }
+    
+    grid->placed = 0;
+    grid->moved = 0;
+    grid->hidden = 0;
+}
+
+void SGDeclutterStateReset(SGDeclutterState* state) {
+    state->placement = 0;
+    state->frames = 0;
+}
+
+int SGDeclutterPlace(SGDeclutterGrid* grid, SGDeclutterState* state,
+                     float x, float y, float width, float height,
+                     float* offsetX, float* offsetY) {
+    SGDeclutterSpan spans[kSGDeclutterAmountOfCandidates];
+    int onScreen[kSGDeclutterAmountOfCandidates];
+    int desired = kSGDeclutterHidden;
+    int candidate;
+    float dx, dy;
+    
+    for(candidate = 0; candidate < kSGDeclutterAmountOfCandidates; candidate++) {
+        dx = kSGDeclutterCandidates[candidate][0] * width;
+        dy = kSGDeclutterCandidates[candidate][1] * height;
+        onScreen[candidate] = spanForRect(grid, x + dx, y + dy, width, height, &spans[candidate]);
+        
+        // Labels that are off screen never collide with anything, but a
+        // label that is on screen is hidden rather than pushed out of view.
+        if(desired == kSGDeclutterHidden &&
+           (onScreen[candidate] ? spanIsFree(grid, &spans[candidate]) : !onScreen[0]))
+            desired = candidate;
+    }
+    
+    // Hysteresis: only give up the current placement after it
+    // has been contested for a couple of frames.
+    if(desired != state->placement) {
+        if(state->frames < kSGDeclutterDelay) {
+            state->frames++;
+            desired = state->placement;
+        } else
+            state->frames = 0;
+    } else
+        state->frames = 0;
+    
+    // A placement that is held on to may have left the screen since
+    if(desired != kSGDeclutterHidden && !onScreen[desired] && onScreen[0])
+        desired = kSGDeclutterHidden;
+    
+    state->placement = desired;
+    
+    if(desired == kSGDeclutterHidden) {
+        grid->hidden++;
+        *offsetX = 0.0f;
+        *offsetY = 0.0f;
+        return 0;
+    }
+    
+    if(onScreen[desired])
+        occupySpan(grid, &spans[desired]);
+    
+    if(desired)
+        grid->moved++;
+    
+    grid->placed++;
+    *offsetX = kSGDeclutterCandidates[desired][0] * width;
+    *offsetY = kSGDeclutterCandidates[desired][1] * height;
+    return 1;
+}
@@ -0,0 +1,87 @@
+//
+//  SGDeclutter.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+/*
+* A screen-space declutter pass for billboards. Labels are placed one after
+* another, nearest first, into an occupancy grid that covers the viewport.
+* When a label collides with one that was already placed it is lifted or
+* offset to the first free candidate position; if none is free the label
+* is hidden. A label is only moved off screen if it was off screen to begin
+* with. Decisions are only changed after they have been contested for
+* kSGDeclutterDelay frames which keeps labels from flickering. Each label
+* touches a bounded amount of cells so a pass is O(n) in the amount of labels.
+*/
+
+#define kSGDeclutterHidden              -1
+#define kSGDeclutterDelay               4
+
+/* state that has to be kept for a label from one frame to the next */
+typedef struct SGDeclutterStateStruct {
+    int placement;              /* index of the candidate offset or kSGDeclutterHidden */
+    int frames;                 /* consecutive frames the placement has been contested */
+} SGDeclutterState;
+
+typedef struct SGDeclutterGridStruct {
+    unsigned int* cells;
+    int columns;
+    int rows;
+    float cellSize;
+    unsigned int stamp;
+    
+    /* statistics for the current pass */
+    int placed;
+    int moved;
+    int hidden;
+} SGDeclutterGrid;
+
+/* create a new grid that covers width x height pixels */
+extern SGDeclutterGrid* SGDeclutterGridNew(float width, float height, float cellSize);
+
+/* release all memory held by the grid */
+extern void SGDeclutterGridFree(SGDeclutterGrid* grid);
+
+/* start a new pass; the grid is only resized when the viewport changes */
+extern void SGDeclutterGridBegin(SGDeclutterGrid* grid, float width, float height);
+
+/* reset the state of a label so it is placed at its original position */
+extern void SGDeclutterStateReset(SGDeclutterState* state);
+
+/*
+* place a label whose top-left corner is at (x, y) in window coordinates (y pointing down).
+* The offset, in pixels, that should be applied to the label is returned through offsetX
+* and offsetY. Returns 0 if the label should be hidden; otherwise 1.
+*/
+extern int SGDeclutterPlace(SGDeclutterGrid* grid, SGDeclutterState* state,
+                            float x, float y, float width, float height,
+                            float* offsetX, float* offsetY);
@@ -0,0 +1,155 @@
+//
+//  SGDeque.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGDeque.h"
+
+#import <stdlib.h>
+#import <string.h>
+
+#define kSGDeque_InitialCapacity    16
+
+#define MASK(__DEQUE__)             ((__DEQUE__)->capacity - 1)
+
+static void grow(SGDeque* deque) {
+    int capacity = deque->capacity * 2;
+    void** items = (void**)malloc(sizeof(void*) * capacity);
+    
+    // Unwrap the items to the start of the new buffer
+    int first = deque->capacity - deque->head;
+    if(first > deque->count)
+        first = deque->count;
+    memcpy(items, deque->items + deque->head, sizeof(void*) * first);
+    memcpy(items + first, deque->items, sizeof(void*) * (deque->count - first));
+    
+    free(deque->items);
+    deque->items = items;
+    deque->capacity = capacity;
+    deque->head = 0;
+}
+
+SGDeque* SGDequeNew(void) {
+    SGDeque* deque = (SGDeque*)malloc(sizeof(SGDeque));
+    deque->capacity = kSGDeque_InitialCapacity;
+    deque->items = (void**)malloc(sizeof(void*) * deque->capacity);
+    deque->head = 0;
+    deque->count = 0;
+    
+    return deque;
+}
+
+void SGDequeFree(SGDeque* deque) {
+    if(!deque)
+        return;
+    
+    free(deque->items);
+    free(deque);
+}
+
+void SGDequePushBack(SGDeque* deque, void* item) {
+    if(deque->count == deque->capacity)
+        grow(deque);
+    
+    deque->items[(deque->head + deque->count) & MASK(deque)] = item;
+    deque->count++;
+}
+
+void SGDequePushFront(SGDeque* deque, void* item) {
+    if(deque->count == deque->capacity)
+        grow(deque);
+    
+    deque->head = (deque->head - 1) & MASK(deque);
+    deque->items[deque->head] = item;
+    deque->count++;
+}
+
+void* SGDequePopBack(SGDeque* deque) {
+    if(!deque->count)
+        return NULL;
+    
+    deque->count--;
+    return deque->items[(deque->head + deque->count) & MASK(deque)];
+}
+
+void* SGDequePopFront(SGDeque* deque) {
+    if(!deque->count)
+        return NULL;
+    
+    void* item = deque->items[deque->head];
+    deque->head = (deque->head + 1) & MASK(deque);
+    deque->count--;
+    
+    return item;
+}
+
+int SGDequeIndexOf(const SGDeque* deque, const void* item) {
+    for(int i = 0; i < deque->count; i++)
+        if(SGDequeGet(deque, i) == item)
+            return i;
+    
+    return -1;
+}
+
+void SGDequeRemoveAt(SGDeque* deque, int index) {
+    if(index < 0 || index >= deque->count)
+        return;
+    
+    if(index < deque->count / 2) {
+        for(int i = index; i > 0; i--)
+            SGDequeGet(deque, i) = SGDequeGet(deque, i - 1);
+        
+        deque->head = (deque->head + 1) & MASK(deque);
+    } else
+        for(int i = index; i < deque->count - 1; i++)
+            SGDequeGet(deque, i) = SGDequeGet(deque, i + 1);
+    
+    deque->count--;
+}
+
+void SGDequeClear(SGDeque* deque) {
+    deque->head = 0;
+    deque->count = 0;
+}
+
+int SGDequeRun(const SGDeque* deque, int index, void*** run) {
+    if(index >= deque->count)
+        return 0;
+    
+    int start = (deque->head + index) & MASK(deque);
+    int length = deque->capacity - start;
+    if(length > deque->count - index)
+        length = deque->count - index;
+    
+    *run = deque->items + start;
+    return length;
+}
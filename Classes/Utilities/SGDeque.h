@@ -0,0 +1,79 @@
+//
+//  SGDeque.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+/*
+* A double ended queue of pointers kept in a ring buffer. Pushing and popping
+* at either end is O(1) and the buffer doubles when it fills. The items are
+* stored in at most two contiguous runs, so they can be walked without copying.
+*/
+
+typedef struct SGDequeStruct {
+    void** items;
+    int capacity;               /* always a power of two */
+    int head;                   /* position of the front item in items */
+    int count;
+} SGDeque;
+
+/* the item at position i from the front */
+#define SGDequeGet(__DEQUE__, __I__) \
+    ((__DEQUE__)->items[((__DEQUE__)->head + (__I__)) & ((__DEQUE__)->capacity - 1)])
+
+/* the front and back items; only valid if the deque is not empty */
+#define SGDequeFront(__DEQUE__)     SGDequeGet((__DEQUE__), 0)
+#define SGDequeBack(__DEQUE__)      SGDequeGet((__DEQUE__), (__DEQUE__)->count - 1)
+
+extern SGDeque* SGDequeNew(void);
+extern void SGDequeFree(SGDeque* deque);
+
+extern void SGDequePushBack(SGDeque* deque, void* item);
+extern void SGDequePushFront(SGDeque* deque, void* item);
+
+/* remove and return an item from either end; NULL if the deque is empty */
+extern void* SGDequePopBack(SGDeque* deque);
+extern void* SGDequePopFront(SGDeque* deque);
+
+/* position of the first occurence of an item from the front; -1 if it is not held */
+extern int SGDequeIndexOf(const SGDeque* deque, const void* item);
+
+/* remove the item at position i from the front, moving whichever side is shorter */
+extern void SGDequeRemoveAt(SGDeque* deque, int index);
+
+/* remove every item; the buffer is kept */
+extern void SGDequeClear(SGDeque* deque);
+
+/*
+* the run of items that starts at position i from the front and is contiguous in
+* memory. Returns the length of the run, which is 0 once i reaches the end.
+*/
+extern int SGDequeRun(const SGDeque* deque, int index, void*** run);
@@ -0,0 +1,200 @@
+//
+//  SGFastTrig.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGFastTrig.h"
+
+#import <math.h>
+
+/* pi/2 split so that q * kPiOver2_1 is exact for the quadrants we reduce */
+#define kPiOver2_1          1.5703125f
+#define kPiOver2_2          4.837512969970703125e-4f
+#define kPiOver2_3          7.54978995489188216e-8f
+#define kTwoOverPi          0.636619772367581343f
+#define kPiOver2            1.57079632679489662f
+#define kPi                 3.14159265358979324f
+
+/* keeps atan2(0, 0) finite without a branch in the kernel */
+#define kSmallestDivisor    1.0e-30f
+
+/* adding and subtracting 1.5 * 2^23 rounds a float to the nearest integer without a library call */
+#define kRoundingMagic      12582912.0f
+
+/*
+* Near-minimax coefficients on [0, pi/4] for sin(x) = x + x^3 * S(x^2) and
+* cos(x) = 1 + x^2 * C(x^2), and on [0, 1] for atan(t) = t * A(t^2). The
+* polynomials are written out so that every tier compiles to straight-line code.
+*/
+#define SIN_LOW(x)      (-1.624279152e-01f)
+#define SIN_MEDIUM(x)   (-1.666339038e-01f + (x) * 8.163281926e-03f)
+#define SIN_HIGH(x)     (-1.666665461e-01f + (x) * (8.332160762e-03f + (x) * -1.951528323e-04f))
+
+#define COS_LOW(x)      (-4.997763071e-01f + (x) * 4.048893588e-02f)
+#define COS_MEDIUM(x)   (-4.999989478e-01f + (x) * (4.165629458e-02f + (x) * -1.359782314e-03f))
+#define COS_HIGH(x)     (-4.999999973e-01f + (x) * (4.166662332e-02f + (x) * (-1.388676373e-03f + (x) * 2.439044561e-05f)))
+
+#define ATAN_LOW(x)     (9.953579549e-01f + (x) * (-2.886902346e-01f + (x) * 7.933903716e-02f))
+#define ATAN_MEDIUM(x)  (9.998663296e-01f + (x) * (-3.303047860e-01f + (x) * (1.801592948e-01f + \
+                        (x) * (-8.515634989e-02f + (x) * 2.084511339e-02f))))
+#define ATAN_HIGH(x)    (9.999993355e-01f + (x) * (-3.332986049e-01f + (x) * (1.994656262e-01f + \
+                        (x) * (-1.390861569e-01f + (x) * (9.642164493e-02f + (x) * (-5.591190774e-02f + \
+                        (x) * (2.186268436e-02f + (x) * -4.054495566e-03f)))))))
+
+/* reduce an angle to [-pi/4, pi/4] and return its quadrant */
+static inline int reduce(float angle, float* reduced) {
+    float quadrant = (angle * kTwoOverPi + kRoundingMagic) - kRoundingMagic;
+    *reduced = ((angle - quadrant * kPiOver2_1) - quadrant * kPiOver2_2) - quadrant * kPiOver2_3;
+    
+    return (int)quadrant;
+}
+
+/* rotate the sine and cosine of a reduced angle back into its quadrant */
+static inline void rotate(int quadrant, float s, float c, float* sine, float* cosine) {
+    float swappedSine = (quadrant & 1) ? c : s;
+    float swappedCosine = (quadrant & 1) ? s : c;
+    *sine = (quadrant & 2) ? -swappedSine : swappedSine;
+    *cosine = ((quadrant + 1) & 2) ? -swappedCosine : swappedCosine;
+}
+
+#define DEFINE_SIN_COS(__NAME__, __SIN__, __COS__) \
+    static inline void __NAME__(float angle, float* sine, float* cosine) { \
+        float r; \
+        int quadrant = reduce(angle, &r); \
+        float r2 = r * r; \
+        rotate(quadrant, r + r * r2 * __SIN__(r2), 1.0f + r2 * __COS__(r2), sine, cosine); \
+    }
+
+/* atan of the smaller over the larger coordinate, moved into the octant of (x, y) */
+#define DEFINE_ATAN2(__NAME__, __ATAN__) \
+    static inline float __NAME__(float y, float x) { \
+        float ax = fabsf(x); \
+        float ay = fabsf(y); \
+        float maximum = ax > ay ? ax : ay; \
+        float minimum = ax > ay ? ay : ax; \
+        float t = minimum / (maximum > kSmallestDivisor ? maximum : kSmallestDivisor); \
+        float angle = t * __ATAN__(t * t); \
+        float complement = kPiOver2 - angle; \
+        angle = ay > ax ? complement : angle; \
+        float supplement = kPi - angle; \
+        angle = x < 0.0f ? supplement : angle; \
+        return copysignf(angle, y); \
+    }
+
+DEFINE_SIN_COS(sinCosLow, SIN_LOW, COS_LOW)
+DEFINE_SIN_COS(sinCosMedium, SIN_MEDIUM, COS_MEDIUM)
+DEFINE_SIN_COS(sinCosHigh, SIN_HIGH, COS_HIGH)
+
+DEFINE_ATAN2(atan2Low, ATAN_LOW)
+DEFINE_ATAN2(atan2Medium, ATAN_MEDIUM)
+DEFINE_ATAN2(atan2High, ATAN_HIGH)
+
+float SGTrigMaximumError(SGTrigAccuracy accuracy) {
+    switch(accuracy) {
+        case kSGTrigAccuracy_Low:
+            return kSGTrigAccuracy_LowError;
+        case kSGTrigAccuracy_Medium:
+            return kSGTrigAccuracy_MediumError;
+        default:
+            return kSGTrigAccuracy_HighError;
+    }
+}
+
+void SGFastSinCos(float angle, float* sine, float* cosine, SGTrigAccuracy accuracy) {
+    switch(accuracy) {
+        case kSGTrigAccuracy_Low:
+            sinCosLow(angle, sine, cosine);
+            break;
+        case kSGTrigAccuracy_Medium:
+            sinCosMedium(angle, sine, cosine);
+            break;
+        default:
+            sinCosHigh(angle, sine, cosine);
+            break;
+    }
+}
+
+float SGFastAtan2(float y, float x, SGTrigAccuracy accuracy) {
+    switch(accuracy) {
+        case kSGTrigAccuracy_Low:
+            return atan2Low(y, x);
+        case kSGTrigAccuracy_Medium:
+            return atan2Medium(y, x);
+        default:
+            return atan2High(y, x);
+    }
+}
+
+float SGFastAsin(float x, SGTrigAccuracy accuracy) {
+    // asin(x) = atan2(x, sqrt(1 - x^2)); the factored form keeps
+    // its precision as x approaches 1.
+    float adjacent = (1.0f - x) * (1.0f + x);
+    return SGFastAtan2(x, sqrtf(adjacent > 0.0f ? adjacent : 0.0f), accuracy);
+}
+
+void SGFastSinCosArray(const float* restrict angles, float* restrict sines, float* restrict cosines, int count,
+                       SGTrigAccuracy accuracy) {
+    int i;
+    switch(accuracy) {
+        case kSGTrigAccuracy_Low:
+            for(i = 0; i < count; i++)
+                sinCosLow(angles[i], &sines[i], &cosines[i]);
+            break;
+        case kSGTrigAccuracy_Medium:
+            for(i = 0; i < count; i++)
+                sinCosMedium(angles[i], &sines[i], &cosines[i]);
+            break;
+        default:
+            for(i = 0; i < count; i++)
+                sinCosHigh(angles[i], &sines[i], &cosines[i]);
+            break;
+    }
+}
+
+void SGFastAtan2Array(const float* restrict y, const float* restrict x, float* restrict angles, int count,
+                      SGTrigAccuracy accuracy) {
+    int i;
+    switch(accuracy) {
+        case kSGTrigAccuracy_Low:
+            for(i = 0; i < count; i++)
+                angles[i] = atan2Low(y[i], x[i]);
+            break;
+        case kSGTrigAccuracy_Medium:
+            for(i = 0; i < count; i++)
+                angles[i] = atan2Medium(y[i], x[i]);
+            break;
+        default:
+            for(i = 0; i < count; i++)
+                angles[i] = atan2High(y[i], x[i]);
+            break;
+    }
+}
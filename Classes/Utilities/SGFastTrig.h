@@ -0,0 +1,73 @@
+//
+//  SGFastTrig.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+/*
+* Single precision polynomial approximations of sin, cos, atan2 and asin.
+* Each call site picks the accuracy that it needs; the less accurate tiers
+* evaluate shorter polynomials. The maximum absolute error of every tier,
+* measured against the C library in double precision, is published below
+* and checked by Tests/SGFastTrigTest.c.
+*
+* sin and cos are reduced to [-pi/4, pi/4] with a three part pi/2, which
+* keeps the error within the published bound for angles up to about 10^4
+* radians. The array versions have no branches in their loops so that the
+* compiler can vectorize them.
+*/
+
+typedef enum {
+    kSGTrigAccuracy_Low = 0,        /* pixels on screen, radar blips */
+    kSGTrigAccuracy_Medium,         /* billboard placement and rotation */
+    kSGTrigAccuracy_High            /* geodesy; close to the precision of a float */
+} SGTrigAccuracy;
+
+/* maximum absolute error in radians, or in units of the result for sin and cos */
+#define kSGTrigAccuracy_LowError        1.0e-3f
+#define kSGTrigAccuracy_MediumError     2.0e-5f
+#define kSGTrigAccuracy_HighError       5.0e-7f
+
+/* returns the published maximum error of a tier */
+extern float SGTrigMaximumError(SGTrigAccuracy accuracy);
+
+/* sine and cosine of an angle in radians */
+extern void SGFastSinCos(float angle, float* sine, float* cosine, SGTrigAccuracy accuracy);
+
+/* angle of the point (x, y) in radians, in [-pi, pi] */
+extern float SGFastAtan2(float y, float x, SGTrigAccuracy accuracy);
+
+/* arc sine in radians for x in [-1, 1] */
+extern float SGFastAsin(float x, SGTrigAccuracy accuracy);
+
+/* the same functions applied to count elements; the outputs may not alias the inputs */
+extern void SGFastSinCosArray(const float* angles, float* sines, float* cosines, int count, SGTrigAccuracy accuracy);
+extern void SGFastAtan2Array(const float* y, const float* x, float* angles, int count, SGTrigAccuracy accuracy);
@@ -0,0 +1,166 @@
+//
+//  SGGLState.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import "SGGLState.h"
+
+#import <string.h>
+
+/* a capability or a client state */
+typedef struct SGGLSwitchStruct {
+    unsigned int name;
+    int enabled;
+    int known;
+} SGGLSwitch;
+
+static SGGLFunctions functions;
+static int hasFunctions = 0;
+static unsigned int generation = 0;
+
+static SGGLSwitch capabilities[kSGGLState_MaximumSwitches];
+static SGGLSwitch clientStates[kSGGLState_MaximumSwitches];
+static int amountOfCapabilities = 0;
+static int amountOfClientStates = 0;
+
+static unsigned int boundTarget;
+static unsigned int boundTexture;
+static int textureKnown = 0;
+
+static SGGLCounts counts;
+
+/* the switch that tracks name, or NULL once the table is full */
+static SGGLSwitch* findSwitch(SGGLSwitch* switches, int* amount, unsigned int name) {
+    for(int i = 0; i < *amount; i++)
+        if(switches[i].name == name)
+            return &switches[i];
+    
+    if(*amount == kSGGLState_MaximumSwitches)
+        return NULL;
+    
+    SGGLSwitch* added = &switches[(*amount)++];
+    added->name = name;
+    added->known = 0;
+    return added;
+}
+
+/* returns 1 if the switch has to be sent to the driver */
+static int flip(SGGLSwitch* switches, int* amount, unsigned int name, int enabled) {
+    SGGLSwitch* tracked = findSwitch(switches, amount, name);
+    if(tracked && tracked->known && tracked->enabled == enabled) {
+        counts.skipped++;
+        return 0;
+    }
+    
+    if(tracked) {
+        tracked->enabled = enabled;
+        tracked->known = 1;
+    }
+    
+    counts.stateChanges++;
+    return hasFunctions;
+}
+
+void SGGLStateContextCreated(const SGGLFunctions* newFunctions) {
+    functions = *newFunctions;
+    hasFunctions = 1;
+    generation++;
+    SGGLStateInvalidate();
+}
+
+unsigned int SGGLStateGeneration(void) {
+    return generation;
+}
+
+void SGGLStateInvalidate(void) {
+    for(int i = 0; i < amountOfCapabilities; i++)
+        capabilities[i].known = 0;
+    for(int i = 0; i < amountOfClientStates; i++)
+        clientStates[i].known = 0;
+    
+    textureKnown = 0;
+}
+
+void SGGLStateEnable(unsigned int capability) {
+    if(flip(capabilities, &amountOfCapabilities, capability, 1))
+        functions.enable(capability);
+}
+
+void SGGLStateDisable(unsigned int capability) {
+    if(flip(capabilities, &amountOfCapabilities, capability, 0))
+        functions.disable(capability);
+}
+
+void SGGLStateEnableClientState(unsigned int array) {
+    if(flip(clientStates, &amountOfClientStates, array, 1))
+        functions.enableClientState(array);
+}
+
+void SGGLStateDisableClientState(unsigned int array) {
+    if(flip(clientStates, &amountOfClientStates, array, 0))
+        functions.disableClientState(array);
+}
+
+void SGGLStateBindTexture(unsigned int target, unsigned int texture) {
+    if(textureKnown && boundTarget == target && boundTexture == texture) {
+        counts.skipped++;
+        return;
+    }
+    
+    boundTarget = target;
+    boundTexture = texture;
+    textureKnown = 1;
+    
+    counts.binds++;
+    if(hasFunctions)
+        functions.bindTexture(target, texture);
+}
+
+void SGGLStateDrawArrays(unsigned int mode, int first, int count) {
+    counts.drawCalls++;
+    if(hasFunctions)
+        functions.drawArrays(mode, first, count);
+}
+
+void SGGLStateDeleteTexture(unsigned int texture) {
+    if(textureKnown && boundTexture == texture)
+        boundTexture = 0;
+}
+
+void SGGLStateBeginFrame(void) {
+    memset(&counts, 0, sizeof(SGGLCounts));
+}
+
+SGGLCounts SGGLStateEndFrame(void) {
+    return counts;
+}
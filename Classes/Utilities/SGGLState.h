@@ -0,0 +1,95 @@
+//
+//  SGGLState.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+/*
+* A thin tracker of the OpenGL state that the environment changes while it
+* draws. Enabling a capability or a client state that is already enabled,
+* and binding the texture that is already bound, is skipped instead of
+* being sent to the driver. The tracker only knows what went through it, so
+* code that calls OpenGL directly, like annotation views that draw
+* themselves, is followed by SGGLStateInvalidate.
+*
+* Every context that is created starts a new generation. Textures remember
+* the generation that they were uploaded in and are uploaded again once it
+* has passed, which spares asking the driver with glIsTexture before every
+* draw. The binds, state changes, draw calls and skipped calls are counted
+* per frame.
+*
+* The OpenGL entry points are passed in when a context is created so that
+* the tracker does not depend on the OpenGL headers.
+*/
+
+#define kSGGLState_MaximumSwitches      8       /* capabilities and client states that are tracked each */
+
+typedef struct SGGLFunctionsStruct {
+    void (*enable)(unsigned int capability);
+    void (*disable)(unsigned int capability);
+    void (*enableClientState)(unsigned int array);
+    void (*disableClientState)(unsigned int array);
+    void (*bindTexture)(unsigned int target, unsigned int texture);
+    void (*drawArrays)(unsigned int mode, int first, int count);
+} SGGLFunctions;
+
+typedef struct SGGLCountsStruct {
+    unsigned int binds;
+    unsigned int stateChanges;  /* capabilities and client states that were enabled or disabled */
+    unsigned int drawCalls;
+    unsigned int skipped;       /* calls that would not have changed the state */
+} SGGLCounts;
+
+/* use the entry points of a context that was just created and start a new generation */
+extern void SGGLStateContextCreated(const SGGLFunctions* functions);
+
+/* the generation of the current context; 0 before the first one was created */
+extern unsigned int SGGLStateGeneration(void);
+
+/* forget what is known about the state after OpenGL was called directly */
+extern void SGGLStateInvalidate(void);
+
+extern void SGGLStateEnable(unsigned int capability);
+extern void SGGLStateDisable(unsigned int capability);
+extern void SGGLStateEnableClientState(unsigned int array);
+extern void SGGLStateDisableClientState(unsigned int array);
+extern void SGGLStateBindTexture(unsigned int target, unsigned int texture);
+extern void SGGLStateDrawArrays(unsigned int mode, int first, int count);
+
+/* call before glDeleteTextures; OpenGL unbinds a texture that is deleted */
+extern void SGGLStateDeleteTexture(unsigned int texture);
+
+/* start counting the calls of a frame */
+extern void SGGLStateBeginFrame(void);
+
+/* return what was counted since the frame began */
+extern SGGLCounts SGGLStateEndFrame(void);
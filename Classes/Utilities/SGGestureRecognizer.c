@@ -0,0 +1,281 @@
+//
+//  SGGestureRecognizer.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGGestureRecognizer.h"
+
+#import <string.h>
+#import <math.h>
+
+static float distanceBetweenPoints(SGGesturePoint first, SGGesturePoint second) {
+    float x = first.x - second.x;
+    float y = first.y - second.y;
+    
+    return sqrtf(x * x + y * y);
+}
+
+static SGGestureEvent* addEvent(SGGestureRecognizer* recognizer, SGGestureEventType type, double timestamp,
+                                SGGesturePoint from, SGGesturePoint to) {
+    SGGestureEvent* event = &recognizer->events[recognizer->amountOfEvents++];
+    event->type = type;
+    event->timestamp = timestamp;
+    event->from = from;
+    event->to = to;
+    event->distance = 0.0f;
+    event->velocity = 0.0f;
+    
+    return event;
+}
+
+/* fold the current spread of the fingers into the smoothed spread velocity */
+static void updateSpread(SGGestureRecognizer* recognizer, float spread, double timestamp) {
+    double interval = timestamp - recognizer->lastSpreadTimestamp;
+    if(interval <= 0.0)
+        return;
+    
+    // A pinch that was resting starts again from rest
+    if(interval > recognizer->pinchTimeout)
+        recognizer->spreadVelocity = 0.0f;
+    
+    float velocity = (spread - recognizer->lastSpread) / interval;
+    float weight = interval / (recognizer->pinchSmoothing + interval);
+    recognizer->spreadVelocity += (velocity - recognizer->spreadVelocity) * weight;
+    recognizer->lastSpread = spread;
+    recognizer->lastSpreadTimestamp = timestamp;
+}
+
+static void touchesBegan(SGGestureRecognizer* recognizer, const SGTouchSample* sample) {
+    double timestamp = sample->timestamp;
+    
+    if(sample->count >= 2) {
+        if(recognizer->state == kSGGestureState_TwoFingers || recognizer->state == kSGGestureState_Pinching)
+            return;
+        
+        if(recognizer->state == kSGGestureState_Dragging)
+            addEvent(recognizer, kSGGestureEvent_DragEnded, timestamp, recognizer->lastPoint, recognizer->lastPoint);
+        
+        float spread = distanceBetweenPoints(sample->points[0], sample->points[1]);
+        recognizer->state = kSGGestureState_TwoFingers;
+        recognizer->initialSpread = spread;
+        recognizer->lastSpread = spread;
+        recognizer->lastSpreadTimestamp = timestamp;
+        recognizer->spreadVelocity = 0.0f;
+        return;
+    }
+    
+    SGGesturePoint point = sample->points[0];
+    recognizer->isSecondTap = recognizer->tapPending &&
+                              timestamp - recognizer->tapTimestamp <= recognizer->doubleTapInterval &&
+                              distanceBetweenPoints(point, recognizer->tapPoint) <= recognizer->doubleTapSlop;
+    
+    // The single tap has already been acted on, so it has to be taken back
+    if(recognizer->isSecondTap) {
+        addEvent(recognizer, kSGGestureEvent_SingleTapCancelled, timestamp, recognizer->tapPoint, recognizer->tapPoint);
+        addEvent(recognizer, kSGGestureEvent_DoubleTap, timestamp, point, point);
+    }
+    
+    recognizer->tapPending = 0;
+    recognizer->state = kSGGestureState_Touching;
+    recognizer->startTimestamp = timestamp;
+    recognizer->startPoint = point;
+    recognizer->lastPoint = point;
+}
+
+static void touchesMoved(SGGestureRecognizer* recognizer, const SGTouchSample* sample) {
+    double timestamp = sample->timestamp;
+    
+    if(sample->count >= 2) {
+        if(recognizer->state != kSGGestureState_TwoFingers && recognizer->state != kSGGestureState_Pinching)
+            return;
+        
+        float previousSpread = recognizer->lastSpread;
+        float spread = distanceBetweenPoints(sample->points[0], sample->points[1]);
+        updateSpread(recognizer, spread, timestamp);
+        
+        // Small changes are expected while two fingers tap
+        if(recognizer->state == kSGGestureState_TwoFingers) {
+            if(fabsf(spread - recognizer->initialSpread) <= recognizer->minimumPinchDelta)
+                return;
+            
+            recognizer->state = kSGGestureState_Pinching;
+        }
+        
+        if(spread != previousSpread) {
+            SGGestureEvent* event = addEvent(recognizer,
+                                             spread < previousSpread ? kSGGestureEvent_Pinch : kSGGestureEvent_Pull,
+                                             timestamp, sample->points[0], sample->points[1]);
+            event->distance = spread;
+            event->velocity = recognizer->spreadVelocity;
+        }
+        
+        return;
+    }
+    
+    SGGesturePoint point = sample->points[0];
+    if(recognizer->state == kSGGestureState_Touching || recognizer->state == kSGGestureState_Dragging) {
+        SGGesturePoint start = recognizer->startPoint;
+        float deltaX = fabsf(point.x - start.x);
+        float deltaY = fabsf(point.y - start.y);
+        
+        if(!recognizer->isSecondTap && timestamp - recognizer->startTimestamp <= recognizer->maximumSwipeDuration) {
+            if(deltaX >= recognizer->minimumSwipeLength && deltaY <= recognizer->maximumSwipeVariance) {
+                addEvent(recognizer, kSGGestureEvent_HorizontalSwipe, timestamp, start, point);
+                recognizer->state = kSGGestureState_Swiped;
+            } else if(deltaY >= recognizer->minimumSwipeLength && deltaX <= recognizer->maximumSwipeVariance) {
+                addEvent(recognizer, kSGGestureEvent_VerticalSwipe, timestamp, start, point);
+                recognizer->state = kSGGestureState_Swiped;
+            }
+        }
+        
+        if(recognizer->state != kSGGestureState_Swiped &&
+           (recognizer->state == kSGGestureState_Dragging ||
+            distanceBetweenPoints(point, start) > recognizer->tapSlop)) {
+            addEvent(recognizer, kSGGestureEvent_Drag, timestamp, start, point);
+            recognizer->state = kSGGestureState_Dragging;
+        }
+    }
+    
+    recognizer->lastPoint = point;
+}
+
+static void touchesEnded(SGGestureRecognizer* recognizer, const SGTouchSample* sample) {
+    double timestamp = sample->timestamp;
+    SGGesturePoint point = sample->points[0];
+    
+    switch(recognizer->state) {
+        case kSGGestureState_TwoFingers:
+            if(sample->count >= 2)
+                addEvent(recognizer, kSGGestureEvent_TwoFingerTap, timestamp, sample->points[0], sample->points[1]);
+            break;
+        case kSGGestureState_Dragging:
+            addEvent(recognizer, kSGGestureEvent_DragEnded, timestamp, point, point);
+            break;
+        case kSGGestureState_Touching:
+            if(!recognizer->isSecondTap &&
+               timestamp - recognizer->startTimestamp <= recognizer->maximumTapDuration &&
+               distanceBetweenPoints(point, recognizer->startPoint) <= recognizer->tapSlop) {
+                addEvent(recognizer, kSGGestureEvent_SingleTap, timestamp, recognizer->startPoint, recognizer->startPoint);
+                recognizer->tapPending = 1;
+                recognizer->tapTimestamp = timestamp;
+                recognizer->tapPoint = recognizer->startPoint;
+            }
+            break;
+        default:
+            break;
+    }
+    
+    recognizer->isSecondTap = 0;
+    recognizer->spreadVelocity = 0.0f;
+    
+    // The rest of the fingers no longer start a gesture of their own
+    if(sample->count > sample->lifted) {
+        recognizer->state = kSGGestureState_Lifting;
+        return;
+    }
+    
+    addEvent(recognizer, kSGGestureEvent_Released, timestamp, point, point);
+    recognizer->state = kSGGestureState_Idle;
+}
+
+void SGGestureRecognizerReset(SGGestureRecognizer* recognizer) {
+    memset(recognizer, 0, sizeof(SGGestureRecognizer));
+    
+    recognizer->state = kSGGestureState_Idle;
+    recognizer->tapSlop = kSGGesture_TapSlop;
+    recognizer->maximumTapDuration = kSGGesture_MaximumTapDuration;
+    recognizer->doubleTapInterval = kSGGesture_DoubleTapInterval;
+    recognizer->doubleTapSlop = kSGGesture_DoubleTapSlop;
+    recognizer->minimumSwipeLength = kSGGesture_MinimumSwipeLength;
+    recognizer->maximumSwipeVariance = kSGGesture_MaximumSwipeVariance;
+    recognizer->maximumSwipeDuration = kSGGesture_MaximumSwipeDuration;
+    recognizer->minimumPinchDelta = kSGGesture_MinimumPinchDelta;
+    recognizer->pinchSmoothing = kSGGesture_PinchSmoothing;
+    recognizer->pinchTimeout = kSGGesture_PinchTimeout;
+}
+
+int SGGestureRecognizerAddSample(SGGestureRecognizer* recognizer, const SGTouchSample* sample) {
+    recognizer->amountOfEvents = 0;
+    
+    if(sample->count < 1 && sample->phase != kSGTouchPhase_Cancelled)
+        return 0;
+    
+    switch(sample->phase) {
+        case kSGTouchPhase_Began:
+            touchesBegan(recognizer, sample);
+            break;
+        case kSGTouchPhase_Moved:
+            touchesMoved(recognizer, sample);
+            break;
+        case kSGTouchPhase_Ended:
+            touchesEnded(recognizer, sample);
+            break;
+        default:
+            recognizer->state = kSGGestureState_Idle;
+            recognizer->isSecondTap = 0;
+            recognizer->spreadVelocity = 0.0f;
+            break;
+    }
+    
+    return recognizer->amountOfEvents;
+}
+
+float SGGestureRecognizerPinchVelocity(const SGGestureRecognizer* recognizer, double timestamp) {
+    if(recognizer->state != kSGGestureState_Pinching ||
+       timestamp - recognizer->lastSpreadTimestamp > recognizer->pinchTimeout)
+        return 0.0f;
+    
+    return recognizer->spreadVelocity;
+}
+
+void SGGestureQueueClear(SGGestureQueue* queue) {
+    queue->amountOfEvents = 0;
+}
+
+int SGGestureQueueAdd(SGGestureQueue* queue, const SGGestureEvent* event) {
+    if(queue->amountOfEvents) {
+        SGGestureEvent* last = &queue->events[queue->amountOfEvents - 1];
+        if(last->type == event->type &&
+           (event->type == kSGGestureEvent_Drag || event->type == kSGGestureEvent_Pinch ||
+            event->type == kSGGestureEvent_Pull)) {
+            *last = *event;
+            queue->coalescedEvents++;
+            return 1;
+        }
+    }
+    
+    if(queue->amountOfEvents >= kSGGestureQueue_Capacity)
+        return 0;
+    
+    queue->events[queue->amountOfEvents++] = *event;
+    return 1;
+}
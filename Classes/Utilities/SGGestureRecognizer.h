@@ -0,0 +1,188 @@
+//
+//  SGGestureRecognizer.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+/*
+* A touch gesture recognizer that is driven by timestamped touch samples and
+* does not depend on UIKit or timers. A single tap is reported as soon as the
+* finger is lifted instead of waiting to rule out a double tap; if a second tap
+* follows, the single tap is rolled back and the double tap is reported. Pinches
+* are tracked as a smoothed velocity of the finger spread so that anything driven
+* by them moves at the same speed regardless of how often touches are delivered.
+*/
+
+#define kSGGesture_TapSlop                  10.0f       /* pixels */
+#define kSGGesture_MaximumTapDuration       0.35        /* seconds */
+#define kSGGesture_DoubleTapInterval        0.3         /* seconds from release to the next touch */
+#define kSGGesture_DoubleTapSlop            40.0f       /* pixels */
+#define kSGGesture_MinimumSwipeLength       80.0f       /* pixels */
+#define kSGGesture_MaximumSwipeVariance     20.0f       /* pixels */
+#define kSGGesture_MaximumSwipeDuration     0.5         /* seconds */
+#define kSGGesture_MinimumPinchDelta        5.0f        /* pixels */
+#define kSGGesture_PinchSmoothing           0.05        /* seconds */
+#define kSGGesture_PinchTimeout             0.1         /* seconds without movement before the pinch stops */
+#define kSGGesture_MaximumEvents            4
+#define kSGGestureQueue_Capacity            16
+
+typedef enum {
+    kSGTouchPhase_Began = 0,
+    kSGTouchPhase_Moved,
+    kSGTouchPhase_Ended,
+    kSGTouchPhase_Cancelled
+} SGTouchPhase;
+
+typedef enum {
+    kSGGestureEvent_SingleTap = 0,          /* reported optimistically when the finger is lifted */
+    kSGGestureEvent_SingleTapCancelled,     /* the last single tap turned out to be part of a double tap */
+    kSGGestureEvent_DoubleTap,
+    kSGGestureEvent_TwoFingerTap,
+    kSGGestureEvent_Drag,
+    kSGGestureEvent_DragEnded,
+    kSGGestureEvent_HorizontalSwipe,
+    kSGGestureEvent_VerticalSwipe,
+    kSGGestureEvent_Pinch,                  /* the fingers move together */
+    kSGGestureEvent_Pull,                   /* the fingers move apart */
+    kSGGestureEvent_Released
+} SGGestureEventType;
+
+typedef enum {
+    kSGGestureState_Idle = 0,
+    kSGGestureState_Touching,
+    kSGGestureState_Dragging,
+    kSGGestureState_Swiped,
+    kSGGestureState_TwoFingers,
+    kSGGestureState_Pinching,
+    kSGGestureState_Lifting
+} SGGestureState;
+
+typedef struct SGGesturePointStruct {
+    float x, y;
+} SGGesturePoint;
+
+/* the touches on the screen at one instant */
+typedef struct SGTouchSampleStruct {
+    double timestamp;           /* seconds */
+    SGTouchPhase phase;
+    int count;                  /* touches on the screen, including the ones that end with this sample */
+    int lifted;                 /* touches that end with this sample */
+    SGGesturePoint points[2];   /* the touches that end with this sample come first */
+} SGTouchSample;
+
+/*
+* For taps, from is the point of the tap. For drags and swipes, from is where the
+* finger went down and to is where it is now. For the two finger gestures, from
+* and to are the two fingers.
+*/
+typedef struct SGGestureEventStruct {
+    SGGestureEventType type;
+    double timestamp;           /* timestamp of the sample that produced the event */
+    SGGesturePoint from;
+    SGGesturePoint to;
+    float distance;             /* pinch: the spread of the fingers in pixels */
+    float velocity;             /* pinch: the smoothed change of the spread in pixels per second */
+} SGGestureEvent;
+
+typedef struct SGGestureRecognizerStruct {
+    SGGestureState state;
+    
+    /* the current touch sequence */
+    double startTimestamp;
+    SGGesturePoint startPoint;
+    SGGesturePoint lastPoint;
+    int isSecondTap;
+    
+    /* the last single tap, while it can still become a double tap */
+    int tapPending;
+    double tapTimestamp;
+    SGGesturePoint tapPoint;
+    
+    /* pinch */
+    float initialSpread;
+    float lastSpread;
+    double lastSpreadTimestamp;
+    float spreadVelocity;
+    
+    /* tuning */
+    float tapSlop;
+    double maximumTapDuration;
+    double doubleTapInterval;
+    float doubleTapSlop;
+    float minimumSwipeLength;
+    float maximumSwipeVariance;
+    double maximumSwipeDuration;
+    float minimumPinchDelta;
+    double pinchSmoothing;
+    double pinchTimeout;
+    
+    /* produced by the last sample */
+    SGGestureEvent events[kSGGesture_MaximumEvents];
+    int amountOfEvents;
+} SGGestureRecognizer;
+
+/*
+* Events that wait for the next frame. A drag, pinch or pull replaces one of the
+* same type that is already at the end of the queue, so however many touches
+* arrive between two frames, only the latest position is acted on. Every other
+* event is kept in order.
+*/
+typedef struct SGGestureQueueStruct {
+    SGGestureEvent events[kSGGestureQueue_Capacity];
+    int amountOfEvents;
+    
+    /* statistics */
+    unsigned int coalescedEvents;
+} SGGestureQueue;
+
+/* forget any touches in progress and restore the default tuning */
+extern void SGGestureRecognizerReset(SGGestureRecognizer* recognizer);
+
+/*
+* feed a sample into the recognizer. The events that the sample produced are
+* left in recognizer->events and their amount is returned.
+*/
+extern int SGGestureRecognizerAddSample(SGGestureRecognizer* recognizer, const SGTouchSample* sample);
+
+/*
+* the velocity of the finger spread in pixels per second at the given time. This
+* is 0 unless a pinch is in progress and the fingers have moved recently.
+*/
+extern float SGGestureRecognizerPinchVelocity(const SGGestureRecognizer* recognizer, double timestamp);
+
+/* empty the queue; the statistics are kept */
+extern void SGGestureQueueClear(SGGestureQueue* queue);
+
+/*
+* add an event to the end of the queue. Returns 0 if the event did not fit, in which
+* case the queue has to be emptied first; otherwise 1.
+*/
+extern int SGGestureQueueAdd(SGGestureQueue* queue, const SGGestureEvent* event);
@@ -0,0 +1,632 @@
+//
+//  SGImageBuffer.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGImageBuffer.h"
+
+#import <stdint.h>
+#import <string.h>
+#import <math.h>
+
+#if defined(SG_IMAGE_NO_SIMD)
+#elif defined(__SSE2__)
+#import <emmintrin.h>
+#define SG_IMAGE_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#import <arm_neon.h>
+#define SG_IMAGE_NEON
+#endif
+
+#define kTileSize           32          /* pixels on a side of the blocks that are transposed at once */
+#define kOne                (1 << kSGImageBuffer_WeightBits)
+#define kRounding           (1 << (kSGImageBuffer_WeightBits - 1))
+
+/* the taps of every output row or column of a resampling pass */
+typedef struct {
+    int* starts;
+    int* counts;
+    int16_t* weights;       /* maxCount weights for each output */
+    int maxCount;
+} Contributions;
+
+static inline unsigned char clampByte(int value) {
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static double sinc(double x) {
+    if(x == 0.0)
+        return 1.0;
+    
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+static double filterSupport(SGImageFilter filter) {
+    switch(filter) {
+        case kSGImageFilter_Bilinear:
+            return 1.0;
+        case kSGImageFilter_Lanczos:
+            return 3.0;
+        default:
+            return 0.5;
+    }
+}
+
+static double filterWeight(SGImageFilter filter, double x) {
+    switch(filter) {
+        case kSGImageFilter_Bilinear:
+            x = fabs(x);
+            return x < 1.0 ? 1.0 - x : 0.0;
+        case kSGImageFilter_Lanczos:
+            return fabs(x) < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+        default:
+            return x > -0.5 && x <= 0.5 ? 1.0 : 0.0;
+    }
+}
+
+/*
+* The weights of each output are scaled by a gain that runs linearly from the
+* first output to the last one, so that a pass can fade the image as it goes.
+*/
+static void buildContributions(Contributions* contributions, int inputLength, int outputLength,
+                               SGImageFilter filter, float firstGain, float lastGain) {
+    double scale = (double)inputLength / outputLength;
+    double filterScale = scale > 1.0 ? scale : 1.0;
+    double support = filterSupport(filter) * filterScale;
+    int maxCount = (int)ceil(support) * 2 + 1;
+    
+    contributions->maxCount = maxCount;
+    contributions->starts = (int*)malloc(sizeof(int) * outputLength);
+    contributions->counts = (int*)malloc(sizeof(int) * outputLength);
+    contributions->weights = (int16_t*)calloc((size_t)outputLength * maxCount, sizeof(int16_t));
+    
+    double* taps = (double*)malloc(sizeof(double) * maxCount);
+    double center, sum, gain;
+    int16_t* weights;
+    int start, end, count, total, fixed, largest;
+    for(int i = 0; i < outputLength; i++) {
+        center = (i + 0.5) * scale;
+        start = (int)(center - support + 0.5);
+        end = (int)(center + support + 0.5);
+        if(start < 0)
+            start = 0;
+        if(end > inputLength)
+            end = inputLength;
+        
+        count = end - start;
+        if(count > maxCount)
+            count = maxCount;
+        
+        sum = 0.0;
+        for(int k = 0; k < count; k++) {
+            taps[k] = filterWeight(filter, (start + k + 0.5 - center) / filterScale);
+            sum += taps[k];
+        }
+        
+        // Nothing fell under the filter; take the nearest input
+        if(sum == 0.0) {
+            start = (int)center;
+            if(start >= inputLength)
+                start = inputLength - 1;
+            count = 1;
+            taps[0] = sum = 1.0;
+        }
+        
+        gain = firstGain + (lastGain - firstGain) * (i + 0.5) / outputLength;
+        total = (int)floor(gain * kOne + 0.5);
+        
+        // The rounding error goes to the largest weight so that the weights add up exactly
+        weights = contributions->weights + (size_t)i * maxCount;
+        fixed = 0;
+        largest = 0;
+        for(int k = 0; k < count; k++) {
+            weights[k] = (int16_t)floor(taps[k] / sum * total + 0.5);
+            fixed += weights[k];
+            if(abs(weights[k]) > abs(weights[largest]))
+                largest = k;
+        }
+        weights[largest] += total - fixed;
+        
+        contributions->starts[i] = start;
+        contributions->counts[i] = count;
+    }
+    
+    free(taps);
+}
+
+static void freeContributions(Contributions* contributions) {
+    free(contributions->starts);
+    free(contributions->counts);
+    free(contributions->weights);
+}
+
+/* one output pixel from count neighbouring input pixels */
+static inline void filterPixel(const unsigned char* pixels, const int16_t* weights, int count, unsigned char* output) {
+#if defined(SG_IMAGE_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    __m128i sum = _mm_set1_epi32(kRounding);
+    __m128i pixel, weight;
+    int k = 0;
+    
+    // Two pixels at a time, with their channels interleaved for madd
+    for(; k + 1 < count; k += 2) {
+        pixel = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(pixels + k * 4)), zero);
+        pixel = _mm_unpacklo_epi16(pixel, _mm_srli_si128(pixel, 8));
+        weight = _mm_set1_epi32((int)(((uint32_t)(uint16_t)weights[k + 1] << 16) | (uint16_t)weights[k]));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(pixel, weight));
+    }
+    
+    if(k < count) {
+        int value;
+        memcpy(&value, pixels + k * 4, 4);
+        pixel = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(pixel, _mm_set1_epi32((uint16_t)weights[k])));
+    }
+    
+    sum = _mm_srai_epi32(sum, kSGImageBuffer_WeightBits);
+    sum = _mm_packs_epi32(sum, sum);
+    sum = _mm_packus_epi16(sum, sum);
+    
+    int result = _mm_cvtsi128_si32(sum);
+    memcpy(output, &result, 4);
+#elif defined(SG_IMAGE_NEON)
+    int32x4_t sum = vdupq_n_s32(kRounding);
+    uint32_t value;
+    int16x4_t pixel;
+    for(int k = 0; k < count; k++) {
+        memcpy(&value, pixels + k * 4, 4);
+        pixel = vget_low_s16(vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(value)))));
+        sum = vmlal_n_s16(sum, pixel, weights[k]);
+    }
+    
+    int16x4_t narrow = vqshrn_n_s32(sum, kSGImageBuffer_WeightBits);
+    uint8x8_t bytes = vqmovun_s16(vcombine_s16(narrow, narrow));
+    value = vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+    memcpy(output, &value, 4);
+#else
+    int r = kRounding, g = kRounding, b = kRounding, a = kRounding;
+    for(int k = 0; k < count; k++, pixels += 4) {
+        r += pixels[0] * weights[k];
+        g += pixels[1] * weights[k];
+        b += pixels[2] * weights[k];
+        a += pixels[3] * weights[k];
+    }
+    
+    output[0] = clampByte(r >> kSGImageBuffer_WeightBits);
+    output[1] = clampByte(g >> kSGImageBuffer_WeightBits);
+    output[2] = clampByte(b >> kSGImageBuffer_WeightBits);
+    output[3] = clampByte(a >> kSGImageBuffer_WeightBits);
+#endif
+}
+
+/* one output row of length bytes from count input rows that are stride bytes apart */
+static inline void filterRow(const unsigned char* rows, long stride, const int16_t* weights, int count,
+                             unsigned char* output, int length) {
+    int i = 0;
+    
+#if defined(SG_IMAGE_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    __m128i sum0, sum1, sum2, sum3, first, second, low, high, weight;
+    int k;
+    for(; i + 16 <= length; i += 16) {
+        sum0 = sum1 = sum2 = sum3 = _mm_set1_epi32(kRounding);
+        
+        // Two rows at a time, with their bytes interleaved for madd
+        for(k = 0; k + 1 < count; k += 2) {
+            first = _mm_loadu_si128((const __m128i*)(rows + k * stride + i));
+            second = _mm_loadu_si128((const __m128i*)(rows + (k + 1) * stride + i));
+            weight = _mm_set1_epi32((int)(((uint32_t)(uint16_t)weights[k + 1] << 16) | (uint16_t)weights[k]));
+            
+            low = _mm_unpacklo_epi8(first, second);
+            high = _mm_unpackhi_epi8(first, second);
+            sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi8(low, zero), weight));
+            sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi8(low, zero), weight));
+            sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_unpacklo_epi8(high, zero), weight));
+            sum3 = _mm_add_epi32(sum3, _mm_madd_epi16(_mm_unpackhi_epi8(high, zero), weight));
+        }
+        
+        if(k < count) {
+            first = _mm_loadu_si128((const __m128i*)(rows + k * stride + i));
+            weight = _mm_set1_epi32((uint16_t)weights[k]);
+            
+            low = _mm_unpacklo_epi8(first, zero);
+            high = _mm_unpackhi_epi8(first, zero);
+            sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi16(low, zero), weight));
+            sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi16(low, zero), weight));
+            sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_unpacklo_epi16(high, zero), weight));
+            sum3 = _mm_add_epi32(sum3, _mm_madd_epi16(_mm_unpackhi_epi16(high, zero), weight));
+        }
+        
+        low = _mm_packs_epi32(_mm_srai_epi32(sum0, kSGImageBuffer_WeightBits), _mm_srai_epi32(sum1, kSGImageBuffer_WeightBits));
+        high = _mm_packs_epi32(_mm_srai_epi32(sum2, kSGImageBuffer_WeightBits), _mm_srai_epi32(sum3, kSGImageBuffer_WeightBits));
+        _mm_storeu_si128((__m128i*)(output + i), _mm_packus_epi16(low, high));
+    }
+#elif defined(SG_IMAGE_NEON)
+    int32x4_t low, high;
+    int16x8_t bytes;
+    for(; i + 8 <= length; i += 8) {
+        low = high = vdupq_n_s32(kRounding);
+        for(int k = 0; k < count; k++) {
+            bytes = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(rows + k * stride + i)));
+            low = vmlal_n_s16(low, vget_low_s16(bytes), weights[k]);
+            high = vmlal_n_s16(high, vget_high_s16(bytes), weights[k]);
+        }
+        
+        vst1_u8(output + i, vqmovun_s16(vcombine_s16(vqshrn_n_s32(low, kSGImageBuffer_WeightBits),
+                                                     vqshrn_n_s32(high, kSGImageBuffer_WeightBits))));
+    }
+#endif
+    
+    int sum;
+    for(; i < length; i++) {
+        sum = kRounding;
+        for(int k = 0; k < count; k++)
+            sum += rows[k * stride + i] * weights[k];
+        
+        output[i] = clampByte(sum >> kSGImageBuffer_WeightBits);
+    }
+}
+
+static void horizontalPass(const SGImageBuffer* source, SGImageBuffer* destination, const Contributions* contributions) {
+    const unsigned char* input;
+    unsigned char* output;
+    for(int y = 0; y < destination->height; y++) {
+        input = SGImageBufferRow(source, y);
+        output = SGImageBufferRow(destination, y);
+        for(int x = 0; x < destination->width; x++)
+            filterPixel(input + contributions->starts[x] * 4,
+                        contributions->weights + (size_t)x * contributions->maxCount,
+                        contributions->counts[x], output + x * 4);
+    }
+}
+
+/* the input rows can run backwards with a negative stride */
+static void verticalPass(const unsigned char* input, long inputStride,
+                         unsigned char* output, long outputStride,
+                         int width, int height, const Contributions* contributions) {
+    for(int y = 0; y < height; y++)
+        filterRow(input + contributions->starts[y] * inputStride, inputStride,
+                  contributions->weights + (size_t)y * contributions->maxCount, contributions->counts[y],
+                  output + y * outputStride, width * 4);
+}
+
+/* count pixels from the one at input backwards */
+static inline void reverseRow(const uint32_t* input, uint32_t* output, int count) {
+    int i = 0;
+    
+#if defined(SG_IMAGE_SSE2)
+    for(; i + 4 <= count; i += 4)
+        _mm_storeu_si128((__m128i*)(output + i),
+                         _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(input - i - 3)), _MM_SHUFFLE(0, 1, 2, 3)));
+#elif defined(SG_IMAGE_NEON)
+    uint32x4_t pixels;
+    for(; i + 4 <= count; i += 4) {
+        pixels = vrev64q_u32(vld1q_u32(input - i - 3));
+        vst1q_u32(output + i, vcombine_u32(vget_high_u32(pixels), vget_low_u32(pixels)));
+    }
+#endif
+    
+    for(; i < count; i++)
+        output[i] = *(input - i);
+}
+
+/*
+* A 4x4 block of the output whose columns are runs of 4 input pixels, read
+* forwards or backwards depending on the sign of step.
+*/
+static inline void transposeBlock(const uint32_t* input, long columnStride, long step,
+                                  uint32_t* output, long outputStride) {
+#if defined(SG_IMAGE_SSE2)
+    __m128i columns[4];
+    for(int i = 0; i < 4; i++) {
+        if(step > 0)
+            columns[i] = _mm_loadu_si128((const __m128i*)(input + i * columnStride));
+        else
+            columns[i] = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(input + i * columnStride - 3)),
+                                           _MM_SHUFFLE(0, 1, 2, 3));
+    }
+    
+    __m128i low01 = _mm_unpacklo_epi32(columns[0], columns[1]);
+    __m128i low23 = _mm_unpacklo_epi32(columns[2], columns[3]);
+    __m128i high01 = _mm_unpackhi_epi32(columns[0], columns[1]);
+    __m128i high23 = _mm_unpackhi_epi32(columns[2], columns[3]);
+    
+    _mm_storeu_si128((__m128i*)output, _mm_unpacklo_epi64(low01, low23));
+    _mm_storeu_si128((__m128i*)(output + outputStride), _mm_unpackhi_epi64(low01, low23));
+    _mm_storeu_si128((__m128i*)(output + 2 * outputStride), _mm_unpacklo_epi64(high01, high23));
+    _mm_storeu_si128((__m128i*)(output + 3 * outputStride), _mm_unpackhi_epi64(high01, high23));
+#elif defined(SG_IMAGE_NEON)
+    uint32x4_t columns[4];
+    for(int i = 0; i < 4; i++) {
+        if(step > 0)
+            columns[i] = vld1q_u32(input + i * columnStride);
+        else {
+            columns[i] = vrev64q_u32(vld1q_u32(input + i * columnStride - 3));
+            columns[i] = vcombine_u32(vget_high_u32(columns[i]), vget_low_u32(columns[i]));
+        }
+    }
+    
+    uint32x4x2_t pairs01 = vtrnq_u32(columns[0], columns[1]);
+    uint32x4x2_t pairs23 = vtrnq_u32(columns[2], columns[3]);
+    
+    vst1q_u32(output, vcombine_u32(vget_low_u32(pairs01.val[0]), vget_low_u32(pairs23.val[0])));
+    vst1q_u32(output + outputStride, vcombine_u32(vget_low_u32(pairs01.val[1]), vget_low_u32(pairs23.val[1])));
+    vst1q_u32(output + 2 * outputStride, vcombine_u32(vget_high_u32(pairs01.val[0]), vget_high_u32(pairs23.val[0])));
+    vst1q_u32(output + 3 * outputStride, vcombine_u32(vget_high_u32(pairs01.val[1]), vget_high_u32(pairs23.val[1])));
+#else
+    for(int j = 0; j < 4; j++)
+        for(int i = 0; i < 4; i++)
+            output[j * outputStride + i] = input[i * columnStride + j * step];
+#endif
+}
+
+/*
+* Output pixel (x, y) is origin[x * stepX + y * stepY], where stepX is a whole
+* input row and stepY a single pixel. The output is walked in tiles that keep
+* both the rows being read and the rows being written in the cache.
+*/
+static void transposePass(const uint32_t* origin, long stepX, long stepY, SGImageBuffer* destination) {
+    long outputStride = destination->bytesPerRow / 4;
+    uint32_t* output = (uint32_t*)destination->pixels;
+    int width = destination->width;
+    int height = destination->height;
+    int xEnd, yEnd;
+    for(int tileY = 0; tileY < height; tileY += kTileSize) {
+        yEnd = tileY + kTileSize < height ? tileY + kTileSize : height;
+        for(int tileX = 0; tileX < width; tileX += kTileSize) {
+            xEnd = tileX + kTileSize < width ? tileX + kTileSize : width;
+            for(int y = tileY; y < yEnd; y += 4)
+                for(int x = tileX; x < xEnd; x += 4) {
+                    if(y + 4 <= yEnd && x + 4 <= xEnd)
+                        transposeBlock(origin + x * stepX + y * stepY, stepX, stepY,
+                                       output + y * outputStride + x, outputStride);
+                    else
+                        for(int j = y; j < y + 4 && j < yEnd; j++)
+                            for(int i = x; i < x + 4 && i < xEnd; i++)
+                                output[j * outputStride + i] = origin[i * stepX + j * stepY];
+                }
+        }
+    }
+}
+
+SGImageBuffer* SGImageBufferNew(int width, int height) {
+    if(width <= 0 || height <= 0)
+        return NULL;
+    
+    SGImageBuffer* buffer = (SGImageBuffer*)malloc(sizeof(SGImageBuffer));
+    buffer->width = width;
+    buffer->height = height;
+    buffer->bytesPerRow = (width * 4 + kSGImageBuffer_Alignment - 1) & ~(kSGImageBuffer_Alignment - 1);
+    
+    if(posix_memalign((void**)&buffer->pixels, kSGImageBuffer_Alignment, (size_t)buffer->bytesPerRow * height)) {
+        free(buffer);
+        return NULL;
+    }
+    
+    return buffer;
+}
+
+void SGImageBufferFree(SGImageBuffer* buffer) {
+    if(!buffer)
+        return;
+    
+    free(buffer->pixels);
+    free(buffer);
+}
+
+static void copyRows(const SGImageBuffer* source, unsigned char* output, long outputStride) {
+    for(int y = 0; y < source->height; y++)
+        memcpy(output + y * outputStride, SGImageBufferRow(source, y), source->width * 4);
+}
+
+void SGImageBufferScale(const SGImageBuffer* source, SGImageBuffer* destination, SGImageFilter filter) {
+    int sameWidth = source->width == destination->width;
+    int sameHeight = source->height == destination->height;
+    if(sameWidth && sameHeight) {
+        copyRows(source, destination->pixels, destination->bytesPerRow);
+        return;
+    }
+    
+    Contributions horizontal, vertical;
+    if(sameHeight) {
+        buildContributions(&horizontal, source->width, destination->width, filter, 1.0f, 1.0f);
+        horizontalPass(source, destination, &horizontal);
+        freeContributions(&horizontal);
+        return;
+    }
+    
+    buildContributions(&vertical, source->height, destination->height, filter, 1.0f, 1.0f);
+    if(sameWidth) {
+        verticalPass(source->pixels, source->bytesPerRow, destination->pixels, destination->bytesPerRow,
+                     destination->width, destination->height, &vertical);
+        freeContributions(&vertical);
+        return;
+    }
+    
+    buildContributions(&horizontal, source->width, destination->width, filter, 1.0f, 1.0f);
+    
+    // Whichever pass goes first runs over the full length of the other axis. The
+    // vertical pass filters whole rows at once and costs about a quarter as much
+    // per tap, so shrinking images are usually cheaper to filter down first.
+    double horizontalFirst = (double)destination->width * source->height * horizontal.maxCount +
+                             (double)destination->width * destination->height * vertical.maxCount / 4.0;
+    double verticalFirst = (double)source->width * destination->height * vertical.maxCount / 4.0 +
+                           (double)destination->width * destination->height * horizontal.maxCount;
+    
+    SGImageBuffer* intermediate;
+    if(horizontalFirst <= verticalFirst) {
+        intermediate = SGImageBufferNew(destination->width, source->height);
+        horizontalPass(source, intermediate, &horizontal);
+        verticalPass(intermediate->pixels, intermediate->bytesPerRow, destination->pixels, destination->bytesPerRow,
+                     destination->width, destination->height, &vertical);
+    } else {
+        intermediate = SGImageBufferNew(source->width, destination->height);
+        verticalPass(source->pixels, source->bytesPerRow, intermediate->pixels, intermediate->bytesPerRow,
+                     source->width, destination->height, &vertical);
+        horizontalPass(intermediate, destination, &horizontal);
+    }
+    
+    freeContributions(&horizontal);
+    freeContributions(&vertical);
+    SGImageBufferFree(intermediate);
+}
+
+void SGImageBufferRoundCorners(SGImageBuffer* buffer, float cornerWidth, float cornerHeight) {
+    float radiusX = cornerWidth < buffer->width / 2.0f ? cornerWidth : buffer->width / 2.0f;
+    float radiusY = cornerHeight < buffer->height / 2.0f ? cornerHeight : buffer->height / 2.0f;
+    if(radiusX <= 0.0f || radiusY <= 0.0f)
+        return;
+    
+    int columns = (int)ceilf(radiusX);
+    int rows = (int)ceilf(radiusY);
+    int xs[2], ys[2], amountOfXs, amountOfYs, coverage;
+    float nx, ny, length, gradient, distance;
+    unsigned char* pixel;
+    for(int y = 0; y < rows; y++)
+        for(int x = 0; x < columns; x++) {
+            // Position of the pixel's center from the center of the ellipse, in radii
+            nx = (radiusX - (x + 0.5f)) / radiusX;
+            ny = (radiusY - (y + 0.5f)) / radiusY;
+            if(nx < 0.0f)
+                nx = 0.0f;
+            if(ny < 0.0f)
+                ny = 0.0f;
+            
+            // Distance to the edge of the ellipse in pixels, to first order
+            length = sqrtf(nx * nx + ny * ny);
+            if(length == 0.0f)
+                continue;
+            
+            gradient = sqrtf(nx * nx / (radiusX * radiusX) + ny * ny / (radiusY * radiusY)) / length;
+            distance = (length - 1.0f) / gradient;
+            if(distance <= -0.5f)
+                continue;
+            
+            coverage = distance >= 0.5f ? 0 : (int)((0.5f - distance) * 256.0f + 0.5f);
+            
+            // The same coverage applies to the mirrored pixel in every corner
+            xs[0] = x;
+            xs[1] = buffer->width - 1 - x;
+            ys[0] = y;
+            ys[1] = buffer->height - 1 - y;
+            amountOfXs = xs[1] != xs[0] ? 2 : 1;
+            amountOfYs = ys[1] != ys[0] ? 2 : 1;
+            for(int j = 0; j < amountOfYs; j++)
+                for(int i = 0; i < amountOfXs; i++) {
+                    pixel = SGImageBufferRow(buffer, ys[j]) + xs[i] * 4;
+                    for(int c = 0; c < 4; c++)
+                        pixel[c] = (pixel[c] * coverage + 128) >> 8;
+                }
+        }
+}
+
+void SGImageBufferTransform(const SGImageBuffer* source, SGImageBuffer* destination, SGImageOrientation orientation) {
+    const uint32_t* pixels = (const uint32_t*)source->pixels;
+    long stride = source->bytesPerRow / 4;
+    int width = source->width;
+    int height = source->height;
+    
+    // Where output pixel (0, 0) comes from and how far apart the next ones in x and y are
+    const uint32_t* origin;
+    long stepX, stepY;
+    switch(orientation) {
+        case kSGImageOrientation_UpMirrored:
+            origin = pixels + width - 1;
+            stepX = -1;
+            stepY = stride;
+            break;
+        case kSGImageOrientation_Down:
+            origin = pixels + (height - 1) * stride + width - 1;
+            stepX = -1;
+            stepY = -stride;
+            break;
+        case kSGImageOrientation_DownMirrored:
+            origin = pixels + (height - 1) * stride;
+            stepX = 1;
+            stepY = -stride;
+            break;
+        case kSGImageOrientation_Left:
+            origin = pixels + width - 1;
+            stepX = stride;
+            stepY = -1;
+            break;
+        case kSGImageOrientation_LeftMirrored:
+            origin = pixels + (height - 1) * stride + width - 1;
+            stepX = -stride;
+            stepY = -1;
+            break;
+        case kSGImageOrientation_Right:
+            origin = pixels + (height - 1) * stride;
+            stepX = -stride;
+            stepY = 1;
+            break;
+        case kSGImageOrientation_RightMirrored:
+            origin = pixels;
+            stepX = stride;
+            stepY = 1;
+            break;
+        default:
+            copyRows(source, destination->pixels, destination->bytesPerRow);
+            return;
+    }
+    
+    if(stepX == 1 || stepX == -1) {
+        uint32_t* output;
+        for(int y = 0; y < destination->height; y++) {
+            output = (uint32_t*)SGImageBufferRow(destination, y);
+            if(stepX == 1)
+                memcpy(output, origin + y * stepY, destination->width * 4);
+            else
+                reverseRow(origin + y * stepY, output, destination->width);
+        }
+    } else
+        transposePass(origin, stepX, stepY, destination);
+}
+
+void SGImageBufferReflect(const SGImageBuffer* source, SGImageBuffer* destination) {
+    copyRows(source, destination->pixels, destination->bytesPerRow);
+    
+    int reflectionHeight = destination->height - source->height;
+    if(reflectionHeight <= 0)
+        return;
+    
+    // Reading the source from its last row squeezes it upside down, and the
+    // fade is folded into the weights of each row
+    Contributions vertical;
+    buildContributions(&vertical, source->height, reflectionHeight, kSGImageFilter_Box,
+                       kSGImageBuffer_ReflectionAlpha, 0.0f);
+    verticalPass(SGImageBufferRow(source, source->height - 1), -(long)source->bytesPerRow,
+                 SGImageBufferRow(destination, source->height), destination->bytesPerRow,
+                 source->width, reflectionHeight, &vertical);
+    freeContributions(&vertical);
+}
@@ -0,0 +1,111 @@
+//
+//  SGImageBuffer.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import <stdlib.h>
+
+/*
+* Image processing on raw buffers of 8 bit, 4 channel pixels with premultiplied
+* alpha. None of the operations care about the order of the channels, so the
+* buffers can be handed to CoreGraphics in whichever layout is native to the
+* device. Rows are padded to a multiple of 16 bytes and the pixels are 16 byte
+* aligned.
+*
+* The inner loops are written with SSE2 or NEON when the compiler targets either
+* one and fall back to plain C otherwise, or when SG_IMAGE_NO_SIMD is defined.
+* Every path produces the same result.
+*
+* Resampling is separable: one pass along each axis through an intermediate buffer
+* of bytes, in whichever order does less work. Each pass uses a table of 14 bit
+* fixed point weights that is computed once per output row or column.
+*/
+
+#define kSGImageBuffer_Alignment        16              /* bytes */
+#define kSGImageBuffer_WeightBits       14
+#define kSGImageBuffer_ReflectionAlpha  0.5f            /* opacity of the reflection at the mirror line */
+
+typedef enum {
+    
+    kSGImageFilter_Box = 0,         /* area average when shrinking, nearest neighbour when enlarging */
+    kSGImageFilter_Bilinear,
+    kSGImageFilter_Lanczos,         /* three lobes; sharpest, but it can ring around hard edges */
+    
+} SGImageFilter;
+
+/* the same values as UIImageOrientation; the result is the image as it would be displayed */
+typedef enum {
+    
+    kSGImageOrientation_Up = 0,
+    kSGImageOrientation_Down,               /* 180 degrees */
+    kSGImageOrientation_Left,               /* 90 degrees counterclockwise */
+    kSGImageOrientation_Right,              /* 90 degrees clockwise */
+    kSGImageOrientation_UpMirrored,         /* flipped horizontally */
+    kSGImageOrientation_DownMirrored,       /* flipped vertically */
+    kSGImageOrientation_LeftMirrored,       /* transposed over the anti-diagonal */
+    kSGImageOrientation_RightMirrored,      /* transposed over the diagonal */
+    
+} SGImageOrientation;
+
+typedef struct SGImageBufferStruct {
+    unsigned char* pixels;
+    int width;
+    int height;
+    int bytesPerRow;
+} SGImageBuffer;
+
+#define SGImageBufferRow(__BUFFER__, __Y__) \
+    ((__BUFFER__)->pixels + (size_t)(__Y__) * (__BUFFER__)->bytesPerRow)
+
+/* the pixels are not cleared; NULL if either dimension is not positive */
+extern SGImageBuffer* SGImageBufferNew(int width, int height);
+extern void SGImageBufferFree(SGImageBuffer* buffer);
+
+/* resamples the whole source into the whole destination */
+extern void SGImageBufferScale(const SGImageBuffer* source, SGImageBuffer* destination, SGImageFilter filter);
+
+/*
+* makes the corners transparent outside of quarter ellipses with the given radii,
+* blending the pixels along the edge by their coverage
+*/
+extern void SGImageBufferRoundCorners(SGImageBuffer* buffer, float cornerWidth, float cornerHeight);
+
+/* the destination has to be the source's size, or its transpose for the left and right orientations */
+extern void SGImageBufferTransform(const SGImageBuffer* source, SGImageBuffer* destination, SGImageOrientation orientation);
+
+/*
+* copies the source to the top of the destination and fills the rows below it with
+* the source flipped upside down, squeezed to fit, and faded from the reflection
+* alpha at the mirror line to transparent. The destination has the source's width
+* and is taller than it.
+*/
+extern void SGImageBufferReflect(const SGImageBuffer* source, SGImageBuffer* destination);
@@ -0,0 +1,345 @@
+//
+//  SGImageCache.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGImageCache.h"
+
+#import <stdint.h>
+#import <string.h>
+
+#define kSGImageCache_InitialBucketCount    64
+
+static unsigned int hashKey(const SGImageCacheKey* key) {
+    // Fibonacci hashing of the address, whose low bits are alignment, mixed with the rest
+    uint32_t hash = (uint32_t)((uintptr_t)key->source >> 3) * 2654435761u;
+    uint32_t bits;
+    
+    hash ^= (uint32_t)key->operation * 0x9e3779b9u;
+    for(int i = 0; i < kSGImageCache_AmountOfParameters; i++) {
+        memcpy(&bits, &key->parameters[i], sizeof(bits));
+        hash = (hash ^ bits) * 16777619u;
+    }
+    
+    return hash ^ (hash >> 15);
+}
+
+static int equalKeys(const SGImageCacheKey* a, const SGImageCacheKey* b) {
+    if(a->source != b->source || a->operation != b->operation)
+        return 0;
+    
+    for(int i = 0; i < kSGImageCache_AmountOfParameters; i++)
+        if(a->parameters[i] != b->parameters[i])
+            return 0;
+    
+    return 1;
+}
+
+#define BUCKET(__CACHE__, __HASH__)     ((__HASH__) & ((__CACHE__)->bucketCount - 1))
+
+static SGImageCacheEntry* find(const SGImageCache* cache, const SGImageCacheKey* key, unsigned int hash) {
+    SGImageCacheEntry* entry = cache->buckets[BUCKET(cache, hash)];
+    while(entry && (entry->hash != hash || !equalKeys(&entry->key, key)))
+        entry = entry->chain;
+    
+    return entry;
+}
+
+static void detach(SGImageCache* cache, SGImageCacheEntry* entry) {
+    if(entry->newer)
+        entry->newer->older = entry->older;
+    else
+        cache->newest = entry->older;
+    
+    if(entry->older)
+        entry->older->newer = entry->newer;
+    else
+        cache->oldest = entry->newer;
+    
+    entry->newer = entry->older = NULL;
+}
+
+static void attachNewest(SGImageCache* cache, SGImageCacheEntry* entry) {
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if(cache->newest)
+        cache->newest->newer = entry;
+    else
+        cache->oldest = entry;
+    
+    cache->newest = entry;
+}
+
+static void rehash(SGImageCache* cache, int bucketCount) {
+    SGImageCacheEntry** buckets = cache->buckets;
+    int oldBucketCount = cache->bucketCount;
+    
+    cache->buckets = (SGImageCacheEntry**)calloc(bucketCount, sizeof(SGImageCacheEntry*));
+    cache->bucketCount = bucketCount;
+    
+    SGImageCacheEntry* entry;
+    SGImageCacheEntry* chain;
+    int bucket;
+    for(int i = 0; i < oldBucketCount; i++)
+        for(entry = buckets[i]; entry; entry = chain) {
+            chain = entry->chain;
+            bucket = BUCKET(cache, entry->hash);
+            entry->chain = cache->buckets[bucket];
+            cache->buckets[bucket] = entry;
+        }
+    
+    free(buckets);
+}
+
+static void retainImage(const SGImageCache* cache, void* image) {
+    if(cache->callbacks.retainImage)
+        cache->callbacks.retainImage(image);
+}
+
+static void releaseImage(const SGImageCache* cache, void* image) {
+    if(cache->callbacks.releaseImage)
+        cache->callbacks.releaseImage(image);
+}
+
+static void removeEntry(SGImageCache* cache, SGImageCacheEntry* entry) {
+    SGImageCacheEntry** link = &cache->buckets[BUCKET(cache, entry->hash)];
+    while(*link != entry)
+        link = &(*link)->chain;
+    *link = entry->chain;
+    
+    detach(cache, entry);
+    cache->cost -= entry->cost;
+    cache->count--;
+    
+    releaseImage(cache, entry->image);
+    if(cache->callbacks.releaseSource)
+        cache->callbacks.releaseSource(entry->key.source);
+    
+    free(entry);
+}
+
+static void evict(SGImageCache* cache, size_t budget) {
+    while(cache->oldest && cache->cost > budget) {
+        removeEntry(cache, cache->oldest);
+        cache->evictions++;
+    }
+}
+
+static void* copy(SGImageCache* cache, const SGImageCacheKey* key) {
+    SGImageCacheEntry* entry = find(cache, key, hashKey(key));
+    if(!entry) {
+        cache->misses++;
+        return NULL;
+    }
+    
+    if(entry != cache->newest) {
+        detach(cache, entry);
+        attachNewest(cache, entry);
+    }
+    
+    cache->hits++;
+    retainImage(cache, entry->image);
+    
+    return entry->image;
+}
+
+static int set(SGImageCache* cache, const SGImageCacheKey* key, void* image, size_t cost) {
+    unsigned int hash = hashKey(key);
+    SGImageCacheEntry* entry = find(cache, key, hash);
+    if(entry)
+        removeEntry(cache, entry);
+    
+    if(cost > cache->budget)
+        return 0;
+    
+    // Make room before the new entry is linked so it is never the one evicted
+    evict(cache, cache->budget - cost);
+    
+    if(cache->count >= cache->bucketCount)
+        rehash(cache, cache->bucketCount * 2);
+    
+    entry = (SGImageCacheEntry*)malloc(sizeof(SGImageCacheEntry));
+    entry->key = *key;
+    entry->hash = hash;
+    entry->image = image;
+    entry->cost = cost;
+    
+    retainImage(cache, image);
+    if(cache->callbacks.retainSource)
+        cache->callbacks.retainSource(key->source);
+    
+    int bucket = BUCKET(cache, hash);
+    entry->chain = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    attachNewest(cache, entry);
+    
+    cache->cost += cost;
+    cache->count++;
+    
+    return 1;
+}
+
+SGImageCache* SGImageCacheNew(size_t budget, const SGImageCacheCallbacks* callbacks) {
+    SGImageCache* cache = (SGImageCache*)calloc(1, sizeof(SGImageCache));
+    cache->budget = budget;
+    if(callbacks)
+        cache->callbacks = *callbacks;
+    
+    cache->bucketCount = kSGImageCache_InitialBucketCount;
+    cache->buckets = (SGImageCacheEntry**)calloc(cache->bucketCount, sizeof(SGImageCacheEntry*));
+    
+    pthread_mutex_init(&cache->lock, NULL);
+    pthread_cond_init(&cache->landing, NULL);
+    
+    return cache;
+}
+
+void SGImageCacheFree(SGImageCache* cache) {
+    if(!cache)
+        return;
+    
+    SGImageCacheClear(cache);
+    free(cache->buckets);
+    
+    pthread_cond_destroy(&cache->landing);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+void* SGImageCacheCopy(SGImageCache* cache, const SGImageCacheKey* key) {
+    pthread_mutex_lock(&cache->lock);
+    void* image = copy(cache, key);
+    pthread_mutex_unlock(&cache->lock);
+    
+    return image;
+}
+
+void* SGImageCacheCopyOrMake(SGImageCache* cache, const SGImageCacheKey* key,
+                             SGImageCacheMakeFunction make, void* context) {
+    pthread_mutex_lock(&cache->lock);
+    
+    void* image = copy(cache, key);
+    if(image) {
+        pthread_mutex_unlock(&cache->lock);
+        return image;
+    }
+    
+    // Somebody else is already making it
+    SGImageCacheFlight* flight;
+    for(flight = cache->flights; flight; flight = flight->next)
+        if(equalKeys(&flight->key, key))
+            break;
+    
+    if(flight) {
+        cache->waits++;
+        flight->waiters++;
+        while(!flight->landed)
+            pthread_cond_wait(&cache->landing, &cache->lock);
+        
+        image = flight->image;
+        if(image)
+            retainImage(cache, image);
+        
+        // The last one out cleans up
+        if(!--flight->waiters) {
+            if(flight->image)
+                releaseImage(cache, flight->image);
+            free(flight);
+        }
+        
+        pthread_mutex_unlock(&cache->lock);
+        return image;
+    }
+    
+    flight = (SGImageCacheFlight*)calloc(1, sizeof(SGImageCacheFlight));
+    flight->key = *key;
+    flight->next = cache->flights;
+    cache->flights = flight;
+    pthread_mutex_unlock(&cache->lock);
+    
+    size_t cost = 0;
+    image = make(key, context, &cost);
+    
+    pthread_mutex_lock(&cache->lock);
+    if(image)
+        set(cache, key, image, cost);
+    
+    SGImageCacheFlight** link = &cache->flights;
+    while(*link != flight)
+        link = &(*link)->next;
+    *link = flight->next;
+    
+    // The waiters share a reference that the last of them gives back
+    if(flight->waiters) {
+        flight->image = image;
+        if(image)
+            retainImage(cache, image);
+        
+        flight->landed = 1;
+        pthread_cond_broadcast(&cache->landing);
+    } else
+        free(flight);
+    
+    pthread_mutex_unlock(&cache->lock);
+    
+    return image;
+}
+
+int SGImageCacheSet(SGImageCache* cache, const SGImageCacheKey* key, void* image, size_t cost) {
+    pthread_mutex_lock(&cache->lock);
+    int stored = set(cache, key, image, cost);
+    pthread_mutex_unlock(&cache->lock);
+    
+    return stored;
+}
+
+void SGImageCacheRemove(SGImageCache* cache, const SGImageCacheKey* key) {
+    pthread_mutex_lock(&cache->lock);
+    SGImageCacheEntry* entry = find(cache, key, hashKey(key));
+    if(entry)
+        removeEntry(cache, entry);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void SGImageCacheClear(SGImageCache* cache) {
+    pthread_mutex_lock(&cache->lock);
+    while(cache->oldest)
+        removeEntry(cache, cache->oldest);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void SGImageCacheSetBudget(SGImageCache* cache, size_t budget) {
+    pthread_mutex_lock(&cache->lock);
+    cache->budget = budget;
+    evict(cache, budget);
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,145 @@
+//
+//  SGImageCache.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import <stdlib.h>
+#import <pthread.h>
+
+/*
+* A least recently used cache of images that is bounded by the amount of bytes
+* that the images hold rather than by their count. The cache does not know what
+* an image is; it holds opaque pointers together with their cost and retains and
+* releases them through callbacks, like a CFDictionary.
+*
+* An image is keyed by the object it was made from and the operation and
+* parameters that made it. The source is compared by identity, so a cache whose
+* keys can outlive their sources should retain them through the callbacks too.
+*
+* Entries are found through a hash table of their keys and kept in a doubly
+* linked list from the most to the least recently used, so lookups, insertions
+* and evictions are all O(1). Every function takes the cache's lock, and images
+* that are being made are tracked so that each one is only made once no matter
+* how many threads ask for it at the same time.
+*/
+
+#define kSGImageCache_DefaultBudget         (1024 * 1024)   /* bytes */
+#define kSGImageCache_AmountOfParameters    4
+
+typedef struct SGImageCacheKeyStruct {
+    const void* source;
+    int operation;                              /* 0 if there is only one image per source */
+    float parameters[kSGImageCache_AmountOfParameters];
+} SGImageCacheKey;
+
+/* any of the callbacks can be NULL */
+typedef struct SGImageCacheCallbacksStruct {
+    void (*retainImage)(void* image);
+    void (*releaseImage)(void* image);
+    void (*retainSource)(const void* source);
+    void (*releaseSource)(const void* source);
+} SGImageCacheCallbacks;
+
+/* makes a new, retained image for a key and sets its cost; NULL if it can not */
+typedef void* (*SGImageCacheMakeFunction)(const SGImageCacheKey* key, void* context, size_t* cost);
+
+typedef struct SGImageCacheEntryStruct {
+    SGImageCacheKey key;
+    unsigned int hash;
+    void* image;
+    size_t cost;
+    struct SGImageCacheEntryStruct* newer;
+    struct SGImageCacheEntryStruct* older;
+    struct SGImageCacheEntryStruct* chain;      /* next entry in the same bucket */
+} SGImageCacheEntry;
+
+/* an image that one thread is making while others wait for it */
+typedef struct SGImageCacheFlightStruct {
+    SGImageCacheKey key;
+    void* image;
+    int landed;
+    int waiters;
+    struct SGImageCacheFlightStruct* next;
+} SGImageCacheFlight;
+
+typedef struct SGImageCacheStruct {
+    size_t budget;
+    size_t cost;                                /* bytes held by all of the images */
+    int count;
+    
+    SGImageCacheCallbacks callbacks;
+    
+    SGImageCacheEntry** buckets;
+    int bucketCount;                            /* always a power of two */
+    SGImageCacheEntry* newest;
+    SGImageCacheEntry* oldest;
+    
+    SGImageCacheFlight* flights;
+    pthread_mutex_t lock;
+    pthread_cond_t landing;
+    
+    /* statistics */
+    int hits;
+    int misses;
+    int evictions;
+    int waits;                                  /* misses that waited for another thread */
+} SGImageCache;
+
+/* the callbacks are copied; NULL if the images are not reference counted */
+extern SGImageCache* SGImageCacheNew(size_t budget, const SGImageCacheCallbacks* callbacks);
+extern void SGImageCacheFree(SGImageCache* cache);
+
+/* the image stored for a key retained for the caller, which becomes the most recently used; NULL on a miss */
+extern void* SGImageCacheCopy(SGImageCache* cache, const SGImageCacheKey* key);
+
+/*
+* the image for a key retained for the caller. On a miss the image is made outside
+* of the lock and added to the cache, while other threads that ask for the same
+* key wait for it instead of making it again. NULL if the image could not be made.
+*/
+extern void* SGImageCacheCopyOrMake(SGImageCache* cache, const SGImageCacheKey* key,
+                                    SGImageCacheMakeFunction make, void* context);
+
+/*
+* retains an image in place of the one stored for the key. The least recently used
+* images are evicted until the cache fits its budget. Returns 0 and does not keep
+* the image if it costs more than the entire budget.
+*/
+extern int SGImageCacheSet(SGImageCache* cache, const SGImageCacheKey* key, void* image, size_t cost);
+
+extern void SGImageCacheRemove(SGImageCache* cache, const SGImageCacheKey* key);
+
+/* releases every image */
+extern void SGImageCacheClear(SGImageCache* cache);
+
+/* evicts images until the cache fits the new budget */
+extern void SGImageCacheSetBudget(SGImageCache* cache, size_t budget);
@@ -0,0 +1,143 @@
+//
+//  SGLocationFilter.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGLocationFilter.h"
+
+#import <math.h>
+
+#define kSGEarthRadius      6371000.0
+
+void SGLocationFilterReset(SGLocationFilter* filter) {
+    filter->latitude = 0.0;
+    filter->longitude = 0.0;
+    filter->variance = 0.0;
+    filter->timestamp = 0.0;
+    filter->hasEstimate = 0;
+    
+    filter->originLatitude = 0.0;
+    filter->originLongitude = 0.0;
+    filter->hasOrigin = 0;
+    
+    filter->maximumSpeed = kSGLocationFilter_MaximumSpeed;
+    filter->processNoise = kSGLocationFilter_ProcessNoise;
+    filter->minimumDisplacement = kSGLocationFilter_MinimumDisplacement;
+    filter->displacementScale = kSGLocationFilter_DisplacementScale;
+    filter->consecutiveRejections = 0;
+    
+    filter->acceptedFixes = 0;
+    filter->rejectedFixes = 0;
+    filter->originUpdates = 0;
+    filter->avoidedUpdates = 0;
+}
+
+double SGLocationFilterDistance(double latitude1, double longitude1, double latitude2, double longitude2) {
+    double x = (longitude2 - longitude1) * M_PI / 180.0 * cos((latitude1 + latitude2) * M_PI / 360.0);
+    double y = (latitude2 - latitude1) * M_PI / 180.0;
+    
+    return sqrt(x * x + y * y) * kSGEarthRadius;
+}
+
+double SGLocationFilterAccuracy(const SGLocationFilter* filter) {
+    return sqrt(filter->variance);
+}
+
+static void startEstimate(SGLocationFilter* filter, const SGLocationFix* fix) {
+    filter->latitude = fix->latitude;
+    filter->longitude = fix->longitude;
+    filter->variance = fix->horizontalAccuracy * fix->horizontalAccuracy;
+    filter->timestamp = fix->timestamp;
+    filter->hasEstimate = 1;
+    filter->consecutiveRejections = 0;
+}
+
+int SGLocationFilterAddFix(SGLocationFilter* filter, const SGLocationFix* fix) {
+    if(fix->horizontalAccuracy < 0.0) {
+        filter->rejectedFixes++;
+        return 0;
+    }
+    
+    if(!filter->hasEstimate)
+        startEstimate(filter, fix);
+    else {
+        double elapsed = fix->timestamp - filter->timestamp;
+        if(elapsed < 0.0)
+            elapsed = 0.0;
+        
+        // The estimate becomes less certain the longer we go without a fix
+        double variance = filter->variance + elapsed * filter->processNoise * filter->processNoise;
+        double measurementVariance = fix->horizontalAccuracy * fix->horizontalAccuracy;
+        
+        // A fix that is further away than we could have travelled, even when
+        // both positions are off by three standard deviations, is an outlier.
+        // If the fixes keep disagreeing with the estimate then the estimate
+        // is the one that is wrong.
+        double distance = SGLocationFilterDistance(filter->latitude, filter->longitude, fix->latitude, fix->longitude);
+        double gate = filter->maximumSpeed * elapsed + 3.0 * sqrt(filter->variance + measurementVariance);
+        if(distance > gate) {
+            filter->consecutiveRejections++;
+            if(filter->consecutiveRejections < kSGLocationFilter_MaximumRejections) {
+                filter->rejectedFixes++;
+                return 0;
+            }
+            
+            startEstimate(filter, fix);
+        } else {
+            double gain = variance + measurementVariance > 0.0 ? variance / (variance + measurementVariance) : 1.0;
+            filter->latitude += gain * (fix->latitude - filter->latitude);
+            filter->longitude += gain * (fix->longitude - filter->longitude);
+            filter->variance = (1.0 - gain) * variance;
+            filter->timestamp = fix->timestamp;
+            filter->consecutiveRejections = 0;
+        }
+    }
+    
+    filter->acceptedFixes++;
+    
+    if(filter->hasOrigin) {
+        double displacement = SGLocationFilterDistance(filter->originLatitude, filter->originLongitude,
+                                                       filter->latitude, filter->longitude);
+        double threshold = filter->minimumDisplacement + filter->displacementScale * SGLocationFilterAccuracy(filter);
+        if(displacement <= threshold) {
+            filter->avoidedUpdates++;
+            return 0;
+        }
+    }
+    
+    filter->originLatitude = filter->latitude;
+    filter->originLongitude = filter->longitude;
+    filter->hasOrigin = 1;
+    filter->originUpdates++;
+    
+    return 1;
+}
@@ -0,0 +1,98 @@
+//
+//  SGLocationFilter.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+/*
+* A processing stage for location fixes. Fixes are smoothed with a simple
+* Kalman filter that weighs each fix by its reported accuracy. Fixes that
+* imply a speed that could not have been travelled are rejected. The
+* smoothed location is only reported as a new origin once it has moved
+* further than a threshold that grows with the uncertainty of the estimate,
+* so jitter does not force the scene to be re-projected.
+*/
+
+#define kSGLocationFilter_MaximumSpeed          50.0        /* meters per second */
+#define kSGLocationFilter_ProcessNoise          3.0         /* meters per second */
+#define kSGLocationFilter_MinimumDisplacement   2.0         /* meters */
+#define kSGLocationFilter_DisplacementScale     1.0
+#define kSGLocationFilter_MaximumRejections     3
+
+/* a single reading from the location provider */
+typedef struct SGLocationFixStruct {
+    double latitude;
+    double longitude;
+    double horizontalAccuracy;  /* meters; negative if the fix is invalid */
+    double timestamp;           /* seconds */
+} SGLocationFix;
+
+typedef struct SGLocationFilterStruct {
+    /* smoothed estimate */
+    double latitude;
+    double longitude;
+    double variance;            /* meters squared */
+    double timestamp;
+    int hasEstimate;
+    
+    /* last location that was reported downstream */
+    double originLatitude;
+    double originLongitude;
+    int hasOrigin;
+    
+    /* tuning */
+    double maximumSpeed;
+    double processNoise;
+    double minimumDisplacement;
+    double displacementScale;
+    int consecutiveRejections;
+    
+    /* statistics */
+    unsigned int acceptedFixes;
+    unsigned int rejectedFixes;
+    unsigned int originUpdates;
+    unsigned int avoidedUpdates;
+} SGLocationFilter;
+
+/* clear the estimate and statistics and restore the default tuning */
+extern void SGLocationFilterReset(SGLocationFilter* filter);
+
+/*
+* feed a fix into the filter. Returns 1 if the smoothed location has moved far enough
+* to be reported as a new origin; otherwise 0.
+*/
+extern int SGLocationFilterAddFix(SGLocationFilter* filter, const SGLocationFix* fix);
+
+/* the estimated accuracy of the smoothed location in meters */
+extern double SGLocationFilterAccuracy(const SGLocationFilter* filter);
+
+/* approximate distance in meters between two coordinates; valid for short distances */
+extern double SGLocationFilterDistance(double latitude1, double longitude1, double latitude2, double longitude2);
@@ -50,3 +50,55 @@ extern float DistanceBetweenTwoPoints(float x1, float y1, float x2, float y2) {
     float y = y2 - y1;    
     return sqrt(x * x + y * y);
 }
+
+#define kSGSort_InsertionThreshold      16
+
+static void swapElements(char* a, char* b, size_t size) {
+    char byte;
+    while(size--) {
+        byte = *a;
+        *a++ = *b;
+        *b++ = byte;
+    }
+}
+
+static void siftDown(char* base, size_t root, size_t count, size_t size, int (*compare)(const void*, const void*)) {
+    size_t child;
+    while((child = root * 2 + 1) < count) {
+        if(child + 1 < count && compare(base + child * size, base + (child + 1) * size) < 0)
+            child++;
+        
+        if(compare(base + root * size, base + child * size) >= 0)
+            return;
+        
+        swapElements(base + root * size, base + child * size, size);
+        root = child;
+    }
+}
+
+void SGSort(void* base, size_t count, size_t size, int (*compare)(const void*, const void*)) {
+    char* elements = (char*)base;
+    size_t i, j;
+    if(count < 2)
+        return;
+    
+    // Arrays that are small or nearly sorted, like the ones kept from one
+    // frame to the next, are sorted by insertion. Once that has moved too
+    // many elements, the rest of the work is left to heapsort.
+    size_t budget = count <= kSGSort_InsertionThreshold ? count * count : count * kSGSort_InsertionThreshold / 4;
+    for(i = 1; i < count && budget; i++)
+        for(j = i; j > 0 && compare(elements + (j - 1) * size, elements + j * size) > 0 && budget; j--, budget--)
+            swapElements(elements + (j - 1) * size, elements + j * size, size);
+    
+    if(budget)
+        return;
+    
+    // Heapsort needs no memory beyond the array itself
+    for(i = count / 2; i > 0; i--)
+        siftDown(elements, i - 1, count, size, compare);
+    
+    for(i = count - 1; i > 0; i--) {
+        swapElements(elements, elements + i * size, size);
+        siftDown(elements, 0, i, size, compare);
+    }
+}
@@ -32,6 +32,8 @@
 //  Created by Derek Smith.
 //
 
+#import <stdlib.h>
+
 /* a simple structure for representing x,y,z points and vectors */
 typedef struct Point3Struct {
 	float x, y, z;
@@ -46,3 +48,6 @@ extern SGVector3* V3New(double x, double y, double z);
 
 /* return the distance between two points */
 extern float DistanceBetweenTwoPoints(float x1, float y1, float x2, float y2);
+
+/* sort an array in place like qsort, but without allocating any memory; the sort is not stable */
+extern void SGSort(void* base, size_t count, size_t size, int (*compare)(const void*, const void*));
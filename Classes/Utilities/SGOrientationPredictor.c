@@ -0,0 +1,213 @@
+//
+//  SGOrientationPredictor.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import "SGOrientationPredictor.h"
+
+#import <string.h>
+#import <math.h>
+
+/* the shortest difference between two values of an axis */
+static double difference(const SGOrientationAxis* axis, double to, double from) {
+    double delta = to - from;
+    if(axis->period > 0.0)
+        delta -= axis->period * floor(delta / axis->period + 0.5);
+    
+    return delta;
+}
+
+/* the least squares slope of the samples in the velocity window */
+static void fitVelocity(SGOrientationAxis* axis) {
+    double newestTime = axis->times[axis->newest];
+    double newestValue = axis->values[axis->newest];
+    double sumT = 0.0, sumV = 0.0, sumTT = 0.0, sumTV = 0.0, t, v;
+    int amount = 0, index;
+    for(int i = 0; i < axis->count; i++) {
+        index = (axis->newest - i + kSGOrientationPredictor_History) % kSGOrientationPredictor_History;
+        t = axis->times[index] - newestTime;
+        if(-t > kSGOrientationPredictor_VelocityWindow)
+            break;
+        
+        // Values are unwrapped around the newest one
+        v = difference(axis, axis->values[index], newestValue);
+        sumT += t;
+        sumV += v;
+        sumTT += t * t;
+        sumTV += t * v;
+        amount++;
+    }
+    
+    double denominator = amount * sumTT - sumT * sumT;
+    axis->velocity = amount > 1 && denominator > 1e-12 ? (amount * sumTV - sumT * sumV) / denominator : 0.0;
+}
+
+/* compare the predictions whose present time has passed with the samples around it */
+static void evaluate(SGOrientationAxis* axis, double timestamp, double value) {
+    double previousTime = axis->times[axis->newest];
+    double previousValue = axis->values[axis->newest];
+    double presentTime, actual, error;
+    while(axis->pendingCount > 0 && axis->pendingTimes[axis->pendingHead] <= timestamp) {
+        presentTime = axis->pendingTimes[axis->pendingHead];
+        
+        // Predictions that were made for a time before the previous
+        // sample can not be compared with anything.
+        if(axis->count > 0 && presentTime >= previousTime) {
+            actual = value;
+            if(timestamp > previousTime)
+                actual = previousValue + difference(axis, value, previousValue) *
+                         (presentTime - previousTime) / (timestamp - previousTime);
+            
+            error = fabs(difference(axis, actual, axis->pendingPredictions[axis->pendingHead]));
+            axis->squaredError += error * error;
+            if(error > axis->maximumError)
+                axis->maximumError = error;
+            
+            error = difference(axis, actual, axis->pendingHolds[axis->pendingHead]);
+            axis->squaredHoldError += error * error;
+            axis->evaluated++;
+        }
+        
+        axis->pendingHead = (axis->pendingHead + 1) % kSGOrientationPredictor_Pending;
+        axis->pendingCount--;
+    }
+}
+
+void SGOrientationPredictorReset(SGOrientationPredictor* predictor) {
+    FILE* trace = predictor->trace;
+    memset(predictor, 0, sizeof(SGOrientationPredictor));
+    predictor->trace = trace;
+    
+    predictor->axes[kSGOrientationAxis_Heading].period = 360.0;
+    predictor->latencyFrames = kSGOrientationPredictor_LatencyFrames;
+    predictor->maximumHorizon = kSGOrientationPredictor_MaximumHorizon;
+    predictor->framePeriod = kSGOrientationPredictor_FramePeriod;
+}
+
+void SGOrientationPredictorAddSample(SGOrientationPredictor* predictor, int axisIndex, double timestamp, double value) {
+    SGOrientationAxis* axis = &predictor->axes[axisIndex];
+    if(axis->count > 0 && timestamp < axis->times[axis->newest])
+        return;
+    
+    if(predictor->trace)
+        fprintf(predictor->trace, "%.6f %i %.6f\n", timestamp, axisIndex, value);
+    
+    evaluate(axis, timestamp, value);
+    
+    axis->newest = (axis->newest + 1) % kSGOrientationPredictor_History;
+    axis->times[axis->newest] = timestamp;
+    axis->values[axis->newest] = value;
+    if(axis->count < kSGOrientationPredictor_History)
+        axis->count++;
+    
+    fitVelocity(axis);
+}
+
+void SGOrientationPredictorBeginFrame(SGOrientationPredictor* predictor, double timestamp) {
+    if(predictor->trace)
+        fprintf(predictor->trace, "%.6f %i 0\n", timestamp, kSGOrientationTrace_Frame);
+    
+    // Stalls would drag the period far from the rate of the display
+    double interval = timestamp - predictor->frameTime;
+    if(predictor->hasFrame && interval > 0.0 && interval <= kSGOrientationPredictor_MaximumPeriod)
+        predictor->framePeriod += (interval - predictor->framePeriod) * kSGOrientationPredictor_Smoothing;
+    
+    predictor->frameTime = timestamp;
+    predictor->hasFrame = 1;
+}
+
+double SGOrientationPredictorPresentTime(const SGOrientationPredictor* predictor, int framesAhead) {
+    return predictor->frameTime + (predictor->latencyFrames + framesAhead) * predictor->framePeriod;
+}
+
+double SGOrientationPredictorPredict(SGOrientationPredictor* predictor, int axisIndex, double presentTime) {
+    SGOrientationAxis* axis = &predictor->axes[axisIndex];
+    if(!axis->count)
+        return 0.0;
+    
+    double newestTime = axis->times[axis->newest];
+    double newestValue = axis->values[axis->newest];
+    double age = presentTime - newestTime;
+    
+    double extrapolation = age;
+    if(extrapolation < 0.0 || extrapolation > kSGOrientationPredictor_StaleTime)
+        extrapolation = 0.0;
+    else if(extrapolation > predictor->maximumHorizon)
+        extrapolation = predictor->maximumHorizon;
+    
+    double prediction = newestValue + axis->velocity * extrapolation;
+    
+    if(axis->pendingCount == kSGOrientationPredictor_Pending) {
+        axis->pendingHead = (axis->pendingHead + 1) % kSGOrientationPredictor_Pending;
+        axis->pendingCount--;
+    }
+    
+    int pending = (axis->pendingHead + axis->pendingCount++) % kSGOrientationPredictor_Pending;
+    axis->pendingTimes[pending] = presentTime;
+    axis->pendingPredictions[pending] = prediction;
+    axis->pendingHolds[pending] = newestValue;
+    
+    predictor->horizon = predictor->predictions ?
+        predictor->horizon + (age - predictor->horizon) * kSGOrientationPredictor_Smoothing : age;
+    predictor->predictions++;
+    
+    return prediction;
+}
+
+double SGOrientationPredictorError(const SGOrientationPredictor* predictor, int axis) {
+    const SGOrientationAxis* a = &predictor->axes[axis];
+    return a->evaluated ? sqrt(a->squaredError / a->evaluated) : 0.0;
+}
+
+double SGOrientationPredictorHoldError(const SGOrientationPredictor* predictor, int axis) {
+    const SGOrientationAxis* a = &predictor->axes[axis];
+    return a->evaluated ? sqrt(a->squaredHoldError / a->evaluated) : 0.0;
+}
+
+int SGOrientationPredictorReplay(SGOrientationPredictor* predictor, FILE* trace, int framesAhead) {
+    double timestamp, value, presentTime;
+    int axis, lines = 0;
+    while(fscanf(trace, "%lf %i %lf", &timestamp, &axis, &value) == 3) {
+        lines++;
+        if(axis == kSGOrientationTrace_Frame) {
+            // Like the environment, every frame predicts all axes
+            SGOrientationPredictorBeginFrame(predictor, timestamp);
+            presentTime = SGOrientationPredictorPresentTime(predictor, framesAhead);
+            for(int i = 0; i < kSGOrientationAxis_Count; i++)
+                SGOrientationPredictorPredict(predictor, i, presentTime);
+        } else if(axis >= 0 && axis < kSGOrientationAxis_Count)
+            SGOrientationPredictorAddSample(predictor, axis, timestamp, value);
+    }
+    
+    return lines;
+}
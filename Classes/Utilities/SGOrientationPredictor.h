@@ -0,0 +1,136 @@
+//
+//  SGOrientationPredictor.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import <stdio.h>
+
+/*
+* Extrapolates the filtered orientation of the device to the time that a
+* frame is expected to reach the screen. The angular velocity of each axis
+* is the least squares slope of its samples over a short window, and the
+* present time is the start of the frame plus a number of frame periods that
+* are measured from the frames themselves. Extrapolation is capped and falls
+* back to holding the last value once the samples have gone stale.
+*
+* Every prediction is kept until the samples on both sides of its present
+* time have arrived. It is then compared with the sample value interpolated
+* at that time, as is the last value that would have been held without a
+* prediction, so the gain of the predictor is measured on the device itself.
+*
+* Samples and frames can be written to a trace to evaluate the predictor
+* offline. Each line holds a timestamp, an axis and a value; frames are
+* written with the axis kSGOrientationTrace_Frame.
+*/
+
+#define kSGOrientationAxis_Heading              0   /* degrees, wraps around */
+#define kSGOrientationAxis_Pitch                1
+#define kSGOrientationAxis_Roll                 2
+#define kSGOrientationAxis_Count                3
+
+#define kSGOrientationTrace_Frame               -1
+
+#define kSGOrientationPredictor_History         16      /* samples per axis */
+#define kSGOrientationPredictor_Pending         16      /* predictions per axis that wait to be evaluated */
+#define kSGOrientationPredictor_VelocityWindow  0.15    /* seconds of samples that the velocity is fit to */
+#define kSGOrientationPredictor_MaximumHorizon  0.1     /* seconds that are extrapolated at most */
+#define kSGOrientationPredictor_StaleTime       0.25    /* seconds after which the last sample is held */
+#define kSGOrientationPredictor_FramePeriod     (1.0 / 60.0)    /* seconds until frames were measured */
+#define kSGOrientationPredictor_MaximumPeriod   0.25    /* seconds; longer gaps between frames are stalls */
+#define kSGOrientationPredictor_Smoothing       0.1     /* weight of the last frame in the smoothed values */
+#define kSGOrientationPredictor_LatencyFrames   1.0     /* frame periods from the start of a frame to the screen */
+
+typedef struct SGOrientationAxisStruct {
+    double period;              /* 360 for an angle that wraps around; 0 otherwise */
+    
+    /* ring of the latest samples */
+    double times[kSGOrientationPredictor_History];
+    double values[kSGOrientationPredictor_History];
+    int newest;
+    int count;
+    double velocity;            /* units per second */
+    
+    /* FIFO of predictions that wait for the samples around their present time */
+    double pendingTimes[kSGOrientationPredictor_Pending];
+    double pendingPredictions[kSGOrientationPredictor_Pending];
+    double pendingHolds[kSGOrientationPredictor_Pending];
+    int pendingHead;
+    int pendingCount;
+    
+    /* statistics */
+    unsigned int evaluated;
+    double squaredError;        /* of the predictions */
+    double squaredHoldError;    /* of the last sample values */
+    double maximumError;
+} SGOrientationAxis;
+
+typedef struct SGOrientationPredictorStruct {
+    SGOrientationAxis axes[kSGOrientationAxis_Count];
+    
+    /* tuning */
+    double latencyFrames;
+    double maximumHorizon;
+    
+    /* frame timing */
+    double frameTime;           /* start of the current frame */
+    double framePeriod;         /* smoothed */
+    int hasFrame;
+    
+    /* statistics */
+    unsigned int predictions;
+    double horizon;             /* smoothed seconds from the newest sample to the present time */
+    
+    FILE* trace;                /* NULL unless samples are recorded */
+} SGOrientationPredictor;
+
+/* forget all samples, frames and statistics and restore the default tuning */
+extern void SGOrientationPredictorReset(SGOrientationPredictor* predictor);
+
+/* add a filtered sample; samples of an axis must arrive in the order that they were taken */
+extern void SGOrientationPredictorAddSample(SGOrientationPredictor* predictor, int axis, double timestamp, double value);
+
+/* measure the frame timing at the start of a frame */
+extern void SGOrientationPredictorBeginFrame(SGOrientationPredictor* predictor, double timestamp);
+
+/* the time that a frame which is framesAhead after the current one is expected to be on screen */
+extern double SGOrientationPredictorPresentTime(const SGOrientationPredictor* predictor, int framesAhead);
+
+/* the value of axis at presentTime; the prediction is kept to be evaluated */
+extern double SGOrientationPredictorPredict(SGOrientationPredictor* predictor, int axis, double presentTime);
+
+/* the root mean square error of the evaluated predictions, and of holding the last sample instead */
+extern double SGOrientationPredictorError(const SGOrientationPredictor* predictor, int axis);
+extern double SGOrientationPredictorHoldError(const SGOrientationPredictor* predictor, int axis);
+
+/* replay a trace into the predictor; returns the amount of lines that were read */
+extern int SGOrientationPredictorReplay(SGOrientationPredictor* predictor, FILE* trace, int framesAhead);
@@ -0,0 +1,771 @@
+//
+//  SGScene.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGScene.h"
+#import "SGFastTrig.h"
+#import "SGMath.h"
+#import "SGMetrics.h"
+
+#import <string.h>
+#import <math.h>
+
+#define kSGScene_CloseDistance      (3.0f * kSGMeter)   /* billboards that are closer are scaled down */
+#define kSGScene_CloseScale         300.0f
+
+/* what the tasks of a parallel pass work on */
+typedef struct SGScenePassStruct {
+    SGScene* scene;
+    const SGSceneInput* input;
+    SGSceneSnapshot* snapshot;
+} SGScenePass;
+
+static void reserveInput(SGSceneInput* input, int count) {
+    if(count <= input->capacity)
+        return;
+    
+    int capacity = input->capacity ? input->capacity : 64;
+    while(capacity < count)
+        capacity *= 2;
+    
+    input->x = (float*)realloc(input->x, sizeof(float) * capacity);
+    input->y = (float*)realloc(input->y, sizeof(float) * capacity);
+    input->z = (float*)realloc(input->z, sizeof(float) * capacity);
+    input->distances = (float*)realloc(input->distances, sizeof(float) * capacity);
+    input->bearings = (float*)realloc(input->bearings, sizeof(float) * capacity);
+    input->widths = (float*)realloc(input->widths, sizeof(float) * capacity);
+    input->heights = (float*)realloc(input->heights, sizeof(float) * capacity);
+    input->flags = (unsigned char*)realloc(input->flags, sizeof(unsigned char) * capacity);
+    input->handles = (SGAnnotationHandle*)realloc(input->handles, sizeof(SGAnnotationHandle) * capacity);
+    input->order = (int*)realloc(input->order, sizeof(int) * capacity);
+    input->capacity = capacity;
+}
+
+void SGSceneInputInit(SGSceneInput* input) {
+    memset(input, 0, sizeof(SGSceneInput));
+}
+
+void SGSceneInputDestroy(SGSceneInput* input) {
+    free(input->x);
+    free(input->y);
+    free(input->z);
+    free(input->distances);
+    free(input->bearings);
+    free(input->widths);
+    free(input->heights);
+    free(input->flags);
+    free(input->handles);
+    free(input->order);
+    memset(input, 0, sizeof(SGSceneInput));
+}
+
+void SGSceneInputCopyStore(SGSceneInput* input, const SGAnnotationStore* store) {
+    int count = store->count;
+    reserveInput(input, count);
+    input->count = count;
+    
+    memcpy(input->x, store->x, sizeof(float) * count);
+    memcpy(input->z, store->z, sizeof(float) * count);
+    memcpy(input->distances, store->distances, sizeof(float) * count);
+    memcpy(input->bearings, store->bearings, sizeof(float) * count);
+    memcpy(input->widths, store->widths, sizeof(float) * count);
+    memcpy(input->heights, store->heights, sizeof(float) * count);
+    memcpy(input->handles, store->handles, sizeof(SGAnnotationHandle) * count);
+    
+    for(int i = 0; i < count; i++) {
+        input->y[i] = store->scale * store->altitudes[i];
+        input->flags[i] = (SGAnnotationStoreTestFlag(store, i, kSGAnnotationFlag_Captured) ? kSGSceneEntry_Captured : 0) |
+                          (SGAnnotationStoreTestFlag(store, i, kSGAnnotationFlag_Hidden) ? kSGSceneEntry_Hidden : 0);
+        input->order[i] = SGAnnotationStoreOrderedIndex(store, i);
+    }
+}
+
+void SGSceneSnapshotInit(SGSceneSnapshot* snapshot) {
+    memset(snapshot, 0, sizeof(SGSceneSnapshot));
+}
+
+void SGSceneSnapshotDestroy(SGSceneSnapshot* snapshot) {
+    free(snapshot->billboards);
+    free(snapshot->touchCells);
+    free(snapshot->touchBillboards);
+    free(snapshot->blips);
+    free(snapshot->blipSlots);
+    memset(snapshot, 0, sizeof(SGSceneSnapshot));
+}
+
+/* m = m * n, like the matrix operations of GL */
+static void multiply(float* m, const float* n) {
+    float result[16];
+    for(int column = 0; column < 4; column++)
+        for(int row = 0; row < 4; row++)
+            result[column * 4 + row] = m[row] * n[column * 4] + m[4 + row] * n[column * 4 + 1] +
+                                       m[8 + row] * n[column * 4 + 2] + m[12 + row] * n[column * 4 + 3];
+    
+    memcpy(m, result, sizeof(result));
+}
+
+static void identity(float* m) {
+    memset(m, 0, sizeof(float) * 16);
+    m[0] = m[5] = m[10] = m[15] = 1.0f;
+}
+
+/* glRotatef around one of the axes */
+static void rotate(float* m, float degrees, int axis) {
+    float rotation[16];
+    float sine = sinf(DEGREES_TO_RADIANS(degrees));
+    float cosine = cosf(DEGREES_TO_RADIANS(degrees));
+    int first = (axis + 1) % 3;
+    int second = (axis + 2) % 3;
+    
+    identity(rotation);
+    rotation[first * 4 + first] = cosine;
+    rotation[first * 4 + second] = sine;
+    rotation[second * 4 + first] = -sine;
+    rotation[second * 4 + second] = cosine;
+    multiply(m, rotation);
+}
+
+static void translate(float* m, float x, float y, float z) {
+    float translation[16];
+    identity(translation);
+    translation[12] = x;
+    translation[13] = y;
+    translation[14] = z;
+    multiply(m, translation);
+}
+
+/* gluPerspective */
+static void perspective(float* m, float fovy, float aspect, float zNear, float zFar) {
+    float f = 1.0f / tanf(DEGREES_TO_RADIANS(fovy) / 2.0f);
+    memset(m, 0, sizeof(float) * 16);
+    m[0] = f / aspect;
+    m[5] = f;
+    m[10] = (zFar + zNear) / (zNear - zFar);
+    m[11] = -1.0f;
+    m[14] = 2.0f * zFar * zNear / (zNear - zFar);
+}
+
+static void prepareCamera(const SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    const SGSceneCamera* camera = &input->camera;
+    snapshot->camera = *camera;
+    
+    // The same transformations that the environment applies before drawing
+    identity(snapshot->modelview);
+    rotate(snapshot->modelview, 90.0f * camera->roll, 2);
+    rotate(snapshot->modelview, -90.0f * camera->pitch, 0);
+    rotate(snapshot->modelview, camera->heading, 1);
+    translate(snapshot->modelview, -camera->x, -camera->height, -camera->z);
+    
+    float aspect = camera->viewport[3] ? (float)camera->viewport[2] / camera->viewport[3] : 1.0f;
+    perspective(snapshot->projection, camera->fovy, aspect, camera->zNear, camera->zFar);
+    
+    memcpy(snapshot->transform, snapshot->projection, sizeof(snapshot->transform));
+    multiply(snapshot->transform, snapshot->modelview);
+}
+
+int SGSceneSnapshotProject(const SGSceneSnapshot* snapshot, float x, float y, float z,
+                           float* winX, float* winY, float* winZ) {
+    const float* m = snapshot->transform;
+    float w = m[3] * x + m[7] * y + m[11] * z + m[15];
+    if(w == 0.0f)
+        return 0;
+    
+    const int* viewport = snapshot->camera.viewport;
+    *winX = viewport[0] + viewport[2] * ((m[0] * x + m[4] * y + m[8] * z + m[12]) / w + 1.0f) / 2.0f;
+    *winY = viewport[1] + viewport[3] * ((m[1] * x + m[5] * y + m[9] * z + m[13]) / w + 1.0f) / 2.0f;
+    *winZ = ((m[2] * x + m[6] * y + m[10] * z + m[14]) / w + 1.0f) / 2.0f;
+    return 1;
+}
+
+static void reserveBillboards(SGSceneSnapshot* snapshot, int count) {
+    if(count > snapshot->billboardCapacity) {
+        snapshot->billboardCapacity = count;
+        snapshot->billboards = (SGSceneBillboard*)realloc(snapshot->billboards, sizeof(SGSceneBillboard) * count);
+    }
+}
+
+static SGSceneBillboard* addBillboard(SGSceneSnapshot* snapshot, const SGSceneInput* input, int entry) {
+    SGSceneBillboard* billboard = &snapshot->billboards[snapshot->amountOfBillboards++];
+    billboard->y = input->y[entry];
+    billboard->offsetX = 0.0f;
+    billboard->offsetY = 0.0f;
+    billboard->touchX = 0.0f;
+    billboard->touchY = 0.0f;
+    billboard->touchWidth = 0.0f;
+    billboard->touchHeight = 0.0f;
+    billboard->touchDistance = input->distances[entry];
+    billboard->entry = entry;
+    billboard->handle = input->handles[entry];
+    billboard->hidden = 0;
+    billboard->touchable = 0;
+    return billboard;
+}
+
+static void layoutEntries(const SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    reserveBillboards(snapshot, input->count);
+    
+    // The entries are already sorted from the back to the front
+    SGSceneBillboard* billboard;
+    int entry;
+    for(int i = 0; i < input->count; i++) {
+        entry = input->order[i];
+        if(input->flags[entry])
+            continue;
+        
+        billboard = addBillboard(snapshot, input, entry);
+        billboard->x = input->x[entry];
+        billboard->z = input->z[entry];
+        billboard->bearing = input->bearings[entry] - 90.0f;
+        billboard->distance = input->distances[entry];
+        billboard->count = 1;
+    }
+}
+
+static void buildClusters(SGScene* scene, const SGSceneInput* input) {
+    if(input->count > scene->clusterEntryCapacity) {
+        scene->clusterEntryCapacity = input->count;
+        scene->clusterEntries = (int*)realloc(scene->clusterEntries, sizeof(int) * scene->clusterEntryCapacity);
+        scene->clusterX = (float*)realloc(scene->clusterX, sizeof(float) * scene->clusterEntryCapacity);
+        scene->clusterZ = (float*)realloc(scene->clusterZ, sizeof(float) * scene->clusterEntryCapacity);
+        scene->clusterDistances = (float*)realloc(scene->clusterDistances, sizeof(float) * scene->clusterEntryCapacity);
+    }
+    
+    // Captured and hidden entries are left out so that they can neither
+    // represent a cluster nor be counted by one.
+    int count = 0;
+    for(int entry = 0; entry < input->count; entry++) {
+        if(input->flags[entry])
+            continue;
+        
+        scene->clusterEntries[count] = entry;
+        scene->clusterX[count] = input->x[entry];
+        scene->clusterZ[count] = input->z[entry];
+        scene->clusterDistances[count] = input->distances[entry];
+        count++;
+    }
+    
+    SGClusterTreeBuild(scene->clusterTree, scene->clusterX, scene->clusterZ, scene->clusterDistances, count,
+                       input->clusterCellSize);
+}
+
+static void layoutClusters(SGScene* scene, const SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    SGClusterTree* tree = scene->clusterTree;
+    if(!scene->hasClusters || scene->clusterRevision != input->revision) {
+        buildClusters(scene, input);
+        scene->clusterRevision = input->revision;
+        scene->hasClusters = 1;
+        
+        if(tree->nodeCount > scene->clusterCutCapacity) {
+            scene->clusterCutCapacity = tree->nodeCount;
+            scene->clusterCut = (int*)realloc(scene->clusterCut, sizeof(int) * scene->clusterCutCapacity);
+        }
+    }
+    
+    const SGSceneCamera* camera = &input->camera;
+    int amountOfClusters = SGClusterTreeCut(tree, camera->x, camera->z, DEGREES_TO_RADIANS(input->clusterTolerance),
+                                            scene->clusterCut, tree->nodeCount);
+    
+    // Blending requires that we draw from back to front
+    SGClusterTreeSortBackToFront(tree, scene->clusterCut, amountOfClusters, camera->x, camera->z);
+    reserveBillboards(snapshot, amountOfClusters);
+    
+    SGClusterNode* cluster;
+    SGSceneBillboard* billboard;
+    for(int i = 0; i < amountOfClusters; i++) {
+        cluster = &tree->nodes[scene->clusterCut[i]];
+        
+        // The representative is drawn in place of the entire cluster
+        // and receives its touch events.
+        billboard = addBillboard(snapshot, input, scene->clusterEntries[cluster->representative]);
+        billboard->x = cluster->x;
+        billboard->z = cluster->z;
+        billboard->bearing = RADIANS_TO_DEGREES(SGFastAtan2(cluster->z, cluster->x, kSGTrigAccuracy_Medium));
+        billboard->distance = sqrtf(cluster->x * cluster->x + cluster->z * cluster->z);
+        billboard->count = cluster->count;
+    }
+}
+
+static SGDeclutterState* declutterState(SGScene* scene, SGAnnotationHandle handle) {
+    int slot = SGAnnotationHandleSlot(handle);
+    if(slot >= scene->declutterCapacity) {
+        int capacity = scene->declutterCapacity ? scene->declutterCapacity : 64;
+        while(capacity <= slot)
+            capacity *= 2;
+        
+        scene->declutterStates = (SGDeclutterState*)realloc(scene->declutterStates, sizeof(SGDeclutterState) * capacity);
+        scene->declutterHandles = (SGAnnotationHandle*)realloc(scene->declutterHandles, sizeof(SGAnnotationHandle) * capacity);
+        for(int i = scene->declutterCapacity; i < capacity; i++)
+            scene->declutterHandles[i] = kSGAnnotationHandle_Invalid;
+        
+        scene->declutterCapacity = capacity;
+    }
+    
+    // A slot that was handed to a new entry starts over
+    if(scene->declutterHandles[slot] != handle) {
+        scene->declutterHandles[slot] = handle;
+        SGDeclutterStateReset(&scene->declutterStates[slot]);
+    }
+    
+    return &scene->declutterStates[slot];
+}
+
+static void projectBillboards(void* context, int begin, int end) {
+    SGScenePass* pass = (SGScenePass*)context;
+    SGSceneSnapshot* snapshot = pass->snapshot;
+    SGSceneBillboard* billboard;
+    float* projection;
+    float winX, winY, winZ, upX, upY, upZ;
+    float scale;
+    for(int i = begin; i < end; i++) {
+        billboard = &snapshot->billboards[i];
+        projection = &pass->scene->projections[i * 3];
+        projection[2] = 0.0f;
+        
+        // Behind the camera
+        if(!SGSceneSnapshotProject(snapshot, billboard->x, billboard->y, billboard->z, &winX, &winY, &winZ) ||
+           winZ >= 1.0f)
+            continue;
+        
+        // Amount of pixels a unit covers at the depth of the billboard
+        if(!SGSceneSnapshotProject(snapshot, billboard->x, billboard->y + 1.0f, billboard->z, &upX, &upY, &upZ))
+            continue;
+        
+        scale = DistanceBetweenTwoPoints(winX, winY, upX, upY);
+        if(scale <= 0.0f)
+            continue;
+        
+        if(billboard->distance < kSGScene_CloseDistance)
+            scale *= billboard->distance / kSGScene_CloseScale;
+        
+        projection[0] = winX;
+        projection[1] = winY;
+        projection[2] = scale;
+    }
+}
+
+static void declutterBillboards(SGScene* scene, const SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    float viewportHeight = snapshot->camera.viewport[3];
+    SGDeclutterGridBegin(scene->declutterGrid, snapshot->camera.viewport[2], viewportHeight);
+    
+    if(snapshot->amountOfBillboards > scene->projectionCapacity) {
+        scene->projectionCapacity = snapshot->amountOfBillboards;
+        scene->projections = (float*)realloc(scene->projections, sizeof(float) * 3 * scene->projectionCapacity);
+    }
+    
+    // Only the placement depends on the billboards in front
+    SGScenePass pass = { scene, input, snapshot };
+    SGTaskPoolParallelFor(scene->taskPool, snapshot->amountOfBillboards, kSGScene_ProjectionGrain, projectBillboards, &pass);
+    
+    SGSceneBillboard* billboard;
+    float* projection;
+    float width, height;
+    float winX, winY, scale, offsetX, offsetY;
+    
+    // The billboards are ordered from back to front and the closest
+    // ones have the first pick of the screen.
+    for(int i = snapshot->amountOfBillboards - 1; i >= 0; i--) {
+        billboard = &snapshot->billboards[i];
+        projection = &scene->projections[i * 3];
+        scale = projection[2];
+        if(scale <= 0.0f)
+            continue;
+        
+        winX = projection[0];
+        winY = projection[1];
+        
+        // The size of the texture as it was drawn during the last frame
+        width = input->widths[billboard->entry];
+        height = input->heights[billboard->entry];
+        
+        billboard->hidden = !SGDeclutterPlace(scene->declutterGrid, declutterState(scene, billboard->handle),
+                                              winX - width * scale / 2.0f, viewportHeight - winY,
+                                              width * scale, height * scale,
+                                              &offsetX, &offsetY);
+        
+        // Window coordinates point down while the billboard's y axis points up
+        billboard->offsetX = offsetX / scale;
+        billboard->offsetY = -offsetY / scale;
+    }
+    
+    snapshot->moved = scene->declutterGrid->moved;
+    snapshot->hidden = scene->declutterGrid->hidden;
+}
+
+/* the touch rectangles are placed at the same point that the texture is drawn at and grow with the distance */
+static void projectTouches(void* context, int begin, int end) {
+    SGScenePass* pass = (SGScenePass*)context;
+    const SGSceneInput* input = pass->input;
+    SGSceneSnapshot* snapshot = pass->snapshot;
+    const int* viewport = snapshot->camera.viewport;
+    SGSceneBillboard* billboard;
+    float sine, cosine, winX, winY, winZ, delta;
+    int left, top, right, bottom;
+    for(int i = begin; i < end; i++) {
+        billboard = &snapshot->billboards[i];
+        if(billboard->hidden)
+            continue;
+        
+        SGFastSinCos(DEGREES_TO_RADIANS(-(billboard->bearing + 90.0f)), &sine, &cosine, kSGTrigAccuracy_Medium);
+        if(!SGSceneSnapshotProject(snapshot, billboard->x + billboard->offsetX * cosine, billboard->y + billboard->offsetY,
+                                   billboard->z - billboard->offsetX * sine, &winX, &winY, &winZ) || winZ >= 1.0f)
+            continue;
+        
+        delta = input->touchScale / billboard->touchDistance;
+        billboard->touchWidth = input->widths[billboard->entry] * delta;
+        billboard->touchHeight = input->heights[billboard->entry] * delta;
+        
+        // Allows for a larger touch space
+        if(billboard->touchWidth < kSGScene_MinimumTouchSize)
+            billboard->touchWidth = kSGScene_MinimumTouchSize;
+        if(billboard->touchHeight < kSGScene_MinimumTouchSize)
+            billboard->touchHeight = kSGScene_MinimumTouchSize;
+        
+        billboard->touchX = winX - billboard->touchWidth / 2.0f;
+        billboard->touchY = viewport[3] - winY;
+        
+        left = (int)floorf((billboard->touchX - viewport[0]) / kSGScene_TouchCellSize);
+        top = (int)floorf(billboard->touchY / kSGScene_TouchCellSize);
+        right = (int)floorf((billboard->touchX + billboard->touchWidth - viewport[0]) / kSGScene_TouchCellSize);
+        bottom = (int)floorf((billboard->touchY + billboard->touchHeight) / kSGScene_TouchCellSize);
+        billboard->touchable = right >= 0 && bottom >= 0 && left < snapshot->touchColumns && top < snapshot->touchRows;
+    }
+}
+
+static void prepareTouches(SGScene* scene, const SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    const int* viewport = snapshot->camera.viewport;
+    int columns = (int)ceilf(viewport[2] / kSGScene_TouchCellSize);
+    int rows = (int)ceilf(viewport[3] / kSGScene_TouchCellSize);
+    if(columns < 1)
+        columns = 1;
+    if(rows < 1)
+        rows = 1;
+    
+    int cellCount = columns * rows;
+    if(cellCount + 1 > snapshot->touchCellCapacity) {
+        snapshot->touchCellCapacity = cellCount + 1;
+        snapshot->touchCells = (int*)realloc(snapshot->touchCells, sizeof(int) * snapshot->touchCellCapacity);
+    }
+    
+    snapshot->touchColumns = columns;
+    snapshot->touchRows = rows;
+    memset(snapshot->touchCells, 0, sizeof(int) * (cellCount + 1));
+    
+    SGScenePass pass = { scene, input, snapshot };
+    SGTaskPoolParallelFor(scene->taskPool, snapshot->amountOfBillboards, kSGScene_ProjectionGrain, projectTouches, &pass);
+    
+    // The cells are counted on this thread alone
+    SGSceneBillboard* billboard;
+    int left, top, right, bottom, amount = 0;
+    for(int i = 0; i < snapshot->amountOfBillboards; i++) {
+        billboard = &snapshot->billboards[i];
+        if(!billboard->touchable)
+            continue;
+        
+        left = (int)floorf((billboard->touchX - viewport[0]) / kSGScene_TouchCellSize);
+        top = (int)floorf(billboard->touchY / kSGScene_TouchCellSize);
+        right = (int)floorf((billboard->touchX + billboard->touchWidth - viewport[0]) / kSGScene_TouchCellSize);
+        bottom = (int)floorf((billboard->touchY + billboard->touchHeight) / kSGScene_TouchCellSize);
+        left = left < 0 ? 0 : left;
+        top = top < 0 ? 0 : top;
+        right = right >= columns ? columns - 1 : right;
+        bottom = bottom >= rows ? rows - 1 : bottom;
+        
+        for(int row = top; row <= bottom; row++)
+            for(int column = left; column <= right; column++)
+                snapshot->touchCells[row * columns + column + 1]++;
+        
+        amount += (right - left + 1) * (bottom - top + 1);
+    }
+    
+    if(amount > snapshot->touchBillboardCapacity) {
+        snapshot->touchBillboardCapacity = amount;
+        snapshot->touchBillboards = (int*)realloc(snapshot->touchBillboards, sizeof(int) * amount);
+    }
+    
+    // Counts become offsets, which are then moved along while filling
+    // the cells so that each ends up where the next one starts.
+    for(int cell = 0; cell < cellCount; cell++)
+        snapshot->touchCells[cell + 1] += snapshot->touchCells[cell];
+    
+    for(int i = 0; i < snapshot->amountOfBillboards; i++) {
+        billboard = &snapshot->billboards[i];
+        if(!billboard->touchable)
+            continue;
+        
+        left = (int)floorf((billboard->touchX - viewport[0]) / kSGScene_TouchCellSize);
+        top = (int)floorf(billboard->touchY / kSGScene_TouchCellSize);
+        right = (int)floorf((billboard->touchX + billboard->touchWidth - viewport[0]) / kSGScene_TouchCellSize);
+        bottom = (int)floorf((billboard->touchY + billboard->touchHeight) / kSGScene_TouchCellSize);
+        left = left < 0 ? 0 : left;
+        top = top < 0 ? 0 : top;
+        right = right >= columns ? columns - 1 : right;
+        bottom = bottom >= rows ? rows - 1 : bottom;
+        
+        for(int row = top; row <= bottom; row++)
+            for(int column = left; column <= right; column++)
+                snapshot->touchBillboards[snapshot->touchCells[row * columns + column]++] = i;
+    }
+    
+    for(int cell = cellCount; cell > 0; cell--)
+        snapshot->touchCells[cell] = snapshot->touchCells[cell - 1];
+    snapshot->touchCells[0] = 0;
+}
+
+const SGSceneBillboard* SGSceneSnapshotTouch(const SGSceneSnapshot* snapshot, float x, float y) {
+    const int* viewport = snapshot->camera.viewport;
+    int column = (int)floorf((x - viewport[0]) / kSGScene_TouchCellSize);
+    int row = (int)floorf(y / kSGScene_TouchCellSize);
+    if(column < 0 || row < 0 || column >= snapshot->touchColumns || row >= snapshot->touchRows)
+        return NULL;
+    
+    int cell = row * snapshot->touchColumns + column;
+    const SGSceneBillboard* billboard;
+    const SGSceneBillboard* closest = NULL;
+    for(int i = snapshot->touchCells[cell]; i < snapshot->touchCells[cell + 1]; i++) {
+        billboard = &snapshot->billboards[snapshot->touchBillboards[i]];
+        if(x >= billboard->touchX && x <= billboard->touchX + billboard->touchWidth &&
+           y >= billboard->touchY && y <= billboard->touchY + billboard->touchHeight &&
+           (!closest || billboard->touchDistance < closest->touchDistance))
+            closest = billboard;
+    }
+    
+    return closest;
+}
+
+static void prepareBlips(const SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    snapshot->amountOfBlips = 0;
+    if(input->radarWidth <= 0.0f)
+        return;
+    
+    if(input->count > snapshot->blipCapacity) {
+        snapshot->blipCapacity = input->count;
+        snapshot->blips = (SGSceneBlip*)realloc(snapshot->blips, sizeof(SGSceneBlip) * input->count);
+    }
+    
+    int slotCount = 0;
+    for(int i = 0; i < input->count; i++)
+        if(SGAnnotationHandleSlot(input->handles[i]) >= slotCount)
+            slotCount = SGAnnotationHandleSlot(input->handles[i]) + 1;
+    
+    if(slotCount > snapshot->blipSlotCapacity) {
+        snapshot->blipSlotCapacity = slotCount;
+        snapshot->blipSlots = (int*)realloc(snapshot->blipSlots, sizeof(int) * slotCount);
+    }
+    
+    snapshot->blipSlotCount = slotCount;
+    memset(snapshot->blipSlots, 0xFF, sizeof(int) * slotCount);
+    
+    SGSceneBlip* blip;
+    float sine, cosine, distance;
+    float centerX = input->radarWidth / 2.0f + input->radarOffsetX * input->radarScale;
+    float centerY = input->radarWidth / 2.0f + input->radarOffsetY * input->radarScale;
+    for(int i = 0; i < input->count; i++) {
+        blip = &snapshot->blips[snapshot->amountOfBlips];
+        blip->handle = input->handles[i];
+        snapshot->blipSlots[SGAnnotationHandleSlot(blip->handle)] = snapshot->amountOfBlips++;
+        
+        // A blip is a few pixels wide so the cheapest tier is plenty.
+        distance = input->distances[i] * input->radarScale;
+        SGFastSinCos(DEGREES_TO_RADIANS(input->bearings[i] - 90.0f), &sine, &cosine, kSGTrigAccuracy_Low);
+        blip->x = distance * cosine + centerX;
+        blip->y = distance * sine + centerY;
+        blip->visible = !(input->flags[i] & kSGSceneEntry_Captured) &&
+                        blip->x >= -kSGScene_RadarMargin && blip->x < input->radarWidth + kSGScene_RadarMargin &&
+                        blip->y >= -kSGScene_RadarMargin && blip->y < input->radarHeight + kSGScene_RadarMargin;
+    }
+}
+
+const SGSceneBlip* SGSceneSnapshotBlip(const SGSceneSnapshot* snapshot, SGAnnotationHandle handle) {
+    int slot = SGAnnotationHandleSlot(handle);
+    if(handle == kSGAnnotationHandle_Invalid || slot >= snapshot->blipSlotCount || snapshot->blipSlots[slot] < 0)
+        return NULL;
+    
+    const SGSceneBlip* blip = &snapshot->blips[snapshot->blipSlots[slot]];
+    return blip->handle == handle ? blip : NULL;
+}
+
+SGScene* SGSceneNew(void) {
+    SGScene* scene = (SGScene*)calloc(1, sizeof(SGScene));
+    scene->clusterTree = SGClusterTreeNew();
+    scene->declutterGrid = SGDeclutterGridNew(320.0f, 480.0f, kSGScene_DeclutterCellSize);
+    return scene;
+}
+
+void SGSceneFree(SGScene* scene) {
+    if(!scene)
+        return;
+    
+    SGClusterTreeFree(scene->clusterTree);
+    free(scene->clusterCut);
+    free(scene->clusterEntries);
+    free(scene->clusterX);
+    free(scene->clusterZ);
+    free(scene->clusterDistances);
+    SGDeclutterGridFree(scene->declutterGrid);
+    free(scene->declutterStates);
+    free(scene->declutterHandles);
+    free(scene->projections);
+    free(scene);
+}
+
+void SGScenePrepare(SGScene* scene, const SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    snapshot->frame = input->frame;
+    snapshot->amountOfBillboards = 0;
+    snapshot->moved = 0;
+    snapshot->hidden = 0;
+    
+    prepareCamera(input, snapshot);
+    
+    if(input->clustering)
+        layoutClusters(scene, input, snapshot);
+    else
+        layoutEntries(input, snapshot);
+    
+    if(input->decluttering)
+        declutterBillboards(scene, input, snapshot);
+    
+    prepareTouches(scene, input, snapshot);
+    prepareBlips(input, snapshot);
+}
+
+static void* runWorker(void* argument) {
+    SGSceneWorker* worker = (SGSceneWorker*)argument;
+    SGSceneInput* input;
+    SGSceneSnapshot* snapshot;
+    
+    pthread_mutex_lock(&worker->lock);
+    while(1) {
+        while(worker->running && !worker->hasPending)
+            pthread_cond_wait(&worker->condition, &worker->lock);
+        
+        if(!worker->running)
+            break;
+        
+        // The render thread fills the other input while this one is prepared
+        input = worker->pending;
+        worker->pending = worker->working;
+        worker->working = input;
+        worker->hasPending = 0;
+        pthread_mutex_unlock(&worker->lock);
+        
+        snapshot = (SGSceneSnapshot*)SGTripleBufferBack(&worker->buffer);
+        SGAllocationTrackerBeginPass(&snapshot->allocations);
+        SGScenePrepare(worker->scene, input, snapshot);
+        SGAllocationTrackerEndPass();
+        SGTripleBufferPublish(&worker->buffer);
+        
+        pthread_mutex_lock(&worker->lock);
+    }
+    pthread_mutex_unlock(&worker->lock);
+    
+    return NULL;
+}
+
+SGSceneWorker* SGSceneWorkerNew(void) {
+    SGSceneWorker* worker = (SGSceneWorker*)calloc(1, sizeof(SGSceneWorker));
+    worker->scene = SGSceneNew();
+    
+    SGSceneInputInit(&worker->inputs[0]);
+    SGSceneInputInit(&worker->inputs[1]);
+    worker->pending = &worker->inputs[0];
+    worker->working = &worker->inputs[1];
+    
+    for(int i = 0; i < 3; i++)
+        SGSceneSnapshotInit(&worker->snapshots[i]);
+    SGTripleBufferInit(&worker->buffer, &worker->snapshots[0], &worker->snapshots[1], &worker->snapshots[2]);
+    
+    pthread_mutex_init(&worker->lock, NULL);
+    pthread_cond_init(&worker->condition, NULL);
+    worker->running = 1;
+    if(pthread_create(&worker->thread, NULL, runWorker, worker)) {
+        worker->running = 0;
+        SGSceneWorkerFree(worker);
+        return NULL;
+    }
+    
+    return worker;
+}
+
+void SGSceneWorkerFree(SGSceneWorker* worker) {
+    if(!worker)
+        return;
+    
+    pthread_mutex_lock(&worker->lock);
+    int running = worker->running;
+    worker->running = 0;
+    pthread_cond_signal(&worker->condition);
+    pthread_mutex_unlock(&worker->lock);
+    
+    if(running)
+        pthread_join(worker->thread, NULL);
+    
+    pthread_mutex_destroy(&worker->lock);
+    pthread_cond_destroy(&worker->condition);
+    
+    SGSceneFree(worker->scene);
+    SGSceneInputDestroy(&worker->inputs[0]);
+    SGSceneInputDestroy(&worker->inputs[1]);
+    for(int i = 0; i < 3; i++)
+        SGSceneSnapshotDestroy(&worker->snapshots[i]);
+    
+    free(worker);
+}
+
+SGSceneInput* SGSceneWorkerBeginInput(SGSceneWorker* worker) {
+    pthread_mutex_lock(&worker->lock);
+    return worker->pending;
+}
+
+void SGSceneWorkerCommitInput(SGSceneWorker* worker) {
+    worker->submitted++;
+    if(worker->hasPending)
+        worker->replaced++;
+    
+    worker->hasPending = 1;
+    pthread_cond_signal(&worker->condition);
+    pthread_mutex_unlock(&worker->lock);
+}
+
+const SGSceneSnapshot* SGSceneWorkerAcquire(SGSceneWorker* worker) {
+    SGSceneSnapshot* snapshot = (SGSceneSnapshot*)SGTripleBufferAcquire(&worker->buffer);
+    
+    // The reader owns the snapshot now, so its allocations are only merged
+    // into the first frame that acquires it. Those of a snapshot that was
+    // replaced before it was acquired are not counted.
+    if(snapshot) {
+        SGAllocationTrackerMergePass(&snapshot->allocations);
+        memset(&snapshot->allocations, 0, sizeof(SGAllocationCounts));
+    }
+    
+    return snapshot;
+}
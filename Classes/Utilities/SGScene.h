@@ -0,0 +1,260 @@
+//
+//  SGScene.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import <pthread.h>
+
+#import "SGAllocationTracker.h"
+#import "SGAnnotationStore.h"
+#import "SGCluster.h"
+#import "SGDeclutter.h"
+#import "SGTaskPool.h"
+#import "SGTripleBuffer.h"
+
+/*
+* The simulation that runs once per frame before anything is drawn: the
+* matrices of the camera, the layout of the billboards with or without
+* clusters, the declutter pass, the rectangles that touches are tested
+* against and the blips of the radar. A frame is prepared from an input that
+* holds a copy of everything it needs into a snapshot that is not changed
+* afterwards. Neither refers to the annotation store or to GL, so frames can
+* be prepared on another thread while the render thread draws.
+*
+* Billboards refer to their annotations by handle. The store may change while
+* a frame is being prepared, so the render thread resolves every handle and
+* skips the ones that are no longer valid.
+*
+* A worker prepares frames on its own thread. The render thread hands it the
+* input of the next frame under a lock that is held only while the input is
+* copied, and picks up the latest snapshot through a triple buffer. Neither
+* thread waits for the other to finish a frame.
+*/
+
+#define kSGScene_MinimumTouchSize   40.0f   /* pixels */
+#define kSGScene_TouchCellSize      32.0f   /* pixels */
+#define kSGScene_RadarMargin        5.0f    /* pixels outside the radar that blips are still shown in */
+#define kSGScene_DeclutterCellSize  16.0f   /* pixels */
+#define kSGScene_ProjectionGrain    256     /* billboards per task */
+
+/* flags of the entries of an input */
+#define kSGSceneEntry_Captured      1
+#define kSGSceneEntry_Hidden        2
+
+typedef struct SGSceneCameraStruct {
+    float pitch;                /* the filtered accelerometer values */
+    float roll;
+    float heading;              /* degrees */
+    float x, z;                 /* position on the ground plane */
+    float height;               /* of the eye above the ground */
+    float fovy;                 /* degrees */
+    float zNear, zFar;
+    int viewport[4];
+} SGSceneCamera;
+
+typedef struct SGSceneInputStruct {
+    SGSceneCamera camera;
+    unsigned int frame;         /* copied to the snapshot */
+    
+    /* settings */
+    int clustering;
+    float clusterTolerance;     /* degrees */
+    float clusterCellSize;
+    int decluttering;
+    float touchScale;           /* touch rectangles are the size of the texture times touchScale / distance */
+    float radarWidth;           /* 0 without a radar */
+    float radarHeight;
+    float radarScale;           /* pixels per environment unit */
+    float radarOffsetX;         /* the walking offset in environment units */
+    float radarOffsetY;
+    
+    /* entries of the store; the clusters are only rebuilt when revision changes, which includes the flags */
+    unsigned int revision;
+    int count;
+    int capacity;
+    float* x;
+    float* y;
+    float* z;
+    float* distances;
+    float* bearings;
+    float* widths;
+    float* heights;
+    unsigned char* flags;
+    SGAnnotationHandle* handles;
+    int* order;                 /* entries from the back to the front */
+} SGSceneInput;
+
+typedef struct SGSceneBillboardStruct {
+    float x, y, z;
+    float bearing;              /* degrees, as the billboard is rotated */
+    float distance;             /* from the origin */
+    float offsetX, offsetY;     /* from the declutter pass in billboard units */
+    float touchX, touchY;       /* top-left corner of the touch rectangle in window coordinates */
+    float touchWidth, touchHeight;
+    float touchDistance;        /* the closest of the billboards under a touch wins */
+    int count;                  /* annotations that the billboard stands for */
+    int entry;                  /* of the input */
+    SGAnnotationHandle handle;
+    int hidden;
+    int touchable;
+} SGSceneBillboard;
+
+typedef struct SGSceneBlipStruct {
+    float x, y;                 /* center of the blip in the radar */
+    SGAnnotationHandle handle;
+    int visible;
+} SGSceneBlip;
+
+typedef struct SGSceneSnapshotStruct {
+    unsigned int frame;
+    SGSceneCamera camera;
+    float modelview[16];        /* of the billboards, column major like GL */
+    float projection[16];
+    float transform[16];        /* projection times modelview */
+    
+    /* from the back to the front */
+    SGSceneBillboard* billboards;
+    int amountOfBillboards;
+    int billboardCapacity;
+    int moved;
+    int hidden;
+    
+    /* billboards by the cell of the viewport that their touch rectangle covers */
+    int* touchCells;            /* offsets into touchBillboards, one more than there are cells */
+    int* touchBillboards;
+    int touchColumns;
+    int touchRows;
+    int touchCellCapacity;
+    int touchBillboardCapacity;
+    
+    /* one for every entry of the input, found by the slot of their handle */
+    SGSceneBlip* blips;
+    int amountOfBlips;
+    int blipCapacity;
+    int* blipSlots;
+    int blipSlotCount;
+    int blipSlotCapacity;
+    
+    /* made by the worker while it prepared the snapshot, once allocations are tracked */
+    SGAllocationCounts allocations;
+} SGSceneSnapshot;
+
+typedef struct SGSceneStruct {
+    SGClusterTree* clusterTree;
+    int* clusterCut;
+    int clusterCutCapacity;
+    unsigned int clusterRevision;
+    int hasClusters;
+    
+    /* the entries without flags that the tree was built from, by leaf */
+    int* clusterEntries;
+    float* clusterX;
+    float* clusterZ;
+    float* clusterDistances;
+    int clusterEntryCapacity;
+    
+    /* declutter states are kept by slot across frames */
+    SGDeclutterGrid* declutterGrid;
+    SGDeclutterState* declutterStates;
+    SGAnnotationHandle* declutterHandles;
+    int declutterCapacity;
+    
+    /* window x, y and pixels per unit of every billboard, a scale of 0 is off screen */
+    float* projections;
+    int projectionCapacity;
+    
+    /* splits the projection of the billboards between the cores; NULL projects on the caller */
+    SGTaskPool* taskPool;
+} SGScene;
+
+typedef struct SGSceneWorkerStruct {
+    SGScene* scene;
+    SGSceneInput inputs[2];
+    SGSceneInput* pending;      /* filled by the render thread */
+    SGSceneInput* working;      /* read by the worker */
+    int hasPending;
+    int running;
+    
+    SGSceneSnapshot snapshots[3];
+    SGTripleBuffer buffer;
+    
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t condition;
+    
+    /* statistics, kept by the render thread */
+    unsigned int submitted;
+    unsigned int replaced;      /* inputs that were submitted before the worker got to the previous one */
+} SGSceneWorker;
+
+extern void SGSceneInputInit(SGSceneInput* input);
+extern void SGSceneInputDestroy(SGSceneInput* input);
+
+/* copy the entries of a store; entries are in the same order as in the store */
+extern void SGSceneInputCopyStore(SGSceneInput* input, const SGAnnotationStore* store);
+
+extern void SGSceneSnapshotInit(SGSceneSnapshot* snapshot);
+extern void SGSceneSnapshotDestroy(SGSceneSnapshot* snapshot);
+
+/* project a point like gluProject; returns 0 if it cannot be projected */
+extern int SGSceneSnapshotProject(const SGSceneSnapshot* snapshot, float x, float y, float z,
+                                  float* winX, float* winY, float* winZ);
+
+/* the closest billboard whose touch rectangle holds (x, y) in window coordinates (y pointing down) or NULL */
+extern const SGSceneBillboard* SGSceneSnapshotTouch(const SGSceneSnapshot* snapshot, float x, float y);
+
+/* the blip of an entry or NULL if the entry was not part of the frame */
+extern const SGSceneBlip* SGSceneSnapshotBlip(const SGSceneSnapshot* snapshot, SGAnnotationHandle handle);
+
+extern SGScene* SGSceneNew(void);
+extern void SGSceneFree(SGScene* scene);
+
+/* prepare a frame; the snapshot is overwritten and its memory is reused */
+extern void SGScenePrepare(SGScene* scene, const SGSceneInput* input, SGSceneSnapshot* snapshot);
+
+/* create a worker and start its thread */
+extern SGSceneWorker* SGSceneWorkerNew(void);
+
+/* stop the thread and release all memory held by the worker */
+extern void SGSceneWorkerFree(SGSceneWorker* worker);
+
+/* lock the input of the next frame so the render thread can fill it */
+extern SGSceneInput* SGSceneWorkerBeginInput(SGSceneWorker* worker);
+
+/* unlock the input and wake up the worker */
+extern void SGSceneWorkerCommitInput(SGSceneWorker* worker);
+
+/*
+* the latest snapshot; it stays valid until the next call; NULL until the first frame was prepared.
+* The allocations of a new snapshot are merged into the frame that the calling thread is tracking.
+*/
+extern const SGSceneSnapshot* SGSceneWorkerAcquire(SGSceneWorker* worker);
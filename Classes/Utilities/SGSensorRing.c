@@ -0,0 +1,91 @@
+//
+//  SGSensorRing.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import "SGSensorRing.h"
+
+#import <string.h>
+
+/*
+* atomic reads of the indices; the other side reads them with an atomic
+* operation, so even the side that owns an index does not read it plainly
+*/
+#define SGSensorRingHead(__RING__)      __sync_fetch_and_add(&(__RING__)->head, 0)
+#define SGSensorRingTail(__RING__)      __sync_fetch_and_add(&(__RING__)->tail, 0)
+
+void SGSensorRingInit(SGSensorRing* ring) {
+    memset(ring, 0, sizeof(SGSensorRing));
+    __sync_synchronize();
+}
+
+int SGSensorRingPush(SGSensorRing* ring, const SGSensorSample* sample) {
+    unsigned int tail = SGSensorRingTail(ring);
+    
+    // The indices run freely and wrap around together
+    if(tail - SGSensorRingHead(ring) >= kSGSensorRing_Capacity) {
+        __sync_fetch_and_add(&ring->dropped, 1);
+        return 0;
+    }
+    
+    ring->samples[tail & kSGSensorRing_Mask] = *sample;
+    
+    // The sample is written before the consumer can see the new tail
+    __sync_fetch_and_add(&ring->tail, 1);
+    __sync_fetch_and_add(&ring->pushed, 1);
+    return 1;
+}
+
+const SGSensorSample* SGSensorRingPeek(SGSensorRing* ring) {
+    unsigned int head = SGSensorRingHead(ring);
+    if(head == SGSensorRingTail(ring))
+        return NULL;
+    
+    return &ring->samples[head & kSGSensorRing_Mask];
+}
+
+int SGSensorRingPop(SGSensorRing* ring, SGSensorSample* sample) {
+    const SGSensorSample* oldest = SGSensorRingPeek(ring);
+    if(!oldest)
+        return 0;
+    
+    *sample = *oldest;
+    
+    // The sample is read before the producer may overwrite it
+    __sync_fetch_and_add(&ring->head, 1);
+    return 1;
+}
+
+int SGSensorRingCount(SGSensorRing* ring) {
+    return (int)(SGSensorRingTail(ring) - SGSensorRingHead(ring));
+}
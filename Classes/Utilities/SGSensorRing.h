@@ -0,0 +1,100 @@
+//
+//  SGSensorRing.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import <stdlib.h>
+
+/*
+* A lock-free ring of timestamped sensor samples between the one thread that
+* receives the sensor callbacks and the one thread that draws the frames.
+* The producer only writes the tail and the consumer only writes the head,
+* so pushing and popping never wait for each other. The frame drains every
+* sample that arrived since the last one, so the filters see all of them in
+* order instead of only the values that happened to be set when the frame
+* started. A full ring drops the new sample; the capacity holds about a
+* second of accelerometer samples, so that only happens while frames stall.
+*/
+
+#define kSGSensorRing_Capacity      128     /* samples; a power of two */
+#define kSGSensorRing_Mask          (kSGSensorRing_Capacity - 1)
+#define kSGSensorRing_CacheLine     64      /* bytes; keeps the head and the tail apart */
+#define kSGSensorSample_Values      6
+
+/* the values of the samples of each stream */
+#define kSGAccelerationSample_X             0
+#define kSGAccelerationSample_Y             1
+#define kSGAccelerationSample_Z             2
+
+#define kSGHeadingSample_TrueHeading        0   /* degrees */
+#define kSGHeadingSample_Accuracy           1   /* degrees */
+
+#define kSGLocationSample_Latitude          0
+#define kSGLocationSample_Longitude         1
+#define kSGLocationSample_Altitude          2   /* meters */
+#define kSGLocationSample_HorizontalAccuracy 3  /* meters */
+#define kSGLocationSample_VerticalAccuracy  4   /* meters */
+#define kSGLocationSample_Timestamp         5   /* seconds since the reference date */
+
+typedef struct SGSensorSampleStruct {
+    double timestamp;           /* seconds since boot; orders the samples of different streams */
+    double values[kSGSensorSample_Values];
+} SGSensorSample;
+
+typedef struct SGSensorRingStruct {
+    SGSensorSample samples[kSGSensorRing_Capacity];
+    
+    /* written by the producer */
+    volatile unsigned int tail;
+    volatile unsigned int pushed;
+    volatile unsigned int dropped;      /* samples that arrived while the ring was full */
+    char producerPadding[kSGSensorRing_CacheLine];
+    
+    /* written by the consumer */
+    volatile unsigned int head;
+    char consumerPadding[kSGSensorRing_CacheLine];
+} SGSensorRing;
+
+extern void SGSensorRingInit(SGSensorRing* ring);
+
+/* append a sample; returns 0 if the ring was full and the sample was dropped */
+extern int SGSensorRingPush(SGSensorRing* ring, const SGSensorSample* sample);
+
+/* the oldest sample without removing it; NULL if the ring is empty */
+extern const SGSensorSample* SGSensorRingPeek(SGSensorRing* ring);
+
+/* remove the oldest sample and copy it to sample; returns 0 if the ring was empty */
+extern int SGSensorRingPop(SGSensorRing* ring, SGSensorSample* sample);
+
+/* the amount of samples that are waiting; exact on the consumer, a lower bound on the producer */
+extern int SGSensorRingCount(SGSensorRing* ring);
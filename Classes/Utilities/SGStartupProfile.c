@@ -0,0 +1,103 @@
+//
+//  SGStartupProfile.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGStartupProfile.h"
+
+#import <stdio.h>
+#import <string.h>
+
+void SGStartupProfileReset(SGStartupProfile* profile, double now) {
+    memset(profile, 0, sizeof(SGStartupProfile));
+    profile->origin = now;
+}
+
+void SGStartupProfileBegin(SGStartupProfile* profile, SGStartupPhase phase, double now) {
+    if(!profile || phase < 0 || phase >= kSGStartupPhase_Count || SGStartupProfileIsRunning(profile, phase))
+        return;
+    
+    profile->begins[phase] = now;
+    profile->running |= 1u << phase;
+}
+
+void SGStartupProfileEnd(SGStartupProfile* profile, SGStartupPhase phase, double now) {
+    if(!profile || phase < 0 || phase >= kSGStartupPhase_Count || !SGStartupProfileIsRunning(profile, phase))
+        return;
+    
+    profile->durations[phase] += now - profile->begins[phase];
+    profile->ends[phase] = now - profile->origin;
+    profile->counts[phase]++;
+    profile->running &= ~(1u << phase);
+}
+
+const char* SGStartupPhaseName(SGStartupPhase phase) {
+    switch(phase) {
+        case kSGStartupPhase_EnvironmentSettings:   return "environment settings";
+        case kSGStartupPhase_Environment:           return "environment";
+        case kSGStartupPhase_Context:               return "GL context";
+        case kSGStartupPhase_Framebuffer:           return "framebuffer";
+        case kSGStartupPhase_GridLines:             return "grid lines";
+        case kSGStartupPhase_Radar:                 return "radar";
+        case kSGStartupPhase_MovableStack:          return "movable stack";
+        case kSGStartupPhase_Capture:               return "capture session";
+        case kSGStartupPhase_FirstFrame:            return "first frame";
+        default:                                    return "unknown";
+    }
+}
+
+int SGStartupProfileReport(const SGStartupProfile* profile, char* buffer, size_t size) {
+    int length = 0;
+    int written;
+    char* line;
+    size_t left;
+    for(int phase = 0; phase < kSGStartupPhase_Count; phase++) {
+        // Once the buffer is full the rest of the report is only measured
+        line = (size_t)length < size ? buffer + length : NULL;
+        left = line ? size - length : 0;
+        
+        if(profile->counts[phase])
+            written = snprintf(line, left,
+                               "%-22s %8.2f ms  x%-3d ended at %8.2f ms\n", SGStartupPhaseName(phase),
+                               profile->durations[phase] * 1000.0, profile->counts[phase], profile->ends[phase] * 1000.0);
+        else
+            written = snprintf(line, left, "%-22s %s\n", SGStartupPhaseName(phase),
+                               SGStartupProfileIsRunning(profile, phase) ? "running" : "deferred");
+        
+        if(written < 0)
+            return written;
+        
+        length += written;
+    }
+    
+    return length;
+}
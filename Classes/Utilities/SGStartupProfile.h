@@ -0,0 +1,89 @@
+//
+//  SGStartupProfile.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import <stdlib.h>
+
+/*
+* Times the phases that an AR view goes through before its first frame. Every
+* subsystem of the view is created the first time it is needed, so a phase may
+* run long after the view was made, more than once, or never. The profile keeps
+* the total time spent in each phase, how often it ran and when it last ended
+* relative to the moment the profile was reset, which tells the phases that
+* delayed the first frame apart from the ones that were deferred past it.
+*
+* Times are passed in by the caller, in seconds, so that the profile does not
+* depend on a particular clock. Phases can be begun and ended on a NULL profile,
+* which does nothing, so code that is not being profiled does not have to check.
+*/
+
+typedef enum {
+    kSGStartupPhase_EnvironmentSettings = 0,
+    kSGStartupPhase_Environment,
+    kSGStartupPhase_Context,
+    kSGStartupPhase_Framebuffer,
+    kSGStartupPhase_GridLines,
+    kSGStartupPhase_Radar,
+    kSGStartupPhase_MovableStack,
+    kSGStartupPhase_Capture,
+    kSGStartupPhase_FirstFrame,                 /* from the start of the animation to the first frame of billboards */
+    kSGStartupPhase_Count
+} SGStartupPhase;
+
+typedef struct SGStartupProfileStruct {
+    double origin;                              /* when the profile was reset */
+    double begins[kSGStartupPhase_Count];       /* when each running phase began */
+    double durations[kSGStartupPhase_Count];    /* total of every run */
+    double ends[kSGStartupPhase_Count];         /* when each phase last ended, from the origin */
+    int counts[kSGStartupPhase_Count];
+    unsigned int running;                       /* a bit for every phase that has begun and not ended */
+} SGStartupProfile;
+
+#define SGStartupProfileIsRunning(__PROFILE__, __PHASE__)   (((__PROFILE__)->running >> (__PHASE__)) & 1)
+
+extern void SGStartupProfileReset(SGStartupProfile* profile, double now);
+
+/* a phase that is already running keeps its beginning */
+extern void SGStartupProfileBegin(SGStartupProfile* profile, SGStartupPhase phase, double now);
+
+/* ignored unless the phase is running */
+extern void SGStartupProfileEnd(SGStartupProfile* profile, SGStartupPhase phase, double now);
+
+/* the name of a phase in the report */
+extern const char* SGStartupPhaseName(SGStartupPhase phase);
+
+/*
+* writes a line for every phase into the buffer, like snprintf, and returns the
+* length of the whole report. Phases that never ran are reported as deferred.
+*/
+extern int SGStartupProfileReport(const SGStartupProfile* profile, char* buffer, size_t size);
@@ -0,0 +1,236 @@
+//
+//  SGTaskPool.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGTaskPool.h"
+
+#import <stdlib.h>
+#import <string.h>
+#import <sched.h>
+#import <unistd.h>
+
+#define kSGTaskPool_DequeMask           (kSGTaskPool_DequeCapacity - 1)
+
+/* ranges are only held for a few instructions, so waiting spins */
+static void lockDeque(SGTaskDeque* deque) {
+    while(__sync_lock_test_and_set(&deque->lock, 1))
+        sched_yield();
+}
+
+static void unlockDeque(SGTaskDeque* deque) {
+    __sync_lock_release(&deque->lock);
+}
+
+static int pushBack(SGTaskDeque* deque, SGTaskRange range) {
+    lockDeque(deque);
+    int pushed = deque->count < kSGTaskPool_DequeCapacity;
+    if(pushed)
+        deque->ranges[(deque->head + deque->count++) & kSGTaskPool_DequeMask] = range;
+    unlockDeque(deque);
+    
+    return pushed;
+}
+
+static int popBack(SGTaskDeque* deque, SGTaskRange* range) {
+    lockDeque(deque);
+    int popped = deque->count > 0;
+    if(popped)
+        *range = deque->ranges[(deque->head + --deque->count) & kSGTaskPool_DequeMask];
+    unlockDeque(deque);
+    
+    return popped;
+}
+
+static int popFront(SGTaskDeque* deque, SGTaskRange* range) {
+    lockDeque(deque);
+    int popped = deque->count > 0;
+    if(popped) {
+        *range = deque->ranges[deque->head];
+        deque->head = (deque->head + 1) & kSGTaskPool_DequeMask;
+        deque->count--;
+    }
+    unlockDeque(deque);
+    
+    return popped;
+}
+
+static void runRange(SGTaskPool* pool, SGTaskDeque* deque, SGTaskRange range) {
+    // The upper halves are left for others to steal
+    SGTaskRange upper;
+    while(range.end - range.begin > pool->grain) {
+        upper.begin = range.begin + (range.end - range.begin) / 2;
+        upper.end = range.end;
+        if(!pushBack(deque, upper))
+            break;
+        
+        range.end = upper.begin;
+    }
+    
+    pool->function(pool->context, range.begin, range.end);
+    
+    __sync_fetch_and_add(&pool->chunks, 1);
+    __sync_fetch_and_sub(&pool->remaining, range.end - range.begin);
+}
+
+/* run and steal ranges until every element of the loop has been run */
+static void work(SGTaskPool* pool, SGTaskDeque* deque) {
+    SGTaskRange range;
+    int victim, attempt;
+    while(__sync_fetch_and_add(&pool->remaining, 0) > 0) {
+        if(popBack(deque, &range)) {
+            runRange(pool, deque, range);
+            continue;
+        }
+        
+        victim = rand_r(&deque->seed) % pool->threadCount;
+        for(attempt = 0; attempt < pool->threadCount; attempt++, victim = (victim + 1) % pool->threadCount)
+            if(&pool->deques[victim] != deque && popFront(&pool->deques[victim], &range))
+                break;
+        
+        if(attempt < pool->threadCount) {
+            __sync_fetch_and_add(&pool->steals, 1);
+            runRange(pool, deque, range);
+        } else
+            sched_yield();
+    }
+}
+
+static void* runThread(void* argument) {
+    SGTaskDeque* deque = (SGTaskDeque*)argument;
+    SGTaskPool* pool = deque->pool;
+    unsigned int generation = 0;
+    
+    pthread_mutex_lock(&pool->lock);
+    while(1) {
+        while(pool->running && pool->generation == generation)
+            pthread_cond_wait(&pool->condition, &pool->lock);
+        
+        if(!pool->running)
+            break;
+        
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        
+        work(pool, deque);
+        
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    
+    return NULL;
+}
+
+int SGTaskPoolCoreCount(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+SGTaskPool* SGTaskPoolNew(int threadCount) {
+    if(threadCount <= 0)
+        threadCount = SGTaskPoolCoreCount();
+    if(threadCount > kSGTaskPool_MaximumThreads)
+        threadCount = kSGTaskPool_MaximumThreads;
+    
+    SGTaskPool* pool = (SGTaskPool*)calloc(1, sizeof(SGTaskPool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->condition, NULL);
+    pool->running = 1;
+    
+    for(int i = 0; i < kSGTaskPool_MaximumThreads; i++) {
+        pool->deques[i].pool = pool;
+        pool->deques[i].seed = 2654435761u * (i + 1);
+    }
+    
+    // The pool makes do with the threads that could be started
+    pool->threadCount = 1;
+    for(int i = 1; i < threadCount; i++) {
+        if(pthread_create(&pool->threads[i], NULL, runThread, &pool->deques[i]))
+            break;
+        
+        pool->threadCount++;
+    }
+    
+    return pool;
+}
+
+void SGTaskPoolFree(SGTaskPool* pool) {
+    if(!pool)
+        return;
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->running = 0;
+    pthread_cond_broadcast(&pool->condition);
+    pthread_mutex_unlock(&pool->lock);
+    
+    for(int i = 1; i < pool->threadCount; i++)
+        pthread_join(pool->threads[i], NULL);
+    
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->condition);
+    free(pool);
+}
+
+void SGTaskPoolParallelFor(SGTaskPool* pool, int count, int grain, SGTaskFunction function, void* context) {
+    if(count <= 0)
+        return;
+    if(grain < 1)
+        grain = 1;
+    
+    // Small loops, pools of one thread and loops that start while
+    // another one is running are not worth waking anybody for.
+    if(!pool || pool->threadCount < 2 || count <= grain || !__sync_bool_compare_and_swap(&pool->busy, 0, 1)) {
+        for(int begin = 0; begin < count; begin += grain)
+            function(context, begin, begin + grain < count ? begin + grain : count);
+        
+        if(pool)
+            __sync_fetch_and_add(&pool->serialLoops, 1);
+        return;
+    }
+    
+    pool->function = function;
+    pool->context = context;
+    pool->grain = grain;
+    __sync_fetch_and_add(&pool->remaining, count);
+    __sync_fetch_and_add(&pool->loops, 1);
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->generation++;
+    pthread_cond_broadcast(&pool->condition);
+    pthread_mutex_unlock(&pool->lock);
+    
+    SGTaskRange range = { 0, count };
+    runRange(pool, &pool->deques[0], range);
+    work(pool, &pool->deques[0]);
+    
+    __sync_lock_release(&pool->busy);
+}
@@ -0,0 +1,107 @@
+//
+//  SGTaskPool.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import <pthread.h>
+
+/*
+* A small pool of threads that split loops over large arrays between the
+* cores. A parallel for hands the whole range to the calling thread, which
+* keeps halving it and pushing the upper halves onto its own deque until a
+* half is no larger than the grain. Idle threads steal from the front of the
+* other deques, which holds the largest ranges, and split them in turn. Every
+* thread works from the back of its own deque, so a loop that is not stolen
+* from runs in order on the calling thread.
+*
+* One loop runs at a time. A loop that is started while another one is
+* running, from a task or from another thread, runs on the calling thread
+* alone. A pool of one thread never starts a thread of its own.
+*/
+
+#define kSGTaskPool_MaximumThreads      16
+#define kSGTaskPool_DequeCapacity       64      /* ranges; halving never leaves more than 32 */
+
+typedef void (*SGTaskFunction)(void* context, int begin, int end);
+
+typedef struct SGTaskRangeStruct {
+    int begin;
+    int end;
+} SGTaskRange;
+
+typedef struct SGTaskDequeStruct {
+    SGTaskRange ranges[kSGTaskPool_DequeCapacity];
+    int head;
+    int count;
+    volatile int lock;
+    unsigned int seed;          /* picks the deques that this thread steals from */
+    struct SGTaskPoolStruct* pool;
+} SGTaskDeque;
+
+typedef struct SGTaskPoolStruct {
+    int threadCount;            /* including the thread that starts a loop */
+    SGTaskDeque deques[kSGTaskPool_MaximumThreads];
+    pthread_t threads[kSGTaskPool_MaximumThreads];
+    
+    /* the running loop */
+    SGTaskFunction function;
+    void* context;
+    int grain;
+    volatile int remaining;     /* elements that have not been run yet */
+    volatile int busy;
+    
+    pthread_mutex_t lock;
+    pthread_cond_t condition;
+    unsigned int generation;    /* counts the loops so sleeping threads know when to wake */
+    int running;
+    
+    /* statistics */
+    volatile unsigned int loops;
+    volatile unsigned int serialLoops;      /* that ran on the calling thread alone */
+    volatile unsigned int chunks;
+    volatile unsigned int steals;
+} SGTaskPool;
+
+/* the amount of cores that are online */
+extern int SGTaskPoolCoreCount(void);
+
+/* create a pool of threadCount threads including the caller; 0 uses every core */
+extern SGTaskPool* SGTaskPoolNew(int threadCount);
+
+/* stop the threads and release the pool */
+extern void SGTaskPoolFree(SGTaskPool* pool);
+
+/*
+* call function for consecutive ranges that cover [0, count) and return once all of them
+* have finished. Ranges hold at most grain elements. A NULL pool runs the loop on the caller.
+*/
+extern void SGTaskPoolParallelFor(SGTaskPool* pool, int count, int grain, SGTaskFunction function, void* context);
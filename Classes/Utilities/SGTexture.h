@@ -70,6 +70,8 @@ typedef enum {
     GLenum format;
     GLenum type;
     GLint internalFormat;
+    BOOL ownsData;
+    unsigned int generation;
 }
 
 /*!
@@ -102,6 +104,18 @@ typedef enum {
 */
 @property(readonly, nonatomic) CGSize size;
 
+/*!
+* @property
+* @abstract The pixels that are uploaded to OpenGL, laid out in the @link pixelFormat pixelFormat @/link.
+*/
+@property(readonly) const void* pixels;
+
+/*!
+* @property
+* @abstract The amount of bytes held by @link pixels pixels @/link.
+*/
+@property(readonly) NSUInteger lengthOfPixels;
+
 /*!
 * @method initWithImage:
 * @abstract Initializes a new SGTexture with a UIImage.
@@ -110,6 +124,20 @@ typedef enum {
 */
 - (id) initWithImage:(UIImage*)image;
 
+/*!
+* @method initWithPixels:pixelFormat:width:height:size:
+* @abstract Initializes a new SGTexture with pixels that are ready to be uploaded.
+* @discussion The pixels are not copied and must stay valid for as long as the texture is alive.
+* @param pixels The pixels of a texture that was made with @link initWithImage: initWithImage: @/link.
+* @param pixelFormat The format of the pixels.
+* @param width The width of the texture, a power of two.
+* @param height The height of the texture, a power of two.
+* @param size The size of the image within the texture.
+* @result A new SGTexture.
+*/
+- (id) initWithPixels:(const void*)pixels pixelFormat:(SGTexturePixelFormat)pixelFormat
+                width:(NSUInteger)width height:(NSUInteger)height size:(CGSize)size;
+
 /*!
 * @method drawAtPoint:
 * @abstract Renders the texture at the given point, assuming z is 0.
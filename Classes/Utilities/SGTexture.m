@@ -33,16 +33,20 @@
 //
 
 #import "SGTexture.h"
+#import "SGGLState.h"
+
 #define kMaxTextureSize	 1024 
 
 @interface SGTexture (Private)
 - (void) rebind;
 - (NSUInteger) getProperLength:(double)length;
+- (void) configureFormat;
 - (void) configurePixelFormat:(CGImageRef)image withTransform:(CGAffineTransform)transform;
 @end
 
 @implementation SGTexture
 @synthesize size, width, height, name, pixelFormat;
+@dynamic pixels, lengthOfPixels;
 
 - (id) initWithImage:(UIImage*)uImage
 {
@@ -84,13 +88,54 @@
         maxS = size.width / (float)width;
         maxT = size.height / (float)height;
         
+        [self configureFormat];
         [self configurePixelFormat:image withTransform:transform];
+        ownsData = YES;
         [self rebind];
     }
 	
 	return self;
 }
 
+- (id) initWithPixels:(const void*)newPixels pixelFormat:(SGTexturePixelFormat)newPixelFormat
+                width:(NSUInteger)newWidth height:(NSUInteger)newHeight size:(CGSize)newSize
+{
+    if(self = [super init]) {
+        name = 0;
+        pixelFormat = newPixelFormat;
+        width = newWidth;
+        height = newHeight;
+        size = newSize;
+        
+        maxS = size.width / (float)width;
+        maxT = size.height / (float)height;
+        
+        [self configureFormat];
+        data = (void*)newPixels;
+        ownsData = NO;
+        [self rebind];
+    }
+    
+    return self;
+}
+
+- (const void*) pixels
+{
+    return data;
+}
+
+- (NSUInteger) lengthOfPixels
+{
+    switch(pixelFormat) {
+        case kSGTexturePixelFormat_RGBA8888:
+            return width * height * 4;
+        case kSGTexturePixelFormat_RGB565:
+            return width * height * 2;
+        default:
+            return width * height;
+    }
+}
+
 - (void) drawAtPoint:(CGPoint)point
 {
     [self drawAtPoint:point withZ:0.0];
@@ -115,23 +160,49 @@
         w / 2 + point.x, h / 2 + point.y, z 
     };
     
-    if(!glIsTexture(name))
+    // The name belongs to the context that the texture was uploaded in
+    if(generation != SGGLStateGeneration())
         [self rebind];
 	
-	glBindTexture(GL_TEXTURE_2D, name);
+	SGGLStateBindTexture(GL_TEXTURE_2D, name);
 	glVertexPointer(3, GL_FLOAT, 0, vertices);
 	glTexCoordPointer(2, GL_FLOAT, 0, coordinates);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	SGGLStateDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 }
 
 - (void) rebind
 {
+    generation = SGGLStateGeneration();
     glGenTextures(1, &name);
-    glBindTexture(GL_TEXTURE_2D, name);
+    SGGLStateBindTexture(GL_TEXTURE_2D, name);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, type, format, data);
 }
 
+- (void) configureFormat
+{
+    switch(pixelFormat) {
+        case kSGTexturePixelFormat_RGBA8888:
+            internalFormat = GL_RGBA;
+            format = GL_UNSIGNED_BYTE;
+            type = GL_RGBA;
+            break;
+        case kSGTexturePixelFormat_RGB565:
+            // OpenGL ES requires the format to match the internal format
+            internalFormat = GL_RGB;
+            format = GL_UNSIGNED_SHORT_5_6_5;
+            type = GL_RGB;
+            break;
+        case kSGTexturePixelFormat_A8:
+            internalFormat = GL_ALPHA;
+            format = GL_UNSIGNED_BYTE;
+            type = GL_ALPHA;
+            break;
+        default:
+            [NSException raise:NSInternalInconsistencyException format:@"Invalid pixel format"];
+    }
+}
+
 - (void) configurePixelFormat:(CGImageRef)image withTransform:(CGAffineTransform)transform
 {   
     CGContextRef context = nil;
@@ -146,25 +217,16 @@
             imageData = malloc(height * width * 4);
             context = CGBitmapContextCreate(imageData, width, height, 8, 4 * width, colorSpace, kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
             CGColorSpaceRelease(colorSpace);
-            internalFormat = GL_RGBA;
-            format = GL_UNSIGNED_BYTE;
-            type = GL_RGBA;
             break;
         case kSGTexturePixelFormat_RGB565:
             colorSpace = CGColorSpaceCreateDeviceRGB();
             imageData = malloc(height * width * 4);
             context = CGBitmapContextCreate(imageData, width, height, 8, 4 * width, colorSpace, kCGImageAlphaNoneSkipLast | kCGBitmapByteOrder32Big);
             CGColorSpaceRelease(colorSpace);
-            internalFormat = GL_RGB;
-            format = GL_UNSIGNED_SHORT_5_6_5;
-            type = GL_RGBA;
             break;
         case kSGTexturePixelFormat_A8:
             imageData = malloc(height * width);
             context = CGBitmapContextCreate(imageData, width, height, 8, width, NULL, kCGImageAlphaOnly);
-            internalFormat = GL_ALPHA;
-            format = GL_UNSIGNED_BYTE;
-            type = GL_ALPHA;
             break;				
         default:
             [NSException raise:NSInternalInconsistencyException format:@"Invalid pixel format"];
@@ -212,10 +274,13 @@
 
 - (void) dealloc
 {
-	if(name)
+	if(name && generation == SGGLStateGeneration()) {
+        SGGLStateDeleteTexture(name);
 		glDeleteTextures(1, &name);
+    }
     
-    free(data);
+    if(ownsData)
+        free(data);
 	
 	[super dealloc];
 }
@@ -0,0 +1,91 @@
+//
+//  SGTripleBuffer.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGTripleBuffer.h"
+
+/* an atomic read of the shared index */
+#define SGTripleBufferShared(__BUFFER__)        __sync_fetch_and_add(&(__BUFFER__)->shared, 0)
+
+void SGTripleBufferInit(SGTripleBuffer* buffer, void* first, void* second, void* third) {
+    buffer->slots[0] = first;
+    buffer->slots[1] = second;
+    buffer->slots[2] = third;
+    
+    buffer->back = 0;
+    buffer->shared = 1;
+    buffer->front = 2;
+    buffer->hasFront = 0;
+    
+    buffer->published = 0;
+    buffer->dropped = 0;
+    __sync_synchronize();
+}
+
+void* SGTripleBufferBack(SGTripleBuffer* buffer) {
+    return buffer->slots[buffer->back];
+}
+
+void* SGTripleBufferPublish(SGTripleBuffer* buffer) {
+    // The compare and swap is a full barrier, so the contents of the
+    // slot are visible before the reader can see its index.
+    int desired = buffer->back | kSGTripleBuffer_Fresh;
+    int shared;
+    do {
+        shared = SGTripleBufferShared(buffer);
+    } while(!__sync_bool_compare_and_swap(&buffer->shared, shared, desired));
+    
+    buffer->back = shared & kSGTripleBuffer_IndexMask;
+    
+    __sync_fetch_and_add(&buffer->published, 1);
+    if(shared & kSGTripleBuffer_Fresh)
+        __sync_fetch_and_add(&buffer->dropped, 1);
+    
+    return buffer->slots[buffer->back];
+}
+
+void* SGTripleBufferAcquire(SGTripleBuffer* buffer) {
+    if(SGTripleBufferShared(buffer) & kSGTripleBuffer_Fresh) {
+        // Only the writer sets the fresh bit, so it is still set if the
+        // writer published again in the meantime.
+        int shared;
+        do {
+            shared = SGTripleBufferShared(buffer);
+        } while(!__sync_bool_compare_and_swap(&buffer->shared, shared, buffer->front));
+        
+        buffer->front = shared & kSGTripleBuffer_IndexMask;
+        buffer->hasFront = 1;
+    }
+    
+    return buffer->hasFront ? buffer->slots[buffer->front] : NULL;
+}
@@ -0,0 +1,71 @@
+//
+//  SGTripleBuffer.h
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import <stdlib.h>
+
+/*
+* A lock-free triple buffer that hands frames from one thread that writes
+* them to one thread that reads them. The writer always has a slot of its own
+* to fill and the reader always has a slot of its own to read; the third slot
+* is exchanged between them with a single atomic operation. Publishing never
+* waits for the reader and acquiring never waits for the writer. A frame that
+* is published before the reader got to the previous one replaces it, so the
+* reader always sees the latest complete frame and never a partial one.
+*/
+
+#define kSGTripleBuffer_Fresh       4       /* set on the shared index while it holds an unread frame */
+#define kSGTripleBuffer_IndexMask   3
+
+typedef struct SGTripleBufferStruct {
+    void* slots[3];
+    volatile int shared;        /* index of the exchanged slot and kSGTripleBuffer_Fresh */
+    int back;                   /* owned by the writer */
+    int front;                  /* owned by the reader */
+    int hasFront;               /* whether the reader acquired a frame yet */
+    
+    /* statistics */
+    volatile unsigned int published;
+    volatile unsigned int dropped;  /* frames that were replaced before they were acquired */
+} SGTripleBuffer;
+
+extern void SGTripleBufferInit(SGTripleBuffer* buffer, void* first, void* second, void* third);
+
+/* the slot that the writer fills next */
+extern void* SGTripleBufferBack(SGTripleBuffer* buffer);
+
+/* make the filled slot the latest frame and return the slot to fill next */
+extern void* SGTripleBufferPublish(SGTripleBuffer* buffer);
+
+/* the latest frame; it stays valid until the next call; NULL until a frame was published */
+extern void* SGTripleBufferAcquire(SGTripleBuffer* buffer);
@@ -37,6 +37,9 @@
 #import <OpenGLES/ES1/gl.h>
 #import <OpenGLES/ES1/glext.h>
 
+#import "SGGestureRecognizer.h"
+#import "SGStartupProfile.h"
+
 @protocol SG3DOverlayViewDelegate;
 
 /*!
@@ -44,7 +47,9 @@
 * @abstract This view is in charge of allocating and maintaining the CAEAGLLayer that 
 * is to draw the AR environment.
 * @discussion All touch events are sent through this view and they are handled by 
-* the @link SG3DOverlayViewDelegate SG3DOverlayViewDelegate @/link. Although this view
+* the @link SG3DOverlayViewDelegate SG3DOverlayViewDelegate @/link. While the view is
+* animating, gestures are held until the start of the next frame and a drag, pinch or
+* pull is only reported at its latest position. Although this view
 * maintains the OpenGL layer, it is not in charge of setting it up or manipulating
 * matrices. Once again, that job is delegated to @link SG3DOverlayViewDelegate SG3DOverlayViewDelegate @/link.
 */
@@ -68,16 +73,13 @@
     
     UIView* mainSubview;
 
-    CGFloat initialTouchDistance;
-    NSTimer* pinchTimer;
-    
-    CGPoint singleGestureStartPoint;
-    
-    BOOL swipeOccurred;
-    BOOL zoomOccurred;
-    BOOL dragging;
+    SGGestureRecognizer gestureRecognizer;
+    SGGestureQueue gestureQueue;
+    CFTimeInterval lastFrameTimestamp;
     
     double currentSphereRadius;
+    
+    SGStartupProfile* startupProfile;
 }
 
 /*!
@@ -87,6 +89,21 @@
 */
 @property(nonatomic, assign) id<SG3DOverlayViewDelegate> delegate;
 
+/*!
+* @property
+* @abstract The state machine that turns the touches in this view into gestures.
+* @discussion The thresholds that gestures are recognized with can be tuned through
+* this structure. See SGGestureRecognizer.h for the defaults.
+*/
+@property(nonatomic, readonly) SGGestureRecognizer* gestureRecognizer;
+
+/*!
+* @property
+* @abstract The profile that the creation of the OpenGL context and framebuffer is timed in.
+* @discussion The default is NULL. The context is created the first time the view is laid out or drawn.
+*/
+@property(nonatomic, assign) SGStartupProfile* startupProfile;
+
 /*!
 * @method startAnimation
 * @abstract Adds a CADisplayLink to the current run loop which will
@@ -153,11 +170,24 @@
 * @method view:ARSingleTap:
 * @abstract This method is called when a single touch event is generated
 * ￼in the view.
+* @discussion The tap is reported as soon as it is released. If it turns out to be
+* the first half of a double tap, @link view:ARSingleTapCancelled: view:ARSingleTapCancelled: @/link
+* is called before @link view:ARDoubleTap: view:ARDoubleTap: @/link.
 * @param view ￼The view that received the touch event.
 * @param point ￼The point in the view where the touch event occurred.
 */
 - (void) view:(SG3DOverlayView*)view ARSingleTap:(CGPoint)point;
 
+/*!
+* @method view:ARSingleTapCancelled:
+* @abstract This method is called when the last single tap turned out to be
+* the first half of a double tap.
+* @discussion Anything that the single tap started should be undone.
+* @param view ￼The view that received the touch event.
+* @param point ￼The point of the single tap.
+*/
+- (void) view:(SG3DOverlayView*)view ARSingleTapCancelled:(CGPoint)point;
+
 /*!
 * @method view:ARDoubleTap:
 * @abstract ￼This method is called when a double touch event is generated
@@ -204,6 +234,18 @@
 */
 - (void) view:(SG3DOverlayView*)view ARPullAtPoint:(CGPoint)pointOne andPoint:(CGPoint)pointTwo withDistance:(CGFloat)distance;
 
+/*!
+* @method view:ARZoomWithVelocity:duration:
+* @abstract This method is called once per frame while a pinch or pull is in progress.
+* @discussion Anything that moves with the pinch should move by velocity * duration
+* so that its speed does not depend on how often touches are delivered.
+* @param view ￼The view that received the touch event.
+* @param velocity ￼The rate at which the fingers spread in pixels per second. This is
+* negative while the fingers pinch together.
+* @param duration ￼The time since the last frame.
+*/
+- (void) view:(SG3DOverlayView*)view ARZoomWithVelocity:(CGFloat)velocity duration:(NSTimeInterval)duration;
+
 /*!
 * @method view:ARMoveFromPoint:toPoint:
 * @abstract ￼This method is called when a drag event is detected.
@@ -39,22 +39,28 @@
 
 #import "SGEnvironmentConstants.h"
 #import "SGMath.h"
+#import "SGGLState.h"
 
-#define kMinimumGestureLength               1000.0f
-#define kMaximumVariance                    20.0f
+static const SGGLFunctions glFunctions = {
+    glEnable, glDisable, glEnableClientState, glDisableClientState, glBindTexture, glDrawArrays
+};
 
 @interface SG3DOverlayView (Private)
 
 - (id) initGLES;
+- (BOOL) prepareContext;
 - (void) drawView;
 - (BOOL) createFramebuffer;
 - (void) destroyFramebuffer;
 
-- (void) clearTouches;
+- (void) addTouchesWithEvent:(UIEvent*)event phase:(SGTouchPhase)phase;
+- (void) sendGestureEvent:(const SGGestureEvent*)gestureEvent;
+- (void) sendQueuedGestureEvents;
 
 @end
 
 @implementation SG3DOverlayView
+@synthesize startupProfile;
 
 + (Class) layerClass
 {
@@ -83,11 +89,9 @@
                                     kEAGLColorFormatRGBA8, kEAGLDrawablePropertyColorFormat,
                                     nil];
 
-	context = [[EAGLContext alloc] initWithAPI:kEAGLRenderingAPIOpenGLES1];
-	if(!context || ![EAGLContext setCurrentContext:context] || ![self createFramebuffer]) {
-		[self release];
-		return nil;
-	}
+    // The context and framebuffer are made once the view is laid out
+    context = nil;
+    startupProfile = NULL;
 	
     self.backgroundColor = [UIColor clearColor];
     
@@ -95,11 +99,11 @@
     mainSubview.backgroundColor = [UIColor clearColor];
                    
 	animationInterval = 1.0;
-    pinchTimer = nil;
-    dragging = NO;
     currentSphereRadius = 0.0;
+    lastFrameTimestamp = 0.0;
     
-    [self clearTouches];
+    SGGestureRecognizerReset(&gestureRecognizer);
+    memset(&gestureQueue, 0, sizeof(SGGestureQueue));
     
 	return self;
 }
@@ -115,16 +119,48 @@
 	delegateSetup = ![delegate respondsToSelector:@selector(setupView:)];
 }
 
+- (SGGestureRecognizer*) gestureRecognizer
+{
+    return &gestureRecognizer;
+}
+
 - (void) layoutSubviews
 {    
-	[EAGLContext setCurrentContext:context];
+	if(![self prepareContext])
+        return;
+    
 	[self destroyFramebuffer];
 	[self createFramebuffer];
 	[self drawView];
 }
 
+- (BOOL) prepareContext
+{
+    if(!context) {
+        SGStartupProfileBegin(startupProfile, kSGStartupPhase_Context, CACurrentMediaTime());
+        context = [[EAGLContext alloc] initWithAPI:kEAGLRenderingAPIOpenGLES1];
+        SGStartupProfileEnd(startupProfile, kSGStartupPhase_Context, CACurrentMediaTime());
+        
+        if(!context) {
+            SGLog(@"SG3DOverlayView - failed to create an OpenGL ES 1 context");
+            return NO;
+        }
+        
+        if(![EAGLContext setCurrentContext:context])
+            return NO;
+        
+        // Textures of an earlier context are uploaded again
+        SGGLStateContextCreated(&glFunctions);
+        return YES;
+    }
+    
+    return [EAGLContext setCurrentContext:context];
+}
+
 - (BOOL) createFramebuffer
 {
+    SGStartupProfileBegin(startupProfile, kSGStartupPhase_Framebuffer, CACurrentMediaTime());
+    
 	glGenFramebuffersOES(1, &viewFramebuffer);
 	glGenRenderbuffersOES(1, &viewRenderbuffer);
 	
@@ -142,12 +178,12 @@
 	glRenderbufferStorageOES(GL_RENDERBUFFER_OES, GL_DEPTH_COMPONENT16_OES, backingWidth, backingHeight);
 	glFramebufferRenderbufferOES(GL_FRAMEBUFFER_OES, GL_DEPTH_ATTACHMENT_OES, GL_RENDERBUFFER_OES, depthRenderbuffer);
     
-	if(glCheckFramebufferStatusOES(GL_FRAMEBUFFER_OES) != GL_FRAMEBUFFER_COMPLETE_OES) {
-		SGLog(@"SG3DOverlayView - failed to make complete framebuffer object %x", glCheckFramebufferStatusOES(GL_FRAMEBUFFER_OES));
-		return NO;
-	}
+    GLenum status = glCheckFramebufferStatusOES(GL_FRAMEBUFFER_OES);
+	if(status != GL_FRAMEBUFFER_COMPLETE_OES)
+		SGLog(@"SG3DOverlayView - failed to make complete framebuffer object %x", status);
 	
-	return YES;
+    SGStartupProfileEnd(startupProfile, kSGStartupPhase_Framebuffer, CACurrentMediaTime());
+	return status == GL_FRAMEBUFFER_COMPLETE_OES;
 }
 
 // Clean up any buffers we have allocated.
@@ -181,6 +217,7 @@
         [displayLink invalidate];
         displayLink = nil;
         
+        SGGestureQueueClear(&gestureQueue);
         [delegate cleanUp];
     }
 }
@@ -198,7 +235,12 @@
 - (void) drawView
 {
 	// Make sure that you are drawing to the current context
-	[EAGLContext setCurrentContext:context];
+	if(![self prepareContext])
+        return;
+    
+    // The display link can fire before the view is first laid out
+    if(!viewFramebuffer)
+        [self createFramebuffer];
 	
 	// If our drawing delegate needs to have the view setup, then call -setupView: and flag that it won't need to be called again.
 	if(!delegateSetup || currentSphereRadius != kSGSphere_Radius) {
@@ -210,6 +252,17 @@
 	
 	glBindFramebufferOES(GL_FRAMEBUFFER_OES, viewFramebuffer);
     
+    [self sendQueuedGestureEvents];
+    
+    // Touch timestamps are measured from the same clock
+    CFTimeInterval timestamp = CACurrentMediaTime();
+    CGFloat velocity = SGGestureRecognizerPinchVelocity(&gestureRecognizer, timestamp);
+    if(velocity != 0.0f && lastFrameTimestamp > 0.0)
+        if(delegate && [delegate respondsToSelector:@selector(view:ARZoomWithVelocity:duration:)])
+            [delegate view:self ARZoomWithVelocity:velocity duration:timestamp - lastFrameTimestamp];
+    
+    lastFrameTimestamp = timestamp;
+    
 	[delegate drawView:self];
 	
 	glBindRenderbufferOES(GL_RENDERBUFFER_OES, viewRenderbuffer);
@@ -225,149 +278,22 @@
 
 - (void) touchesBegan:(NSSet*)touches withEvent:(UIEvent*)event
 {
-    NSSet* allTouches = [event allTouches];
-    NSInteger numberOfTouches = [allTouches count];
-    NSInteger tapCount = 0;
-    
-    if(numberOfTouches == 1) {     
-        UITouch* touchOne = [[allTouches allObjects] objectAtIndex:0];
-        tapCount = [touchOne tapCount];
-        
-        // Save the point for possible swipe
-        singleGestureStartPoint = [touchOne locationInView:self];
-        
-        if(tapCount == 1)
-            pinchTimer = [[NSTimer scheduledTimerWithTimeInterval:0.5
-                                                           target:self
-                                                         selector:@selector(ARSingleTapDetected:) 
-                                                         userInfo:touchOne
-                                                          repeats:NO] retain];
-        else {
-            if(pinchTimer) {
-                [pinchTimer invalidate];
-                [pinchTimer release];
-                pinchTimer = nil;
-                
-            }
-                
-            if(delegate && [delegate respondsToSelector:@selector(view:ARDoubleTap:)])
-                [delegate view:self ARDoubleTap:singleGestureStartPoint];
-        }
-    } else if(numberOfTouches == 2) {
-        if(pinchTimer) {
-            [pinchTimer invalidate];
-            [pinchTimer release];
-            pinchTimer = nil;
-        }        
-        
-        UITouch* touchOne = [[allTouches allObjects] objectAtIndex:0];
-        tapCount = [touchOne tapCount];
-        
-        if(tapCount == 1) {
-            UITouch* touchTwo = [[allTouches allObjects] objectAtIndex:1];
-            
-            CGPoint toPoint = [touchTwo locationInView:self];
-            CGPoint fromPoint = [touchOne locationInView:self];
-            initialTouchDistance = DistanceBetweenTwoPoints(fromPoint.x, fromPoint.y,
-                                                            toPoint.x, toPoint.y);
-        }
-    }
+    [self addTouchesWithEvent:event phase:kSGTouchPhase_Began];
 }
 
 - (void) touchesMoved:(NSSet*)touches withEvent:(UIEvent*)event
 {
-    if([pinchTimer isValid]) {
-        [pinchTimer invalidate];
-        pinchTimer = nil;
-    }
-    
-    NSSet* allTouches = [event allTouches];
-    
-    NSInteger touchCount = [allTouches count];
-    if(touchCount == 1) {
-        UITouch* touch = [touches anyObject];
-        CGPoint singleGestureCurrentPoint = [touch locationInView:self];
-        
-        CGFloat deltaX = fabsf(singleGestureStartPoint.x - singleGestureCurrentPoint.x);
-        CGFloat deltaY = fabsf(singleGestureStartPoint.y - singleGestureCurrentPoint.y);
-        
-        if(!swipeOccurred && deltaX >= kMinimumGestureLength && deltaY <= kMaximumVariance) {
-            // Horizontal swipe
-            if(delegate && [delegate respondsToSelector:@selector(view:ARHorizontalSwipeAtPoint:toPoint:)])
-                [delegate view:self ARHorizontalSwipeAtPoint:singleGestureStartPoint toPoint:singleGestureCurrentPoint];
-            
-            swipeOccurred = YES;
-        } else if(!swipeOccurred && deltaY >= kMinimumGestureLength && deltaX <= kMaximumVariance) {
-            // Vertical swipe
-            if(delegate && [delegate respondsToSelector:@selector(view:ARVerticalSwipeAtPoint:toPoint:)])
-                [delegate view:self ARVerticalSwipeAtPoint:singleGestureStartPoint toPoint:singleGestureCurrentPoint];
-
-            swipeOccurred = YES;
-        } else {            
-            dragging = YES;
-            
-            // Normal movement
-            if(delegate && [delegate respondsToSelector:@selector(view:ARMoveFromPoint:toPoint:)])
-                [delegate view:self ARMoveFromPoint:singleGestureStartPoint toPoint:singleGestureCurrentPoint];
-        }
-        
-    } else if(touchCount == 2) {
-        UITouch* touchOne = [[allTouches allObjects] objectAtIndex:0];
-        UITouch* touchTwo = [[allTouches allObjects] objectAtIndex:1];
-        
-        CGPoint pointOne = [touchOne locationInView:self];
-        CGPoint pointTwo = [touchTwo locationInView:self];
-        
-        //Calculate the distance between the two fingers
-        CGFloat finalDistance = DistanceBetweenTwoPoints(pointOne.x, pointOne.y, pointTwo.x, pointTwo.y);
-        
-        BOOL validDelta = abs(finalDistance - initialTouchDistance) > 5.0f;
-        
-        if(validDelta && initialTouchDistance > finalDistance) {
-            zoomOccurred = YES;
-            // Zoom out
-            if(delegate && [delegate respondsToSelector:@selector(view:ARPinchAtPoint:andPoint:withDistance:)])
-                [delegate view:self ARPinchAtPoint:pointOne andPoint:pointTwo withDistance:finalDistance];
-
-        } else if(validDelta && initialTouchDistance < finalDistance) {
-            zoomOccurred = YES;
-            // Zoom in
-            if(delegate && [delegate respondsToSelector:@selector(view:ARPullAtPoint:andPoint:withDistance:)])
-                [delegate view:self ARPullAtPoint:pointOne andPoint:pointTwo withDistance:finalDistance];
-            
-        }
-    }
+    [self addTouchesWithEvent:event phase:kSGTouchPhase_Moved];
 }
 
 - (void) touchesEnded:(NSSet*)touches withEvent:(UIEvent*)event
 {
-    NSSet* allTouches = [event allTouches];
-    
-    NSInteger touchCount = [allTouches count];
-    if(touchCount == 2) {
-        if(!zoomOccurred) {
-            if(delegate && [delegate respondsToSelector:@selector(view:ARSingleTapAtPoint:andPoint:)]) {
-                CGPoint pointOne = [[[allTouches allObjects] objectAtIndex:0] locationInView:self];
-                CGPoint pointTwo = [[[allTouches allObjects] objectAtIndex:1] locationInView:self];
-                
-                [delegate view:self ARSingleTapAtPoint:pointOne andPoint:pointTwo];
-            }
-        }
-    }
-    
-    if(dragging)
-        if(delegate && [delegate respondsToSelector:@selector(view:ARMoveEndedAtPoint:)])
-            [delegate view:self ARMoveEndedAtPoint:[[allTouches anyObject] locationInView:self]];
-    
-    if(delegate && [delegate respondsToSelector:@selector(view:tapReleased:)])
-        [delegate view:self tapReleased:[[[allTouches allObjects] objectAtIndex:0] locationInView:self]];
-    
-    [self clearTouches];
+    [self addTouchesWithEvent:event phase:kSGTouchPhase_Ended];
 }
 
 - (void) touchesCancelled:(NSSet*)touches withEvent:(UIEvent*)event
 {
-    [self clearTouches];
+    [self addTouchesWithEvent:event phase:kSGTouchPhase_Cancelled];
 }
 
 - (void) motionBegan:(UIEventSubtype)motion withEvent:(UIEvent*)event
@@ -377,12 +303,6 @@
             [delegate ARViewDidShake:self];
 }
 
-- (void) ARSingleTapDetected:(NSTimer*)timer
-{
-    if([delegate respondsToSelector:@selector(view:ARSingleTap:)])
-        [delegate view:self ARSingleTap:singleGestureStartPoint];
-}
-
 #pragma mark -
 #pragma mark UIView overrides 
 
@@ -394,13 +314,113 @@
 
 #pragma mark -
 #pragma mark Helper methods 
- 
-- (void) clearTouches
+
+- (void) addTouchesWithEvent:(UIEvent*)event phase:(SGTouchPhase)phase
 {
-    initialTouchDistance = -1.0f;
+    NSSet* allTouches = [event allTouches];
+    
+    SGTouchSample sample;
+    sample.timestamp = [event timestamp];
+    sample.phase = phase;
+    sample.count = [allTouches count];
+    sample.lifted = 0;
+    
+    // The touches that are lifted with this event go first
+    CGPoint point;
+    int amountOfPoints = 0;
+    for(int lifted = 1; lifted >= 0; lifted--)
+        for(UITouch* touch in allTouches) {
+            BOOL ended = touch.phase == UITouchPhaseEnded || touch.phase == UITouchPhaseCancelled;
+            if(ended != lifted)
+                continue;
+            
+            if(ended)
+                sample.lifted++;
+            
+            if(amountOfPoints < 2) {
+                point = [touch locationInView:self];
+                sample.points[amountOfPoints].x = point.x;
+                sample.points[amountOfPoints].y = point.y;
+                amountOfPoints++;
+            }
+        }
     
-    zoomOccurred = NO;
-    swipeOccurred = NO;
+    // Touches can arrive several times per frame. The gestures wait for the next frame
+    // so that picking and the responders only run once for each of them.
+    SGGestureEvent* gestureEvent;
+    int amountOfEvents = SGGestureRecognizerAddSample(&gestureRecognizer, &sample);
+    for(int i = 0; i < amountOfEvents; i++) {
+        gestureEvent = &gestureRecognizer.events[i];
+        if(!displayLink)
+            [self sendGestureEvent:gestureEvent];
+        else if(!SGGestureQueueAdd(&gestureQueue, gestureEvent)) {
+            [self sendQueuedGestureEvents];
+            SGGestureQueueAdd(&gestureQueue, gestureEvent);
+        }
+    }
+}
+
+- (void) sendQueuedGestureEvents
+{
+    for(int i = 0; i < gestureQueue.amountOfEvents; i++)
+        [self sendGestureEvent:&gestureQueue.events[i]];
+    
+    SGGestureQueueClear(&gestureQueue);
+}
+
+- (void) sendGestureEvent:(const SGGestureEvent*)gestureEvent
+{
+    if(!delegate)
+        return;
+    
+    CGPoint fromPoint = CGPointMake(gestureEvent->from.x, gestureEvent->from.y);
+    CGPoint toPoint = CGPointMake(gestureEvent->to.x, gestureEvent->to.y);
+    switch(gestureEvent->type) {
+        case kSGGestureEvent_SingleTap:
+            if([delegate respondsToSelector:@selector(view:ARSingleTap:)])
+                [delegate view:self ARSingleTap:fromPoint];
+            break;
+        case kSGGestureEvent_SingleTapCancelled:
+            if([delegate respondsToSelector:@selector(view:ARSingleTapCancelled:)])
+                [delegate view:self ARSingleTapCancelled:fromPoint];
+            break;
+        case kSGGestureEvent_DoubleTap:
+            if([delegate respondsToSelector:@selector(view:ARDoubleTap:)])
+                [delegate view:self ARDoubleTap:fromPoint];
+            break;
+        case kSGGestureEvent_TwoFingerTap:
+            if([delegate respondsToSelector:@selector(view:ARSingleTapAtPoint:andPoint:)])
+                [delegate view:self ARSingleTapAtPoint:fromPoint andPoint:toPoint];
+            break;
+        case kSGGestureEvent_Drag:
+            if([delegate respondsToSelector:@selector(view:ARMoveFromPoint:toPoint:)])
+                [delegate view:self ARMoveFromPoint:fromPoint toPoint:toPoint];
+            break;
+        case kSGGestureEvent_DragEnded:
+            if([delegate respondsToSelector:@selector(view:ARMoveEndedAtPoint:)])
+                [delegate view:self ARMoveEndedAtPoint:fromPoint];
+            break;
+        case kSGGestureEvent_HorizontalSwipe:
+            if([delegate respondsToSelector:@selector(view:ARHorizontalSwipeAtPoint:toPoint:)])
+                [delegate view:self ARHorizontalSwipeAtPoint:fromPoint toPoint:toPoint];
+            break;
+        case kSGGestureEvent_VerticalSwipe:
+            if([delegate respondsToSelector:@selector(view:ARVerticalSwipeAtPoint:toPoint:)])
+                [delegate view:self ARVerticalSwipeAtPoint:fromPoint toPoint:toPoint];
+            break;
+        case kSGGestureEvent_Pinch:
+            if([delegate respondsToSelector:@selector(view:ARPinchAtPoint:andPoint:withDistance:)])
+                [delegate view:self ARPinchAtPoint:fromPoint andPoint:toPoint withDistance:gestureEvent->distance];
+            break;
+        case kSGGestureEvent_Pull:
+            if([delegate respondsToSelector:@selector(view:ARPullAtPoint:andPoint:withDistance:)])
+                [delegate view:self ARPullAtPoint:fromPoint andPoint:toPoint withDistance:gestureEvent->distance];
+            break;
+        case kSGGestureEvent_Released:
+            if([delegate respondsToSelector:@selector(view:tapReleased:)])
+                [delegate view:self tapReleased:fromPoint];
+            break;
+    }
 }
 
 - (void) dealloc
@@ -415,9 +435,6 @@
     
     [mainSubview release];
     [displayLink release];
-    
-    if(pinchTimer)
-        [pinchTimer release];
 	
 	[super dealloc];
 }
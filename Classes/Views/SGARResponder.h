@@ -61,6 +61,15 @@
 */
 - (void) ARDoubleTap:(CGPoint)point;
 
+/*!
+* @method ARSingleTapCancelled:
+* @abstract Notifies the reciever that the last single tap was the first half of a double tap.
+* @discussion Single taps are sent as soon as they are released. Anything that the single tap
+* started should be undone; @link ARDoubleTap: ARDoubleTap: @/link follows.
+* @param point ￼The point of the single tap.
+*/
+- (void) ARSingleTapCancelled:(CGPoint)point;
+
 /*!
 * @method ARSingleTapAtPoint:andPoint:
 * @abstract Notifies the reciever when a single touch event occurs at two points.
@@ -56,11 +56,15 @@ enum SGChromeComponent {
 typedef NSUInteger SGChromeComponent;
 
 #import "SGControlEvents.h"
+#import "SGAllocationTracker.h"
+#import "SGStartupProfile.h"
 
 @class SGAnnotationView;
 @class SGRadar;
 @class SGMovableStack;
 @class SGAnnotationViewContainer;
+@class SGAnnotationFetchOperation;
+@class SGSensorManager;
 
 @protocol SGARViewDataSource;
 @protocol SGAnnotation;
@@ -87,6 +91,15 @@ typedef NSUInteger SGChromeComponent;
  
  	BOOL enableWalking;
  	BOOL enableGridLines;
+    BOOL enableClustering;
+    BOOL enableDecluttering;
+    BOOL enableConcurrentScenePreparation;
+    BOOL enableOrientationPrediction;
+    NSString* orientationTracePath;
+ 
+    CGFloat clusterTolerance;
+    
+    SGAllocationTracking allocationTracking;
  
     UIColor* gridLineColor;
 
@@ -94,13 +107,21 @@ typedef NSUInteger SGChromeComponent;
  
     @private
     NSMutableDictionary* annotationViews;
-    NSMutableArray* overlaySubviews;
+    NSMutableDictionary* overlaySubviews;
+ 
+    NSOperationQueue* fetchQueue;
+    SGAnnotationFetchOperation* fetchOperation;
+    NSMutableSet* fetchedAnnotations;
  
     SG3DOverlayView* openGLOverlayView;
     SG3DOverlayEnvironment* enviornmentDrawer;
  
     float* gridLines; 
+    double gridLinesRadius;
     CGFloat* gridLineColorComponents;
+    
+    BOOL createsMovableStack;
+    SGStartupProfile startupProfile;
  
     BOOL dragging;
     SGAnnotationViewContainer* previousContainer;
@@ -129,12 +150,30 @@ typedef NSUInteger SGChromeComponent;
 */
 @property (nonatomic, readonly) CLLocationManager* locationManager;
 
+/*!
+* @property
+* @abstract Starts and stops the accelerometer, location and heading updates.
+* @discussion The sensors run while the view is animating and on screen. See
+* @link //simplegeo/ooc/cl/SGSensorManager SGSensorManager @/link for the rates and the amount of callbacks per minute.
+*/
+@property (nonatomic, readonly) SGSensorManager* sensorManager;
+
 /*!
 * @property
 * @abstract The @link //simplegeo/ooc/cl/SGRadar radar @/link that is associated with the AR view.
+* @discussion A default radar is created the first time this property is read, which happens when the
+* OpenGL view is set up or annotation views are added.
 */
 @property (nonatomic, retain) SGRadar* radar;
 
+/*!
+* @property
+* @abstract The @link radar radar @/link if one has been created. Otherwise; nil.
+* @discussion Unlike @link radar radar @/link, reading this property never creates a radar. It is
+* read every frame by the enviornment.
+*/
+@property (nonatomic, readonly) SGRadar* existingRadar;
+
 /*!
 * @property
 * @abstract YES if gridlines should be drawn. Otherwize; NO. The default is NO.
@@ -154,6 +193,178 @@ typedef NSUInteger SGChromeComponent;
 */
 @property (nonatomic, assign) BOOL enableWalking;
 
+/*!
+* @property
+* @abstract Merges annotation views that are close to each other in the AR enviornment into
+* a single billboard that displays the amount of views it holds. The default is NO.
+* @discussion The clusters are rebuilt everytime the location of the device changes. As the user
+* walks closer to a cluster, it is split back into its members. See @link clusterTolerance clusterTolerance @/link.
+*/
+@property (nonatomic, assign) BOOL enableClustering;
+
+/*!
+* @property
+* @abstract The angle, in degrees, that a cluster is allowed to span before it is split
+* into its members. The default is 5 degrees.
+*/
+@property (nonatomic, assign) CGFloat clusterTolerance;
+
+/*!
+* @property
+* @abstract Moves overlapping annotation views out of each others way once they have
+* been projected onto the screen. The default is NO.
+* @discussion Closer annotation views are placed first. Any view that overlaps with a view
+* that has already been placed is lifted or offset; if there is no room left, the view is hidden until there is.
+* See @link amountOfMovedAnnotationViews amountOfMovedAnnotationViews @/link and
+* @link amountOfHiddenAnnotationViews amountOfHiddenAnnotationViews @/link.
+*/
+@property (nonatomic, assign) BOOL enableDecluttering;
+
+/*!
+* @property
+* @abstract The amount of annotation views that were moved during the last frame
+* in order to avoid overlapping with other views.
+*/
+@property (nonatomic, readonly) NSInteger amountOfMovedAnnotationViews;
+
+/*!
+* @property
+* @abstract The amount of annotation views that were hidden during the last frame
+* because there was no room to display them.
+*/
+@property (nonatomic, readonly) NSInteger amountOfHiddenAnnotationViews;
+
+/*!
+* @property
+* @abstract The amount of location updates that were absorbed by smoothing because the device
+* did not move far enough to re-project the annotation views.
+*/
+@property (nonatomic, readonly) NSInteger amountOfAvoidedLocationUpdates;
+
+/*!
+* @property
+* @abstract Counts the heap allocations, including Objective-C objects, that are made while a frame is drawn.
+* The default is kSGAllocationTracking_None.
+* @discussion With kSGAllocationTracking_Count the count of the last frame is available from
+* @link amountOfAllocationsPerFrame amountOfAllocationsPerFrame @/link. kSGAllocationTracking_Assert also
+* fails an assertion at the end of every frame that allocated and calls SGAllocationTrackerBreak for each allocation,
+* so a breakpoint on that function stops at the code that allocated. Allocations made by the render thread are counted, and
+* so are those that the scene worker made while preparing a snapshot, in the frame that draws it. A snapshot that the worker
+* replaced before it was drawn is not counted.
+* This is meant for debug builds; the allocator is hooked the first time tracking is turned on.
+*/
+@property (nonatomic, assign) SGAllocationTracking allocationTracking;
+
+/*!
+* @property
+* @abstract The amount of heap allocations that were made while the last frame was drawn.
+* @discussion This is 0 unless @link allocationTracking allocationTracking @/link is turned on.
+*/
+@property (nonatomic, readonly) NSInteger amountOfAllocationsPerFrame;
+
+/*!
+* @property
+* @abstract The amount of textures that were bound while the last frame was drawn.
+*/
+@property (nonatomic, readonly) NSInteger amountOfTextureBindsPerFrame;
+
+/*!
+* @property
+* @abstract The amount of OpenGL capabilities and client states that were turned on or off while the last frame was drawn.
+*/
+@property (nonatomic, readonly) NSInteger amountOfStateChangesPerFrame;
+
+/*!
+* @property
+* @abstract The amount of draw calls that were made while the last frame was drawn.
+*/
+@property (nonatomic, readonly) NSInteger amountOfDrawCallsPerFrame;
+
+/*!
+* @property
+* @abstract The amount of binds and state changes that were skipped while the last frame was drawn.
+* @discussion A call is skipped when the state it asks for is already set. Annotation views that
+* draw themselves with OpenGL make the environment forget the state, so the calls after them are not skipped.
+*/
+@property (nonatomic, readonly) NSInteger amountOfSkippedGLCallsPerFrame;
+
+/*!
+* @property
+* @abstract The amount of seconds between @link startAnimation startAnimation @/link and the end of the first
+* frame that drew the annotation views.
+* @discussion This is 0 until such a frame has been drawn. Annotation views that set a
+* @link //simplegeo/ooc/instp/SGAnnotationView/billboardIdentifier billboardIdentifier @/link have their textures
+* kept in a cache on disk, which spares later launches from rendering them again.
+*/
+@property (nonatomic, readonly) NSTimeInterval timeToFirstFrame;
+
+/*!
+* @property
+* @abstract Prepares the placement of the annotation views on a worker thread. The default is YES.
+* @discussion Sorting, clustering, decluttering, the touch areas and the radar blips of the next frame are
+* worked out while the current one is drawn, which leaves the main thread with drawing alone. The annotation
+* views are drawn one frame after the sensor values that placed them. See
+* @link mainThreadTimePerFrame mainThreadTimePerFrame @/link.
+*/
+@property (nonatomic, assign) BOOL enableConcurrentScenePreparation;
+
+/*!
+* @property
+* @abstract The amount of seconds that the main thread spends on a frame, averaged over the last frames.
+*/
+@property (nonatomic, readonly) NSTimeInterval mainThreadTimePerFrame;
+
+/*!
+* @property
+* @abstract Turns the camera to where the device is expected to point once a frame is on screen. The default is YES.
+* @discussion The heading, pitch and roll are extrapolated from their recent rate of change over the time between
+* the newest sensor values and the display of the frame, so the annotation views keep up with the camera feed
+* while the device turns. See @link orientationPredictionError orientationPredictionError @/link.
+*/
+@property (nonatomic, assign) BOOL enableOrientationPrediction;
+
+/*!
+* @property
+* @abstract The amount of seconds that the orientation is predicted ahead, averaged over the last frames.
+*/
+@property (nonatomic, readonly) NSTimeInterval orientationPredictionHorizon;
+
+/*!
+* @property
+* @abstract The root mean square error, in degrees, of the predicted orientations.
+* @discussion Each prediction is compared with the sensor values once they reach the time that it was made for.
+* Compare with @link orientationHoldError orientationHoldError @/link.
+*/
+@property (nonatomic, readonly) double orientationPredictionError;
+
+/*!
+* @property
+* @abstract The root mean square error, in degrees, that drawing the last sensor values would have had.
+*/
+@property (nonatomic, readonly) double orientationHoldError;
+
+/*!
+* @property
+* @abstract A file that the filtered sensor values and the frames are written to. The default is nil.
+* @discussion Recorded traces can be replayed with SGOrientationPredictorReplay to tune the predictor offline.
+*/
+@property (nonatomic, copy) NSString* orientationTracePath;
+
+/*!
+* @property
+* @abstract Times the phases that the view goes through before its first frame.
+* @discussion The radar, movable stack, grid lines, capture session and OpenGL view are only created once they are
+* first needed. The profile records how long each of them took and when, and is written to the log once the first
+* frame of annotation views has been drawn. See @link startupReport startupReport @/link.
+*/
+@property (nonatomic, readonly) SGStartupProfile* startupProfile;
+
+/*!
+* @property
+* @abstract A table of the phases in the @link startupProfile startup profile @/link.
+*/
+@property (nonatomic, readonly) NSString* startupReport;
+
 /*!
 * @property
 * @abstract The color of the grid lines.
@@ -165,7 +376,8 @@ typedef NSUInteger SGChromeComponent;
 * @abstract The @link //simplegeo/ooc/cl/SGMovableStack movable stack @/link that is present when a drag event
 * is produced over a @link //simplegeo/ooc/cl/SGAnnotationView annotation view @/link within the AR enviornment.
 * @discussion If a movable to stack is present, it will be added as a subview of @link //simplegeo/ooc/cl/SGARView SGARView @/link. Set
-* this property to nil in order to not allow views to be collected.
+* this property to nil in order to not allow views to be collected. Unless it is set, a default stack is created
+* the first time a view is dragged.
 */
 @property (nonatomic, retain) SGMovableStack* movableStack;
 
@@ -194,23 +406,74 @@ typedef NSUInteger SGChromeComponent;
 
 /*!
 * @method reloadData
-* @abstract ￼ Removes all annotation views from the envoirnment and loads in a new data set from @link dataSource dataSource @/link
-* using the devices current location.
-* @discussion Once reloadData is called, all annotaiton views are sent @link //simplegeo/ooc/instm/SGAnnotationView/prepareForReuse prepareForReuse @/link.
-* The views are then awaiting to be dequeue and resused.
+* @abstract ￼ Loads in a new data set from @link dataSource dataSource @/link using the devices current location.
+* @discussion Annotations are matched to the views that are currently displayed by their identity. If an annotation
+* is still part of the data set, its view is kept along with its texture and position and the data source is not
+* asked for a new view. The views of annotations that are no longer present are removed from the enviornment and
+* become available to @link dequeueReuseableAnnotationViewWithIdentifier: dequeueReuseableAnnotationViewWithIdentifier: @/link.
 */
 - (void) reloadData;
 
 /*!
 * @method reloadData
-* @abstract ￼ Removes all annotation views from the envoirnment and loads in a new data set from @link dataSource dataSource @/link
-* using the location passed in.
-* @discussion Once reloadData is called, all annotaiton views are sent @link //simplegeo/ooc/instm/SGAnnotationView/prepareForReuse prepareForReuse @/link.
-* The views are then awaiting to be dequeue and resused.
+* @abstract ￼ Loads in a new data set from @link dataSource dataSource @/link using the location passed in.
+* @discussion Only the annotations that were inserted or removed since the last reload are touched. See
+* @link reloadData reloadData @/link.
 * @param location The location to load data for.
 */
 - (void) reloadDataForLocation:(CLLocation*)location;
 
+/*!
+* @method reloadDataAsynchronously
+* @abstract Loads in a new data set from @link dataSource dataSource @/link on a background thread
+* using the devices current location.
+* @discussion See @link reloadDataAsynchronouslyForLocation: reloadDataAsynchronouslyForLocation: @/link.
+*/
+- (void) reloadDataAsynchronously;
+
+/*!
+* @method reloadDataAsynchronouslyForLocation:
+* @abstract Loads in a new data set from @link dataSource dataSource @/link on a background thread
+* using the location passed in.
+* @discussion The annotations are requested a page at a time with
+* @link //simplegeo/ooc/intfm/SGARViewDataSource/arView:annotationsAtLocation:page: arView:annotationsAtLocation:page: @/link
+* and each page is added to the enviornment as soon as it is returned. Views of annotations that are not part of
+* any page are removed once the last page has loaded. Starting a new reload, asynchronous or not, cancels the one
+* that is in progress. If the data source does not implement the paged method, this behaves like
+* @link reloadDataForLocation: reloadDataForLocation: @/link.
+* @param location The location to load data for.
+*/
+- (void) reloadDataAsynchronouslyForLocation:(CLLocation*)location;
+
+/*!
+* @method insertAnnotations:
+* @abstract Adds annotations to the data set without reloading it.
+* @discussion The @link dataSource dataSource @/link is asked for a view for each annotation that is not
+* already displayed. The views are placed in the enviornment and the radar at the start of the next frame.
+* The cost depends only on the amount of annotations passed in.
+* @param annotations The annotations to add.
+*/
+- (void) insertAnnotations:(NSArray*)annotations;
+
+/*!
+* @method removeAnnotations:
+* @abstract Removes annotations from the data set without reloading it.
+* @discussion The views of the annotations are taken out of the enviornment and the radar at the start
+* of the next frame and become available to
+* @link dequeueReuseableAnnotationViewWithIdentifier: dequeueReuseableAnnotationViewWithIdentifier: @/link.
+* @param annotations The annotations to remove.
+*/
+- (void) removeAnnotations:(NSArray*)annotations;
+
+/*!
+* @method updateAnnotations:
+* @abstract Notifies the view that the coordinate or content of annotations has changed.
+* @discussion The views of the annotations are redrawn and moved to their new position at the start of the
+* next frame. Annotations that are not displayed are ignored.
+* @param annotations The annotations that have changed.
+*/
+- (void) updateAnnotations:(NSArray*)annotations;
+
 /*!
 * @method startAnimation
 * @abstract ￼ Begins rendering the AR enviornment.
@@ -322,10 +585,24 @@ typedef NSUInteger SGChromeComponent;
 * @method arView:didAddAnnotationViews:
 * @abstract ￼Notifies the delegate when @link //simplegeo/ooc/cl/SGAnnotationView SGAnnotationViews @/link have
 * been added to the arView.
+* @discussion Views that were kept from a previous reload are not included.
 * @param arView ￼The @link SGARView SGARView @/link that added the annotation views.
 * @param views ￼The annotation views.
 */
 - (void) arView:(SGARView*)arView didAddAnnotationViews:(NSArray*)views;
 
+/*!
+* @method arView:annotationsAtLocation:page:
+* @abstract ￼Provides a page of the annotations that are at a location.
+* @discussion This method is called on a background thread by
+* @link //simplegeo/ooc/instm/SGARView/reloadDataAsynchronouslyForLocation: reloadDataAsynchronouslyForLocation: @/link,
+* starting with page 0. Pages are requested until nil is returned or a newer reload cancels the request.
+* @param arView ￼The @link SGARView AR view @/link that is loading the annotations.
+* @param location The location to load annotations for.
+* @param page The index of the page.
+* @result The annotations in the page or nil if there are no more pages.
+*/
+- (NSArray*) arView:(SGARView*)arView annotationsAtLocation:(CLLocation*)location page:(NSInteger)page;
+
 @end
 
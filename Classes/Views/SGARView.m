@@ -34,8 +34,11 @@
 
 #import "SGARView.h"
 
+#import <QuartzCore/QuartzCore.h>
+
 #import "SG3DOverlayEnvironment.h"
 #import "SGMetrics.h"
+#import "SGGLState.h"
 #import "SGEnvironmentConstants.h"
 
 #import "SGAnnotationView.h"
@@ -43,10 +46,12 @@
 #import "SGRadar.h"
 #import "SGMovableStack.h"
 #import "SGAnnotationViewContainer.h"
+#import "SGAnnotationFetchOperation.h"
 
 @interface SGARView (Private)
 
 - (void) setupViewableObjects;
+- (void) setUpEnvironment;
 - (void) setUpOverlayView;
 
 - (void) loadObjectIntoSortedBucket:(NSInteger)bucketIndex;
@@ -59,6 +64,13 @@
 
 - (void) dragStarted:(BOOL)started atPoint:(CGPoint)point;
 
+- (void) recycleAnnotationView:(SGAnnotationView*)view;
+- (void) removeAnnotationViewsForKeys:(NSArray*)keys;
+
+- (void) cancelAnnotationFetch;
+- (void) fetchOperation:(SGAnnotationFetchOperation*)operation didLoadAnnotations:(NSArray*)annotations;
+- (void) fetchOperationDidFinish:(SGAnnotationFetchOperation*)operation;
+
 #if __IPHONE_4_0 && __IPHONE_OS_VERSION_MIN_REQUIRED >= __IPHONE_4_0 && !TARGET_IPHONE_SIMULATOR
 
 - (AVCaptureSession*) defaultCaptureSession;
@@ -69,34 +81,58 @@
 
 @implementation SGARView
 @synthesize dataSource, locationManager, movableStack, enableWalking, enableGridLines, walkingOffset;
-@dynamic radar, gridLineColor;
+@dynamic sensorManager;
+@synthesize enableClustering, clusterTolerance, enableDecluttering, enableConcurrentScenePreparation, allocationTracking;
+@synthesize enableOrientationPrediction, orientationTracePath;
+@dynamic amountOfMovedAnnotationViews, amountOfHiddenAnnotationViews, amountOfAvoidedLocationUpdates, amountOfAllocationsPerFrame, timeToFirstFrame, mainThreadTimePerFrame;
+@dynamic amountOfTextureBindsPerFrame, amountOfStateChangesPerFrame, amountOfDrawCallsPerFrame, amountOfSkippedGLCallsPerFrame;
+@dynamic orientationPredictionHorizon, orientationPredictionError, orientationHoldError;
+@dynamic radar, existingRadar, gridLineColor, startupProfile, startupReport;
 
 - (id) initWithFrame:(CGRect)frame
 {
     if(self = [super initWithFrame:frame]) {
         
+        SGStartupProfileReset(&startupProfile, CACurrentMediaTime());
+        
+        SGStartupProfileBegin(&startupProfile, kSGStartupPhase_EnvironmentSettings, CACurrentMediaTime());
         SGInitializeEnvironmentSettings();
+        SGStartupProfileEnd(&startupProfile, kSGStartupPhase_EnvironmentSettings, CACurrentMediaTime());
         
-        overlaySubviews = [[NSMutableArray alloc] init];
+        overlaySubviews = [[NSMutableDictionary alloc] init];
+        
+        fetchQueue = [[NSOperationQueue alloc] init];
+        [fetchQueue setMaxConcurrentOperationCount:1];
+        fetchOperation = nil;
+        fetchedAnnotations = [[NSMutableSet alloc] init];
         annotationViews = [[NSMutableDictionary alloc] init];
         
         [self setGridLineColor:[UIColor whiteColor]];
         
         enableWalking = NO;
         enableGridLines = NO;
+        enableClustering = NO;
+        clusterTolerance = 5.0;
+        enableDecluttering = NO;
+        enableConcurrentScenePreparation = YES;
+        enableOrientationPrediction = YES;
+        orientationTracePath = nil;
+        allocationTracking = kSGAllocationTracking_None;
         dragging = NO;
         previousContainer = nil;
         
         touchPoint = CGPointZero;
         
-        [self setRadar:[[[SGRadar alloc] initWithFrame:CGRectMake(10.0, 10.0, 100.0, 100.0)] autorelease]];
+        // The chrome, the camera and the OpenGL view are made when they are first needed
+        radar = nil;
         
         containers = [[NSMutableArray alloc] init];
         
-        movableStack = [[SGMovableStack alloc] initWithFrame:CGRectZero];
-        movableStack.arView = self;
+        movableStack = nil;
+        createsMovableStack = YES;
         
-        [self createGraphLines];
+        gridLines = NULL;
+        gridLinesRadius = 0.0;
         
 #if __IPHONE_4_0 && __IPHONE_OS_VERSION_MIN_REQUIRED >= __IPHONE_4_0 && !TARGET_IPHONE_SIMULATOR
         
@@ -105,8 +141,10 @@
         
 #endif       
 
+        openGLOverlayView = nil;
+
         self.backgroundColor = [UIColor clearColor];
-        [self setUpOverlayView];
+        [self setUpEnvironment];
                 
     }
     
@@ -116,27 +154,42 @@
 #pragma mark -
 #pragma mark Setup methods 
  
-- (void) setUpOverlayView
-{   
-
-#if __IPHONE_4_0 && __IPHONE_OS_VERSION_MIN_REQUIRED >= __IPHONE_4_0 && !TARGET_IPHONE_SIMULATOR
-    
-    [self startCaptureSession];
-    
-#endif
-
+- (void) setUpEnvironment
+{
+    SGStartupProfileBegin(&startupProfile, kSGStartupPhase_Environment, CACurrentMediaTime());
     enviornmentDrawer = [[SG3DOverlayEnvironment alloc] init];
     enviornmentDrawer.arView = self;
-    
+    SGStartupProfileEnd(&startupProfile, kSGStartupPhase_Environment, CACurrentMediaTime());
+}
+ 
+- (void) setUpOverlayView
+{   
     openGLOverlayView = [[SG3DOverlayView alloc] initWithFrame:self.bounds];
+    openGLOverlayView.startupProfile = &startupProfile;
     openGLOverlayView.delegate = enviornmentDrawer;
     
-    [self addSubview:openGLOverlayView];
+    // The chrome that was made before the view stays on top of it
+    if([self.subviews count])
+        [self insertSubview:openGLOverlayView belowSubview:[self.subviews objectAtIndex:0]];
+    else
+        [self addSubview:openGLOverlayView];
 }
 
 #pragma mark -
 #pragma mark UIView overrides 
 
+- (void) didMoveToWindow
+{
+    [super didMoveToWindow];
+    enviornmentDrawer.sensorManager.visible = self.window && !self.hidden;
+}
+
+- (void) setHidden:(BOOL)hidden
+{
+    [super setHidden:hidden];
+    enviornmentDrawer.sensorManager.visible = self.window && !hidden;
+}
+
 #if __IPHONE_4_0 && __IPHONE_OS_VERSION_MIN_REQUIRED >= __IPHONE_4_0 && !TARGET_IPHONE_SIMULATOR
 
 - (AVCaptureSession*) defaultCaptureSession
@@ -169,6 +222,8 @@
 
 - (void) startCaptureSession
 {
+    SGStartupProfileBegin(&startupProfile, kSGStartupPhase_Capture, CACurrentMediaTime());
+    
     if(!captureSession)
         captureSession = [self defaultCaptureSession];
     
@@ -181,6 +236,8 @@
         [captureSession startRunning];
 
     [self setNeedsLayout];
+    
+    SGStartupProfileEnd(&startupProfile, kSGStartupPhase_Capture, CACurrentMediaTime());
 }
 
 - (void) stopCaptureSession
@@ -226,10 +283,110 @@
 }
 
 - (SGRadar*) radar
+{
+    if(!radar) {
+        SGStartupProfileBegin(&startupProfile, kSGStartupPhase_Radar, CACurrentMediaTime());
+        [self setRadar:[[[SGRadar alloc] initWithFrame:CGRectMake(10.0, 10.0, 100.0, 100.0)] autorelease]];
+        SGStartupProfileEnd(&startupProfile, kSGStartupPhase_Radar, CACurrentMediaTime());
+    }
+    
+    return radar;
+}
+
+- (SGRadar*) existingRadar
 {
     return radar;
 }
 
+- (SGSensorManager*) sensorManager
+{
+    return enviornmentDrawer.sensorManager;
+}
+
+- (void) setEnableWalking:(BOOL)walking
+{
+    enableWalking = walking;
+    enviornmentDrawer.sensorManager.walking = walking;
+}
+
+- (NSInteger) amountOfMovedAnnotationViews
+{
+    return enviornmentDrawer.amountOfMovedAnnotationViews;
+}
+
+- (NSInteger) amountOfHiddenAnnotationViews
+{
+    return enviornmentDrawer.amountOfHiddenAnnotationViews;
+}
+
+- (NSInteger) amountOfAvoidedLocationUpdates
+{
+    return enviornmentDrawer.amountOfAvoidedLocationUpdates;
+}
+
+- (NSInteger) amountOfAllocationsPerFrame
+{
+    return enviornmentDrawer.amountOfAllocationsPerFrame;
+}
+
+- (NSInteger) amountOfTextureBindsPerFrame
+{
+    return enviornmentDrawer.amountOfTextureBindsPerFrame;
+}
+
+- (NSInteger) amountOfStateChangesPerFrame
+{
+    return enviornmentDrawer.amountOfStateChangesPerFrame;
+}
+
+- (NSInteger) amountOfDrawCallsPerFrame
+{
+    return enviornmentDrawer.amountOfDrawCallsPerFrame;
+}
+
+- (NSInteger) amountOfSkippedGLCallsPerFrame
+{
+    return enviornmentDrawer.amountOfSkippedGLCallsPerFrame;
+}
+
+- (NSTimeInterval) timeToFirstFrame
+{
+    return enviornmentDrawer.timeToFirstFrame;
+}
+
+- (NSTimeInterval) mainThreadTimePerFrame
+{
+    return enviornmentDrawer.mainThreadTimePerFrame;
+}
+
+- (NSTimeInterval) orientationPredictionHorizon
+{
+    return enviornmentDrawer.orientationPredictionHorizon;
+}
+
+- (double) orientationPredictionError
+{
+    return enviornmentDrawer.orientationPredictionError;
+}
+
+- (double) orientationHoldError
+{
+    return enviornmentDrawer.orientationHoldError;
+}
+
+- (SGStartupProfile*) startupProfile
+{
+    return &startupProfile;
+}
+
+- (NSString*) startupReport
+{
+    char report[1024];
+    SGStartupProfileReport(&startupProfile, report, sizeof(report));
+    
+    return [NSString stringWithUTF8String:report];
+}
+
 - (void) dragStarted:(BOOL)started atPoint:(CGPoint)point
 {
     dragging = started;
@@ -264,6 +421,19 @@
     
     movableStack = [ms retain];
     movableStack.arView = self;
+    createsMovableStack = NO;
+}
+
+- (SGMovableStack*) movableStack
+{
+    if(!movableStack && createsMovableStack) {
+        SGStartupProfileBegin(&startupProfile, kSGStartupPhase_MovableStack, CACurrentMediaTime());
+        movableStack = [[SGMovableStack alloc] initWithFrame:CGRectZero];
+        movableStack.arView = self;
+        SGStartupProfileEnd(&startupProfile, kSGStartupPhase_MovableStack, CACurrentMediaTime());
+    }
+    
+    return movableStack;
 }
 
 - (NSArray*) getContainers
@@ -284,57 +454,81 @@
 
 - (void) reloadDataForLocation:(CLLocation*)location
 {
-    [self empty];
+    [self cancelAnnotationFetch];
     
-    // Make every view resuseable and place them in the proper bucket
-    NSMutableArray* viewBucket;
-    for(SGAnnotationView* view in overlaySubviews) {
-        
-        // Place each view in the proper bucket so a user
-        // might be able to access the view later
-        viewBucket = [annotationViews objectForKey:view.reuseIdentifier];
+    if(movableStack)
+        [movableStack emptyStack:NO];
+    
+    // Get the amount of annotations to display
+    NSArray* annotations = [dataSource arView:self annotationsAtLocation:location];
+    int amountOfAnnotations = [annotations count];
+    
+    // Annotations that are still present keep their view, texture and
+    // position. Only the new annotations will need a view.
+    NSMutableDictionary* previousViews = overlaySubviews;
+    overlaySubviews = [[NSMutableDictionary alloc] initWithCapacity:amountOfAnnotations];
+    
+    NSMutableIndexSet* insertedIndexes = [NSMutableIndexSet indexSet];
+    NSMutableArray* movedViews = [NSMutableArray array];
+    NSValue* key;
+    SGAnnotationView* overlaySubview;
+    id<MKAnnotation> annotation = nil;
+    for(int i = 0; i < amountOfAnnotations; i++) {
+        annotation = [annotations objectAtIndex:i];
+        key = [NSValue valueWithNonretainedObject:annotation];
+        overlaySubview = [previousViews objectForKey:key];
         
-        if(!viewBucket) {
-            
-            viewBucket = [[[NSMutableArray alloc] init] autorelease];
-            [annotationViews setObject:viewBucket forKey:view.reuseIdentifier];
+        if(overlaySubview) {
+            [overlaySubviews setObject:overlaySubview forKey:key];
+            [previousViews removeObjectForKey:key];
             
-        }
-        
-        [viewBucket addObject:view];
-    }        
+            // The store only reads the coordinate when a view is added or updated
+            if(overlaySubview.hasMoved)
+                [movedViews addObject:overlaySubview];
+        } else
+            [insertedIndexes addIndex:i];
+    }
     
-    // Empty out all of the subviews that were recycled
-    [overlaySubviews removeAllObjects];
+    // Whatever is left over has been removed. Make those views resuseable
+    // and place them in the proper bucket before new views are requested.
+    NSArray* removedViews = [previousViews allValues];
+    for(SGAnnotationView* view in removedViews)
+        [self recycleAnnotationView:view];
     
-    // Get the amount of annotations to display
-    NSArray* annotations = [dataSource arView:self annotationsAtLocation:location];
+    [previousViews release];
+    
+    // A recycled view that the data source hands out again is only moved
+    if([removedViews count])
+        [enviornmentDrawer removeAnnotationViews:removedViews];
     
-    if(annotations && [annotations count]) {
-        int amountOfAnnotations = [annotations count];
-        SGAnnotationView* overlaySubview;
-        id<MKAnnotation> annotation = nil;
-        for(int i = 0; i < amountOfAnnotations; i++) {
-            annotation = [annotations objectAtIndex:i];
-            overlaySubview = [dataSource arView:self viewForAnnotation:annotation];
+    if([movedViews count])
+        [enviornmentDrawer updateAnnotationViews:movedViews];
+    
+    NSMutableArray* insertedViews = [NSMutableArray arrayWithCapacity:[insertedIndexes count]];
+    NSUInteger index = [insertedIndexes firstIndex];
+    while(index != NSNotFound) {
+        annotation = [annotations objectAtIndex:index];
+        overlaySubview = [dataSource arView:self viewForAnnotation:annotation];
+        
+        if(overlaySubview) {
             
-            if(overlaySubview) {
-                
-                if(!overlaySubview.annotation)
-                    overlaySubview.annotation = annotation;
-                
-                [overlaySubviews addObject:overlaySubview];
-            }   
+            if(!overlaySubview.annotation)
+                overlaySubview.annotation = annotation;
+            
+            [overlaySubviews setObject:overlaySubview forKey:[NSValue valueWithNonretainedObject:annotation]];
+            [insertedViews addObject:overlaySubview];
         }
+        
+        index = [insertedIndexes indexGreaterThanIndex:index];
     }
     
-    if([overlaySubviews count]) {
-        
-        [enviornmentDrawer addAnnotationViews:overlaySubviews];
+    // Annotations that are still present are left alone
+    if([insertedViews count]) {
+        [enviornmentDrawer insertAnnotationViews:insertedViews];
         
         if([dataSource respondsToSelector:@selector(arView:didAddAnnotationViews:)])
-            [dataSource arView:self didAddAnnotationViews:overlaySubviews];
-    }    
+            [dataSource arView:self didAddAnnotationViews:insertedViews];
+    }
 }
 
 - (void) reloadData
@@ -342,16 +536,177 @@
     [self reloadDataForLocation:enviornmentDrawer.locationManager.location];
 }
 
+- (void) insertAnnotations:(NSArray*)annotations
+{
+    NSMutableArray* insertedViews = [NSMutableArray arrayWithCapacity:[annotations count]];
+    NSValue* key;
+    SGAnnotationView* overlaySubview;
+    for(id<MKAnnotation> annotation in annotations) {
+        key = [NSValue valueWithNonretainedObject:annotation];
+        if([overlaySubviews objectForKey:key])
+            continue;
+        
+        overlaySubview = [dataSource arView:self viewForAnnotation:annotation];
+        if(overlaySubview) {
+            
+            if(!overlaySubview.annotation)
+                overlaySubview.annotation = annotation;
+            
+            [overlaySubviews setObject:overlaySubview forKey:key];
+            [insertedViews addObject:overlaySubview];
+        }
+    }
+    
+    if([insertedViews count]) {
+        [enviornmentDrawer insertAnnotationViews:insertedViews];
+        
+        if([dataSource respondsToSelector:@selector(arView:didAddAnnotationViews:)])
+            [dataSource arView:self didAddAnnotationViews:insertedViews];
+    }
+}
+
+- (void) removeAnnotations:(NSArray*)annotations
+{
+    NSMutableArray* keys = [NSMutableArray arrayWithCapacity:[annotations count]];
+    for(id<MKAnnotation> annotation in annotations)
+        [keys addObject:[NSValue valueWithNonretainedObject:annotation]];
+    
+    [self removeAnnotationViewsForKeys:keys];
+}
+
+- (void) updateAnnotations:(NSArray*)annotations
+{
+    NSMutableArray* updatedViews = [NSMutableArray arrayWithCapacity:[annotations count]];
+    SGAnnotationView* overlaySubview;
+    for(id<MKAnnotation> annotation in annotations) {
+        overlaySubview = [overlaySubviews objectForKey:[NSValue valueWithNonretainedObject:annotation]];
+        if(overlaySubview) {
+            overlaySubview.needNewTexture = YES;
+            [updatedViews addObject:overlaySubview];
+        }
+    }
+    
+    if([updatedViews count])
+        [enviornmentDrawer updateAnnotationViews:updatedViews];
+}
+
+- (void) removeAnnotationViewsForKeys:(NSArray*)keys
+{
+    NSMutableArray* removedViews = [NSMutableArray arrayWithCapacity:[keys count]];
+    SGAnnotationView* overlaySubview;
+    for(NSValue* key in keys) {
+        overlaySubview = [overlaySubviews objectForKey:key];
+        if(overlaySubview) {
+            [removedViews addObject:overlaySubview];
+            [overlaySubviews removeObjectForKey:key];
+            [self recycleAnnotationView:overlaySubview];
+        }
+    }
+    
+    if([removedViews count])
+        [enviornmentDrawer removeAnnotationViews:removedViews];
+}
+
+- (void) recycleAnnotationView:(SGAnnotationView*)view
+{
+    for(SGAnnotationViewContainer* container in containers)
+        [container removeAnnotationView:view];
+    
+    // Place each view in the proper bucket so a user
+    // might be able to access the view later
+    NSMutableArray* viewBucket = [annotationViews objectForKey:view.reuseIdentifier];
+    
+    if(!viewBucket) {
+        
+        viewBucket = [[[NSMutableArray alloc] init] autorelease];
+        [annotationViews setObject:viewBucket forKey:view.reuseIdentifier];
+        
+    }
+    
+    [viewBucket addObject:view];
+}
+
 - (void) clear
 {
+    [self cancelAnnotationFetch];
+    
     [annotationViews removeAllObjects];
     [overlaySubviews removeAllObjects];
     
+    // The next reload starts from an empty environment
+    [enviornmentDrawer addAnnotationViews:[NSArray array]];
+    
     // Redraw the
     [openGLOverlayView startAnimation];
     [openGLOverlayView stopAnimation];
 }
 
+#pragma mark -
+#pragma mark Asynchronous loading methods 
+
+- (void) reloadDataAsynchronously
+{
+    [self reloadDataAsynchronouslyForLocation:enviornmentDrawer.locationManager.location];
+}
+
+- (void) reloadDataAsynchronouslyForLocation:(CLLocation*)location
+{
+    if(![dataSource respondsToSelector:@selector(arView:annotationsAtLocation:page:)]) {
+        [self reloadDataForLocation:location];
+        return;
+    }
+    
+    // Only the newest location is worth loading
+    [self cancelAnnotationFetch];
+    
+    if(movableStack)
+        [movableStack emptyStack:NO];
+    
+    fetchOperation = [[SGAnnotationFetchOperation alloc] initWithARView:self location:location];
+    [fetchQueue addOperation:fetchOperation];
+}
+
+- (void) cancelAnnotationFetch
+{
+    if(fetchOperation) {
+        [fetchOperation cancel];
+        [fetchOperation release];
+        fetchOperation = nil;
+    }
+    
+    [fetchedAnnotations removeAllObjects];
+}
+
+- (void) fetchOperation:(SGAnnotationFetchOperation*)operation didLoadAnnotations:(NSArray*)annotations
+{
+    if(operation != fetchOperation)
+        return;
+    
+    for(id<MKAnnotation> annotation in annotations)
+        [fetchedAnnotations addObject:[NSValue valueWithNonretainedObject:annotation]];
+    
+    // Annotations that are already displayed keep their views
+    [self insertAnnotations:annotations];
+}
+
+- (void) fetchOperationDidFinish:(SGAnnotationFetchOperation*)operation
+{
+    if(operation != fetchOperation)
+        return;
+    
+    // The views that were not part of any page belong to the previous data set
+    NSMutableArray* removedKeys = [NSMutableArray array];
+    for(NSValue* key in [overlaySubviews keyEnumerator])
+        if(![fetchedAnnotations containsObject:key])
+            [removedKeys addObject:key];
+    
+    [self removeAnnotationViewsForKeys:removedKeys];
+    
+    [fetchedAnnotations removeAllObjects];
+    [fetchOperation release];
+    fetchOperation = nil;
+}
+
 #pragma mark -
 #pragma mark Draw methods 
 
@@ -360,7 +715,7 @@
     if(enableGridLines && chromeComponent & kSGChromeComponent_Gridlines)
         [self drawGraphLines];
     
-    if(radar && !radar.hidden && chromeComponent & kSGChromeComponent_Radar)
+    if(radar && chromeComponent & kSGChromeComponent_Radar && !radar.hidden)
         [self drawRadarWithHeading:heading roll:roll];
     
     if(movableStack && chromeComponent & kSGChromeComponent_MovableStack)
@@ -369,10 +724,17 @@
 
 - (void) drawGraphLines
 {
+    // The grid spans the sphere, which can grow after the lines were made
+    if(!gridLines || gridLinesRadius != kSGSphere_Radius) {
+        SGStartupProfileBegin(&startupProfile, kSGStartupPhase_GridLines, CACurrentMediaTime());
+        [self createGraphLines];
+        SGStartupProfileEnd(&startupProfile, kSGStartupPhase_GridLines, CACurrentMediaTime());
+    }
+    
     glColor4f(gridLineColorComponents[0], gridLineColorComponents[1],
               gridLineColorComponents[2], gridLineColorComponents[3]);
     glVertexPointer(3.0, GL_FLOAT, 0, gridLines);
-    glDrawArrays(GL_LINES, 0, kSGSphere_Radius * 8.0);
+    SGGLStateDrawArrays(GL_LINES, 0, kSGSphere_Radius * 8.0);
 }
 
 - (void) drawRadarWithHeading:(double)heading roll:(double)roll
@@ -402,9 +764,21 @@
 
 - (void) startAnimation
 {
-    for(SGAnnotationView* annotationView in overlaySubviews)
+    SGStartupProfileBegin(&startupProfile, kSGStartupPhase_FirstFrame, CACurrentMediaTime());
+    
+    for(SGAnnotationView* annotationView in [overlaySubviews objectEnumerator])
         [annotationView layoutSubviews];
     
+#if __IPHONE_4_0 && __IPHONE_OS_VERSION_MIN_REQUIRED >= __IPHONE_4_0 && !TARGET_IPHONE_SIMULATOR
+    
+    if(!captureSession)
+        [self startCaptureSession];
+    
+#endif
+    
+    if(!openGLOverlayView)
+        [self setUpOverlayView];
+    
     [openGLOverlayView startAnimation];
     [openGLOverlayView becomeFirstResponder];    
 }
@@ -417,12 +791,12 @@
 
 - (void) addResponder:(id<SGARResponder>)responder
 {
-    [[enviornmentDrawer responders] addObject:responder];
+    [enviornmentDrawer addResponder:responder];
 }
 
 - (void) removeResponder:(id<SGARResponder>)responder
 {
-    [[enviornmentDrawer responders] removeObject:responder];
+    [enviornmentDrawer removeResponder:responder];
 }
 
 #pragma mark -
@@ -433,7 +807,8 @@
     int amountOfLines = kSGSphere_Radius * 2.0 * 2.0;
     int numberOfVertices = amountOfLines * 3.0 * 2.0;
     
-    gridLines = malloc(sizeof(float) * numberOfVertices);
+    gridLines = realloc(gridLines, sizeof(float) * numberOfVertices);
+    gridLinesRadius = kSGSphere_Radius;
     
     GLfloat deviation = kSGMeter;
     
@@ -533,8 +908,7 @@
 - (void) empty
 {
     for(SGAnnotationViewContainer* container in containers)
-        for(SGAnnotationView* view in [container getRecordAnnotationViews])
-            [container removeAnnotationView:view];
+        [container removeAllAnnotationViews];
 
     if(movableStack)
         [movableStack emptyStack:NO];
@@ -546,8 +920,12 @@
     [radar release];    
     [movableStack release];
     [gridLineColor release];
+    [orientationTracePath release];
     [annotationViews release];    
     [overlaySubviews release];
+    [self cancelAnnotationFetch];
+    [fetchQueue release];
+    [fetchedAnnotations release];
     [openGLOverlayView stopAnimation];
     [openGLOverlayView resignFirstResponder];
     [openGLOverlayView release];
@@ -36,6 +36,8 @@
 
 #import "SGTexture.h"
 #import "SGMath.h"
+#import "SGAnnotationStore.h"
+#import "SGBillboardCache.h"
 
 @protocol SGAnnotationViewDelegate;
 
@@ -76,9 +78,13 @@
     
     UIButton* radarTargetButton;
     UIImage* containerImage;
+    NSString* billboardIdentifier;
         
     @private    
     SGPoint3* point;
+    SGAnnotationStore* store;
+    SGAnnotationHandle handle;
+    NSInteger radarIndex;
     SGTexture* texture;
     SGTexture* radarPointTexture;
     
@@ -167,6 +173,36 @@
 */
 @property (nonatomic, assign) SGPoint3* point;
 
+/*!
+* @property
+* @abstract The @link //simplegeo/ooc/cl/SG3DOverlayEnvironment SG3DOverlayEnvironment @/link store that holds
+* the render state of the view, or NULL if the view is not part of an environment.
+* @discussion Just like @link point point @/link, this property should only be mutated
+* by @link //simplegeo/ooc/cl/SG3DOverlayEnvironment SG3DOverlayEnvironment @/link. While the view is in a store,
+* @link bearing bearing @/link and @link distance distance @/link are read from it.
+*/
+@property (nonatomic, assign) SGAnnotationStore* store;
+
+/*!
+* @property
+* @abstract The entry of the view in @link store store @/link.
+*/
+@property (nonatomic, assign) SGAnnotationHandle handle;
+
+/*!
+* @property
+* @abstract The position of the view in the @link //simplegeo/ooc/instp/SGRadar/annotationViews annotationViews @/link
+* of the @link //simplegeo/ooc/cl/SGRadar SGRadar @/link, or -1 if the radar does not hold it.
+*/
+@property (nonatomic, assign) NSInteger radarIndex;
+
+/*!
+* @property
+* @abstract YES if the coordinate of the @link annotation annotation @/link is no longer the one
+* that the view was placed at in its @link store store @/link.
+*/
+@property (nonatomic, readonly) BOOL hasMoved;
+
 /*!
 * @property
 * @abstract The texture that represents this view.
@@ -185,9 +221,21 @@
 * @abstract The image used to display in a 
 * @link //simplegeo/ooc/cl/SGAnnotationViewContainer SGAnnotationViewContainer @/link when the view
 * has reached the top of the stack.
+* @discussion The default is nil, in which case a thumbnail of the view is rendered by
+* @link containerImageWithSize: containerImageWithSize: @/link.
 */
 @property (nonatomic, retain) UIImage* containerImage;
 
+/*!
+* @property
+* @abstract Identifies what the @link texture texture @/link of the view looks like so that it can be
+* kept in the billboard cache and reused by later launches of the application.
+* @discussion The default is nil, in which case the texture is always rendered. Views of the same class and size
+* that share an identifier must look the same, so the identifier has to change whenever the artwork of the view does.
+* See @link billboardHash billboardHash @/link.
+*/
+@property (nonatomic, retain) NSString* billboardIdentifier;
+
 /*!
 * @method initWithFrame:reuseIdentifier:
 * @abstract Initialize a new annotation view.
@@ -205,6 +253,43 @@
 */
 - (void) prepareForReuse;
 
+/*!
+* @method containerImageWithSize:
+* @abstract Returns the image that represents the view inside of a container.
+* @discussion If @link containerImage containerImage @/link is nil, the view is rendered and scaled down to
+* fit the size. The thumbnails of all annotation views are kept in a shared cache that is bounded by
+* the amount of bytes they hold and is emptied when the application receives a memory warning.
+* A thumbnail is rendered again once the view needs a new texture.
+* @param size The size of the container.
+* @result The image to display.
+*/
+- (UIImage*) containerImageWithSize:(CGSize)size;
+
+/*!
+* @method removeAllContainerImages
+* @abstract Empties the cache of thumbnails that is shared by all annotation views.
+*/
++ (void) removeAllContainerImages;
+
+/*!
+* @method billboardHash
+* @abstract Hashes everything that the @link texture texture @/link of the view is drawn from.
+* @discussion The texture is looked up in the billboard cache by this hash before the view is rendered.
+* The default implementation combines the class, the size of the bounds, @link billboardIdentifier billboardIdentifier @/link
+* and the version of the application. Subclasses that draw content which is not described by the identifier should
+* mix it in, or return 0 when it should not be cached.
+* @result The hash, or 0 if the texture should not be cached.
+*/
+- (uint64_t) billboardHash;
+
+/*!
+* @method billboardCache
+* @abstract The cache of textures that is shared by all annotation views and kept
+* in the caches directory of the application.
+* @result The cache, or NULL if it could not be opened.
+*/
++ (SGBillboardCache*) billboardCache;
+
 /*!
 * @method drawAnnotationView
 * @abstract ￼The current implementation of this method does nothing. If @link enableOpenGL enableOpenGL @/link is set to YES, then
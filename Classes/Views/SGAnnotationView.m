@@ -36,19 +36,45 @@
 #import <QuartzCore/QuartzCore.h>
 
 #import "SGMetrics.h"
+#import "SGImageCache.h"
 
 #define MAX_PHOTO_WIDTH                 224.0
 #define MAX_PHOTO_HEIGHT                224.0
 
+#define kSGBillboardCache_FileName      @"SGBillboards.cache"
+
+// The thumbnails of every annotation view share a single budget
+static SGImageCache* containerImageCache = NULL;
+
+// Stays open for the life of the application so that cached textures can reference its pixels
+static SGBillboardCache* billboardCache = NULL;
+static BOOL billboardCacheOpened = NO;
+
+static void SGRetainContainerImage(void* image)
+{
+    [(UIImage*)image retain];
+}
+
+static void SGReleaseContainerImage(void* image)
+{
+    [(UIImage*)image release];
+}
+
+// Views remove their thumbnails before they go away, so they are not retained
+static const SGImageCacheCallbacks containerImageCallbacks = {
+    SGRetainContainerImage, SGReleaseContainerImage, NULL, NULL
+};
+
 @interface SGAnnotationView (Private)
 
 - (void) layoutSubviewsExpanded:(BOOL)expand;
+- (void) removeContainerImage;
 
 @end
 
 @implementation SGAnnotationView
 @synthesize targetImageView, isCaptured, isCapturable, distance, bearing, altitude, reuseIdentifier;
-@synthesize point, needNewTexture, delegate, enableOpenGL, containerImage, radarTargetButton;
+@synthesize point, store, handle, radarIndex, needNewTexture, delegate, enableOpenGL, containerImage, radarTargetButton, billboardIdentifier;
 @dynamic texture, annotation;
 
 - (id) initWithFrame:(CGRect)frame reuseIdentifier:(NSString*)identifier
@@ -56,6 +82,9 @@
     if (self = [super initWithFrame:frame]) {
         // Order of creation is important here
         point = (SGPoint3*)malloc(sizeof(SGPoint3));
+        store = NULL;
+        handle = kSGAnnotationHandle_Invalid;
+        radarIndex = -1;
         
         radarPointTexture = nil;
         texture = nil;
@@ -90,7 +119,13 @@
 
 - (void) setAnnotation:(id<MKAnnotation>)newAnnotation
 {
-    annotation = newAnnotation;
+    // The AR view finds the views to keep by the address of their
+    // annotation, which must not be handed to another annotation.
+    if(newAnnotation != annotation) {
+        [annotation release];
+        annotation = [newAnnotation retain];
+    }
+    
     self.needNewTexture = YES;
 }
 
@@ -99,13 +134,83 @@
     return annotation;
 }
 
+- (void) setStore:(SGAnnotationStore*)newStore
+{
+    // Keep the last known placement once the view leaves its store
+    int index = store ? SGAnnotationStoreIndex(store, handle) : -1;
+    if(index >= 0) {
+        bearing = store->bearings[index];
+        distance = store->distances[index];
+    }
+    
+    store = newStore;
+}
+
+- (double) bearing
+{
+    int index = store ? SGAnnotationStoreIndex(store, handle) : -1;
+    return index >= 0 ? store->bearings[index] : bearing;
+}
+
+- (double) distance
+{
+    int index = store ? SGAnnotationStoreIndex(store, handle) : -1;
+    return index >= 0 ? store->distances[index] : distance;
+}
+
+- (void) setAltitude:(double)newAltitude
+{
+    altitude = newAltitude;
+    
+    int index = store ? SGAnnotationStoreIndex(store, handle) : -1;
+    if(index >= 0)
+        store->altitudes[index] = altitude;
+}
+
+- (BOOL) hasMoved
+{
+    int index = store ? SGAnnotationStoreIndex(store, handle) : -1;
+    if(index < 0 || !annotation)
+        return NO;
+    
+    CLLocationCoordinate2D coordinate = annotation.coordinate;
+    return coordinate.latitude != store->latitudes[index] || coordinate.longitude != store->longitudes[index];
+}
+
+- (void) setNeedNewTexture:(BOOL)needsTexture
+{
+    needNewTexture = needsTexture;
+    
+    // The thumbnail is out of date as soon as the texture is
+    if(needsTexture)
+        [self removeContainerImage];
+}
+
+- (void) setBillboardIdentifier:(NSString*)identifier
+{
+    if(identifier != billboardIdentifier) {
+        [billboardIdentifier release];
+        billboardIdentifier = [identifier retain];
+        self.needNewTexture = YES;
+    }
+}
+
+- (void) setIsCaptured:(BOOL)captured
+{
+    isCaptured = captured;
+    
+    if(store)
+        SGAnnotationStoreSetFlag(store, handle, kSGAnnotationFlag_Captured, captured);
+}
+
 - (void) prepareForReuse
 {
     if(texture) {
         [texture release];
         texture = nil;
     }
-    isCaptured = NO;
+    [self removeContainerImage];
+    self.isCaptured = NO;
 }
 
 - (SGTexture*) texture
@@ -114,17 +219,28 @@
         if(texture)
             [texture release];
 
-        CGSize size = CGSizeMake(self.bounds.size.width, self.bounds.size.height);
-        
-        UIGraphicsBeginImageContext(size);
-        [self.layer renderInContext:UIGraphicsGetCurrentContext()];
-        UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
-        UIGraphicsEndImageContext();
-        
-        texture = [[SGTexture alloc] initWithImage:image];
-        
-        if(!containerImage)            
-            containerImage = [image retain];
+        uint64_t hash = [self billboardHash];
+        SGBillboardCache* cache = hash ? [SGAnnotationView billboardCache] : NULL;
+        SGBillboardCacheEntry entry;
+        if(cache && SGBillboardCacheFind(cache, hash, &entry))
+            texture = [[SGTexture alloc] initWithPixels:entry.pixels
+                                            pixelFormat:entry.format
+                                                  width:entry.width
+                                                 height:entry.height
+                                                   size:CGSizeMake(entry.contentWidth, entry.contentHeight)];
+        else {
+            CGSize size = CGSizeMake(self.bounds.size.width, self.bounds.size.height);
+            
+            UIGraphicsBeginImageContext(size);
+            [self.layer renderInContext:UIGraphicsGetCurrentContext()];
+            UIImage* image = UIGraphicsGetImageFromCurrentImageContext();
+            UIGraphicsEndImageContext();
+            
+            texture = [[SGTexture alloc] initWithImage:image];
+            if(cache && texture)
+                SGBillboardCacheStore(cache, hash, texture.pixelFormat, texture.width, texture.height,
+                                      texture.size.width, texture.size.height, texture.pixels, texture.lengthOfPixels);
+        }
         
         needNewTexture = NO;
     }
@@ -132,18 +248,115 @@
     return texture;
 }
 
+- (UIImage*) containerImageWithSize:(CGSize)size
+{
+    if(containerImage)
+        return containerImage;
+    
+    CGSize bounds = self.bounds.size;
+    if(bounds.width <= 0.0 || bounds.height <= 0.0 || size.width <= 0.0 || size.height <= 0.0)
+        return nil;
+    
+    // Fit the view inside the container without ever scaling it up
+    CGFloat scale = MIN(1.0, MIN(size.width / bounds.width, size.height / bounds.height));
+    CGSize thumbnailSize = CGSizeMake(floorf(bounds.width * scale), floorf(bounds.height * scale));
+    
+    if(!containerImageCache) {
+        containerImageCache = SGImageCacheNew(kSGImageCache_DefaultBudget, &containerImageCallbacks);
+        [[NSNotificationCenter defaultCenter] addObserver:[SGAnnotationView class]
+                                                 selector:@selector(removeAllContainerImages)
+                                                     name:UIApplicationDidReceiveMemoryWarningNotification
+                                                   object:nil];
+    }
+    
+    SGImageCacheKey key = { self, 0, { 0.0f } };
+    UIImage* image = [(UIImage*)SGImageCacheCopy(containerImageCache, &key) autorelease];
+    if(image && CGSizeEqualToSize(image.size, thumbnailSize))
+        return image;
+    
+    UIGraphicsBeginImageContext(thumbnailSize);
+    CGContextRef context = UIGraphicsGetCurrentContext();
+    CGContextSetInterpolationQuality(context, kCGInterpolationHigh);
+    CGContextScaleCTM(context, scale, scale);
+    [self.layer renderInContext:context];
+    image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    
+    CGImageRef imageRef = image.CGImage;
+    if(imageRef)
+        SGImageCacheSet(containerImageCache, &key, image,
+                        CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef));
+    
+    return image;
+}
+
++ (void) removeAllContainerImages
+{
+    if(containerImageCache)
+        SGImageCacheClear(containerImageCache);
+}
+
+- (uint64_t) billboardHash
+{
+    if(!billboardIdentifier)
+        return 0;
+    
+    // Textures that were cached by another version of the application may have been drawn differently
+    static uint64_t seed = 0;
+    if(!seed) {
+        NSString* version = [[NSBundle mainBundle] objectForInfoDictionaryKey:@"CFBundleVersion"];
+        const char* bytes = version ? [version UTF8String] : "";
+        seed = SGBillboardCacheHash(kSGBillboardCache_HashSeed, bytes, strlen(bytes) + 1);
+    }
+    
+    const char* className = [NSStringFromClass([self class]) UTF8String];
+    const char* identifier = [billboardIdentifier UTF8String];
+    CGSize size = self.bounds.size;
+    float dimensions[2] = { size.width, size.height };
+    
+    uint64_t hash = SGBillboardCacheHash(seed, className, strlen(className) + 1);
+    hash = SGBillboardCacheHash(hash, identifier, strlen(identifier) + 1);
+    
+    return SGBillboardCacheHash(hash, dimensions, sizeof(dimensions));
+}
+
++ (SGBillboardCache*) billboardCache
+{
+    if(!billboardCacheOpened) {
+        billboardCacheOpened = YES;
+        
+        NSString* directory = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+        NSString* path = [directory stringByAppendingPathComponent:kSGBillboardCache_FileName];
+        billboardCache = SGBillboardCacheOpen([path fileSystemRepresentation], kSGBillboardCache_DefaultSize);
+        if(!billboardCache)
+            SGLog(@"SGAnnotationView - Unable to open the billboard cache at %@", path);
+    }
+    
+    return billboardCache;
+}
+
 - (void) drawAnnotationView
 {
     // Does nothing
 }
 
+- (void) removeContainerImage
+{
+    SGImageCacheKey key = { self, 0, { 0.0f } };
+    if(containerImageCache)
+        SGImageCacheRemove(containerImageCache, &key);
+}
+
 - (void) dealloc 
 {
+    [annotation release];
     [reuseIdentifier release];
     [targetImageView release];
     [radarTargetButton release];    
     [containerImage release];
-    free(point);    
+    [billboardIdentifier release];
+    [self removeContainerImage];
+    free(point);
     [texture release];
     [radarPointTexture release];
     
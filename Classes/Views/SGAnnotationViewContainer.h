@@ -34,6 +34,7 @@
 
 #import "SGAnnotationView.h"
 #import "SGARView.h"
+#import "SGDeque.h"
 
 /*!
 * @class SGAnnotationViewContainer
@@ -42,8 +43,11 @@
 * a high volume of records per location, users can drag views into containers until they reach the desired view.
 *
 * Containers are registered with the AR view by @link //simplegeo/ooc/instm/SGChromeManager/addContainer: addContainer: @/link.
+*
+* A container can be enumerated with for...in, from the bottom view to the top one, without
+* copying its views. The container must not be changed while it is enumerated.
 */
-@interface SGAnnotationViewContainer : UIButton {
+@interface SGAnnotationViewContainer : UIButton <NSFastEnumeration> {
  
     BOOL rotatable;
  
@@ -53,8 +57,11 @@
     UIImage* highlightedImage;
  
     @private
-    NSMutableArray* views;
+    SGDeque* views;
     NSMutableArray* images;
+    
+    SGAnnotationView* topView;
+    unsigned long mutations;
  
 }
 
@@ -91,6 +98,7 @@
 /*!
 * @method getRecordAnnotationViews
 * @abstract ￼ Returns the @link //simplegeo/ooc/cl/SGRecordAnnotationView record views @/link associated with the container.
+* @discussion The views are copied into a new array. Enumerate the container itself to avoid the copy.
 * @result The record views associated with the container.￼
 */
 - (NSArray*) getRecordAnnotationViews;
@@ -115,6 +123,13 @@
 */
 - (void) removeAllAnnotationViews;
 
+/*!
+* @method amountOfAnnotationViews
+* @abstract The amount of @link //simplegeo/ooc/cl/SGRecordAnnotationView annotation views @/link held by the container.
+* @result The amount of views in the container.
+*/
+- (NSInteger) amountOfAnnotationViews;
+
 /*!
 * @method isEmpty
 * @abstract ￼Determines whether the container is empty.
@@ -44,6 +44,7 @@
 - (void) changeImageDueToEvent;
 
 - (void) setTopImage;
+- (void) releaseView:(SGAnnotationView*)view;
 
 @end
 
@@ -54,8 +55,10 @@
 - (id) initWithFrame:(CGRect)frame
 {
     if(self = [super initWithFrame:frame]) {
-        views = [[NSMutableArray alloc] init];        
+        views = SGDequeNew();
         images = [[NSMutableArray alloc] init];
+        topView = nil;
+        mutations = 0;
         
         rotatable = YES;
         
@@ -112,52 +115,94 @@
 {
     if(newViews && [newViews count] && [self shouldAddViews:newViews]) {
         
-        [views addObjectsFromArray:newViews];
-        for(SGAnnotationView* view in newViews)
+        for(SGAnnotationView* view in newViews) {
             view.isCaptured = YES;
+            SGDequePushBack(views, [view retain]);
+        }
         
+        mutations++;
         [self setTopImage];
     }
 }
 
 - (BOOL) isEmpty
 {
-    return views && [views count] == 0;
+    return views->count == 0;
+}
+
+- (NSInteger) amountOfAnnotationViews
+{
+    return views->count;
 }
 
 - (NSArray*) getRecordAnnotationViews
 {
-    return [NSArray arrayWithArray:views];
+    NSMutableArray* objects = [NSMutableArray arrayWithCapacity:views->count];
+    for(SGAnnotationView* view in self)
+        [objects addObject:view];
+    
+    return objects;
 }
 
 - (NSArray*) getRecordAnnotations
 {
-    NSMutableArray* objects = [[NSMutableArray alloc] init];
-    for(SGAnnotationView* view in views)
+    NSMutableArray* objects = [NSMutableArray arrayWithCapacity:views->count];
+    for(SGAnnotationView* view in self)
         [objects addObject:view.annotation];
     
-    return [objects autorelease];
+    return objects;
 }
 
 - (void) removeAnnotationView:(SGAnnotationView*)view
 {
     if(view) {
-        view.isCaptured = NO;
-        [views removeObject:view];
+        int index = SGDequeIndexOf(views, view);
+        if(index < 0) {
+            view.isCaptured = NO;
+            return;
+        }
+        
+        SGDequeRemoveAt(views, index);
+        mutations++;
         
+        [self releaseView:view];
         [self setTopImage];
     }
 }
 
 - (void) removeAllAnnotationViews
 {
-    for(SGAnnotationView* view in views)
-        view.isCaptured = NO;
+    if(!views->count)
+        return;
+    
+    void** run;
+    int length, index = 0;
+    while((length = SGDequeRun(views, index, &run))) {
+        for(int i = 0; i < length; i++)
+            [self releaseView:(SGAnnotationView*)run[i]];
+        
+        index += length;
+    }
+    
+    SGDequeClear(views);
+    mutations++;
     
-    [views removeAllObjects];
     [self setTopImage];
 }
 
+- (NSUInteger) countByEnumeratingWithState:(NSFastEnumerationState*)state objects:(id*)stackbuf count:(NSUInteger)len
+{
+    // The views are handed out straight from the deque, one contiguous run at a time
+    void** run;
+    int length = SGDequeRun(views, state->state, &run);
+    
+    state->itemsPtr = (id*)run;
+    state->mutationsPtr = &mutations;
+    state->state += length;
+    
+    return length;
+}
+
 #pragma mark -
 #pragma mark Event handlers 
 
@@ -185,20 +230,26 @@
  
 - (void) setTopImage
 {
-    if([views count])
-        [self setImage:((SGAnnotationView*)[views objectAtIndex:[views count] - 1]).containerImage 
-              forState:UIControlStateNormal];
-    else
-        [self setImage:nil forState:UIControlStateNormal];
+    // The image only has to change when a different view ends up on top
+    SGAnnotationView* view = views->count ? (SGAnnotationView*)SGDequeBack(views) : nil;
+    if(view == topView)
+        return;
+    
+    topView = view;
+    [self setImage:[view containerImageWithSize:self.bounds.size] forState:UIControlStateNormal];
+}
+
+- (void) releaseView:(SGAnnotationView*)view
+{
+    view.isCaptured = NO;
+    [view release];
 }
 
 - (SGAnnotationView*) popAnnotationView
 {
-    SGAnnotationView* view = nil;
-    if([views count]) {
-        view = [[views objectAtIndex:0] retain];
-        [views removeObjectAtIndex:0];
-        
+    SGAnnotationView* view = (SGAnnotationView*)SGDequePopFront(views);
+    if(view) {
+        mutations++;
         [self setTopImage];
         
         [view autorelease];
@@ -209,7 +260,16 @@
 
 - (void) dealloc
 {
-    [views release];
+    void** run;
+    int length, index = 0;
+    while((length = SGDequeRun(views, index, &run))) {
+        for(int i = 0; i < length; i++)
+            [(SGAnnotationView*)run[i] release];
+        
+        index += length;
+    }
+    
+    SGDequeFree(views);
     [images release];
     [normalImage release];
     [highlightedImage release];
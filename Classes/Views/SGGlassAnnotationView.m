@@ -117,6 +117,27 @@
     [self resetSubviews];
 }
 
+- (uint64_t) billboardHash
+{
+    uint64_t hash = [super billboardHash];
+    
+    // Photos are rarely shared between views and would crowd out everything else
+    if(!hash || photoImageView.image)
+        return 0;
+    
+    hash = SGBillboardCacheHash(hash, &inspectionMode, sizeof(inspectionMode));
+    if(inspectionMode) {
+        NSString* texts[] = { titleLabel.text, messageLabel.text, detailedLabel.text };
+        const char* text;
+        for(int i = 0; i < 3; i++) {
+            text = texts[i] ? [texts[i] UTF8String] : "";
+            hash = SGBillboardCacheHash(hash, text, strlen(text) + 1);
+        }
+    }
+    
+    return hash;
+}
+
 #pragma mark -
 #pragma mark Accessor methods 
 
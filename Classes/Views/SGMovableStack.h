@@ -44,6 +44,9 @@
 *
 * To change how the stack is presented, override @link drawStackAtPoint:roll: drawStackAtPoint:roll @/link. This method 
 * will notify the stack when the origin of the stack has moved along with the orientation of the device.
+*
+* The collected views are not subviews of the stack. They are drawn into a single composited image that
+* follows the drag, and only the views that were added since the last layout are drawn into it.
 */
 @interface SGMovableStack : UIView {
  
@@ -52,6 +55,9 @@
  
     @private
     NSMutableArray* movableStack;
+    
+    UIImageView* compositeView;
+    NSInteger amountOfCompositedViews;
 }
 
 /*!
@@ -76,6 +82,14 @@
 */
 - (void) addAnnotationView:(SGAnnotationView*)view;
 
+/*!
+* @method removeAnnotationView:
+* @abstract Removes an annotation view from the stack.
+* @discussion The view is no longer captured and returns to the AR enviornment.
+* @param view The @link //simplegeo/ooc/cl/SGAnnotaitonView SGAnnotationView @/link to remove from the movable stack.
+*/
+- (void) removeAnnotationView:(SGAnnotationView*)view;
+
 /*!
 * @method stack 
 * @abstract ￼ Returns an array of @link //simplegeo/ooc/cl/SGAnnotationView SGAnntationViews @/link that are
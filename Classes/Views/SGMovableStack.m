@@ -40,6 +40,13 @@
 
 #define SGMovableStack_Inset               4.0
 
+@interface SGMovableStack (Private)
+
+- (void) layoutAnnotationViewsFromIndex:(NSInteger)index;
+- (void) updateComposite;
+
+@end
+
 @implementation SGMovableStack
 
 @synthesize arView, maxStackAmount;
@@ -50,6 +57,10 @@
         movableStack = [[NSMutableArray alloc] init];
         arView = nil;
         maxStackAmount = 100;
+        
+        compositeView = [[UIImageView alloc] initWithFrame:CGRectZero];
+        [self addSubview:compositeView];
+        amountOfCompositedViews = 0;
     }
     
     return self;
@@ -64,41 +75,43 @@
         view.isCaptured = YES;
         [movableStack addObject:view];
         
-        [self addSubview:view];
+        // The view is drawn into the composite instead
+        [view removeFromSuperview];
     
         if(!self.superview)
             [arView addSubview:self];
         
-        if([self isKindOfClass:[SGMovableStack class]]) {
-            self.frame = CGRectMake(self.frame.origin.x,
-                                    self.frame.origin.y,
-                                    ((UIView*)[movableStack objectAtIndex:0]).frame.size.width + SGMovableStack_Inset * ([movableStack count] - 1),
-                                    ((UIView*)[movableStack objectAtIndex:0]).frame.size.height + SGMovableStack_Inset * ([movableStack count] - 1));
-    
-            SGAnnotationView* annotationView = nil;
-            NSInteger size = [movableStack count];
-            for(int i = size - 1; i >= 0 ; i--) {
-                annotationView = [movableStack objectAtIndex:i];
-                annotationView.frame = CGRectMake(self.frame.size.width - annotationView.frame.size.width - SGMovableStack_Inset * (size - i),
-                                                  self.frame.size.height - annotationView.frame.size.height - SGMovableStack_Inset * (size - i),
-                                                  annotationView.frame.size.width,
-                                                  annotationView.frame.size.height);
-            
-                [self bringSubviewToFront:annotationView];
-            }
-        }
+        [self layoutAnnotationViewsFromIndex:[movableStack count] - 1];
     }
 }
 
+- (void) removeAnnotationView:(SGAnnotationView*)view
+{
+    NSInteger index = [movableStack indexOfObjectIdenticalTo:view];
+    if(index == NSNotFound)
+        return;
+    
+    view.isCaptured = NO;
+    [movableStack removeObjectAtIndex:index];
+    
+    if([movableStack count]) {
+        // The views behind the one that was removed move up
+        amountOfCompositedViews = 0;
+        [self layoutAnnotationViewsFromIndex:index];
+    } else
+        [self emptyStack:NO];
+}
+
 - (void) emptyStack:(BOOL)stillCaptured
 {
-    for(SGAnnotationView* view in movableStack) {
-        [view removeFromSuperview];
+    for(SGAnnotationView* view in movableStack)
         view.isCaptured = stillCaptured;
-    }
     
     [movableStack removeAllObjects];
     [self removeFromSuperview];
+    
+    compositeView.image = nil;
+    amountOfCompositedViews = 0;
 }
 
 - (NSArray*) stack
@@ -106,6 +119,11 @@
     return movableStack;
 }
 
+- (void) layoutSubviews
+{
+    [self updateComposite];
+}
+
 - (void) drawStackAtPoint:(CGPoint)point roll:(double)roll
 {
     self.frame = CGRectMake(point.x - self.frame.size.width / 2.0,
@@ -114,10 +132,72 @@
                             self.frame.size.height);    
 }
 
+#pragma mark -
+#pragma mark Helper methods 
+
+- (void) layoutAnnotationViewsFromIndex:(NSInteger)index
+{
+    NSInteger size = [movableStack count];
+    CGSize firstSize = ((UIView*)[movableStack objectAtIndex:0]).frame.size;
+    self.frame = CGRectMake(self.frame.origin.x,
+                            self.frame.origin.y,
+                            firstSize.width + SGMovableStack_Inset * (size - 1),
+                            firstSize.height + SGMovableStack_Inset * (size - 1));
+    
+    // Each view is offset from the first one by its place in the stack. Adding a view
+    // to the back of the stack does not move the ones in front of it.
+    SGAnnotationView* annotationView;
+    for(NSInteger i = index; i < size; i++) {
+        annotationView = [movableStack objectAtIndex:i];
+        annotationView.frame = CGRectMake(firstSize.width - annotationView.frame.size.width + SGMovableStack_Inset * (i - 1),
+                                          firstSize.height - annotationView.frame.size.height + SGMovableStack_Inset * (i - 1),
+                                          annotationView.frame.size.width,
+                                          annotationView.frame.size.height);
+    }
+    
+    [self setNeedsLayout];
+}
+
+- (void) updateComposite
+{
+    NSInteger size = [movableStack count];
+    if(amountOfCompositedViews == size)
+        return;
+    
+    CGRect bounds = amountOfCompositedViews ? compositeView.frame : CGRectNull;
+    for(NSInteger i = amountOfCompositedViews; i < size; i++)
+        bounds = CGRectUnion(bounds, ((UIView*)[movableStack objectAtIndex:i]).frame);
+    
+    bounds = CGRectIntegral(bounds);
+    UIGraphicsBeginImageContext(bounds.size);
+    CGContextRef context = UIGraphicsGetCurrentContext();
+    
+    // The new views are at the back of the stack, so they are drawn first
+    // and the views that were already composited are drawn over them.
+    UIView* view;
+    for(NSInteger i = size - 1; i >= amountOfCompositedViews; i--) {
+        view = [movableStack objectAtIndex:i];
+        
+        CGContextSaveGState(context);
+        CGContextTranslateCTM(context, view.frame.origin.x - bounds.origin.x, view.frame.origin.y - bounds.origin.y);
+        [view.layer renderInContext:context];
+        CGContextRestoreGState(context);
+    }
+    
+    if(amountOfCompositedViews)
+        [compositeView.image drawInRect:CGRectOffset(compositeView.frame, -bounds.origin.x, -bounds.origin.y)];
+    
+    compositeView.image = UIGraphicsGetImageFromCurrentImageContext();
+    compositeView.frame = bounds;
+    UIGraphicsEndImageContext();
+    
+    amountOfCompositedViews = size;
+}
 
 - (void) dealloc
 {
     [movableStack release];
+    [compositeView release];
     [arView release];
     
     [super dealloc];
@@ -34,6 +34,7 @@
 
 #import "SGAnnotationView.h"
 #import "SGHeadingView.h"
+#import "SGScene.h"
 
 /*!
 * @enum SGCardinalDirection
@@ -84,6 +85,7 @@ typedef NSInteger SGCardinalDirection;
     CGPoint walkingOffset;
  
     NSMutableArray* annotationViews;
+    const SGSceneSnapshot* sceneSnapshot;
  
     @private
  	NSMutableArray* cardinalLabels;
@@ -165,6 +167,14 @@ typedef NSInteger SGCardinalDirection;
 */
 @property (nonatomic, assign) CGPoint walkingOffset;
 
+/*!
+* @property
+* @abstract The frame that the blips of the annotation views are placed from.
+* @discussion The blips are laid out on the worker thread that prepares the frame, together with the
+* rest of the scene. When this is NULL, the radar places the blips itself.
+*/
+@property (nonatomic, assign) const SGSceneSnapshot* sceneSnapshot;
+
 /*!
 * @method addAnnotationViews:
 * @abstract Adds an array of @link //simplegeo/ooc/cl/SGAnnotationView SGAnnotationViews @/link to the radar view.
@@ -172,6 +182,21 @@ typedef NSInteger SGCardinalDirection;
 */
 - (void) addAnnotationViews:(NSArray*)views;
 
+/*!
+* @method insertAnnotationViews:
+* @abstract Adds an array or a set of @link //simplegeo/ooc/cl/SGAnnotationView SGAnnotationViews @/link to the radar view
+* without touching the views that are already displayed.
+* @param views
+*/
+- (void) insertAnnotationViews:(id<NSFastEnumeration>)views;
+
+/*!
+* @method removeAnnotationViews:
+* @abstract Removes an array or a set of @link //simplegeo/ooc/cl/SGAnnotationView SGAnnotationViews @/link from the radar view.
+* @param views
+*/
+- (void) removeAnnotationViews:(id<NSFastEnumeration>)views;
+
 /*!
 * @method labelForCardinalDirection:
 * @abstract ￼Returns the label associated with the @link SGCardinalDirection SGCardinalDirection @/link.
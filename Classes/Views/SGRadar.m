@@ -35,6 +35,7 @@
 #import "SGRadar.h"
 
 #import "SGMath.h"
+#import "SGFastTrig.h"
 #import "SGAnnotationView.h"
 
 #import "SGEnvironmentConstants.h"
@@ -49,7 +50,7 @@
 
 @implementation SGRadar
 
-@synthesize rotatable, shouldShowCardinalDirections, annotationViews, cardinalDirectionOffset, walkingOffset;
+@synthesize rotatable, shouldShowCardinalDirections, annotationViews, cardinalDirectionOffset, walkingOffset, sceneSnapshot;
 @synthesize currentLocationImageView, radarBackgroundImageView, headingImageView, radarBorderColor, radarCircleColor;
 @dynamic headingColor;
 
@@ -65,6 +66,7 @@
         heading = 0.0;
         
         walkingOffset = CGPointZero;
+        sceneSnapshot = NULL;
         
         cardinalDirectionOffset = 5.0;
         
@@ -154,14 +156,47 @@
 
 - (void) addAnnotationViews:(NSArray*)views
 {
-    for(SGAnnotationView* view in annotationViews)
+    for(SGAnnotationView* view in annotationViews) {
         [view.radarTargetButton removeFromSuperview];
+        view.radarIndex = -1;
+    }
     
     [annotationViews removeAllObjects];
-    [annotationViews addObjectsFromArray:views];
-    
-    for(SGAnnotationView* view in annotationViews)
+    [self insertAnnotationViews:views];
+}
+
+- (void) insertAnnotationViews:(id<NSFastEnumeration>)views
+{
+    for(SGAnnotationView* view in views) {
+        view.radarIndex = [annotationViews count];
+        [annotationViews addObject:view];
         [self addSubview:view.radarTargetButton];
+    }
+}
+
+- (void) removeAnnotationViews:(id<NSFastEnumeration>)views
+{
+    NSInteger index, lastIndex;
+    SGAnnotationView* lastView;
+    for(SGAnnotationView* view in views) {
+        index = view.radarIndex;
+        if(index < 0 || index >= [annotationViews count] || [annotationViews objectAtIndex:index] != view)
+            continue;
+        
+        [view.radarTargetButton removeFromSuperview];
+        view.radarIndex = -1;
+        
+        // The order of the targets does not matter, so the last
+        // view fills the hole.
+        lastIndex = [annotationViews count] - 1;
+        if(index != lastIndex) {
+            lastView = [annotationViews objectAtIndex:lastIndex];
+            lastView.radarIndex = index;
+            [annotationViews exchangeObjectAtIndex:index withObjectAtIndex:lastIndex];
+        }
+        
+        [annotationViews removeLastObject];
+    }
 }
 
 - (void) setRotatable:(BOOL)rot
@@ -220,20 +255,37 @@
         
     // Annotaiton Views
     CGFloat bearing, distance;
+    float sine, cosine;
     CGPoint origin = CGPointZero;
     UIButton* targetButton;
+    const SGSceneBlip* blip;
     for(SGAnnotationView* view in annotationViews) {
         targetButton = view.radarTargetButton;
         
-        if(!view.isCaptured) {
+        if(sceneSnapshot) {
+            // Placed along with the rest of the frame
+            blip = SGSceneSnapshotBlip(sceneSnapshot, view.handle);
+            if(blip && blip->visible && !view.isCaptured) {
+                targetButton.hidden = NO;
+                targetButton.frame = CGRectMake(blip->x - (targetButton.frame.size.width / 2.0),
+                                                blip->y - (targetButton.frame.size.height / 2.0),
+                                                targetButton.frame.size.width,
+                                                targetButton.frame.size.height);
+                [self bringSubviewToFront:targetButton];
+            } else
+                targetButton.hidden = YES;
+            
+        } else if(!view.isCaptured) {
             bearing = view.bearing - 90.0;
         
             // The distance that we have here is not the distance
             // calculation that we want. We need to scale it down.
             distance = view.distance * scale;
         
-            origin.x = distance * cos(DEGREES_TO_RADIANS(bearing)) + (boundsWidth / 2.0);
-            origin.y = distance * sin(DEGREES_TO_RADIANS(bearing)) + (boundsWidth / 2.0);
+            // A blip is a few pixels wide so the cheapest tier is plenty.
+            SGFastSinCos(DEGREES_TO_RADIANS(bearing), &sine, &cosine, kSGTrigAccuracy_Low);
+            origin.x = distance * cosine + (boundsWidth / 2.0);
+            origin.y = distance * sine + (boundsWidth / 2.0);
 
             // Recenter the position
             origin.x += (walkingOffset.x * scale);
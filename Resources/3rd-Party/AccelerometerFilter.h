@@ -57,6 +57,9 @@
 // Add a UIAcceleration to the filter.
 -(void)addAcceleration:(UIAcceleration*)accel;
 
+// Add an acceleration that was queued as plain values.
+-(void)addAccelerationX:(UIAccelerationValue)ax y:(UIAccelerationValue)ay z:(UIAccelerationValue)az;
+
 @property(nonatomic, readonly) UIAccelerationValue x;
 @property(nonatomic, readonly) UIAccelerationValue y;
 @property(nonatomic, readonly) UIAccelerationValue z;
@@ -55,9 +55,14 @@
 
 -(void)addAcceleration:(UIAcceleration*)accel
 {
-	x = accel.x;
-	y = accel.y;
-	z = accel.z;
+	[self addAccelerationX:accel.x y:accel.y z:accel.z];
+}
+
+-(void)addAccelerationX:(UIAccelerationValue)ax y:(UIAccelerationValue)ay z:(UIAccelerationValue)az
+{
+	x = ax;
+	y = ay;
+	z = az;
 }
 
 -(NSString*)name
@@ -100,19 +105,19 @@ double Clamp(double v, double min, double max)
 	return self;
 }
 
--(void)addAcceleration:(UIAcceleration*)accel
+-(void)addAccelerationX:(UIAccelerationValue)ax y:(UIAccelerationValue)ay z:(UIAccelerationValue)az
 {
 	double alpha = filterConstant;
 	
 	if(adaptive)
 	{
-		double d = Clamp(fabs(Norm(x, y, z) - Norm(accel.x, accel.y, accel.z)) / kAccelerometerMinStep - 1.0, 0.0, 1.0);
+		double d = Clamp(fabs(Norm(x, y, z) - Norm(ax, ay, az)) / kAccelerometerMinStep - 1.0, 0.0, 1.0);
 		alpha = (1.0 - d) * filterConstant / kAccelerometerNoiseAttenuation + d * filterConstant;
 	}
 	
-	x = accel.x * alpha + x * (1.0 - alpha);
-	y = accel.y * alpha + y * (1.0 - alpha);
-	z = accel.z * alpha + z * (1.0 - alpha);
+	x = ax * alpha + x * (1.0 - alpha);
+	y = ay * alpha + y * (1.0 - alpha);
+	z = az * alpha + z * (1.0 - alpha);
 }
 
 -(NSString*)name
@@ -137,23 +142,23 @@ double Clamp(double v, double min, double max)
 	return self;
 }
 
--(void)addAcceleration:(UIAcceleration*)accel
+-(void)addAccelerationX:(UIAccelerationValue)ax y:(UIAccelerationValue)ay z:(UIAccelerationValue)az
 {
 	double alpha = filterConstant;
 	
 	if(adaptive)
 	{
-		double d = Clamp(fabs(Norm(x, y, z) - Norm(accel.x, accel.y, accel.z)) / kAccelerometerMinStep - 1.0, 0.0, 1.0);
+		double d = Clamp(fabs(Norm(x, y, z) - Norm(ax, ay, az)) / kAccelerometerMinStep - 1.0, 0.0, 1.0);
 		alpha = d * filterConstant / kAccelerometerNoiseAttenuation + (1.0 - d) * filterConstant;
 	}
 	
-	x = alpha * (x + accel.x - lastX);
-	y = alpha * (y + accel.y - lastY);
-	z = alpha * (z + accel.z - lastZ);
+	x = alpha * (x + ax - lastX);
+	y = alpha * (y + ay - lastY);
+	z = alpha * (z + az - lastZ);
 	
-	lastX = accel.x;
-	lastY = accel.y;
-	lastZ = accel.z;
+	lastX = ax;
+	lastY = ay;
+	lastZ = az;
 }
 
 -(NSString*)name
@@ -0,0 +1,241 @@
+//
+//  SGAllocationTrackerTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGAllocationTracker.h"
+#import "SGScene.h"
+
+#import <pthread.h>
+#import <stdlib.h>
+
+/*
+* The host has no zone to hook, so the C library's allocator is wrapped
+* here the same way the tracker wraps the default zone on the device.
+*/
+#ifdef __GLIBC__
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t amount, size_t size);
+extern void* __libc_realloc(void* pointer, size_t size);
+extern void __libc_free(void* pointer);
+
+void* malloc(size_t size) {
+    SGAllocationTrackerRecordAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t amount, size_t size) {
+    SGAllocationTrackerRecordAllocation(amount * size);
+    return __libc_calloc(amount, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+    SGAllocationTrackerRecordAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) {
+    if(pointer)
+        SGAllocationTrackerRecordFree();
+    __libc_free(pointer);
+}
+
+#endif
+
+#define kAmountOfAnnotations    500
+
+static void* allocateOnOtherThread(void* context) {
+    free(malloc(64));
+    return NULL;
+}
+
+static void testCounting(void) {
+    SGAllocationTrackerSetMode(kSGAllocationTracking_Count);
+    
+    SGAllocationTrackerBeginFrame();
+    SGAllocationTrackerRecordAllocation(16);
+    SGAllocationTrackerRecordAllocation(32);
+    SGAllocationTrackerRecordFree();
+    SGAllocationCounts counts = SGAllocationTrackerEndFrame();
+    
+    SGAssertTrue(counts.allocations == 2, "expected 2 allocations, got %u", counts.allocations);
+    SGAssertTrue(counts.frees == 1, "expected 1 free, got %u", counts.frees);
+    SGAssertTrue(counts.bytes == 48, "expected 48 bytes, got %u", (unsigned int)counts.bytes);
+    SGAssertTrue(counts.firstSize == 16, "expected the first allocation to be 16 bytes");
+    
+    // Outside of a frame nothing is counted
+    SGAllocationTrackerRecordAllocation(16);
+    SGAllocationTrackerBeginFrame();
+    counts = SGAllocationTrackerEndFrame();
+    SGAssertTrue(counts.allocations == 0, "allocations between frames were counted");
+    
+    // Nor when tracking is off
+    SGAllocationTrackerSetMode(kSGAllocationTracking_None);
+    SGAllocationTrackerBeginFrame();
+    SGAllocationTrackerRecordAllocation(16);
+    counts = SGAllocationTrackerEndFrame();
+    SGAssertTrue(counts.allocations == 0, "allocations were counted while tracking was off");
+}
+
+static void testOtherThreads(void) {
+    SGAllocationTrackerSetMode(kSGAllocationTracking_Count);
+    
+    pthread_t thread;
+    SGAllocationTrackerBeginFrame();
+    pthread_create(&thread, NULL, allocateOnOtherThread, NULL);
+    pthread_join(thread, NULL);
+    SGAllocationTrackerRecordAllocation(8);
+    SGAllocationCounts counts = SGAllocationTrackerEndFrame();
+    
+    // pthread_create itself allocates on the watched thread, so only
+    // the worker's allocation is known to be absent.
+    SGAssertTrue(counts.allocations >= 1, "the watched thread's allocation was not counted");
+    SGAssertTrue(counts.bytes < 64 || counts.firstSize != 64, "another thread's allocation was counted");
+}
+
+static void* allocateInPass(void* context) {
+    SGAllocationTrackerBeginPass((SGAllocationCounts*)context);
+    SGAllocationTrackerRecordAllocation(24);
+    SGAllocationTrackerRecordAllocation(8);
+    SGAllocationTrackerRecordFree();
+    SGAllocationTrackerEndPass();
+    SGAllocationTrackerRecordAllocation(64);
+    return NULL;
+}
+
+static void testPasses(void) {
+    SGAllocationTrackerSetMode(kSGAllocationTracking_Count);
+    
+    SGAllocationCounts passCounts;
+    pthread_t thread;
+    pthread_create(&thread, NULL, allocateInPass, &passCounts);
+    pthread_join(thread, NULL);
+    
+    SGAssertTrue(passCounts.allocations == 2 && passCounts.bytes == 32, "the pass counted %u allocations of %u bytes",
+                 passCounts.allocations, (unsigned int)passCounts.bytes);
+    
+    SGAllocationTrackerBeginFrame();
+    SGAllocationTrackerRecordAllocation(16);
+    SGAllocationTrackerMergePass(&passCounts);
+    SGAllocationCounts counts = SGAllocationTrackerEndFrame();
+    
+    SGAssertTrue(counts.allocations == 3, "expected 3 allocations after the merge, got %u", counts.allocations);
+    SGAssertTrue(counts.frees == 1, "expected 1 free after the merge, got %u", counts.frees);
+    SGAssertTrue(counts.bytes == 48, "expected 48 bytes after the merge, got %u", (unsigned int)counts.bytes);
+    SGAssertTrue(counts.firstSize == 16, "the frame's own first allocation should be kept");
+    
+    // Outside of a frame a pass is not merged
+    SGAllocationTrackerMergePass(&passCounts);
+    SGAllocationTrackerBeginFrame();
+    counts = SGAllocationTrackerEndFrame();
+    SGAssertTrue(counts.allocations == 0, "a pass was merged outside of a frame");
+}
+
+#ifdef __GLIBC__
+
+static void testFramePath(void) {
+    SGAnnotationStore* store = SGAnnotationStoreNew(10.0f, 30.0f, 1000000.0f);
+    SGScene* scene = SGSceneNew();
+    SGSceneInput input;
+    SGSceneSnapshot snapshot;
+    SGSceneInputInit(&input);
+    SGSceneSnapshotInit(&snapshot);
+    
+    srand(9);
+    SGAnnotationStoreSetOrigin(store, 37.7749, -122.4194);
+    for(int i = 0; i < kAmountOfAnnotations; i++) {
+        SGAnnotationHandle handle = SGAnnotationStoreAdd(store, 37.7749 + (rand() % 2000 - 1000) / 100000.0,
+                                                         -122.4194 + (rand() % 2000 - 1000) / 100000.0,
+                                                         0.0f, NULL);
+        store->widths[SGAnnotationStoreIndex(store, handle)] = 48.0f;
+        store->heights[SGAnnotationStoreIndex(store, handle)] = 48.0f;
+    }
+    
+    input.camera.height = 17.0f;
+    input.camera.fovy = 65.0f;
+    input.camera.zNear = 0.5f;
+    input.camera.zFar = 1000000.0f;
+    input.camera.viewport[2] = 320;
+    input.camera.viewport[3] = 480;
+    input.clustering = 1;
+    input.clusterTolerance = 5.0f;
+    input.clusterCellSize = 100.0f;
+    input.decluttering = 1;
+    input.touchScale = 1.0f;
+    
+    // The declutter states are the scene's, kept by slot across frames
+    int amountOfBillboards = 0;
+    SGAllocationCounts counts;
+    for(int frame = 0; frame < 4; frame++) {
+        SGAllocationTrackerSetMode(kSGAllocationTracking_Count);
+        SGAllocationTrackerBeginFrame();
+        
+        // The first frame at each of the two locations may grow buffers; the ones after them may not
+        SGAnnotationStoreSetOrigin(store, 37.7749 + (frame % 2) * 0.0001, -122.4194);
+        input.revision++;
+        
+        SGSceneInputCopyStore(&input, store);
+        input.frame = frame;
+        SGScenePrepare(scene, &input, &snapshot);
+        amountOfBillboards += snapshot.amountOfBillboards;
+        counts = SGAllocationTrackerEndFrame();
+        
+        if(frame > 1)
+            SGAssertTrue(counts.allocations == 0, "frame %i allocated %u times (%u bytes first)",
+                         frame, counts.allocations, (unsigned int)counts.firstSize);
+    }
+    
+    SGAssertTrue(amountOfBillboards != 0, "nothing was laid out");
+    
+    SGSceneSnapshotDestroy(&snapshot);
+    SGSceneInputDestroy(&input);
+    SGSceneFree(scene);
+    SGAnnotationStoreFree(store);
+}
+
+#endif
+
+int main(int argc, char** argv) {
+    testCounting();
+    testOtherThreads();
+    testPasses();
+    
+#ifdef __GLIBC__
+    testFramePath();
+#endif
+    
+    SGAllocationTrackerSetMode(kSGAllocationTracking_None);
+    
+    return SGTestResult();
+}
@@ -0,0 +1,285 @@
+//
+//  SGAnnotationStoreBenchmark.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGAnnotationStore.h"
+
+#import <stdio.h>
+#import <stdlib.h>
+#import <string.h>
+#import <math.h>
+#import <time.h>
+
+#ifdef __linux__
+#import <unistd.h>
+#import <sys/ioctl.h>
+#import <sys/syscall.h>
+#import <linux/perf_event.h>
+#endif
+
+/*
+* Compares a frame of billboard layout done through the store with the way
+* the environment used to do it: a pointer chase per view into a heap object,
+* a dynamically dispatched accessor per property, a temporary location object
+* per view and the bearing and distance recomputed every frame.
+*/
+
+#define kMeter              10.0f
+#define kFrames             200
+#define kObjectSize         384     /* roughly a UIView with its ivars */
+
+typedef struct {
+    double latitude;
+    double longitude;
+} Coordinate;
+
+typedef struct {
+    char isa[16];
+    Coordinate coordinate;
+} Annotation;
+
+typedef struct {
+    char header[kObjectSize];
+    Annotation* annotation;
+    float* point;
+    double distance;
+    double bearing;
+    double altitude;
+    int isCaptured;
+} View;
+
+typedef struct {
+    float x, y, z;
+    float bearing;
+    float distance;
+} Billboard;
+
+/* accessors are called through pointers so the compiler cannot inline them, as with objc_msgSend */
+typedef Coordinate (*CoordinateAccessor)(Annotation*);
+typedef int (*FlagAccessor)(View*);
+static Coordinate annotationCoordinate(Annotation* annotation) { return annotation->coordinate; }
+static int viewIsCaptured(View* view) { return view->isCaptured; }
+static volatile CoordinateAccessor getCoordinate = annotationCoordinate;
+static volatile FlagAccessor getIsCaptured = viewIsCaptured;
+
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static int openCacheMissCounter(void) {
+#ifdef __linux__
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static void startCounter(int counter) {
+#ifdef __linux__
+    if(counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+static long long stopCounter(int counter) {
+    long long value = -1;
+#ifdef __linux__
+    if(counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if(read(counter, &value, sizeof(value)) != sizeof(value))
+            value = -1;
+    }
+#endif
+    return value;
+}
+
+static void project(double originLatitude, double originLongitude, double latitude, double longitude,
+                    double* bearing, double* distance) {
+    double firstLat = originLatitude * M_PI / 180.0;
+    double secondLat = latitude * M_PI / 180.0;
+    double deltaLon = (longitude - originLongitude) * M_PI / 180.0;
+    double deltaLat = secondLat - firstLat;
+    *bearing = atan2(sin(deltaLon) * cos(secondLat), cos(firstLat) * sin(secondLat) - sin(firstLat) * cos(secondLat) * cos(deltaLon));
+    double a = sin(deltaLat / 2.0) * sin(deltaLat / 2.0) + cos(firstLat) * cos(secondLat) * sin(deltaLon / 2.0) * sin(deltaLon / 2.0);
+    *distance = 2.0 * atan2(sqrt(a), sqrt(1.0 - a)) * 6371009.0 * kMeter;
+}
+
+static void run(int amount) {
+    double originLatitude = 37.77, originLongitude = -122.40;
+    
+    // Views are allocated with other objects in between and visited in
+    // the order of the data set, not the order of the heap.
+    View** views = (View**)malloc(sizeof(View*) * amount);
+    void** filler = (void**)malloc(sizeof(void*) * amount);
+    SGAnnotationStore* store = SGAnnotationStoreNew(kMeter, 3.0f * kMeter, 100000.0f * kMeter);
+    SGAnnotationStoreSetOrigin(store, originLatitude, originLongitude);
+    
+    srand(5);
+    for(int i = 0; i < amount; i++) {
+        views[i] = (View*)calloc(1, sizeof(View));
+        filler[i] = malloc(64 + rand() % 512);
+        views[i]->annotation = (Annotation*)calloc(1, sizeof(Annotation));
+        views[i]->point = (float*)calloc(3, sizeof(float));
+        views[i]->annotation->coordinate.latitude = originLatitude + (rand() % 2000 - 1000) / 100000.0;
+        views[i]->annotation->coordinate.longitude = originLongitude + (rand() % 2000 - 1000) / 100000.0;
+        views[i]->isCaptured = (i % 10) == 0;
+        
+        SGAnnotationHandle handle = SGAnnotationStoreAdd(store, views[i]->annotation->coordinate.latitude,
+                                                         views[i]->annotation->coordinate.longitude, 0.0f, views[i]);
+        if(views[i]->isCaptured)
+            SGAnnotationStoreSetFlag(store, handle, kSGAnnotationFlag_Captured, 1);
+    }
+    
+    for(int i = amount - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        View* view = views[i];
+        views[i] = views[j];
+        views[j] = view;
+    }
+    
+    Billboard* billboards = (Billboard*)malloc(sizeof(Billboard) * amount);
+    int counter = openCacheMissCounter();
+    double checksum = 0.0;
+    
+    // The old path
+    double start = now();
+    startCounter(counter);
+    for(int frame = 0; frame < kFrames; frame++) {
+        int amountOfBillboards = 0;
+        for(int i = 0; i < amount; i++) {
+            View* view = views[i];
+            if(getIsCaptured(view))
+                continue;
+            
+            Coordinate coordinate = getCoordinate(view->annotation);
+            Coordinate* location = (Coordinate*)malloc(sizeof(Coordinate));
+            *location = getCoordinate(view->annotation);
+            
+            double bearing, distance;
+            project(originLatitude, originLongitude, location->latitude, coordinate.longitude, &bearing, &distance);
+            free(location);
+            
+            bearing = bearing * 180.0 / M_PI - 90.0;
+            Billboard* billboard = &billboards[amountOfBillboards++];
+            billboard->x = distance * cos(bearing * M_PI / 180.0);
+            billboard->y = view->altitude;
+            billboard->z = distance * sin(bearing * M_PI / 180.0);
+            billboard->bearing = bearing;
+            billboard->distance = distance;
+            
+            view->bearing = bearing + 90.0;
+            view->distance = distance;
+            view->point[0] = billboard->x;
+            view->point[2] = billboard->z;
+        }
+        
+        checksum += billboards[amountOfBillboards / 2].distance;
+    }
+    long long oldMisses = stopCounter(counter);
+    double oldTime = (now() - start) / kFrames;
+    
+    // The store only re-projects when the location changes
+    start = now();
+    startCounter(counter);
+    for(int frame = 0; frame < kFrames; frame++) {
+        int amountOfBillboards = 0;
+        int index;
+        for(int i = 0; i < store->count; i++) {
+            index = SGAnnotationStoreOrderedIndex(store, i);
+            if(SGAnnotationStoreTestFlag(store, index, kSGAnnotationFlag_Captured))
+                continue;
+            
+            Billboard* billboard = &billboards[amountOfBillboards++];
+            billboard->x = store->x[index];
+            billboard->y = store->altitudes[index];
+            billboard->z = store->z[index];
+            billboard->bearing = store->bearings[index] - 90.0f;
+            billboard->distance = store->distances[index];
+        }
+        
+        checksum += billboards[amountOfBillboards / 2].distance;
+    }
+    long long newMisses = stopCounter(counter);
+    double newTime = (now() - start) / kFrames;
+    
+    // What a location update costs the store
+    start = now();
+    for(int frame = 0; frame < kFrames; frame++)
+        SGAnnotationStoreSetOrigin(store, originLatitude + frame * 1e-6, originLongitude);
+    double originTime = (now() - start) / kFrames;
+    
+    printf("%6i annotations: %9.1f us/frame before, %7.1f us/frame with the store (%.1fx), %8.1f us per location update",
+           amount, oldTime * 1e6, newTime * 1e6, oldTime / newTime, originTime * 1e6);
+    if(oldMisses >= 0 && newMisses >= 0)
+        printf(", cache misses/frame %lld vs %lld", oldMisses / kFrames, newMisses / kFrames);
+    else
+        printf(", cache misses unavailable");
+    printf("  [%g]\n", checksum > 0.0 ? 1.0 : 0.0);
+    
+#ifdef __linux__
+    if(counter >= 0)
+        close(counter);
+#endif
+    
+    for(int i = 0; i < amount; i++) {
+        free(views[i]->annotation);
+        free(views[i]->point);
+        free(views[i]);
+        free(filler[i]);
+    }
+    free(views);
+    free(filler);
+    free(billboards);
+    SGAnnotationStoreFree(store);
+}
+
+int main(int argc, char** argv) {
+    run(100);
+    run(1000);
+    run(10000);
+    run(50000);
+    
+    return 0;
+}
@@ -0,0 +1,168 @@
+//
+//  SGAnnotationStoreTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGAnnotationStore.h"
+
+#import <stdlib.h>
+
+#define kMeter          10.0f
+#define kAmount         2000
+
+static void checkOrder(SGAnnotationStore* store) {
+    int sorted = 1;
+    for(int i = 1; i < store->count; i++)
+        if(store->distances[SGAnnotationStoreOrderedIndex(store, i - 1)] <
+           store->distances[SGAnnotationStoreOrderedIndex(store, i)])
+            sorted = 0;
+    
+    SGAssertTrue(sorted, "The order should go from the farthest to the closest");
+}
+
+static void testProjection(void) {
+    SGAnnotationStore* store = SGAnnotationStoreNew(kMeter, 3.0f * kMeter, 1000000.0f * kMeter);
+    SGAnnotationStoreSetOrigin(store, 37.77, -122.40);
+    
+    SGAnnotationHandle north = SGAnnotationStoreAdd(store, 37.78, -122.40, 0.0f, NULL);
+    SGAnnotationHandle far = SGAnnotationStoreAdd(store, 10.0, 10.0, 0.0f, NULL);
+    
+    int index = SGAnnotationStoreIndex(store, north);
+    SGAssertEqualsWithAccuracy(store->bearings[index], 0.0, 1e-3, "Bearing should be 0.0 but was %f", store->bearings[index]);
+    SGAssertEqualsWithAccuracy(store->distances[index], 1112.0 * kMeter, 2.0 * kMeter,
+                               "Distance should be about 1112m but was %f", store->distances[index] / kMeter);
+    SGAssertEqualsWithAccuracy(store->z[index], -store->distances[index], 1e-1, "North should point down the z axis");
+    
+    // Same value as SGBearingTest
+    index = SGAnnotationStoreIndex(store, far);
+    SGAssertEqualsWithAccuracy(store->bearings[index], 53.20235, 1e-3, "Bearing should be 53.20235 but was %f", store->bearings[index]);
+    SGAssertTrue(SGAnnotationStoreOrderedIndex(store, 0) == index, "The farthest entry should be drawn first");
+    
+    SGAnnotationStoreFree(store);
+}
+
+static void testHandles(void) {
+    SGAnnotationStore* store = SGAnnotationStoreNew(kMeter, 0.0f, 1000000.0f * kMeter);
+    SGAnnotationStoreSetOrigin(store, 0.0, 0.0);
+    
+    SGAnnotationHandle handles[kAmount];
+    long objects[kAmount];
+    int alive[kAmount];
+    
+    srand(3);
+    for(int i = 0; i < kAmount; i++) {
+        objects[i] = i;
+        handles[i] = SGAnnotationStoreAdd(store, (rand() % 2000) / 100000.0, (rand() % 2000) / 100000.0,
+                                          0.0f, &objects[i]);
+        alive[i] = 1;
+        
+        if(i % 3 == 0)
+            SGAnnotationStoreSetFlag(store, handles[i], kSGAnnotationFlag_Captured, 1);
+    }
+    
+    checkOrder(store);
+    
+    // Remove half of the entries and move some of the others
+    for(int i = 0; i < kAmount; i += 2) {
+        SGAnnotationStoreRemove(store, handles[i]);
+        alive[i] = 0;
+    }
+    
+    for(int i = 1; i < kAmount; i += 6)
+        SGAnnotationStoreMove(store, handles[i], (rand() % 2000) / 100000.0, (rand() % 2000) / 100000.0, 0.0f);
+    
+    SGAssertTrue(store->count == kAmount / 2, "There should be %i entries but there were %i", kAmount / 2, store->count);
+    checkOrder(store);
+    
+    int index, found = 1, flagged = 1;
+    for(int i = 0; i < kAmount; i++) {
+        index = SGAnnotationStoreIndex(store, handles[i]);
+        if(alive[i]) {
+            found &= index >= 0 && store->objects[index] == &objects[i];
+            flagged &= SGAnnotationStoreTestFlag(store, index, kSGAnnotationFlag_Captured) == (i % 3 == 0);
+        } else
+            found &= index < 0;
+    }
+    
+    SGAssertTrue(found, "Handles should refer to the same object until the entry is removed");
+    SGAssertTrue(flagged, "Flags should follow their entry when entries are packed");
+    
+    // Only a flag that actually changes is seen by the clusters
+    unsigned int flagRevision = store->flagRevision;
+    SGAnnotationStoreSetFlag(store, handles[3], kSGAnnotationFlag_Captured, 1);
+    SGAssertTrue(store->flagRevision == flagRevision, "Setting a flag that is already set should not change the revision");
+    SGAnnotationStoreSetFlag(store, handles[3], kSGAnnotationFlag_Captured, 0);
+    SGAssertTrue(store->flagRevision != flagRevision, "Clearing a flag should change the revision");
+    
+    // Slots are reused but old handles stay invalid
+    SGAnnotationHandle handle = SGAnnotationStoreAdd(store, 0.0, 0.0, 0.0f, NULL);
+    SGAssertTrue(SGAnnotationStoreIndex(store, handles[0]) < 0, "A removed handle should not become valid again");
+    SGAssertTrue(SGAnnotationStoreIndex(store, handle) == store->count - 1, "A new entry should be appended");
+    
+    SGAnnotationStoreSetOrigin(store, 0.01, 0.01);
+    checkOrder(store);
+    
+    SGAnnotationStoreClear(store);
+    SGAssertTrue(store->count == 0 && SGAnnotationStoreIndex(store, handle) < 0, "Clearing should invalidate every handle");
+    
+    SGAnnotationStoreFree(store);
+}
+
+static void testStaleHandles(void) {
+    SGAnnotationStore* store = SGAnnotationStoreNew(kMeter, 0.0f, 1000000.0f * kMeter);
+    SGAnnotationStoreSetOrigin(store, 0.0, 0.0);
+    
+    // Every reload reuses the same slot, which must never hand out an old handle again
+    SGAnnotationHandle stale = SGAnnotationStoreAdd(store, 0.001, 0.001, 0.0f, NULL);
+    SGAnnotationHandle handle = stale;
+    int reused = 0;
+    for(int reload = 0; reload < 1000; reload++) {
+        SGAnnotationStoreClear(store);
+        handle = SGAnnotationStoreAdd(store, 0.001, 0.001, 0.0f, NULL);
+        if(SGAnnotationStoreIndex(store, stale) >= 0 || handle == stale)
+            reused++;
+    }
+    
+    SGAssertTrue(SGAnnotationHandleSlot(handle) == SGAnnotationHandleSlot(stale), "The slot should have been reused");
+    SGAssertTrue(!reused, "A stale handle became valid again after %i reloads", reused);
+    
+    SGAnnotationStoreFree(store);
+}
+
+int main(int argc, char** argv) {
+    testProjection();
+    testHandles();
+    testStaleHandles();
+    
+    return SGTestResult();
+}
@@ -0,0 +1,173 @@
+//
+//  SGBillboardCacheTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGBillboardCache.h"
+
+#import <string.h>
+#import <unistd.h>
+
+#define kCacheSize              (256 * 1024)
+#define kBillboardWidth         64
+#define kBillboardHeight        32
+#define kBillboardLength        (kBillboardWidth * kBillboardHeight * 4)
+
+static unsigned char pixels[kBillboardLength];
+
+static void fillPixels(int seed) {
+    for(int i = 0; i < kBillboardLength; i++)
+        pixels[i] = (unsigned char)(i * 31 + seed * 7);
+}
+
+static uint64_t hashOf(int seed) {
+    return SGBillboardCacheHash(kSGBillboardCache_HashSeed, &seed, sizeof(seed));
+}
+
+static int store(SGBillboardCache* cache, int seed) {
+    fillPixels(seed);
+    return SGBillboardCacheStore(cache, hashOf(seed), seed % 3, kBillboardWidth, kBillboardHeight,
+                                 kBillboardWidth - 3, kBillboardHeight - 5, pixels, kBillboardLength);
+}
+
+/* whether the billboard of the seed is found with all of its pixels intact */
+static int found(SGBillboardCache* cache, int seed) {
+    SGBillboardCacheEntry entry;
+    if(!SGBillboardCacheFind(cache, hashOf(seed), &entry))
+        return 0;
+    
+    fillPixels(seed);
+    return entry.length == kBillboardLength && entry.format == seed % 3 &&
+        entry.width == kBillboardWidth && entry.height == kBillboardHeight &&
+        entry.contentWidth == kBillboardWidth - 3 && entry.contentHeight == kBillboardHeight - 5 &&
+        !((uintptr_t)entry.pixels % kSGBillboardCache_Alignment) &&
+        !memcmp(entry.pixels, pixels, kBillboardLength);
+}
+
+int main(int argc, char** argv) {
+    char path[] = "/tmp/SGBillboardCacheTestXXXXXX";
+    int file = mkstemp(path);
+    SGAssertTrue(file >= 0, "Could not create %s", path);
+    close(file);
+    
+    // FNV-1a test vector
+    SGAssertTrue(SGBillboardCacheHash(kSGBillboardCache_HashSeed, "a", 1) == 0xaf63dc4c8601ec8cULL, "Unexpected hash of \"a\"");
+    
+    SGBillboardCache* cache = SGBillboardCacheOpen(path, kCacheSize);
+    SGAssertTrue(cache != NULL, "Could not open the cache");
+    SGAssertTrue(!found(cache, 0), "An empty cache should miss");
+    
+    for(int i = 0; i < 10; i++)
+        SGAssertTrue(store(cache, i), "Billboard %d should be stored", i);
+    SGAssertTrue(!store(cache, 3), "A billboard should only be stored once");
+    SGAssertTrue(!SGBillboardCacheStore(cache, 0, 0, 1, 1, 1, 1, pixels, 4), "The hash 0 should never be stored");
+    SGAssertTrue(!SGBillboardCacheStore(cache, hashOf(100), 3, 1, 1, 1, 1, pixels, 4), "An unknown format should not be stored");
+    SGAssertTrue(!SGBillboardCacheStore(cache, hashOf(100), kSGBillboardCache_RGBA8888, 2, 2, 2, 2, pixels, 15),
+                 "Pixels that do not cover the texture should not be stored");
+    
+    for(int i = 0; i < 10; i++)
+        SGAssertTrue(found(cache, i), "Billboard %d should be found", i);
+    SGAssertTrue(!found(cache, 10), "An unknown billboard should miss");
+    SGAssertTrue(cache->hits == 10 && cache->misses == 2, "Expected 10 hits and 2 misses, got %d and %d", cache->hits, cache->misses);
+    SGBillboardCacheClose(cache);
+    
+    // Billboards outlive the cache that stored them
+    cache = SGBillboardCacheOpen(path, kCacheSize);
+    for(int i = 0; i < 10; i++)
+        SGAssertTrue(found(cache, i), "Billboard %d should be found after reopening", i);
+    
+    // Storing stops once the file is full, without touching what is there
+    int stored = 10;
+    while(store(cache, stored))
+        stored++;
+    printf("SGBillboardCacheTest: %d billboards of %d bytes fit in %d bytes\n", stored, kBillboardLength, kCacheSize);
+    SGAssertTrue(stored > 10 && stored <= kCacheSize / kBillboardLength, "Unexpected amount of billboards: %d", stored);
+    SGAssertTrue(cache->rejections == 1, "The billboard that did not fit should be rejected");
+    SGAssertTrue(found(cache, 0) && found(cache, stored - 1), "A full cache should still find its billboards");
+    SGBillboardCacheClose(cache);
+    
+    // A full file starts over
+    cache = SGBillboardCacheOpen(path, kCacheSize);
+    SGAssertTrue(!found(cache, 0) && cache->header->count == 0, "A full cache should be emptied when it is opened");
+    SGAssertTrue(store(cache, 0) && store(cache, 1), "An emptied cache should store billboards");
+    SGBillboardCacheClose(cache);
+    
+    // A damaged header or slot empties the cache instead of handing out bad pixels
+    cache = SGBillboardCacheOpen(path, kCacheSize);
+    cache->header->magic = 0;
+    SGBillboardCacheClose(cache);
+    cache = SGBillboardCacheOpen(path, kCacheSize);
+    SGAssertTrue(!found(cache, 0) && cache->header->count == 0, "A damaged header should empty the cache");
+    
+    SGAssertTrue(store(cache, 0) && store(cache, 1), "Billboards should be stored");
+    for(int i = 0; i < (int)cache->header->slotCount; i++)
+        if(cache->slots[i].hash == hashOf(1))
+            cache->slots[i].offset = kCacheSize;
+    SGBillboardCacheClose(cache);
+    cache = SGBillboardCacheOpen(path, kCacheSize);
+    SGAssertTrue(!found(cache, 0) && cache->header->count == 0, "A slot that points outside of the file should empty the cache");
+    SGAssertTrue(store(cache, 0), "Billboards should be stored");
+    SGBillboardCacheClose(cache);
+    
+    // So does a slot whose pixels are too short for its texture or of an unknown format
+    cache = SGBillboardCacheOpen(path, kCacheSize);
+    SGAssertTrue(store(cache, 1), "Billboards should be stored");
+    for(int i = 0; i < (int)cache->header->slotCount; i++)
+        if(cache->slots[i].hash == hashOf(1))
+            cache->slots[i].height = kBillboardHeight * 4;
+    SGBillboardCacheClose(cache);
+    cache = SGBillboardCacheOpen(path, kCacheSize);
+    SGAssertTrue(!found(cache, 0) && cache->header->count == 0, "A slot that is too short for its texture should empty the cache");
+    
+    SGAssertTrue(store(cache, 0), "Billboards should be stored");
+    for(int i = 0; i < (int)cache->header->slotCount; i++)
+        if(cache->slots[i].hash == hashOf(0))
+            cache->slots[i].format = 7;
+    SGBillboardCacheClose(cache);
+    cache = SGBillboardCacheOpen(path, kCacheSize);
+    SGAssertTrue(!found(cache, 0) && cache->header->count == 0, "A slot of an unknown format should empty the cache");
+    SGAssertTrue(store(cache, 0), "Billboards should be stored");
+    SGBillboardCacheClose(cache);
+    
+    // A file of another size is rebuilt
+    cache = SGBillboardCacheOpen(path, 2 * kCacheSize);
+    SGAssertTrue(cache && !found(cache, 0), "A cache of another size should start empty");
+    SGAssertTrue(store(cache, 0) && found(cache, 0), "A resized cache should store billboards");
+    SGBillboardCacheClose(cache);
+    
+    SGAssertTrue(SGBillboardCacheOpen(path, 256) == NULL, "A size that can not hold the table should fail");
+    SGAssertTrue(SGBillboardCacheOpen("/nonexistent/SGBillboardCacheTest", kCacheSize) == NULL, "An unreachable path should fail");
+    
+    unlink(path);
+    return SGTestResult();
+}
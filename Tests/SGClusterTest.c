@@ -0,0 +1,204 @@
+//
+//  SGClusterTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import "SGCTest.h"
+#import "SGCluster.h"
+
+#import <stdlib.h>
+#import <string.h>
+
+#define kAmountOfGroups         10
+#define kGroupSize              20
+#define kAmountOfAnnotations    (kAmountOfGroups * kGroupSize)
+#define kCellSize               5.0f
+#define kTolerance              0.05f
+
+static float x[kAmountOfAnnotations];
+static float z[kAmountOfAnnotations];
+static float distances[kAmountOfAnnotations];
+static int nodes[kAmountOfAnnotations * 2];
+static int covered[kAmountOfAnnotations];
+
+/* tight groups of annotations spread around the origin */
+static void layoutAnnotations(void) {
+    srand(11);
+    float groupX, groupZ;
+    for(int group = 0; group < kAmountOfGroups; group++) {
+        groupX = (rand() % 4000 - 2000) / 2.0f;
+        groupZ = (rand() % 4000 - 2000) / 2.0f;
+        for(int i = 0; i < kGroupSize; i++) {
+            x[group * kGroupSize + i] = groupX + (rand() % 100) / 25.0f;
+            z[group * kGroupSize + i] = groupZ + (rand() % 100) / 25.0f;
+        }
+    }
+    
+    for(int i = 0; i < kAmountOfAnnotations; i++)
+        distances[i] = sqrtf(x[i] * x[i] + z[i] * z[i]);
+}
+
+/* marks the annotations below a node; returns the closest one */
+static int cover(SGClusterTree* tree, int index) {
+    SGClusterNode* node = &tree->nodes[index];
+    if(node->firstChild < 0) {
+        covered[index]++;
+        return index;
+    }
+    
+    int closest = -1, member;
+    for(int i = 0; i < node->childCount; i++) {
+        member = cover(tree, tree->children[node->firstChild + i]);
+        if(closest < 0 || distances[member] < distances[closest])
+            closest = member;
+    }
+    
+    return closest;
+}
+
+/* whether the nodes of a cut hold every annotation exactly once */
+static int isPartition(SGClusterTree* tree, int* cut, int amount) {
+    memset(covered, 0, sizeof(covered));
+    int count = 0;
+    for(int i = 0; i < amount; i++) {
+        cover(tree, cut[i]);
+        count += tree->nodes[cut[i]].count;
+    }
+    
+    for(int i = 0; i < kAmountOfAnnotations; i++)
+        if(covered[i] != 1)
+            return 0;
+    
+    return count == kAmountOfAnnotations;
+}
+
+static void testBuild(void) {
+    SGClusterTree* tree = SGClusterTreeNew();
+    SGClusterTreeBuild(tree, x, z, distances, kAmountOfAnnotations, kCellSize);
+    
+    SGAssertTrue(tree->leafCount == kAmountOfAnnotations, "Expected %i leaves, got %i", kAmountOfAnnotations, tree->leafCount);
+    SGAssertTrue(tree->rootCount > 0 && tree->rootCount < kAmountOfAnnotations, "Expected the groups to merge, got %i roots", tree->rootCount);
+    SGAssertTrue(isPartition(tree, tree->roots, tree->rootCount), "The roots should hold every annotation once");
+    
+    // Each cluster is represented by its member that is closest to the origin
+    int wrong = 0;
+    for(int i = kAmountOfAnnotations; i < tree->nodeCount; i++)
+        if(cover(tree, i) != tree->nodes[i].representative)
+            wrong++;
+    SGAssertTrue(!wrong, "%i clusters were not represented by their closest member", wrong);
+    
+    SGClusterTreeFree(tree);
+}
+
+static void testSplitOnApproach(void) {
+    SGClusterTree* tree = SGClusterTreeNew();
+    SGClusterTreeBuild(tree, x, z, distances, kAmountOfAnnotations, kCellSize);
+    
+    // From far away every group is a single cluster
+    float farX = 100000.0f, farZ = 0.0f;
+    int far = SGClusterTreeCut(tree, farX, farZ, kTolerance, nodes, tree->nodeCount);
+    SGAssertTrue(far <= kAmountOfGroups, "Expected at most %i clusters from far away, got %i", kAmountOfGroups, far);
+    SGAssertTrue(isPartition(tree, nodes, far), "A cut from far away should hold every annotation once");
+    
+    // Walking into the first group splits it into its annotations
+    int near = SGClusterTreeCut(tree, x[0], z[0], kTolerance, nodes, tree->nodeCount);
+    SGAssertTrue(near > far, "Expected more than %i clusters up close, got %i", far, near);
+    SGAssertTrue(isPartition(tree, nodes, near), "A cut up close should hold every annotation once");
+    
+    int leavesOfGroup = 0;
+    for(int i = 0; i < near; i++)
+        if(nodes[i] < kGroupSize)
+            leavesOfGroup++;
+    SGAssertTrue(leavesOfGroup == kGroupSize, "Only %i annotations of the group around the camera were split out", leavesOfGroup);
+    
+    // The cut is sorted from back to front for blending
+    SGClusterTreeSortBackToFront(tree, nodes, near, x[0], z[0]);
+    int unsorted = 0;
+    float dx, dz, depth, previous = INFINITY;
+    for(int i = 0; i < near; i++) {
+        dx = tree->nodes[nodes[i]].x - x[0];
+        dz = tree->nodes[nodes[i]].z - z[0];
+        depth = dx * dx + dz * dz;
+        if(depth > previous)
+            unsorted++;
+        previous = depth;
+    }
+    SGAssertTrue(!unsorted, "%i clusters were drawn before one behind them", unsorted);
+    
+    SGClusterTreeFree(tree);
+}
+
+static void testBounds(void) {
+    SGClusterTree* tree = SGClusterTreeNew();
+    SGClusterTreeBuild(tree, x, z, distances, kAmountOfAnnotations, kCellSize);
+    
+    // Without any tolerance every cluster is split and only leaves are emitted
+    int amount = SGClusterTreeCut(tree, 0.0f, 0.0f, 0.0f, nodes, tree->nodeCount);
+    int inner = 0;
+    for(int i = 0; i < amount; i++)
+        if(nodes[i] >= tree->leafCount)
+            inner++;
+    SGAssertTrue(amount == kAmountOfAnnotations && !inner, "Expected %i leaves, got %i nodes of which %i were clusters",
+                 kAmountOfAnnotations, amount, inner);
+    
+    // A leaf is emitted however large the tolerance is
+    SGClusterTreeBuild(tree, x, z, distances, 1, kCellSize);
+    amount = SGClusterTreeCut(tree, 0.0f, 0.0f, 100.0f, nodes, tree->nodeCount);
+    SGAssertTrue(amount == 1 && nodes[0] == 0, "A single annotation should always be emitted");
+    
+    // The output never holds more than it was given room for
+    SGClusterTreeBuild(tree, x, z, distances, kAmountOfAnnotations, kCellSize);
+    nodes[3] = -1;
+    amount = SGClusterTreeCut(tree, 0.0f, 0.0f, 0.0f, nodes, 3);
+    SGAssertTrue(amount == 3 && nodes[3] == -1, "Expected 3 nodes within the bound, got %i", amount);
+    
+    amount = SGClusterTreeCut(tree, 0.0f, 0.0f, 0.0f, nodes, 0);
+    SGAssertTrue(amount == 0, "No room should emit no nodes");
+    
+    // An empty tree emits nothing
+    SGClusterTreeBuild(tree, x, z, distances, 0, kCellSize);
+    amount = SGClusterTreeCut(tree, 0.0f, 0.0f, kTolerance, nodes, kAmountOfAnnotations);
+    SGAssertTrue(amount == 0, "An empty tree emitted %i nodes", amount);
+    
+    SGClusterTreeFree(tree);
+}
+
+int main(int argc, char** argv) {
+    layoutAnnotations();
+    
+    testBuild();
+    testSplitOnApproach();
+    testBounds();
+    
+    return SGTestResult();
+}
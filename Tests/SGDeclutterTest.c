@@ -0,0 +1,169 @@
+//
+//  SGDeclutterTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import "SGCTest.h"
+#import "SGDeclutter.h"
+
+#define kScreenWidth            320.0f
+#define kScreenHeight           480.0f
+#define kCellSize               16.0f
+#define kLabelWidth             64.0f
+#define kLabelHeight            32.0f
+
+static void testNearestFirst(void) {
+    SGDeclutterGrid* grid = SGDeclutterGridNew(kScreenWidth, kScreenHeight, kCellSize);
+    SGDeclutterState nearest, farther;
+    SGDeclutterStateReset(&nearest);
+    SGDeclutterStateReset(&farther);
+    
+    // Both labels want the same spot; the one placed first keeps it
+    float offsetX, offsetY;
+    int visible;
+    for(int frame = 0; frame <= kSGDeclutterDelay; frame++) {
+        SGDeclutterGridBegin(grid, kScreenWidth, kScreenHeight);
+        SGDeclutterPlace(grid, &nearest, 96.0f, 96.0f, kLabelWidth, kLabelHeight, &offsetX, &offsetY);
+        SGAssertTrue(offsetX == 0.0f && offsetY == 0.0f, "The nearest label moved in frame %i", frame);
+        
+        visible = SGDeclutterPlace(grid, &farther, 96.0f, 96.0f, kLabelWidth, kLabelHeight, &offsetX, &offsetY);
+        SGAssertTrue(visible, "The farther label was hidden in frame %i", frame);
+        
+        // A new collision is sat out before the label gives up its spot
+        if(frame < kSGDeclutterDelay)
+            SGAssertTrue(offsetY == 0.0f && !grid->moved, "The farther label moved after %i frames", frame + 1);
+    }
+    
+    SGAssertTrue(offsetX == 0.0f && offsetY == -kLabelHeight, "The farther label should be lifted by its height, not (%g, %g)",
+                 offsetX, offsetY);
+    SGAssertTrue(grid->placed == 2 && grid->moved == 1 && grid->hidden == 0, "Expected 2 placed, 1 moved and 0 hidden, got %i, %i and %i",
+                 grid->placed, grid->moved, grid->hidden);
+    
+    SGDeclutterGridFree(grid);
+}
+
+static void testHysteresis(void) {
+    SGDeclutterGrid* grid = SGDeclutterGridNew(kScreenWidth, kScreenHeight, kCellSize);
+    SGDeclutterState state;
+    SGDeclutterStateReset(&state);
+    state.placement = 2;
+    
+    // A placement that is no longer needed is kept for kSGDeclutterDelay frames
+    float offsetX, offsetY;
+    int frames = 0;
+    do {
+        SGDeclutterGridBegin(grid, kScreenWidth, kScreenHeight);
+        SGDeclutterPlace(grid, &state, 96.0f, 96.0f, kLabelWidth, kLabelHeight, &offsetX, &offsetY);
+        frames++;
+    } while(offsetY != 0.0f && frames < 100);
+    
+    SGAssertTrue(frames == kSGDeclutterDelay + 1, "The label returned after %i frames", frames);
+    
+    // A collision that goes away before the delay is over is ignored, and the count starts over
+    SGDeclutterState blocker;
+    SGDeclutterStateReset(&blocker);
+    for(int round = 0; round < 3; round++)
+        for(int frame = 0; frame < kSGDeclutterDelay; frame++) {
+            SGDeclutterGridBegin(grid, kScreenWidth, kScreenHeight);
+            if(frame < kSGDeclutterDelay - 1)
+                SGDeclutterPlace(grid, &blocker, 96.0f, 96.0f, kLabelWidth, kLabelHeight, &offsetX, &offsetY);
+            
+            SGDeclutterPlace(grid, &state, 96.0f, 96.0f, kLabelWidth, kLabelHeight, &offsetX, &offsetY);
+            SGAssertTrue(offsetY == 0.0f && !grid->moved, "A label flickered in round %i, frame %i", round, frame);
+        }
+    
+    SGDeclutterGridFree(grid);
+}
+
+static void testHidden(void) {
+    SGDeclutterGrid* grid = SGDeclutterGridNew(kScreenWidth, kScreenHeight, kCellSize);
+    SGDeclutterState background, label;
+    SGDeclutterStateReset(&background);
+    SGDeclutterStateReset(&label);
+    
+    // Every position on screen is taken. The lifted positions of a label at
+    // the top edge are off screen, which does not make them free.
+    float offsetX, offsetY;
+    int visible = 1;
+    for(int frame = 0; frame <= kSGDeclutterDelay; frame++) {
+        SGDeclutterGridBegin(grid, kScreenWidth, kScreenHeight);
+        SGDeclutterPlace(grid, &background, 0.0f, 0.0f, kScreenWidth, kScreenHeight, &offsetX, &offsetY);
+        visible = SGDeclutterPlace(grid, &label, 96.0f, 0.0f, kLabelWidth, kLabelHeight, &offsetX, &offsetY);
+    }
+    
+    SGAssertTrue(!visible && label.placement == kSGDeclutterHidden, "A label was pushed out of view instead of being hidden");
+    SGAssertTrue(grid->hidden == 1 && grid->moved == 0, "Expected 1 hidden and 0 moved, got %i and %i", grid->hidden, grid->moved);
+    
+    // A placement that was held on to is hidden once it leaves the screen
+    SGDeclutterStateReset(&label);
+    label.placement = 2;
+    SGDeclutterGridBegin(grid, kScreenWidth, kScreenHeight);
+    visible = SGDeclutterPlace(grid, &label, 96.0f, 0.0f, kLabelWidth, kLabelHeight, &offsetX, &offsetY);
+    SGAssertTrue(!visible && grid->moved == 0, "A label was kept out of view");
+    
+    SGDeclutterGridFree(grid);
+}
+
+static void testOffScreen(void) {
+    SGDeclutterGrid* grid = SGDeclutterGridNew(kScreenWidth, kScreenHeight, kCellSize);
+    SGDeclutterState offScreen, onScreen;
+    SGDeclutterStateReset(&offScreen);
+    SGDeclutterStateReset(&onScreen);
+    
+    // A label that is off screen stays where it is and takes no room
+    float offsetX, offsetY;
+    SGDeclutterGridBegin(grid, kScreenWidth, kScreenHeight);
+    int visible = SGDeclutterPlace(grid, &offScreen, -200.0f, 96.0f, kLabelWidth, kLabelHeight, &offsetX, &offsetY);
+    SGAssertTrue(visible && offsetX == 0.0f && offsetY == 0.0f, "A label off screen should not be moved");
+    
+    SGDeclutterPlace(grid, &onScreen, 0.0f, 96.0f, kLabelWidth, kLabelHeight, &offsetX, &offsetY);
+    SGAssertTrue(grid->placed == 2 && grid->moved == 0 && grid->hidden == 0, "Expected 2 placed and none moved or hidden, got %i, %i and %i",
+                 grid->placed, grid->moved, grid->hidden);
+    
+    // The grid follows the viewport
+    SGDeclutterGridBegin(grid, kScreenHeight, kScreenWidth);
+    SGAssertTrue(grid->columns == (int)(kScreenHeight / kCellSize) && grid->rows == (int)(kScreenWidth / kCellSize),
+                 "The grid was not resized to the viewport");
+    SGAssertTrue(grid->placed == 0 && grid->moved == 0 && grid->hidden == 0, "A new pass should start its counts over");
+    
+    SGDeclutterGridFree(grid);
+}
+
+int main(int argc, char** argv) {
+    testNearestFirst();
+    testHysteresis();
+    testHidden();
+    testOffScreen();
+    
+    return SGTestResult();
+}
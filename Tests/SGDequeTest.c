@@ -0,0 +1,138 @@
+//
+//  SGDequeTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGDeque.h"
+
+#import <stdlib.h>
+#import <string.h>
+
+#define kAmountOfOperations     20000
+#define kMaximumCount           1000
+
+/* a plain array that the deque is checked against */
+static long model[kMaximumCount * 2];
+static int modelCount = 0;
+
+static void* item(long value) {
+    return (void*)value;
+}
+
+static int matchesModel(const SGDeque* deque) {
+    if(deque->count != modelCount)
+        return 0;
+    
+    for(int i = 0; i < modelCount; i++)
+        if(SGDequeGet(deque, i) != item(model[i]))
+            return 0;
+    
+    // The runs cover every item in order
+    void** run;
+    int length, index = 0;
+    while((length = SGDequeRun(deque, index, &run)))
+        for(int i = 0; i < length; i++, index++)
+            if(run[i] != item(model[index]))
+                return 0;
+    
+    return index == modelCount;
+}
+
+int main(int argc, char** argv) {
+    SGDeque* deque = SGDequeNew();
+    
+    SGAssertTrue(SGDequePopFront(deque) == NULL && SGDequePopBack(deque) == NULL, "An empty deque should pop NULL");
+    
+    // The front is popped in the order that the back was pushed
+    for(long i = 1; i <= 100; i++)
+        SGDequePushBack(deque, item(i));
+    for(long i = 1; i <= 100; i++) {
+        void* popped = SGDequePopFront(deque);
+        SGAssertTrue(popped == item(i), "Expected %ld from the front, got %ld", i, (long)popped);
+    }
+    SGAssertTrue(deque->count == 0, "Expected the deque to be empty");
+    
+    // Random operations at both ends and in the middle, wrapping around and growing the buffer
+    srand(7);
+    long next = 1;
+    int mismatches = 0;
+    for(int operation = 0; operation < kAmountOfOperations; operation++) {
+        int choice = rand() % 100;
+        if(choice < 30 && modelCount < kMaximumCount) {
+            SGDequePushBack(deque, item(next));
+            model[modelCount++] = next++;
+        } else if(choice < 55 && modelCount < kMaximumCount) {
+            SGDequePushFront(deque, item(next));
+            memmove(model + 1, model, sizeof(long) * modelCount);
+            model[0] = next++;
+            modelCount++;
+        } else if(choice < 70) {
+            void* popped = SGDequePopBack(deque);
+            void* expected = modelCount ? item(model[--modelCount]) : NULL;
+            if(popped != expected)
+                mismatches++;
+        } else if(choice < 85) {
+            void* popped = SGDequePopFront(deque);
+            void* expected = NULL;
+            if(modelCount) {
+                expected = item(model[0]);
+                memmove(model, model + 1, sizeof(long) * --modelCount);
+            }
+            if(popped != expected)
+                mismatches++;
+        } else if(choice < 99) {
+            if(modelCount) {
+                int index = rand() % modelCount;
+                if(SGDequeIndexOf(deque, item(model[index])) != index)
+                    mismatches++;
+                
+                SGDequeRemoveAt(deque, index);
+                memmove(model + index, model + index + 1, sizeof(long) * (modelCount - index - 1));
+                modelCount--;
+            }
+        } else {
+            SGDequeClear(deque);
+            modelCount = 0;
+        }
+        
+        if(!matchesModel(deque))
+            mismatches++;
+    }
+    
+    SGAssertTrue(mismatches == 0, "%d operations did not match the model", mismatches);
+    SGAssertTrue(SGDequeIndexOf(deque, item(next)) == -1, "An item that was never pushed should not be found");
+    
+    SGDequeFree(deque);
+    
+    return SGTestResult();
+}
@@ -0,0 +1,162 @@
+//
+//  SGFastTrigBenchmark.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGFastTrig.h"
+
+#import <stdio.h>
+#import <stdlib.h>
+#import <math.h>
+#import <time.h>
+
+#define kCount          4096
+#define kRounds         500
+
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static void report(const char* name, double seconds, double baseline) {
+    double nanoseconds = seconds * 1e9 / ((double)kCount * kRounds);
+    printf("%-28s %6.2f ns/element %6.1fx\n", name, nanoseconds, baseline / seconds);
+}
+
+int main(int argc, char** argv) {
+    static float angles[kCount], x[kCount], y[kCount];
+    static float sines[kCount], cosines[kCount], results[kCount];
+    static double doubleSines[kCount], doubleCosines[kCount], doubleResults[kCount];
+    static const char* tiers[] = { "low", "medium", "high" };
+    char name[64];
+    double start, baseline, checksum = 0.0;
+    int round, i, tier;
+    
+    srand(3);
+    for(i = 0; i < kCount; i++) {
+        angles[i] = ((float)rand() / RAND_MAX - 0.5f) * 4.0f * M_PI;
+        x[i] = (float)rand() / RAND_MAX - 0.5f;
+        y[i] = (float)rand() / RAND_MAX - 0.5f;
+    }
+    
+    start = now();
+    for(round = 0; round < kRounds; round++) {
+        for(i = 0; i < kCount; i++) {
+            doubleSines[i] = sin(angles[i]);
+            doubleCosines[i] = cos(angles[i]);
+        }
+        checksum += doubleSines[round % kCount] + doubleCosines[round % kCount];
+    }
+    baseline = now() - start;
+    report("sin + cos (double)", baseline, baseline);
+    
+    start = now();
+    for(round = 0; round < kRounds; round++) {
+        for(i = 0; i < kCount; i++) {
+            sines[i] = sinf(angles[i]);
+            cosines[i] = cosf(angles[i]);
+        }
+        checksum += sines[round % kCount] + cosines[round % kCount];
+    }
+    report("sinf + cosf", now() - start, baseline);
+    
+    for(tier = kSGTrigAccuracy_Low; tier <= kSGTrigAccuracy_High; tier++) {
+        start = now();
+        for(round = 0; round < kRounds; round++) {
+            SGFastSinCosArray(angles, sines, cosines, kCount, tier);
+            checksum += sines[round % kCount] + cosines[round % kCount];
+        }
+        sprintf(name, "SGFastSinCosArray %s", tiers[tier]);
+        report(name, now() - start, baseline);
+        
+        start = now();
+        for(round = 0; round < kRounds; round++) {
+            for(i = 0; i < kCount; i++)
+                SGFastSinCos(angles[i], &sines[i], &cosines[i], tier);
+            checksum += sines[round % kCount];
+        }
+        sprintf(name, "SGFastSinCos %s", tiers[tier]);
+        report(name, now() - start, baseline);
+    }
+    
+    start = now();
+    for(round = 0; round < kRounds; round++) {
+        for(i = 0; i < kCount; i++)
+            doubleResults[i] = atan2(y[i], x[i]);
+        checksum += doubleResults[round % kCount];
+    }
+    baseline = now() - start;
+    report("atan2 (double)", baseline, baseline);
+    
+    start = now();
+    for(round = 0; round < kRounds; round++) {
+        for(i = 0; i < kCount; i++)
+            results[i] = atan2f(y[i], x[i]);
+        checksum += results[round % kCount];
+    }
+    report("atan2f", now() - start, baseline);
+    
+    for(tier = kSGTrigAccuracy_Low; tier <= kSGTrigAccuracy_High; tier++) {
+        start = now();
+        for(round = 0; round < kRounds; round++) {
+            SGFastAtan2Array(y, x, results, kCount, tier);
+            checksum += results[round % kCount];
+        }
+        sprintf(name, "SGFastAtan2Array %s", tiers[tier]);
+        report(name, now() - start, baseline);
+    }
+    
+    start = now();
+    for(round = 0; round < kRounds; round++) {
+        for(i = 0; i < kCount; i++)
+            doubleResults[i] = asin(x[i]);
+        checksum += doubleResults[round % kCount];
+    }
+    baseline = now() - start;
+    report("asin (double)", baseline, baseline);
+    
+    for(tier = kSGTrigAccuracy_Low; tier <= kSGTrigAccuracy_High; tier++) {
+        start = now();
+        for(round = 0; round < kRounds; round++) {
+            for(i = 0; i < kCount; i++)
+                results[i] = SGFastAsin(x[i], tier);
+            checksum += results[round % kCount];
+        }
+        sprintf(name, "SGFastAsin %s", tiers[tier]);
+        report(name, now() - start, baseline);
+    }
+    
+    printf("[%d]\n", checksum != 0.0);
+    
+    return 0;
+}
@@ -0,0 +1,192 @@
+//
+//  SGFastTrigTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGFastTrig.h"
+
+#import <stdlib.h>
+
+#define kSamples        200000
+
+static const SGTrigAccuracy kTiers[] = { kSGTrigAccuracy_Low, kSGTrigAccuracy_Medium, kSGTrigAccuracy_High };
+static const char* kTierNames[] = { "low", "medium", "high" };
+
+static double angleDifference(double a, double b) {
+    double difference = fabs(a - b);
+    return difference > M_PI ? 2.0 * M_PI - difference : difference;
+}
+
+/* the bearing in degrees from one coordinate to another, without the cancellation of the textbook formula */
+static double bearing(double latitude1, double longitude1, double latitude2, double longitude2, SGTrigAccuracy accuracy) {
+    float sinLat1, cosLat1, sinLat2, cosLat2, sinHalfLat, cosHalfLat, sinHalfLon, cosHalfLon;
+    SGFastSinCos(latitude1 * M_PI / 180.0, &sinLat1, &cosLat1, accuracy);
+    SGFastSinCos(latitude2 * M_PI / 180.0, &sinLat2, &cosLat2, accuracy);
+    SGFastSinCos((latitude2 - latitude1) * M_PI / 360.0, &sinHalfLat, &cosHalfLat, accuracy);
+    SGFastSinCos((longitude2 - longitude1) * M_PI / 360.0, &sinHalfLon, &cosHalfLon, accuracy);
+    
+    float y = 2.0f * sinHalfLon * cosHalfLon * cosLat2;
+    float x = 2.0f * sinHalfLat * cosHalfLat + 2.0f * sinLat1 * cosLat2 * sinHalfLon * sinHalfLon;
+    double degrees = SGFastAtan2(y, x, accuracy) * 180.0 / M_PI;
+    
+    return degrees < 0.0 ? degrees + 360.0 : degrees;
+}
+
+static void testSinCos(void) {
+    float sine, cosine;
+    double angle, error;
+    for(int tier = 0; tier < 3; tier++) {
+        double maximum = 0.0;
+        for(int i = 0; i <= kSamples; i++) {
+            // Densely around the circle and sparsely out to 10^4 radians
+            angle = -100.0 * M_PI + 200.0 * M_PI * i / kSamples;
+            SGFastSinCos(angle, &sine, &cosine, kTiers[tier]);
+            error = fmax(fabs(sine - sin((float)angle)), fabs(cosine - cos((float)angle)));
+            maximum = fmax(maximum, error);
+            
+            angle = -1.0e4 + 2.0e4 * i / kSamples;
+            SGFastSinCos(angle, &sine, &cosine, kTiers[tier]);
+            error = fmax(fabs(sine - sin((float)angle)), fabs(cosine - cos((float)angle)));
+            maximum = fmax(maximum, error);
+        }
+        
+        printf("sincos %-6s max error %.3e\n", kTierNames[tier], maximum);
+        SGAssertTrue(maximum <= SGTrigMaximumError(kTiers[tier]), "sincos %s error %e is above the published bound",
+                     kTierNames[tier], maximum);
+    }
+}
+
+static void testAtan2(void) {
+    double angle, error;
+    float radius;
+    for(int tier = 0; tier < 3; tier++) {
+        double maximum = 0.0;
+        for(int i = 0; i <= kSamples; i++) {
+            angle = -M_PI + 2.0 * M_PI * i / kSamples;
+            radius = (i % 7) ? 1.0f + (i % 1000) : 1.0e-3f;
+            float x = radius * cos(angle);
+            float y = radius * sin(angle);
+            error = angleDifference(SGFastAtan2(y, x, kTiers[tier]), atan2(y, x));
+            maximum = fmax(maximum, error);
+        }
+        
+        printf("atan2  %-6s max error %.3e\n", kTierNames[tier], maximum);
+        SGAssertTrue(maximum <= SGTrigMaximumError(kTiers[tier]), "atan2 %s error %e is above the published bound",
+                     kTierNames[tier], maximum);
+        
+        SGAssertEqualsWithAccuracy(SGFastAtan2(0.0f, 1.0f, kTiers[tier]), 0.0, 1e-7, "atan2(0, 1) should be 0");
+        SGAssertEqualsWithAccuracy(SGFastAtan2(0.0f, -1.0f, kTiers[tier]), M_PI, 1e-6, "atan2(0, -1) should be pi");
+        SGAssertEqualsWithAccuracy(SGFastAtan2(1.0f, 0.0f, kTiers[tier]), M_PI / 2.0, 1e-6, "atan2(1, 0) should be pi/2");
+        SGAssertEqualsWithAccuracy(SGFastAtan2(0.0f, 0.0f, kTiers[tier]), 0.0, 1e-7, "atan2(0, 0) should be 0");
+    }
+}
+
+static void testAsin(void) {
+    float x;
+    for(int tier = 0; tier < 3; tier++) {
+        double maximum = 0.0;
+        for(int i = 0; i <= kSamples; i++) {
+            x = -1.0f + 2.0f * i / kSamples;
+            maximum = fmax(maximum, fabs(SGFastAsin(x, kTiers[tier]) - asin(x)));
+        }
+        
+        printf("asin   %-6s max error %.3e\n", kTierNames[tier], maximum);
+        SGAssertTrue(maximum <= SGTrigMaximumError(kTiers[tier]), "asin %s error %e is above the published bound",
+                     kTierNames[tier], maximum);
+        
+        // Small arguments keep their relative precision, which distances rely on
+        SGAssertEqualsWithAccuracy(SGFastAsin(1.0e-6f, kTiers[tier]) / 1.0e-6, 1.0, 1e-2, "asin should be x for small x");
+    }
+}
+
+static void testArrays(void) {
+    float angles[257], x[257], y[257];
+    float sines[257], cosines[257], results[257];
+    float sine, cosine;
+    for(int i = 0; i < 257; i++) {
+        angles[i] = -20.0f + 0.17f * i;
+        x[i] = cosf(angles[i]) * (i + 1);
+        y[i] = sinf(angles[i]) * (i + 1);
+    }
+    
+    for(int tier = 0; tier < 3; tier++) {
+        int matches = 1;
+        SGFastSinCosArray(angles, sines, cosines, 257, kTiers[tier]);
+        SGFastAtan2Array(y, x, results, 257, kTiers[tier]);
+        for(int i = 0; i < 257; i++) {
+            SGFastSinCos(angles[i], &sine, &cosine, kTiers[tier]);
+            if(sine != sines[i] || cosine != cosines[i] || results[i] != SGFastAtan2(y[i], x[i], kTiers[tier]))
+                matches = 0;
+        }
+        
+        SGAssertTrue(matches, "The %s array functions should match the scalar ones", kTierNames[tier]);
+    }
+}
+
+static void testBearings(void) {
+    // The values of SGBearingTest. The bearing between the two poles is left
+    // out; every direction points north from the south pole.
+    static const double tolerance[] = { 0.1, 2.0e-3, 1.0e-4 };
+    for(int tier = 0; tier < 3; tier++) {
+        double value = bearing(0.0, 0.0, 90.0, 0.0, kTiers[tier]);
+        SGAssertEqualsWithAccuracy(value, 0.0, tolerance[tier], "%s: bearing should be 0.0 but was %f", kTierNames[tier], value);
+        
+        value = bearing(90.0, 0.0, 0.0, 0.0, kTiers[tier]);
+        SGAssertEqualsWithAccuracy(value, 180.0, tolerance[tier], "%s: bearing should be 180.0 but was %f", kTierNames[tier], value);
+        
+        value = bearing(37.77, -122.40, 10.0, 10.0, kTiers[tier]);
+        SGAssertEqualsWithAccuracy(value, 53.20235, tolerance[tier], "%s: bearing should be 53.20235 but was %f", kTierNames[tier], value);
+        
+        value = bearing(37.77, -122.40, -40.0, 20.0, kTiers[tier]);
+        SGAssertEqualsWithAccuracy(value, 106.26513, tolerance[tier], "%s: bearing should be 106.26513 but was %f", kTierNames[tier], value);
+        
+        // A block away, where the textbook formula loses most of its digits in single precision
+        value = bearing(37.7749, -122.4194, 37.7758, -122.4183, kTiers[tier]);
+        double expected = atan2(sin((-122.4183 + 122.4194) * M_PI / 180.0) * cos(37.7758 * M_PI / 180.0),
+                                cos(37.7749 * M_PI / 180.0) * sin(37.7758 * M_PI / 180.0) -
+                                sin(37.7749 * M_PI / 180.0) * cos(37.7758 * M_PI / 180.0) * cos((-122.4183 + 122.4194) * M_PI / 180.0));
+        expected *= 180.0 / M_PI;
+        SGAssertEqualsWithAccuracy(value, expected, tolerance[tier] * 10.0, "%s: bearing should be %f but was %f",
+                                   kTierNames[tier], expected, value);
+    }
+}
+
+int main(int argc, char** argv) {
+    testSinCos();
+    testAtan2();
+    testAsin();
+    testArrays();
+    testBearings();
+    
+    return SGTestResult();
+}
@@ -0,0 +1,169 @@
+//
+//  SGGLStateTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import "SGCTest.h"
+#import "SGGLState.h"
+
+/* the values of the OpenGL ES headers */
+#define GL_TEXTURE_2D               0x0DE1
+#define GL_BLEND                    0x0BE2
+#define GL_VERTEX_ARRAY             0x8074
+#define GL_TEXTURE_COORD_ARRAY      0x8078
+#define GL_TRIANGLE_STRIP           0x0005
+
+/* what reached the fake driver */
+static int enables, disables, clientEnables, clientDisables, binds, draws;
+static unsigned int lastTexture;
+
+static void fakeEnable(unsigned int capability) { enables++; }
+static void fakeDisable(unsigned int capability) { disables++; }
+static void fakeEnableClientState(unsigned int array) { clientEnables++; }
+static void fakeDisableClientState(unsigned int array) { clientDisables++; }
+static void fakeBindTexture(unsigned int target, unsigned int texture) { binds++; lastTexture = texture; }
+static void fakeDrawArrays(unsigned int mode, int first, int count) { draws++; }
+
+static const SGGLFunctions fakeFunctions = {
+    fakeEnable, fakeDisable, fakeEnableClientState, fakeDisableClientState, fakeBindTexture, fakeDrawArrays
+};
+
+static void resetDriver(void) {
+    enables = disables = clientEnables = clientDisables = binds = draws = 0;
+}
+
+static void testSkipping(void) {
+    SGGLStateContextCreated(&fakeFunctions);
+    resetDriver();
+    SGGLStateBeginFrame();
+    
+    // The billboard loop asks for texturing around every annotation
+    for(int i = 0; i < 10; i++) {
+        SGGLStateEnable(GL_TEXTURE_2D);
+        SGGLStateEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        SGGLStateBindTexture(GL_TEXTURE_2D, 1 + i % 2);
+        SGGLStateDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    
+    SGGLStateDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    SGGLStateDisable(GL_TEXTURE_2D);
+    SGGLStateDisable(GL_TEXTURE_2D);
+    
+    SGGLCounts counts = SGGLStateEndFrame();
+    
+    SGAssertTrue(enables == 1 && clientEnables == 1, "texturing was enabled %i and %i times", enables, clientEnables);
+    SGAssertTrue(disables == 1 && clientDisables == 1, "texturing was disabled %i and %i times", disables, clientDisables);
+    SGAssertTrue(binds == 10 && draws == 10, "%i binds and %i draws reached the driver", binds, draws);
+    SGAssertTrue(counts.binds == 10, "expected 10 binds, got %u", counts.binds);
+    SGAssertTrue(counts.stateChanges == 4, "expected 4 state changes, got %u", counts.stateChanges);
+    SGAssertTrue(counts.drawCalls == 10, "expected 10 draw calls, got %u", counts.drawCalls);
+    SGAssertTrue(counts.skipped == 19, "expected 19 skipped calls, got %u", counts.skipped);
+    
+    // The same texture is bound once
+    resetDriver();
+    SGGLStateBindTexture(GL_TEXTURE_2D, 3);
+    SGGLStateBindTexture(GL_TEXTURE_2D, 3);
+    SGAssertTrue(binds == 1 && lastTexture == 3, "the same texture was bound %i times", binds);
+    
+    // Deleting the bound texture leaves nothing bound
+    SGGLStateDeleteTexture(3);
+    SGGLStateBindTexture(GL_TEXTURE_2D, 0);
+    SGGLStateBindTexture(GL_TEXTURE_2D, 3);
+    SGAssertTrue(binds == 2 && lastTexture == 3, "a deleted texture was assumed to be bound");
+    
+    // Deleting another texture does not
+    SGGLStateDeleteTexture(4);
+    SGGLStateBindTexture(GL_TEXTURE_2D, 3);
+    SGAssertTrue(binds == 2, "deleting an unbound texture forgot the binding");
+}
+
+static void testInvalidate(void) {
+    SGGLStateContextCreated(&fakeFunctions);
+    SGGLStateEnable(GL_BLEND);
+    SGGLStateEnableClientState(GL_VERTEX_ARRAY);
+    SGGLStateBindTexture(GL_TEXTURE_2D, 5);
+    
+    // Calls that did not go through the tracker may have changed anything
+    SGGLStateInvalidate();
+    resetDriver();
+    SGGLStateEnable(GL_BLEND);
+    SGGLStateEnableClientState(GL_VERTEX_ARRAY);
+    SGGLStateBindTexture(GL_TEXTURE_2D, 5);
+    SGAssertTrue(enables == 1 && clientEnables == 1 && binds == 1, "state was trusted after it was invalidated");
+    
+    resetDriver();
+    SGGLStateEnable(GL_BLEND);
+    SGAssertTrue(enables == 0, "state was not learned again after it was invalidated");
+}
+
+static void testGenerations(void) {
+    unsigned int generation = SGGLStateGeneration();
+    
+    SGGLStateEnable(GL_BLEND);
+    SGGLStateContextCreated(&fakeFunctions);
+    SGAssertTrue(SGGLStateGeneration() == generation + 1, "a new context did not start a new generation");
+    
+    // A new context starts from the defaults which the tracker does not assume
+    resetDriver();
+    SGGLStateEnable(GL_BLEND);
+    SGAssertTrue(enables == 1, "the state of the old context was trusted");
+}
+
+static void testCapacity(void) {
+    SGGLStateContextCreated(&fakeFunctions);
+    
+    // Capabilities beyond the table are passed through every time
+    for(unsigned int capability = 1; capability <= kSGGLState_MaximumSwitches + 4; capability++)
+        SGGLStateEnable(capability);
+    
+    resetDriver();
+    for(unsigned int capability = 1; capability <= kSGGLState_MaximumSwitches + 4; capability++)
+        SGGLStateEnable(capability);
+    
+    SGAssertTrue(enables > 0 && enables <= 4 + 2, "%i untracked capabilities reached the driver", enables);
+}
+
+int main(int argc, char** argv) {
+    // Nothing reaches a driver before a context was created
+    SGAssertTrue(SGGLStateGeneration() == 0, "a generation began without a context");
+    SGGLStateEnable(GL_BLEND);
+    SGGLStateDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    SGAssertTrue(!enables && !draws, "calls reached a driver before a context was created");
+    
+    testSkipping();
+    testInvalidate();
+    testGenerations();
+    testCapacity();
+    
+    return SGTestResult();
+}
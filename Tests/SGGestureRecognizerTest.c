@@ -0,0 +1,296 @@
+//
+//  SGGestureRecognizerTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGGestureRecognizer.h"
+
+#import <string.h>
+
+/* the UIKit recognizer waited this long after touch down before reporting a single tap */
+#define kTimerTapDelay      0.5
+
+#define kEventRate          60.0
+#define kFrameRate          60.0
+
+static SGGestureRecognizer recognizer;
+
+/* events of every type that the samples fed through addSample produced, with the time of the first one */
+static int eventCounts[kSGGestureEvent_Released + 1];
+static double firstEventTimestamps[kSGGestureEvent_Released + 1];
+
+static void reset(void) {
+    SGGestureRecognizerReset(&recognizer);
+    for(int i = 0; i <= kSGGestureEvent_Released; i++) {
+        eventCounts[i] = 0;
+        firstEventTimestamps[i] = -1.0;
+    }
+}
+
+static void addSample(double timestamp, SGTouchPhase phase, int count, int lifted,
+                      float x0, float y0, float x1, float y1) {
+    SGTouchSample sample;
+    sample.timestamp = timestamp;
+    sample.phase = phase;
+    sample.count = count;
+    sample.lifted = lifted;
+    sample.points[0].x = x0;
+    sample.points[0].y = y0;
+    sample.points[1].x = x1;
+    sample.points[1].y = y1;
+    
+    int amount = SGGestureRecognizerAddSample(&recognizer, &sample);
+    for(int i = 0; i < amount; i++) {
+        SGGestureEventType type = recognizer.events[i].type;
+        if(!eventCounts[type])
+            firstEventTimestamps[type] = recognizer.events[i].timestamp;
+        eventCounts[type]++;
+    }
+}
+
+static void tap(double timestamp, float x, float y) {
+    addSample(timestamp, kSGTouchPhase_Began, 1, 0, x, y, 0.0f, 0.0f);
+    addSample(timestamp + 0.04, kSGTouchPhase_Moved, 1, 0, x + 1.0f, y, 0.0f, 0.0f);
+    addSample(timestamp + 0.08, kSGTouchPhase_Ended, 1, 1, x + 1.0f, y, 0.0f, 0.0f);
+}
+
+/* a single finger moving in a straight line at the event rate */
+static void stroke(double timestamp, double duration, float x, float y, float deltaX, float deltaY) {
+    addSample(timestamp, kSGTouchPhase_Began, 1, 0, x, y, 0.0f, 0.0f);
+    int amount = duration * kEventRate;
+    for(int i = 1; i <= amount; i++)
+        addSample(timestamp + i / kEventRate, kSGTouchPhase_Moved, 1, 0,
+                  x + deltaX * i / amount, y + deltaY * i / amount, 0.0f, 0.0f);
+    addSample(timestamp + duration + 0.02, kSGTouchPhase_Ended, 1, 1, x + deltaX, y + deltaY, 0.0f, 0.0f);
+}
+
+/*
+* two fingers spreading from one distance to another in the given time, with
+* touches delivered at eventRate. The velocity is sampled once per frame for
+* half a second past the end of the movement and the spread that it accounts
+* for is returned.
+*/
+static float pinch(double eventRate, float fromSpread, float toSpread, double duration, double* latency) {
+    double start = 0.1;
+    addSample(0.0, kSGTouchPhase_Began, 2, 0, 160.0f - fromSpread / 2.0f, 240.0f, 160.0f + fromSpread / 2.0f, 240.0f);
+    
+    float integrated = 0.0f;
+    double nextSample = start + 1.0 / eventRate;
+    double frame = 0.0;
+    *latency = -1.0;
+    while(frame < start + duration + 0.5) {
+        while(nextSample <= frame && nextSample <= start + duration + 1.0e-9) {
+            float spread = fromSpread + (toSpread - fromSpread) * (nextSample - start) / duration;
+            addSample(nextSample, kSGTouchPhase_Moved, 2, 0,
+                      160.0f - spread / 2.0f, 240.0f, 160.0f + spread / 2.0f, 240.0f);
+            nextSample += 1.0 / eventRate;
+        }
+        
+        float velocity = SGGestureRecognizerPinchVelocity(&recognizer, frame);
+        if(velocity != 0.0f && *latency < 0.0)
+            *latency = frame - start;
+        
+        integrated += velocity / kFrameRate;
+        frame += 1.0 / kFrameRate;
+    }
+    
+    addSample(frame, kSGTouchPhase_Ended, 2, 2, 160.0f - toSpread / 2.0f, 240.0f, 160.0f + toSpread / 2.0f, 240.0f);
+    SGAssertEqualsWithAccuracy(SGGestureRecognizerPinchVelocity(&recognizer, frame), 0.0, 0.0,
+                               "The pinch should stop once the fingers are lifted");
+    
+    return integrated;
+}
+
+/*
+* a fast drag with touches delivered at eventRate that are queued and handed out
+* once per frame. Returns the amount of drags that were handed out.
+*/
+static int coalescedDrag(double eventRate, int* producedDrags) {
+    SGGestureQueue queue;
+    memset(&queue, 0, sizeof(SGGestureQueue));
+    SGGestureRecognizerReset(&recognizer);
+    
+    SGTouchSample sample;
+    memset(&sample, 0, sizeof(SGTouchSample));
+    sample.count = 1;
+    
+    int deliveredDrags = 0;
+    int dragEnded = 0;
+    *producedDrags = 0;
+    
+    double nextFrame = 1.0 / kFrameRate;
+    int amountOfSamples = 0.5 * eventRate;
+    for(int i = 0; i <= amountOfSamples + 1; i++) {
+        sample.timestamp = i / eventRate;
+        sample.phase = !i ? kSGTouchPhase_Began : i <= amountOfSamples ? kSGTouchPhase_Moved : kSGTouchPhase_Ended;
+        sample.lifted = sample.phase == kSGTouchPhase_Ended;
+        sample.points[0].x = 100.0f + 400.0f * (i < amountOfSamples ? i : amountOfSamples) / amountOfSamples;
+        sample.points[0].y = 100.0f + 300.0f * (i < amountOfSamples ? i : amountOfSamples) / amountOfSamples;
+        
+        int amount = SGGestureRecognizerAddSample(&recognizer, &sample);
+        for(int j = 0; j < amount; j++) {
+            if(recognizer.events[j].type == kSGGestureEvent_Drag)
+                (*producedDrags)++;
+            
+            SGAssertTrue(SGGestureQueueAdd(&queue, &recognizer.events[j]), "The queue should not fill up");
+        }
+        
+        // Hand out the queued events at the start of every frame and after the last touch
+        if(sample.timestamp + 1.0 / eventRate >= nextFrame || sample.phase == kSGTouchPhase_Ended) {
+            int drags = 0;
+            for(int j = 0; j < queue.amountOfEvents; j++) {
+                SGGestureEvent* event = &queue.events[j];
+                if(event->type == kSGGestureEvent_Drag) {
+                    SGAssertTrue(!dragEnded, "A drag was handed out after the drag ended");
+                    SGAssertTrue(event->to.x == sample.points[0].x, "The drag should be at the latest position");
+                    drags++;
+                } else if(event->type == kSGGestureEvent_DragEnded)
+                    dragEnded = 1;
+            }
+            
+            SGAssertTrue(drags <= 1, "Expected at most one drag per frame, got %d", drags);
+            deliveredDrags += drags;
+            SGGestureQueueClear(&queue);
+            nextFrame += 1.0 / kFrameRate;
+        }
+    }
+    
+    SGAssertTrue(dragEnded, "Expected the drag to end");
+    
+    return deliveredDrags;
+}
+
+int main(int argc, char** argv) {
+    // A single tap is reported as soon as the finger is lifted
+    reset();
+    tap(1.0, 100.0f, 100.0f);
+    SGAssertTrue(eventCounts[kSGGestureEvent_SingleTap] == 1, "Expected a single tap");
+    SGAssertTrue(eventCounts[kSGGestureEvent_Released] == 1, "Expected the tap to be released");
+    SGAssertTrue(!eventCounts[kSGGestureEvent_Drag], "A tap should not drag");
+    double singleTapLatency = firstEventTimestamps[kSGGestureEvent_SingleTap] - 1.0;
+    SGAssertTrue(singleTapLatency <= kSGGesture_MaximumTapDuration, "Single tap took %f seconds", singleTapLatency);
+    
+    // The second tap of a double tap rolls back the first one
+    reset();
+    tap(1.0, 100.0f, 100.0f);
+    tap(1.2, 104.0f, 98.0f);
+    SGAssertTrue(eventCounts[kSGGestureEvent_SingleTap] == 1, "Only the first tap should be reported as a single tap");
+    SGAssertTrue(eventCounts[kSGGestureEvent_SingleTapCancelled] == 1, "Expected the single tap to be rolled back");
+    SGAssertTrue(eventCounts[kSGGestureEvent_DoubleTap] == 1, "Expected a double tap");
+    SGAssertTrue(firstEventTimestamps[kSGGestureEvent_SingleTapCancelled] <= firstEventTimestamps[kSGGestureEvent_DoubleTap],
+                 "The rollback should come before the double tap");
+    double doubleTapLatency = firstEventTimestamps[kSGGestureEvent_DoubleTap] - 1.2;
+    SGAssertTrue(doubleTapLatency == 0.0, "Double tap took %f seconds", doubleTapLatency);
+    
+    // Taps that are too far apart in time or space are two single taps
+    reset();
+    tap(1.0, 100.0f, 100.0f);
+    tap(1.6, 100.0f, 100.0f);
+    tap(1.8, 200.0f, 100.0f);
+    SGAssertTrue(eventCounts[kSGGestureEvent_SingleTap] == 3, "Expected three single taps, got %d",
+                 eventCounts[kSGGestureEvent_SingleTap]);
+    SGAssertTrue(!eventCounts[kSGGestureEvent_SingleTapCancelled] && !eventCounts[kSGGestureEvent_DoubleTap],
+                 "Expected no double tap");
+    
+    // A slow stroke drags and is not a tap or a swipe
+    reset();
+    stroke(1.0, 2.0, 100.0f, 100.0f, 200.0f, 0.0f);
+    SGAssertTrue(eventCounts[kSGGestureEvent_Drag] > 0, "Expected a drag");
+    SGAssertTrue(eventCounts[kSGGestureEvent_DragEnded] == 1, "Expected the drag to end");
+    SGAssertTrue(!eventCounts[kSGGestureEvent_SingleTap], "A drag should not tap");
+    SGAssertTrue(!eventCounts[kSGGestureEvent_HorizontalSwipe], "A slow drag should not swipe");
+    
+    // Quick strokes swipe, once, as soon as they are long enough
+    reset();
+    stroke(1.0, 0.15, 100.0f, 100.0f, 200.0f, 5.0f);
+    SGAssertTrue(eventCounts[kSGGestureEvent_HorizontalSwipe] == 1, "Expected a horizontal swipe");
+    SGAssertTrue(!eventCounts[kSGGestureEvent_VerticalSwipe], "Expected no vertical swipe");
+    double swipeLatency = firstEventTimestamps[kSGGestureEvent_HorizontalSwipe] - 1.0;
+    SGAssertTrue(swipeLatency <= 0.15 * kSGGesture_MinimumSwipeLength / 200.0f + 1.0 / kEventRate,
+                 "Swipe took %f seconds", swipeLatency);
+    
+    reset();
+    stroke(1.0, 0.15, 100.0f, 300.0f, -2.0f, -200.0f);
+    SGAssertTrue(eventCounts[kSGGestureEvent_VerticalSwipe] == 1, "Expected a vertical swipe");
+    SGAssertTrue(!eventCounts[kSGGestureEvent_HorizontalSwipe], "Expected no horizontal swipe");
+    
+    // Two fingers that barely move tap
+    reset();
+    addSample(1.0, kSGTouchPhase_Began, 2, 0, 100.0f, 100.0f, 200.0f, 100.0f);
+    addSample(1.05, kSGTouchPhase_Moved, 2, 0, 101.0f, 100.0f, 199.0f, 100.0f);
+    addSample(1.1, kSGTouchPhase_Ended, 2, 1, 101.0f, 100.0f, 199.0f, 100.0f);
+    addSample(1.12, kSGTouchPhase_Ended, 1, 1, 199.0f, 100.0f, 0.0f, 0.0f);
+    SGAssertTrue(eventCounts[kSGGestureEvent_TwoFingerTap] == 1, "Expected a two finger tap");
+    SGAssertTrue(eventCounts[kSGGestureEvent_Released] == 1, "Expected one release once both fingers are lifted");
+    SGAssertTrue(!eventCounts[kSGGestureEvent_Pinch] && !eventCounts[kSGGestureEvent_Pull], "Expected no pinch");
+    
+    // Pinching moves by the same amount no matter how often touches are delivered
+    double latency60, latency120, latencyIn;
+    reset();
+    float spread60 = pinch(60.0, 100.0f, 300.0f, 0.5, &latency60);
+    SGAssertTrue(eventCounts[kSGGestureEvent_Pull] > 0 && !eventCounts[kSGGestureEvent_Pinch], "Expected the fingers to pull");
+    int pulls60 = eventCounts[kSGGestureEvent_Pull];
+    
+    reset();
+    float spread120 = pinch(120.0, 100.0f, 300.0f, 0.5, &latency120);
+    int pulls120 = eventCounts[kSGGestureEvent_Pull];
+    
+    reset();
+    float spreadIn = pinch(60.0, 300.0f, 100.0f, 0.5, &latencyIn);
+    SGAssertTrue(eventCounts[kSGGestureEvent_Pinch] > 0 && !eventCounts[kSGGestureEvent_Pull], "Expected the fingers to pinch");
+    
+    SGAssertEqualsWithAccuracy(spread60, 200.0, 200.0 * 0.15, "Pinch at 60 Hz moved %f pixels", spread60);
+    SGAssertEqualsWithAccuracy(spread120, spread60, spread60 * 0.05, "Pinch at 120 Hz moved %f pixels, at 60 Hz %f",
+                               spread120, spread60);
+    SGAssertEqualsWithAccuracy(spreadIn, -spread60, spread60 * 0.01, "Pinching in moved %f pixels", spreadIn);
+    SGAssertTrue(latency60 >= 0.0 && latency60 <= 0.1, "Pinch took %f seconds to start", latency60);
+    
+    // Touches that arrive faster than frames are drawn only drag once per frame
+    int produced60, produced240;
+    int delivered60 = coalescedDrag(60.0, &produced60);
+    int delivered240 = coalescedDrag(240.0, &produced240);
+    SGAssertTrue(delivered240 <= 0.5 * kFrameRate + 1, "%d drags were handed out in 0.5 seconds", delivered240);
+    
+    printf("single tap      %6.1f ms from touch down (%.1f ms with the timer)\n",
+           singleTapLatency * 1000.0, kTimerTapDelay * 1000.0);
+    printf("double tap      %6.1f ms from the second touch down\n", doubleTapLatency * 1000.0);
+    printf("swipe           %6.1f ms from touch down\n", swipeLatency * 1000.0);
+    printf("pinch           %6.1f ms from the first movement; %.1f px at 60 Hz, %.1f px at 120 Hz "
+           "(%d and %d fixed steps per event before)\n",
+           latency60 * 1000.0, spread60, spread120, pulls60, pulls120);
+    
+    printf("drag            %d of %d events handed out at 60 Hz, %d of %d at 240 Hz\n",
+           delivered60, produced60, delivered240, produced240);
+    
+    return SGTestResult();
+}
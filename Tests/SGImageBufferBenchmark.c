@@ -0,0 +1,188 @@
+//
+//  SGImageBufferBenchmark.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGImageBuffer.h"
+
+#import <stdio.h>
+#import <stdlib.h>
+#import <stdint.h>
+#import <string.h>
+#import <math.h>
+#import <time.h>
+
+#define kWidth          1024
+#define kHeight         768
+#define kRounds         20
+
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static void report(const char* name, double seconds, int pixels, double baseline) {
+    printf("%-38s %8.2f ms %8.1f Mpixel/s", name, seconds * 1e3 / kRounds, (double)pixels * kRounds / seconds / 1e6);
+    if(baseline > 0.0)
+        printf(" %6.1fx", baseline / seconds);
+    printf("\n");
+}
+
+/* bilinear sampling of the nearest four pixels in floating point, which aliases when shrinking */
+static void naiveScale(const SGImageBuffer* source, SGImageBuffer* destination) {
+    float scaleX = (float)source->width / destination->width;
+    float scaleY = (float)source->height / destination->height;
+    float sx, sy, fx, fy;
+    int x0, y0, x1, y1;
+    const unsigned char* row0;
+    const unsigned char* row1;
+    for(int y = 0; y < destination->height; y++) {
+        sy = (y + 0.5f) * scaleY - 0.5f;
+        sy = sy < 0.0f ? 0.0f : sy;
+        y0 = (int)sy;
+        y1 = y0 + 1 < source->height ? y0 + 1 : y0;
+        fy = sy - y0;
+        row0 = SGImageBufferRow(source, y0);
+        row1 = SGImageBufferRow(source, y1);
+        for(int x = 0; x < destination->width; x++) {
+            sx = (x + 0.5f) * scaleX - 0.5f;
+            sx = sx < 0.0f ? 0.0f : sx;
+            x0 = (int)sx;
+            x1 = x0 + 1 < source->width ? x0 + 1 : x0;
+            fx = sx - x0;
+            for(int c = 0; c < 4; c++)
+                SGImageBufferRow(destination, y)[x * 4 + c] = (unsigned char)
+                    ((row0[x0 * 4 + c] * (1.0f - fx) + row0[x1 * 4 + c] * fx) * (1.0f - fy) +
+                     (row1[x0 * 4 + c] * (1.0f - fx) + row1[x1 * 4 + c] * fx) * fy + 0.5f);
+        }
+    }
+}
+
+/* a quarter turn to the left, reading the source down its columns */
+static void naiveRotate(const SGImageBuffer* source, SGImageBuffer* destination) {
+    const uint32_t* pixels = (const uint32_t*)source->pixels;
+    long stride = source->bytesPerRow / 4;
+    uint32_t* output;
+    for(int y = 0; y < destination->height; y++) {
+        output = (uint32_t*)SGImageBufferRow(destination, y);
+        for(int x = 0; x < destination->width; x++)
+            output[x] = pixels[x * stride + source->width - 1 - y];
+    }
+}
+
+int main(int argc, char** argv) {
+    static const char* filters[] = { "box", "bilinear", "lanczos" };
+    static const char* orientations[] = { "up", "down", "left", "right", "up mirrored", "down mirrored", "left mirrored", "right mirrored" };
+    static const int sizes[][2] = { { 256, 192 }, { 2048, 1536 } };
+    SGImageBuffer* source = SGImageBufferNew(kWidth, kHeight);
+    SGImageBuffer* destination;
+    char name[64];
+    double start, baseline;
+    int round, checksum = 0;
+    
+    srand(3);
+    for(int y = 0; y < kHeight; y++)
+        for(int x = 0; x < kWidth * 4; x++)
+            SGImageBufferRow(source, y)[x] = rand();
+    
+    for(int s = 0; s < 2; s++) {
+        destination = SGImageBufferNew(sizes[s][0], sizes[s][1]);
+        
+        start = now();
+        for(round = 0; round < kRounds; round++) {
+            naiveScale(source, destination);
+            checksum += destination->pixels[round];
+        }
+        baseline = now() - start;
+        sprintf(name, "point sampled bilinear to %dx%d", sizes[s][0], sizes[s][1]);
+        report(name, baseline, sizes[s][0] * sizes[s][1], baseline);
+        
+        for(int filter = kSGImageFilter_Box; filter <= kSGImageFilter_Lanczos; filter++) {
+            start = now();
+            for(round = 0; round < kRounds; round++) {
+                SGImageBufferScale(source, destination, filter);
+                checksum += destination->pixels[round];
+            }
+            sprintf(name, "%s to %dx%d", filters[filter], sizes[s][0], sizes[s][1]);
+            report(name, now() - start, sizes[s][0] * sizes[s][1], baseline);
+        }
+        
+        SGImageBufferFree(destination);
+    }
+    
+    destination = SGImageBufferNew(kHeight, kWidth);
+    start = now();
+    for(round = 0; round < kRounds; round++) {
+        naiveRotate(source, destination);
+        checksum += destination->pixels[round];
+    }
+    baseline = now() - start;
+    report("naive left", baseline, kWidth * kHeight, baseline);
+    SGImageBufferFree(destination);
+    
+    for(int orientation = kSGImageOrientation_Down; orientation <= kSGImageOrientation_RightMirrored; orientation++) {
+        int swapped = orientation == kSGImageOrientation_Left || orientation == kSGImageOrientation_Right ||
+                      orientation == kSGImageOrientation_LeftMirrored || orientation == kSGImageOrientation_RightMirrored;
+        destination = swapped ? SGImageBufferNew(kHeight, kWidth) : SGImageBufferNew(kWidth, kHeight);
+        
+        start = now();
+        for(round = 0; round < kRounds; round++) {
+            SGImageBufferTransform(source, destination, orientation);
+            checksum += destination->pixels[round];
+        }
+        report(orientations[orientation], now() - start, kWidth * kHeight, baseline);
+        
+        SGImageBufferFree(destination);
+    }
+    
+    destination = SGImageBufferNew(kWidth, kHeight + kHeight / 4);
+    start = now();
+    for(round = 0; round < kRounds; round++) {
+        SGImageBufferReflect(source, destination);
+        checksum += destination->pixels[round];
+    }
+    report("reflection of a quarter", now() - start, kWidth * (kHeight + kHeight / 4), 0.0);
+    
+    start = now();
+    for(round = 0; round < kRounds; round++) {
+        SGImageBufferRoundCorners(destination, 24.0f, 24.0f);
+        checksum += destination->pixels[round];
+    }
+    report("rounded corners", now() - start, kWidth * (kHeight + kHeight / 4), 0.0);
+    SGImageBufferFree(destination);
+    
+    SGImageBufferFree(source);
+    printf("[%d]\n", checksum != 0);
+    
+    return 0;
+}
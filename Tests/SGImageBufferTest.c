@@ -0,0 +1,312 @@
+//
+//  SGImageBufferTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGImageBuffer.h"
+
+#import <stdint.h>
+#import <string.h>
+
+static uint32_t pixelAt(const SGImageBuffer* buffer, int x, int y) {
+    uint32_t pixel;
+    memcpy(&pixel, SGImageBufferRow(buffer, y) + x * 4, 4);
+    
+    return pixel;
+}
+
+/* premultiplied pixels with every channel below alpha */
+static SGImageBuffer* randomImage(int width, int height) {
+    SGImageBuffer* buffer = SGImageBufferNew(width, height);
+    unsigned char* pixel;
+    for(int y = 0; y < height; y++)
+        for(int x = 0; x < width; x++) {
+            pixel = SGImageBufferRow(buffer, y) + x * 4;
+            pixel[3] = rand() % 256;
+            for(int c = 0; c < 3; c++)
+                pixel[c] = pixel[3] ? rand() % (pixel[3] + 1) : 0;
+        }
+    
+    return buffer;
+}
+
+/* the image with an independent, floating point implementation of the filters */
+static double referenceWeight(SGImageFilter filter, double x) {
+    switch(filter) {
+        case kSGImageFilter_Bilinear:
+            return fabs(x) < 1.0 ? 1.0 - fabs(x) : 0.0;
+        case kSGImageFilter_Lanczos:
+            if(x == 0.0)
+                return 1.0;
+            return fabs(x) < 3.0 ? 3.0 * sin(M_PI * x) * sin(M_PI * x / 3.0) / (M_PI * M_PI * x * x) : 0.0;
+        default:
+            return x > -0.5 && x <= 0.5 ? 1.0 : 0.0;
+    }
+}
+
+static void referenceAxis(int inputLength, int outputLength, int i, SGImageFilter filter, double* weights) {
+    static const double supports[] = { 0.5, 1.0, 3.0 };
+    double scale = (double)inputLength / outputLength;
+    double filterScale = scale > 1.0 ? scale : 1.0;
+    double center = (i + 0.5) * scale;
+    double sum = 0.0;
+    for(int k = 0; k < inputLength; k++) {
+        weights[k] = 0.0;
+        if(fabs(k + 0.5 - center) < supports[filter] * filterScale + 0.5)
+            weights[k] = referenceWeight(filter, (k + 0.5 - center) / filterScale);
+        sum += weights[k];
+    }
+    
+    for(int k = 0; k < inputLength; k++)
+        weights[k] /= sum;
+}
+
+static double clampChannel(double value) {
+    value = floor(value + 0.5);
+    return value < 0.0 ? 0.0 : (value > 255.0 ? 255.0 : value);
+}
+
+/* one axis is filtered and rounded to bytes before the other, like the two passes of the library */
+static int scaleErrorInOrder(const SGImageBuffer* source, const SGImageBuffer* scaled, SGImageFilter filter, int rowsFirst) {
+    int width = rowsFirst ? scaled->width : source->width;
+    int height = rowsFirst ? source->height : scaled->height;
+    double* xWeights = (double*)malloc(sizeof(double) * source->width);
+    double* yWeights = (double*)malloc(sizeof(double) * source->height);
+    double* intermediate = (double*)malloc(sizeof(double) * width * height * 4);
+    double value;
+    int error = 0, difference;
+    for(int y = 0; y < height; y++)
+        for(int x = 0; x < width; x++) {
+            if(rowsFirst)
+                referenceAxis(source->width, scaled->width, x, filter, xWeights);
+            else
+                referenceAxis(source->height, scaled->height, y, filter, yWeights);
+            
+            for(int c = 0; c < 4; c++) {
+                value = 0.0;
+                if(rowsFirst)
+                    for(int i = 0; i < source->width; i++)
+                        value += xWeights[i] * SGImageBufferRow(source, y)[i * 4 + c];
+                else
+                    for(int j = 0; j < source->height; j++)
+                        value += yWeights[j] * SGImageBufferRow(source, j)[x * 4 + c];
+                intermediate[(y * width + x) * 4 + c] = clampChannel(value);
+            }
+        }
+    
+    for(int y = 0; y < scaled->height; y++)
+        for(int x = 0; x < scaled->width; x++) {
+            if(rowsFirst)
+                referenceAxis(source->height, scaled->height, y, filter, yWeights);
+            else
+                referenceAxis(source->width, scaled->width, x, filter, xWeights);
+            
+            for(int c = 0; c < 4; c++) {
+                value = 0.0;
+                if(rowsFirst)
+                    for(int j = 0; j < height; j++)
+                        value += yWeights[j] * intermediate[(j * width + x) * 4 + c];
+                else
+                    for(int i = 0; i < width; i++)
+                        value += xWeights[i] * intermediate[(y * width + i) * 4 + c];
+                
+                difference = abs((int)clampChannel(value) - SGImageBufferRow(scaled, y)[x * 4 + c]);
+                if(difference > error)
+                    error = difference;
+            }
+        }
+    
+    free(xWeights);
+    free(yWeights);
+    free(intermediate);
+    
+    return error;
+}
+
+/* the library picks the order of the passes, so the closer of the two is compared against */
+static int scaleError(const SGImageBuffer* source, const SGImageBuffer* scaled, SGImageFilter filter) {
+    int rowsFirst = scaleErrorInOrder(source, scaled, filter, 1);
+    int columnsFirst = scaleErrorInOrder(source, scaled, filter, 0);
+    
+    return rowsFirst < columnsFirst ? rowsFirst : columnsFirst;
+}
+
+int main(int argc, char** argv) {
+    static const char* filters[] = { "box", "bilinear", "lanczos" };
+    static const int sizes[][4] = {
+        { 64, 48, 20, 15 },     /* shrinking */
+        { 13, 9, 37, 29 },      /* enlarging */
+        { 50, 40, 31, 40 },     /* only across */
+        { 40, 50, 40, 77 },     /* only down */
+    };
+    
+    srand(11);
+    SGAssertTrue(SGImageBufferNew(0, 10) == NULL, "An empty buffer should not be created");
+    
+    // Resampling matches floating point filters to within the rounding of the fixed point weights
+    SGImageBuffer* source;
+    SGImageBuffer* scaled;
+    int error, difference;
+    for(int filter = kSGImageFilter_Box; filter <= kSGImageFilter_Lanczos; filter++)
+        for(int s = 0; s < 4; s++) {
+            source = randomImage(sizes[s][0], sizes[s][1]);
+            scaled = SGImageBufferNew(sizes[s][2], sizes[s][3]);
+            SGImageBufferScale(source, scaled, filter);
+            
+            error = scaleError(source, scaled, filter);
+            SGAssertTrue(error <= 1, "%s %dx%d to %dx%d is off by %d", filters[filter],
+                         sizes[s][0], sizes[s][1], sizes[s][2], sizes[s][3], error);
+            printf("%-8s %2dx%-2d to %2dx%-2d max error %d\n", filters[filter],
+                   sizes[s][0], sizes[s][1], sizes[s][2], sizes[s][3], error);
+            
+            SGImageBufferFree(source);
+            SGImageBufferFree(scaled);
+        }
+    
+    // A flat image stays exactly flat, since the weights add up to one
+    source = SGImageBufferNew(57, 43);
+    memset(source->pixels, 0x80, source->bytesPerRow * source->height);
+    for(int filter = kSGImageFilter_Box; filter <= kSGImageFilter_Lanczos; filter++) {
+        scaled = SGImageBufferNew(23, 91);
+        SGImageBufferScale(source, scaled, filter);
+        
+        error = 0;
+        for(int y = 0; y < scaled->height; y++)
+            for(int x = 0; x < scaled->width * 4; x++)
+                if(SGImageBufferRow(scaled, y)[x] != 0x80)
+                    error++;
+        SGAssertTrue(error == 0, "%d bytes of a flat image changed with the %s filter", error, filters[filter]);
+        SGImageBufferFree(scaled);
+    }
+    SGImageBufferFree(source);
+    
+    // Every orientation against where UIImage would put each pixel
+    int width = 37, height = 22;
+    source = randomImage(width, height);
+    SGImageBuffer* rotated;
+    SGImageBuffer* back;
+    int mismatches, c, r, rotatedWidth, rotatedHeight;
+    for(int orientation = kSGImageOrientation_Up; orientation <= kSGImageOrientation_RightMirrored; orientation++) {
+        int swapped = orientation == kSGImageOrientation_Left || orientation == kSGImageOrientation_Right ||
+                      orientation == kSGImageOrientation_LeftMirrored || orientation == kSGImageOrientation_RightMirrored;
+        rotatedWidth = swapped ? height : width;
+        rotatedHeight = swapped ? width : height;
+        rotated = SGImageBufferNew(rotatedWidth, rotatedHeight);
+        SGImageBufferTransform(source, rotated, orientation);
+        
+        mismatches = 0;
+        for(int y = 0; y < rotatedHeight; y++)
+            for(int x = 0; x < rotatedWidth; x++) {
+                switch(orientation) {
+                    case kSGImageOrientation_Down:          c = width - 1 - x;  r = height - 1 - y; break;
+                    case kSGImageOrientation_Left:          c = width - 1 - y;  r = x;              break;
+                    case kSGImageOrientation_Right:         c = y;              r = height - 1 - x; break;
+                    case kSGImageOrientation_UpMirrored:    c = width - 1 - x;  r = y;              break;
+                    case kSGImageOrientation_DownMirrored:  c = x;              r = height - 1 - y; break;
+                    case kSGImageOrientation_LeftMirrored:  c = width - 1 - y;  r = height - 1 - x; break;
+                    case kSGImageOrientation_RightMirrored: c = y;              r = x;              break;
+                    default:                                c = x;              r = y;              break;
+                }
+                
+                if(pixelAt(rotated, x, y) != pixelAt(source, c, r))
+                    mismatches++;
+            }
+        SGAssertTrue(mismatches == 0, "%d pixels are misplaced with orientation %d", mismatches, orientation);
+        SGImageBufferFree(rotated);
+    }
+    
+    // Turning left and then right is the identity
+    rotated = SGImageBufferNew(height, width);
+    back = SGImageBufferNew(width, height);
+    SGImageBufferTransform(source, rotated, kSGImageOrientation_Left);
+    SGImageBufferTransform(rotated, back, kSGImageOrientation_Right);
+    mismatches = 0;
+    for(int y = 0; y < height; y++)
+        if(memcmp(SGImageBufferRow(back, y), SGImageBufferRow(source, y), width * 4))
+            mismatches++;
+    SGAssertTrue(mismatches == 0, "%d rows changed after turning left and right", mismatches);
+    SGImageBufferFree(rotated);
+    SGImageBufferFree(back);
+    SGImageBufferFree(source);
+    
+    // Rounded corners clear the corners, keep the middle and blend the edge
+    source = SGImageBufferNew(40, 30);
+    memset(source->pixels, 0xff, source->bytesPerRow * source->height);
+    SGImageBufferRoundCorners(source, 10.0f, 8.0f);
+    SGAssertTrue(pixelAt(source, 0, 0) == 0 && pixelAt(source, 39, 0) == 0 &&
+                 pixelAt(source, 0, 29) == 0 && pixelAt(source, 39, 29) == 0, "The corners should be transparent");
+    SGAssertTrue(pixelAt(source, 20, 0) == 0xffffffff && pixelAt(source, 0, 15) == 0xffffffff &&
+                 pixelAt(source, 20, 15) == 0xffffffff, "The edges away from the corners should be untouched");
+    SGAssertTrue(pixelAt(source, 10, 10) == 0xffffffff, "The inside of the corner should be untouched");
+    int partial = 0, asymmetric = 0;
+    for(int y = 0; y < 8; y++)
+        for(int x = 0; x < 10; x++) {
+            unsigned char alpha = SGImageBufferRow(source, y)[x * 4 + 3];
+            if(alpha > 0 && alpha < 255)
+                partial++;
+            if(pixelAt(source, x, y) != pixelAt(source, 39 - x, 29 - y))
+                asymmetric++;
+        }
+    SGAssertTrue(partial > 0, "The edge of the corner should be antialiased");
+    SGAssertTrue(asymmetric == 0, "%d pixels differ between opposite corners", asymmetric);
+    SGImageBufferFree(source);
+    
+    // The reflection starts at half of the bottom row and fades out
+    width = 20;
+    height = 40;
+    source = SGImageBufferNew(width, height);
+    for(int y = 0; y < height; y++)
+        memset(SGImageBufferRow(source, y), y < height / 2 ? 0x40 : 0xf0, width * 4);
+    back = SGImageBufferNew(width, height + 10);
+    SGImageBufferReflect(source, back);
+    mismatches = 0;
+    for(int y = 0; y < height; y++)
+        if(memcmp(SGImageBufferRow(back, y), SGImageBufferRow(source, y), width * 4))
+            mismatches++;
+    SGAssertTrue(mismatches == 0, "%d rows of the original changed", mismatches);
+    
+    unsigned char first = SGImageBufferRow(back, height)[0];
+    unsigned char last = SGImageBufferRow(back, height + 9)[0];
+    SGAssertEqualsWithAccuracy(first, 0xf0 * 0.95 * kSGImageBuffer_ReflectionAlpha, 1.0,
+                               "The reflection should start from the bottom row, got %d", first);
+    SGAssertTrue(last < 0x40 * 0.1, "The reflection should fade out from the top row, got %d", last);
+    difference = 0;
+    for(int y = height + 1; y < height + 10; y++)
+        if(SGImageBufferRow(back, y)[0] > SGImageBufferRow(back, y - 1)[0])
+            difference++;
+    SGAssertTrue(difference == 0, "The reflection should only get fainter");
+    SGImageBufferFree(source);
+    SGImageBufferFree(back);
+    
+    return SGTestResult();
+}
@@ -0,0 +1,234 @@
+//
+//  SGImageCacheTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGImageCache.h"
+
+#import <pthread.h>
+#import <unistd.h>
+
+#define kAmountOfImages     64
+#define kImageCost          1000
+#define kAmountOfThreads    8
+
+/* the images and sources are slots that count their references */
+static int references[kAmountOfImages];
+static int sourceReferences[kAmountOfImages];
+
+static void retainImage(void* image) {
+    __sync_fetch_and_add((int*)image, 1);
+}
+
+static void releaseImage(void* image) {
+    __sync_fetch_and_sub((int*)image, 1);
+}
+
+static void retainSource(const void* source) {
+    __sync_fetch_and_add((int*)source, 1);
+}
+
+static void releaseSource(const void* source) {
+    __sync_fetch_and_sub((int*)source, 1);
+}
+
+static SGImageCacheKey key(int source, int operation, float parameter) {
+    SGImageCacheKey key = { &sourceReferences[source], operation, { parameter, 0.0f, 0.0f, 0.0f } };
+    return key;
+}
+
+/* hands an image over to the cache, dropping the test's own reference */
+static int give(SGImageCache* cache, SGImageCacheKey key, int image, size_t cost) {
+    references[image]++;
+    int stored = SGImageCacheSet(cache, &key, &references[image], cost);
+    references[image]--;
+    
+    return stored;
+}
+
+static int* copy(SGImageCache* cache, SGImageCacheKey key) {
+    int* image = (int*)SGImageCacheCopy(cache, &key);
+    if(image)
+        releaseImage(image);
+    
+    return image;
+}
+
+static int makes = 0;
+
+/* slowly makes the image in the slot of the first parameter, or fails for negative ones */
+static void* makeImage(const SGImageCacheKey* key, void* context, size_t* cost) {
+    __sync_fetch_and_add(&makes, 1);
+    usleep(20000);
+    
+    int image = (int)key->parameters[0];
+    if(image < 0)
+        return NULL;
+    
+    *cost = kImageCost;
+    references[image]++;
+    
+    return &references[image];
+}
+
+typedef struct {
+    SGImageCache* cache;
+    SGImageCacheKey key;
+    void* image;
+} Request;
+
+static void* request(void* argument) {
+    Request* request = (Request*)argument;
+    request->image = SGImageCacheCopyOrMake(request->cache, &request->key, makeImage, NULL);
+    
+    return NULL;
+}
+
+static int requestConcurrently(SGImageCache* cache, SGImageCacheKey* keys, int amountOfKeys, Request* requests) {
+    pthread_t threads[kAmountOfThreads];
+    makes = 0;
+    for(int i = 0; i < kAmountOfThreads; i++) {
+        requests[i].cache = cache;
+        requests[i].key = keys[i % amountOfKeys];
+        pthread_create(&threads[i], NULL, request, &requests[i]);
+    }
+    
+    for(int i = 0; i < kAmountOfThreads; i++)
+        pthread_join(threads[i], NULL);
+    
+    return makes;
+}
+
+int main(int argc, char** argv) {
+    SGImageCacheCallbacks callbacks = { retainImage, releaseImage, retainSource, releaseSource };
+    SGImageCache* cache = SGImageCacheNew(10 * kImageCost, &callbacks);
+    
+    SGAssertTrue(copy(cache, key(0, 0, 0.0f)) == NULL, "An empty cache should miss");
+    
+    for(int i = 0; i < 10; i++)
+        SGAssertTrue(give(cache, key(i, 0, 0.0f), i, kImageCost), "Image %d should fit the budget", i);
+    SGAssertTrue(cache->cost == 10 * kImageCost && cache->count == 10, "Expected 10 images, got %d", cache->count);
+    SGAssertTrue(references[3] == 1 && sourceReferences[3] == 1, "The cache should retain the image and its source");
+    
+    // The operation and its parameters are part of the key
+    SGAssertTrue(copy(cache, key(0, 1, 0.0f)) == NULL && copy(cache, key(0, 0, 1.0f)) == NULL,
+                 "A different operation on the same source should miss");
+    
+    // Touching the oldest image keeps it while the next oldest is evicted
+    SGAssertTrue(copy(cache, key(0, 0, 0.0f)) == &references[0], "Expected the first image");
+    give(cache, key(10, 0, 0.0f), 10, kImageCost);
+    SGAssertTrue(copy(cache, key(0, 0, 0.0f)) != NULL, "The recently used image should not be evicted");
+    SGAssertTrue(copy(cache, key(1, 0, 0.0f)) == NULL, "The least recently used image should be evicted");
+    SGAssertTrue(references[1] == 0 && sourceReferences[1] == 0 && cache->evictions == 1,
+                 "The evicted image and its source should be released");
+    
+    // A bigger image evicts as many as it needs
+    give(cache, key(11, 0, 0.0f), 11, 3 * kImageCost);
+    SGAssertTrue(cache->cost <= cache->budget, "The cache holds %zu bytes over a budget of %zu", cache->cost, cache->budget);
+    SGAssertTrue(!references[2] && !references[3] && !references[4], "Expected the three oldest images to be evicted");
+    
+    // Replacing an image releases the old one and updates the cost
+    size_t cost = cache->cost;
+    give(cache, key(11, 0, 0.0f), 12, kImageCost);
+    SGAssertTrue(references[11] == 0 && sourceReferences[11] == 1, "The replaced image should be released");
+    SGAssertTrue(cache->cost == cost - 2 * kImageCost, "Expected the cost to shrink by %d", 2 * kImageCost);
+    SGAssertTrue(copy(cache, key(11, 0, 0.0f)) == &references[12], "Expected the replacement");
+    
+    // Images that do not fit at all are not kept
+    SGAssertTrue(!give(cache, key(13, 0, 0.0f), 13, 11 * kImageCost), "An image over the budget should be refused");
+    SGAssertTrue(references[13] == 0 && copy(cache, key(13, 0, 0.0f)) == NULL, "The refused image should not be retained");
+    
+    SGImageCacheKey removed = key(0, 0, 0.0f);
+    SGImageCacheRemove(cache, &removed);
+    SGAssertTrue(references[0] == 0 && copy(cache, key(0, 0, 0.0f)) == NULL, "The removed image should be released");
+    
+    SGImageCacheSetBudget(cache, 2 * kImageCost);
+    SGAssertTrue(cache->cost <= 2 * kImageCost, "Shrinking the budget should evict images");
+    
+    // Enough images to grow the hash table
+    SGImageCacheSetBudget(cache, kAmountOfImages * kImageCost);
+    for(int i = 0; i < kAmountOfImages; i++)
+        give(cache, key(i, 2, 0.5f), i, kImageCost);
+    int found = 0;
+    for(int i = 0; i < kAmountOfImages; i++)
+        if(copy(cache, key(i, 2, 0.5f)) == &references[i])
+            found++;
+    SGAssertTrue(found == kAmountOfImages, "Expected all %d images, found %d", kAmountOfImages, found);
+    SGImageCacheClear(cache);
+    
+    // Threads that ask for the same image at once wait for a single one to make it
+    Request requests[kAmountOfThreads];
+    SGImageCacheKey keys[2] = { key(20, 3, 20.0f), key(21, 3, 21.0f) };
+    int amountOfMakes = requestConcurrently(cache, keys, 1, requests);
+    SGAssertTrue(amountOfMakes == 1, "The image was made %d times", amountOfMakes);
+    int shared = 0;
+    for(int i = 0; i < kAmountOfThreads; i++)
+        if(requests[i].image == &references[20])
+            shared++;
+    SGAssertTrue(shared == kAmountOfThreads, "%d of %d threads got the image", shared, kAmountOfThreads);
+    SGAssertTrue(references[20] == kAmountOfThreads + 1, "Expected a reference for every thread and the cache, got %d", references[20]);
+    references[20] -= kAmountOfThreads;
+    
+    // Once it is made, it is found
+    amountOfMakes = requestConcurrently(cache, keys, 1, requests);
+    SGAssertTrue(amountOfMakes == 0, "A cached image should not be made again");
+    references[20] -= kAmountOfThreads;
+    
+    // Different images are still made side by side
+    SGImageCacheClear(cache);
+    amountOfMakes = requestConcurrently(cache, keys, 2, requests);
+    SGAssertTrue(amountOfMakes == 2, "Expected each of 2 images to be made once, made %d", amountOfMakes);
+    references[20] -= kAmountOfThreads / 2;
+    references[21] -= kAmountOfThreads / 2;
+    
+    // A failure is shared too
+    SGImageCacheKey failing = key(22, 3, -1.0f);
+    amountOfMakes = requestConcurrently(cache, &failing, 1, requests);
+    int failures = 0;
+    for(int i = 0; i < kAmountOfThreads; i++)
+        if(!requests[i].image)
+            failures++;
+    SGAssertTrue(amountOfMakes == 1 && failures == kAmountOfThreads, "Expected one failed attempt for all threads");
+    
+    printf("SGImageCache: %d hits, %d misses, %d waits, %d evictions\n", cache->hits, cache->misses, cache->waits, cache->evictions);
+    
+    // Every reference that the cache took is given back
+    SGImageCacheFree(cache);
+    int unbalanced = 0;
+    for(int i = 0; i < kAmountOfImages; i++)
+        if(references[i] || sourceReferences[i])
+            unbalanced++;
+    SGAssertTrue(unbalanced == 0, "%d images or sources still have references", unbalanced);
+    
+    return SGTestResult();
+}
@@ -0,0 +1,220 @@
+//
+//  SGLocationFilterTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGLocationFilter.h"
+
+#define kOriginLatitude     37.77490
+#define kOriginLongitude    -122.41940
+
+/*
+* 40 seconds of standing still with GPS-like jitter followed by 60 seconds of
+* walking east at 1.4 meters per second. One fix per second.
+*/
+static const SGLocationFix kTrace[] = {
+    { 37.7748855, -122.4193460, 10.0, 0.0 },
+    { 37.7749122, -122.4193683, 5.0, 1.0 },
+    { 37.7748510, -122.4195083, 10.0, 2.0 },
+    { 37.7749112, -122.4193410, 10.0, 3.0 },
+    { 37.7749284, -122.4193979, 5.0, 4.0 },
+    { 37.7748898, -122.4193932, 5.0, 5.0 },
+    { 37.7748565, -122.4194513, 10.0, 6.0 },
+    { 37.7748895, -122.4194253, 5.0, 7.0 },
+    { 37.7749257, -122.4192923, 10.0, 8.0 },
+    { 37.7749273, -122.4194620, 10.0, 9.0 },
+    { 37.7750236, -122.4194602, 16.0, 10.0 },
+    { 37.7749353, -122.4193410, 10.0, 11.0 },
+    { 37.7749407, -122.4194498, 10.0, 12.0 },
+    { 37.7748877, -122.4194363, 5.0, 13.0 },
+    { 37.7748570, -122.4194254, 10.0, 14.0 },
+    { 37.7749219, -122.4195260, 10.0, 15.0 },
+    { 37.7749761, -122.4194311, 10.0, 16.0 },
+    { 37.7748708, -122.4193930, 16.0, 17.0 },
+    { 37.7748855, -122.4195146, 10.0, 18.0 },
+    { 37.7749312, -122.4195183, 16.0, 19.0 },
+    { 37.7749158, -122.4193782, 5.0, 20.0 },
+    { 37.7751804, -122.4196316, 32.0, 21.0 },
+    { 37.7749163, -122.4193180, 10.0, 22.0 },
+    { 37.7748094, -122.4197000, 32.0, 23.0 },
+    { 37.7751043, -122.4195094, 32.0, 24.0 },
+    { 37.7749027, -122.4195625, 16.0, 25.0 },
+    { 37.7748543, -122.4193633, 5.0, 26.0 },
+    { 37.7748844, -122.4194068, 10.0, 27.0 },
+    { 37.7748009, -122.4194394, 16.0, 28.0 },
+    { 37.7748470, -122.4193675, 16.0, 29.0 },
+    { 37.7748729, -122.4193602, 10.0, 30.0 },
+    { 37.7749487, -122.4194481, 10.0, 31.0 },
+    { 37.7749278, -122.4193093, 10.0, 32.0 },
+    { 37.7748548, -122.4194042, 10.0, 33.0 },
+    { 37.7749019, -122.4195098, 32.0, 34.0 },
+    { 37.7748715, -122.4195123, 10.0, 35.0 },
+    { 37.7749769, -122.4196085, 32.0, 36.0 },
+    { 37.7749344, -122.4194739, 16.0, 37.0 },
+    { 37.7748932, -122.4193686, 10.0, 38.0 },
+    { 37.7749536, -122.4193515, 10.0, 39.0 },
+    { 37.7749028, -122.4194218, 5.0, 40.0 },
+    { 37.7749247, -122.4193745, 10.0, 41.0 },
+    { 37.7748749, -122.4193906, 10.0, 42.0 },
+    { 37.7748496, -122.4193613, 10.0, 43.0 },
+    { 37.7749122, -122.4193758, 5.0, 44.0 },
+    { 37.7749430, -122.4193775, 16.0, 45.0 },
+    { 37.7748807, -122.4193102, 16.0, 46.0 },
+    { 37.7748977, -122.4192421, 5.0, 47.0 },
+    { 37.7749062, -122.4192617, 5.0, 48.0 },
+    { 37.7748886, -122.4192729, 5.0, 49.0 },
+    { 37.7748887, -122.4192412, 10.0, 50.0 },
+    { 37.7748832, -122.4192332, 10.0, 51.0 },
+    { 37.7748831, -122.4191187, 10.0, 52.0 },
+    { 37.7749976, -122.4190502, 16.0, 53.0 },
+    { 37.7749076, -122.4192392, 16.0, 54.0 },
+    { 37.7749247, -122.4191034, 10.0, 55.0 },
+    { 37.7749092, -122.4192157, 10.0, 56.0 },
+    { 37.7749532, -122.4190938, 5.0, 57.0 },
+    { 37.7749448, -122.4190543, 10.0, 58.0 },
+    { 37.7748811, -122.4190802, 5.0, 59.0 },
+    { 37.7748835, -122.4190728, 5.0, 60.0 },
+    { 37.7748770, -122.4190048, 10.0, 61.0 },
+    { 37.7748841, -122.4191304, 10.0, 62.0 },
+    { 37.7748531, -122.4190690, 10.0, 63.0 },
+    { 37.7748221, -122.4189655, 10.0, 64.0 },
+    { 37.7749498, -122.4189653, 10.0, 65.0 },
+    { 37.7748974, -122.4189198, 5.0, 66.0 },
+    { 37.7750103, -122.4189620, 16.0, 67.0 },
+    { 37.7749344, -122.4190646, 10.0, 68.0 },
+    { 37.7748881, -122.4188701, 10.0, 69.0 },
+    { 37.7749303, -122.4188549, 10.0, 70.0 },
+    { 37.7749603, -122.4188678, 10.0, 71.0 },
+    { 37.7749042, -122.4189154, 5.0, 72.0 },
+    { 37.7748902, -122.4188511, 5.0, 73.0 },
+    { 37.7747826, -122.4188119, 16.0, 74.0 },
+    { 37.7748507, -122.4187521, 16.0, 75.0 },
+    { 37.7749564, -122.4186930, 10.0, 76.0 },
+    { 37.7749272, -122.4189408, 16.0, 77.0 },
+    { 37.7748864, -122.4187815, 5.0, 78.0 },
+    { 37.7749104, -122.4186879, 10.0, 79.0 },
+    { 37.7748621, -122.4187291, 16.0, 80.0 },
+    { 37.7748442, -122.4187775, 16.0, 81.0 },
+    { 37.7749108, -122.4186140, 10.0, 82.0 },
+    { 37.7748913, -122.4187645, 5.0, 83.0 },
+    { 37.7748960, -122.4186235, 16.0, 84.0 },
+    { 37.7749054, -122.4186285, 10.0, 85.0 },
+    { 37.7748602, -122.4186470, 10.0, 86.0 },
+    { 37.7748780, -122.4186191, 16.0, 87.0 },
+    { 37.7748603, -122.4185524, 10.0, 88.0 },
+    { 37.7747694, -122.4185165, 16.0, 89.0 },
+    { 37.7748891, -122.4186555, 10.0, 90.0 },
+    { 37.7748721, -122.4185374, 5.0, 91.0 },
+    { 37.7748874, -122.4185531, 5.0, 92.0 },
+    { 37.7749120, -122.4186300, 10.0, 93.0 },
+    { 37.7749241, -122.4185397, 5.0, 94.0 },
+    { 37.7748667, -122.4184988, 16.0, 95.0 },
+    { 37.7749181, -122.4184918, 5.0, 96.0 },
+    { 37.7748986, -122.4185126, 5.0, 97.0 },
+    { 37.7749108, -122.4184969, 5.0, 98.0 },
+    { 37.7748538, -122.4184663, 10.0, 99.0 },
+};
+
+#define kAmountOfFixes      (int)(sizeof(kTrace) / sizeof(kTrace[0]))
+#define kStationaryFixes    40
+
+static void testStationary(void) {
+    SGLocationFilter filter;
+    SGLocationFilterReset(&filter);
+    
+    int updates = 0;
+    for(int i = 0; i < kStationaryFixes; i++)
+        updates += SGLocationFilterAddFix(&filter, &kTrace[i]);
+    
+    double error = SGLocationFilterDistance(kOriginLatitude, kOriginLongitude, filter.latitude, filter.longitude);
+    SGAssertTrue(error < 5.0, "Stationary estimate should be within 5m but was %fm away", error);
+    SGAssertTrue(updates <= 3, "Jitter should not move the origin but it moved %i times", updates);
+    SGAssertTrue(filter.avoidedUpdates >= kStationaryFixes - 3,
+                 "Expected at least %i avoided updates but there were %u", kStationaryFixes - 3, filter.avoidedUpdates);
+}
+
+static void testWalking(void) {
+    SGLocationFilter filter;
+    SGLocationFilterReset(&filter);
+    
+    int updates = 0;
+    for(int i = 0; i < kAmountOfFixes; i++)
+        updates += SGLocationFilterAddFix(&filter, &kTrace[i]);
+    
+    SGAssertTrue(updates >= 10, "Walking should move the origin but it only moved %i times", updates);
+    SGAssertTrue(filter.rejectedFixes == 0, "No fix should be rejected but %u were", filter.rejectedFixes);
+    
+    double travelled = SGLocationFilterDistance(kOriginLatitude, kOriginLongitude,
+                                                filter.originLatitude, filter.originLongitude);
+    SGAssertEqualsWithAccuracy(travelled, 84.0, 15.0, "The origin should be about 84m away but was %fm", travelled);
+    printf("%i fixes, %i origin updates, %u avoided\n", kAmountOfFixes, updates, filter.avoidedUpdates);
+}
+
+static void testOutliers(void) {
+    SGLocationFilter filter;
+    SGLocationFilterReset(&filter);
+    
+    for(int i = 0; i < 10; i++)
+        SGLocationFilterAddFix(&filter, &kTrace[i]);
+    
+    double latitude = filter.latitude;
+    double longitude = filter.longitude;
+    
+    // Two kilometers away a second later
+    SGLocationFix jump = { kOriginLatitude + 0.018, kOriginLongitude, 10.0, 10.0 };
+    SGAssertTrue(!SGLocationFilterAddFix(&filter, &jump), "An outlier should not move the origin");
+    SGAssertTrue(filter.rejectedFixes == 1, "The outlier should be rejected");
+    SGAssertTrue(filter.latitude == latitude && filter.longitude == longitude, "An outlier should not move the estimate");
+    
+    SGLocationFix invalid = { kOriginLatitude, kOriginLongitude, -1.0, 11.0 };
+    SGAssertTrue(!SGLocationFilterAddFix(&filter, &invalid), "An invalid fix should not move the origin");
+    SGAssertTrue(filter.rejectedFixes == 2, "The invalid fix should be rejected");
+    
+    // Fixes that keep agreeing with each other win over the estimate
+    int moved = 0;
+    for(int i = 0; i < kSGLocationFilter_MaximumRejections; i++) {
+        jump.timestamp = 12.0 + i;
+        moved |= SGLocationFilterAddFix(&filter, &jump);
+    }
+    
+    SGAssertTrue(moved, "A lasting jump should move the origin");
+    SGAssertEqualsWithAccuracy(filter.latitude, jump.latitude, 1e-6, "The estimate should restart at the new position");
+}
+
+int main(int argc, char** argv) {
+    testStationary();
+    testWalking();
+    testOutliers();
+    
+    return SGTestResult();
+}
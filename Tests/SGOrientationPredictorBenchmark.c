@@ -0,0 +1,183 @@
+//
+//  SGOrientationPredictorBenchmark.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import "SGOrientationPredictor.h"
+
+#import <stdio.h>
+#import <stdlib.h>
+#import <math.h>
+
+/*
+* Evaluates the orientation predictor offline. Traces that were recorded
+* with SGARView's orientationTracePath are passed as arguments; without any,
+* traces of typical motions are synthesized in the same format: a noisy
+* compass at 30 Hz, the accelerometer at 30 Hz through the lowpass filter of
+* the environment and frames at 60 Hz with some jitter. Every trace is
+* replayed for scenes that are prepared inline and on the worker, which
+* draws them a frame later, and the error of the predictions is compared with
+* holding the last sample. Pitch and roll are reported in degrees, as the
+* camera rotates by 90 degrees per g.
+*/
+
+#define kDuration               20.0        /* seconds */
+#define kSensorPeriod           (1.0 / 30.0)
+#define kFramePeriod            (1.0 / 60.0)
+#define kFrameJitter            0.002       /* seconds */
+#define kHeadingNoise           0.5         /* degrees */
+#define kAccelerationNoise      0.005       /* g */
+#define kFilterCutoff           1.5         /* Hz, like the environment */
+#define kDegreesPerG            90.0
+
+typedef void (*Motion)(double t, double* heading, double* pitch, double* roll);
+
+static void still(double t, double* heading, double* pitch, double* roll) {
+    *heading = 120.0;
+    *pitch = -0.1;
+    *roll = 0.02;
+}
+
+static void pan(double t, double* heading, double* pitch, double* roll) {
+    *heading = fmod(60.0 * t, 360.0);
+    *pitch = -0.1;
+    *roll = 0.02;
+}
+
+static void lookAround(double t, double* heading, double* pitch, double* roll) {
+    *heading = fmod(360.0 + 45.0 * sin(2.0 * M_PI * 0.4 * t), 360.0);
+    *pitch = -0.1 + 0.1 * sin(2.0 * M_PI * 0.3 * t);
+    *roll = 0.02 + 0.03 * sin(2.0 * M_PI * 0.5 * t);
+}
+
+/* turns of 90 degrees in half a second, each followed by a second of rest */
+static void quickTurns(double t, double* heading, double* pitch, double* roll) {
+    double phase = fmod(t, 1.5);
+    int turns = (int)(t / 1.5);
+    double progress = phase < 0.5 ? phase / 0.5 : 1.0;
+    progress = progress * progress * (3.0 - 2.0 * progress);
+    *heading = fmod(90.0 * (turns + progress), 360.0);
+    *pitch = -0.1 - 0.05 * sin(M_PI * progress);
+    *roll = 0.02;
+}
+
+static double noise(double amplitude) {
+    // The sum of uniform numbers is close enough to a normal distribution
+    double sum = 0.0;
+    for(int i = 0; i < 12; i++)
+        sum += rand() / (double)RAND_MAX;
+    
+    return (sum - 6.0) * amplitude;
+}
+
+/* writes the samples and frames of motion in the order that they happen */
+static FILE* synthesize(Motion motion) {
+    FILE* trace = tmpfile();
+    double alpha = kSensorPeriod / (kSensorPeriod + 1.0 / kFilterCutoff);
+    double heading, pitch, roll, filteredPitch = 0.0, filteredRoll = 0.0;
+    double nextSample = 0.0, nextFrame = 0.0;
+    int hasFilter = 0;
+    
+    srand(11);
+    while(nextSample < kDuration || nextFrame < kDuration) {
+        if(nextSample <= nextFrame) {
+            motion(nextSample, &heading, &pitch, &roll);
+            
+            pitch += noise(kAccelerationNoise);
+            roll += noise(kAccelerationNoise);
+            filteredPitch = hasFilter ? pitch * alpha + filteredPitch * (1.0 - alpha) : pitch;
+            filteredRoll = hasFilter ? roll * alpha + filteredRoll * (1.0 - alpha) : roll;
+            hasFilter = 1;
+            
+            fprintf(trace, "%.6f %i %.6f\n", nextSample, kSGOrientationAxis_Pitch, filteredPitch);
+            fprintf(trace, "%.6f %i %.6f\n", nextSample, kSGOrientationAxis_Roll, filteredRoll);
+            fprintf(trace, "%.6f %i %.6f\n", nextSample, kSGOrientationAxis_Heading,
+                    fmod(heading + noise(kHeadingNoise) + 360.0, 360.0));
+            nextSample += kSensorPeriod;
+        } else {
+            fprintf(trace, "%.6f %i 0\n", nextFrame, kSGOrientationTrace_Frame);
+            nextFrame += kFramePeriod + noise(kFrameJitter / 3.0);
+        }
+    }
+    
+    return trace;
+}
+
+static void evaluate(const char* name, FILE* trace) {
+    const char* modes[] = { "inline", "worker" };
+    for(int framesAhead = 0; framesAhead < 2; framesAhead++) {
+        SGOrientationPredictor predictor;
+        predictor.trace = NULL;
+        SGOrientationPredictorReset(&predictor);
+        
+        rewind(trace);
+        SGOrientationPredictorReplay(&predictor, trace, framesAhead);
+        
+        printf("%-12s %s horizon %5.1f ms", name, modes[framesAhead], predictor.horizon * 1000.0);
+        for(int axis = 0; axis < kSGOrientationAxis_Count; axis++) {
+            double scale = axis == kSGOrientationAxis_Heading ? 1.0 : kDegreesPerG;
+            printf(" | %s %6.3f vs %6.3f", axis == kSGOrientationAxis_Heading ? "heading" : (axis == kSGOrientationAxis_Pitch ? "pitch" : "roll"),
+                   SGOrientationPredictorError(&predictor, axis) * scale, SGOrientationPredictorHoldError(&predictor, axis) * scale);
+        }
+        printf(" degrees\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    printf("root mean square error of the prediction vs holding the last sample\n");
+    
+    if(argc > 1) {
+        for(int i = 1; i < argc; i++) {
+            FILE* trace = fopen(argv[i], "r");
+            if(!trace) {
+                fprintf(stderr, "Unable to open %s\n", argv[i]);
+                return 1;
+            }
+            
+            evaluate(argv[i], trace);
+            fclose(trace);
+        }
+        
+        return 0;
+    }
+    
+    Motion motions[] = { still, pan, lookAround, quickTurns };
+    const char* names[] = { "still", "pan", "look around", "quick turns" };
+    for(int i = 0; i < sizeof(motions) / sizeof(Motion); i++) {
+        FILE* trace = synthesize(motions[i]);
+        evaluate(names[i], trace);
+        fclose(trace);
+    }
+    
+    return 0;
+}
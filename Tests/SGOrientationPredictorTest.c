@@ -0,0 +1,138 @@
+//
+//  SGOrientationPredictorTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import "SGCTest.h"
+#import "SGOrientationPredictor.h"
+
+#import <math.h>
+
+#define kSamplePeriod       (1.0 / 30.0)
+#define kFramePeriod        (1.0 / 60.0)
+
+/* a heading that turns at a constant rate, fed for duration seconds with a frame in between */
+static void turn(SGOrientationPredictor* predictor, double start, double duration, double rate, int framesAhead) {
+    double nextSample = start, nextFrame = start;
+    while(nextSample < start + duration || nextFrame < start + duration) {
+        if(nextSample <= nextFrame) {
+            SGOrientationPredictorAddSample(predictor, kSGOrientationAxis_Heading, nextSample,
+                                            fmod(350.0 + rate * nextSample, 360.0));
+            nextSample += kSamplePeriod;
+        } else {
+            SGOrientationPredictorBeginFrame(predictor, nextFrame);
+            SGOrientationPredictorPredict(predictor, kSGOrientationAxis_Heading,
+                                          SGOrientationPredictorPresentTime(predictor, framesAhead));
+            nextFrame += kFramePeriod;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    SGOrientationPredictor predictor;
+    predictor.trace = NULL;
+    SGOrientationPredictorReset(&predictor);
+    
+    SGAssertTrue(SGOrientationPredictorPredict(&predictor, kSGOrientationAxis_Pitch, 1.0) == 0.0,
+                 "An axis without samples should predict 0");
+    
+    // A constant turn across north is predicted exactly once the velocity
+    // is known, while holding the last heading lags behind.
+    turn(&predictor, 0.0, 0.2, 90.0, 0);
+    SGOrientationAxis* heading = &predictor.axes[kSGOrientationAxis_Heading];
+    heading->evaluated = 0;
+    heading->squaredError = 0.0;
+    heading->squaredHoldError = 0.0;
+    turn(&predictor, 0.2, 1.8, 90.0, 0);
+    SGAssertEqualsWithAccuracy(heading->velocity, 90.0, 1e-6, "The velocity should be fit across the wrap around");
+    SGAssertTrue(heading->evaluated > 50, "The predictions should be evaluated, %u were", heading->evaluated);
+    SGAssertTrue(SGOrientationPredictorError(&predictor, kSGOrientationAxis_Heading) < 1e-6,
+                 "A constant turn should be predicted exactly, the error is %f degrees",
+                 SGOrientationPredictorError(&predictor, kSGOrientationAxis_Heading));
+    SGAssertTrue(SGOrientationPredictorHoldError(&predictor, kSGOrientationAxis_Heading) > 1.0,
+                 "Holding the last heading should lag behind, the error is %f degrees",
+                 SGOrientationPredictorHoldError(&predictor, kSGOrientationAxis_Heading));
+    SGAssertEqualsWithAccuracy(predictor.framePeriod, kFramePeriod, 1e-6, "The frame period should be measured");
+    SGAssertTrue(predictor.horizon > kFramePeriod && predictor.horizon < kFramePeriod + kSamplePeriod,
+                 "The horizon should be a frame plus the age of the sample, it is %f seconds", predictor.horizon);
+    
+    // The extrapolation is capped
+    double last = heading->values[heading->newest];
+    double lastTime = heading->times[heading->newest];
+    double prediction = SGOrientationPredictorPredict(&predictor, kSGOrientationAxis_Heading, lastTime + 0.2);
+    SGAssertEqualsWithAccuracy(prediction, last + 90.0 * kSGOrientationPredictor_MaximumHorizon, 1e-6,
+                               "The extrapolation should be capped");
+    
+    // Stale samples are held
+    prediction = SGOrientationPredictorPredict(&predictor, kSGOrientationAxis_Heading, lastTime + 1.0);
+    SGAssertEqualsWithAccuracy(prediction, last, 1e-9, "A stale sample should be held");
+    
+    // Stalls do not count towards the frame period
+    SGOrientationPredictorBeginFrame(&predictor, 10.0);
+    SGAssertEqualsWithAccuracy(predictor.framePeriod, kFramePeriod, 1e-6, "A stall should not change the frame period");
+    for(int i = 1; i <= 200; i++)
+        SGOrientationPredictorBeginFrame(&predictor, 10.0 + i / 30.0);
+    SGAssertEqualsWithAccuracy(predictor.framePeriod, 1.0 / 30.0, 1e-5, "The frame period should follow the frame rate");
+    
+    // Samples that arrive out of order are ignored
+    SGOrientationPredictorReset(&predictor);
+    SGOrientationPredictorAddSample(&predictor, kSGOrientationAxis_Roll, 1.0, 0.5);
+    SGOrientationPredictorAddSample(&predictor, kSGOrientationAxis_Roll, 0.5, 0.1);
+    SGAssertTrue(predictor.axes[kSGOrientationAxis_Roll].count == 1, "An older sample should be ignored");
+    
+    // A recorded trace replays to the same statistics
+    SGOrientationPredictorReset(&predictor);
+    predictor.trace = tmpfile();
+    SGAssertTrue(predictor.trace != NULL, "A trace should be created");
+    turn(&predictor, 0.0, 2.0, -45.0, 1);
+    double error = SGOrientationPredictorError(&predictor, kSGOrientationAxis_Heading);
+    double holdError = SGOrientationPredictorHoldError(&predictor, kSGOrientationAxis_Heading);
+    
+    SGOrientationPredictor replay;
+    replay.trace = NULL;
+    SGOrientationPredictorReset(&replay);
+    rewind(predictor.trace);
+    int lines = SGOrientationPredictorReplay(&replay, predictor.trace, 1);
+    SGAssertTrue(lines == 60 + 120 + 1, "Every sample and frame should be replayed, %i lines were", lines);
+    SGAssertTrue(replay.axes[kSGOrientationAxis_Heading].evaluated == predictor.axes[kSGOrientationAxis_Heading].evaluated,
+                 "The replay should evaluate as many predictions");
+    SGAssertEqualsWithAccuracy(SGOrientationPredictorError(&replay, kSGOrientationAxis_Heading), error, 1e-4,
+                               "The replay should have the same error");
+    SGAssertEqualsWithAccuracy(SGOrientationPredictorHoldError(&replay, kSGOrientationAxis_Heading), holdError, 1e-4,
+                               "The replay should have the same error when holding");
+    fclose(predictor.trace);
+    
+    printf("horizon %.1f ms, error %.4f degrees, %.4f degrees when holding\n", replay.horizon * 1000.0, error, holdError);
+    
+    return SGTestResult();
+}
@@ -0,0 +1,168 @@
+//
+//  SGSceneBenchmark.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGScene.h"
+#import "SGMetrics.h"
+
+#import <stdio.h>
+#import <stdlib.h>
+#import <time.h>
+
+/*
+* Measures the time that the render thread spends on the simulation of a
+* frame: before, it prepared every frame itself; with the worker it only
+* copies the input of the next frame and picks up the latest snapshot. The
+* frames are paced at 60 Hz like the display link so the worker has the
+* rest of each frame to prepare the next one.
+*/
+
+#define kFrames             120
+#define kFramePeriod        (1.0 / 60.0)
+#define kSphereRadius       (5000.0f * kSGMeter)
+
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static void waitUntil(double time) {
+    double remaining = time - now();
+    if(remaining > 0.0) {
+        struct timespec duration = { (time_t)remaining, (long)((remaining - (time_t)remaining) * 1e9) };
+        nanosleep(&duration, NULL);
+    }
+}
+
+static void fillInput(SGSceneInput* input, const SGAnnotationStore* store, unsigned int frame, int clustering) {
+    SGSceneInputCopyStore(input, store);
+    input->frame = frame;
+    input->camera.pitch = -0.1f;
+    input->camera.roll = 0.02f;
+    input->camera.heading = frame * 0.5f;
+    input->camera.height = kSGMeter * 1.7018f;
+    input->camera.fovy = 65.0f;
+    input->camera.zNear = 0.5f;
+    input->camera.zFar = kSphereRadius + 10.0f;
+    input->camera.viewport[2] = 320;
+    input->camera.viewport[3] = 480;
+    input->clustering = clustering;
+    input->clusterTolerance = 5.0f;
+    input->clusterCellSize = 5.0f * kSGMeter;
+    input->decluttering = 1;
+    input->touchScale = kSphereRadius / 2.0f;
+    input->radarWidth = 100.0f;
+    input->radarHeight = 100.0f;
+    input->radarScale = 50.0f / kSphereRadius;
+}
+
+static void report(const char* name, int count, double seconds, double baseline, double behind) {
+    printf("%-24s %5i annotations %7.3f ms/frame on the render thread %6.1fx %4.1f frames behind\n",
+           name, count, seconds * 1000.0 / kFrames, baseline / seconds, behind);
+}
+
+static void run(int count, int clustering) {
+    SGAnnotationStore* store = SGAnnotationStoreNew(kSGMeter, 3.0f * kSGMeter, kSphereRadius);
+    SGAnnotationStoreSetOrigin(store, 37.77, -122.40);
+    
+    srand(5);
+    for(int i = 0; i < count; i++) {
+        SGAnnotationHandle handle = SGAnnotationStoreAdd(store, 37.77 + (rand() % 4000 - 2000) / 100000.0,
+                                                         -122.40 + (rand() % 4000 - 2000) / 100000.0, 0.0f, NULL);
+        int index = SGAnnotationStoreIndex(store, handle);
+        store->widths[index] = 120.0f;
+        store->heights[index] = 40.0f;
+    }
+    
+    // Inline, as the render thread used to do it
+    SGScene* scene = SGSceneNew();
+    SGSceneInput input;
+    SGSceneSnapshot snapshot;
+    SGSceneInputInit(&input);
+    SGSceneSnapshotInit(&snapshot);
+    
+    double start, spent = 0.0, next = now();
+    for(unsigned int frame = 1; frame <= kFrames; frame++) {
+        start = now();
+        fillInput(&input, store, frame, clustering);
+        SGScenePrepare(scene, &input, &snapshot);
+        spent += now() - start;
+        
+        next += kFramePeriod;
+        waitUntil(next);
+    }
+    
+    double baseline = spent;
+    report(clustering ? "inline, clustered" : "inline", count, baseline, baseline, 0.0);
+    
+    // With the worker
+    SGSceneWorker* worker = SGSceneWorkerNew();
+    const SGSceneSnapshot* latest;
+    double behind = 0.0;
+    int acquired = 0;
+    spent = 0.0;
+    next = now();
+    for(unsigned int frame = 1; frame <= kFrames; frame++) {
+        start = now();
+        latest = SGSceneWorkerAcquire(worker);
+        fillInput(SGSceneWorkerBeginInput(worker), store, frame, clustering);
+        SGSceneWorkerCommitInput(worker);
+        spent += now() - start;
+        
+        if(latest) {
+            behind += frame - latest->frame;
+            acquired++;
+        }
+        
+        next += kFramePeriod;
+        waitUntil(next);
+    }
+    
+    report(clustering ? "worker, clustered" : "worker", count, spent, baseline, acquired ? behind / acquired : 0.0);
+    
+    SGSceneWorkerFree(worker);
+    SGSceneSnapshotDestroy(&snapshot);
+    SGSceneInputDestroy(&input);
+    SGSceneFree(scene);
+    SGAnnotationStoreFree(store);
+}
+
+int main(int argc, char** argv) {
+    run(500, 0);
+    run(500, 1);
+    run(2000, 0);
+    run(2000, 1);
+    
+    return 0;
+}
@@ -0,0 +1,431 @@
+//
+//  SGSceneTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGScene.h"
+#import "SGMetrics.h"
+
+#import <stdlib.h>
+#import <string.h>
+
+#define kAmount         500
+#define kMeter          kSGMeter
+#define kSphereRadius   (5000.0f * kMeter)
+
+static SGAnnotationStore* newStore(SGAnnotationHandle* handles) {
+    SGAnnotationStore* store = SGAnnotationStoreNew(kMeter, 3.0f * kMeter, kSphereRadius);
+    SGAnnotationStoreSetOrigin(store, 37.77, -122.40);
+    
+    srand(7);
+    for(int i = 0; i < kAmount; i++) {
+        handles[i] = SGAnnotationStoreAdd(store, 37.77 + (rand() % 2000 - 1000) / 100000.0,
+                                          -122.40 + (rand() % 2000 - 1000) / 100000.0, (rand() % 20) / 2.0f, NULL);
+        int index = SGAnnotationStoreIndex(store, handles[i]);
+        store->widths[index] = 80.0f + rand() % 100;
+        store->heights[index] = 30.0f + rand() % 30;
+        
+        if(i % 10 == 0)
+            SGAnnotationStoreSetFlag(store, handles[i], kSGAnnotationFlag_Captured, 1);
+    }
+    
+    return store;
+}
+
+static void fillInput(SGSceneInput* input, const SGAnnotationStore* store) {
+    SGSceneInputCopyStore(input, store);
+    input->camera.pitch = -0.1f;
+    input->camera.roll = 0.05f;
+    input->camera.heading = 30.0f;
+    input->camera.x = 15.0f;
+    input->camera.z = -40.0f;
+    input->camera.height = kMeter * 1.7018f;
+    input->camera.fovy = 65.0f;
+    input->camera.zNear = 0.5f;
+    input->camera.zFar = kSphereRadius + 10.0f;
+    input->camera.viewport[0] = 0;
+    input->camera.viewport[1] = 0;
+    input->camera.viewport[2] = 320;
+    input->camera.viewport[3] = 480;
+    input->touchScale = kSphereRadius / 2.0f;
+    input->radarWidth = 100.0f;
+    input->radarHeight = 100.0f;
+    input->radarScale = 50.0f / kSphereRadius;
+    input->clusterTolerance = 5.0f;
+    input->clusterCellSize = 5.0f * kMeter;
+}
+
+/* rotate (x, y, z) the way glRotatef does around a single axis */
+static void rotatePoint(double* point, double degrees, int axis) {
+    double angle = degrees * M_PI / 180.0;
+    int first = (axis + 1) % 3, second = (axis + 2) % 3;
+    double a = point[first], b = point[second];
+    point[first] = a * cos(angle) - b * sin(angle);
+    point[second] = a * sin(angle) + b * cos(angle);
+}
+
+/* gluProject written out step by step from the transformations of the environment */
+static int referenceProject(const SGSceneCamera* camera, float x, float y, float z, double* window) {
+    double point[3] = { x - camera->x, y - camera->height, z - camera->z };
+    rotatePoint(point, camera->heading, 1);
+    rotatePoint(point, -90.0 * camera->pitch, 0);
+    rotatePoint(point, 90.0 * camera->roll, 2);
+    
+    if(point[2] == 0.0)
+        return 0;
+    
+    double f = 1.0 / tan(camera->fovy * M_PI / 360.0);
+    double aspect = (double)camera->viewport[2] / camera->viewport[3];
+    double w = -point[2];
+    double clipZ = point[2] * (camera->zFar + camera->zNear) / (camera->zNear - camera->zFar) +
+                   2.0 * camera->zFar * camera->zNear / (camera->zNear - camera->zFar);
+    window[0] = camera->viewport[0] + camera->viewport[2] * (point[0] * f / aspect / w + 1.0) / 2.0;
+    window[1] = camera->viewport[1] + camera->viewport[3] * (point[1] * f / w + 1.0) / 2.0;
+    window[2] = (clipZ / w + 1.0) / 2.0;
+    return 1;
+}
+
+static void testProjection(SGScene* scene, SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    SGScenePrepare(scene, input, snapshot);
+    
+    float winX, winY, winZ;
+    double window[3];
+    int wrong = 0;
+    srand(11);
+    for(int i = 0; i < 1000; i++) {
+        float x = (rand() % 4000 - 2000) * 0.5f, y = (rand() % 200 - 100) * 0.5f, z = (rand() % 4000 - 2000) * 0.5f;
+        if(!referenceProject(&snapshot->camera, x, y, z, window))
+            continue;
+        
+        SGSceneSnapshotProject(snapshot, x, y, z, &winX, &winY, &winZ);
+        if(fabs(winX - window[0]) > 0.01 * (1.0 + fabs(window[0])) || fabs(winY - window[1]) > 0.01 * (1.0 + fabs(window[1])))
+            wrong++;
+    }
+    
+    SGAssertTrue(!wrong, "%i points were projected differently from the environment's transformations", wrong);
+}
+
+static void testLayout(SGScene* scene, SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    input->clustering = 0;
+    input->decluttering = 0;
+    SGScenePrepare(scene, input, snapshot);
+    
+    int expected = 0;
+    for(int i = 0; i < input->count; i++)
+        if(!input->flags[i])
+            expected++;
+    
+    SGAssertTrue(snapshot->amountOfBillboards == expected, "%i billboards should be laid out but %i were",
+                 expected, snapshot->amountOfBillboards);
+    
+    int sorted = 1, captured = 0;
+    for(int i = 0; i < snapshot->amountOfBillboards; i++) {
+        if(i && snapshot->billboards[i - 1].distance < snapshot->billboards[i].distance)
+            sorted = 0;
+        if(input->flags[snapshot->billboards[i].entry] & kSGSceneEntry_Captured)
+            captured++;
+        if(input->handles[snapshot->billboards[i].entry] != snapshot->billboards[i].handle)
+            captured++;
+    }
+    
+    SGAssertTrue(sorted, "The billboards should go from the back to the front");
+    SGAssertTrue(!captured, "Captured entries should not be laid out");
+    
+    // Every annotation is held by exactly one cluster once none are captured
+    unsigned char flags[kAmount];
+    memcpy(flags, input->flags, input->count);
+    memset(input->flags, 0, input->count);
+    input->clustering = 1;
+    input->revision++;
+    SGScenePrepare(scene, input, snapshot);
+    
+    int held = 0;
+    for(int i = 0; i < snapshot->amountOfBillboards; i++)
+        held += snapshot->billboards[i].count;
+    
+    SGAssertTrue(snapshot->amountOfBillboards < expected, "Clustering should lay out fewer billboards");
+    SGAssertTrue(held == input->count, "The clusters should hold %i annotations but held %i", input->count, held);
+    memcpy(input->flags, flags, input->count);
+    input->clustering = 0;
+}
+
+static int clusteredEntries(const SGSceneInput* input, const SGSceneSnapshot* snapshot, int* flagged) {
+    int held = 0;
+    *flagged = 0;
+    for(int i = 0; i < snapshot->amountOfBillboards; i++) {
+        held += snapshot->billboards[i].count;
+        if(input->flags[snapshot->billboards[i].entry])
+            (*flagged)++;
+    }
+    
+    return held;
+}
+
+static void testClusterCapture(SGScene* scene, SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    input->clustering = 1;
+    input->decluttering = 0;
+    input->revision++;
+    SGScenePrepare(scene, input, snapshot);
+    
+    int expected = 0;
+    for(int i = 0; i < input->count; i++)
+        if(!input->flags[i])
+            expected++;
+    
+    int flagged;
+    int held = clusteredEntries(input, snapshot, &flagged);
+    SGAssertTrue(held == expected, "The clusters should hold the %i entries that are not captured but held %i",
+                 expected, held);
+    SGAssertTrue(!flagged, "%i clusters are represented by a captured entry", flagged);
+    
+    // Capturing the representative of a cluster leaves the rest of it on screen
+    int cluster = -1;
+    for(int i = 0; i < snapshot->amountOfBillboards && cluster < 0; i++)
+        if(snapshot->billboards[i].count > 2)
+            cluster = i;
+    
+    SGAssertTrue(cluster >= 0, "A cluster of more than two entries should be laid out");
+    if(cluster < 0)
+        return;
+    
+    int representative = snapshot->billboards[cluster].entry;
+    int amountOfBillboards = snapshot->amountOfBillboards;
+    input->flags[representative] |= kSGSceneEntry_Captured;
+    input->revision++;
+    SGScenePrepare(scene, input, snapshot);
+    
+    held = clusteredEntries(input, snapshot, &flagged);
+    SGAssertTrue(held == expected - 1, "The clusters should hold %i entries after a capture but held %i",
+                 expected - 1, held);
+    SGAssertTrue(!flagged, "%i clusters are represented by a captured entry", flagged);
+    SGAssertTrue(snapshot->amountOfBillboards >= amountOfBillboards,
+                 "Capturing an entry should not hide its cluster (%i billboards before, %i after)",
+                 amountOfBillboards, snapshot->amountOfBillboards);
+    
+    input->flags[representative] &= ~kSGSceneEntry_Captured;
+    input->clustering = 0;
+    input->revision++;
+}
+
+static void testDecluttering(SGScene* scene, SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    input->decluttering = 1;
+    for(int frame = 0; frame < kSGDeclutterDelay + 2; frame++)
+        SGScenePrepare(scene, input, snapshot);
+    
+    SGAssertTrue(snapshot->moved + snapshot->hidden > 0, "Overlapping billboards should be moved or hidden");
+    
+    int hidden = 0;
+    for(int i = 0; i < snapshot->amountOfBillboards; i++)
+        hidden += snapshot->billboards[i].hidden;
+    
+    SGAssertTrue(hidden == snapshot->hidden, "%i billboards were hidden but %i were counted", hidden, snapshot->hidden);
+    input->decluttering = 0;
+}
+
+static void testTouches(SGScene* scene, SGSceneInput* input, SGSceneSnapshot* snapshot) {
+    SGScenePrepare(scene, input, snapshot);
+    
+    // Touches at every few pixels are checked against every billboard
+    int touchable = 0, wrong = 0;
+    const SGSceneBillboard* billboard;
+    const SGSceneBillboard* closest;
+    for(int i = 0; i < snapshot->amountOfBillboards; i++)
+        touchable += snapshot->billboards[i].touchable;
+    
+    for(float y = 0.5f; y < 480.0f; y += 7.0f) {
+        for(float x = 0.5f; x < 320.0f; x += 7.0f) {
+            closest = NULL;
+            for(int i = 0; i < snapshot->amountOfBillboards; i++) {
+                billboard = &snapshot->billboards[i];
+                if(billboard->touchable && x >= billboard->touchX && x <= billboard->touchX + billboard->touchWidth &&
+                   y >= billboard->touchY && y <= billboard->touchY + billboard->touchHeight &&
+                   (!closest || billboard->touchDistance < closest->touchDistance))
+                    closest = billboard;
+            }
+            
+            billboard = SGSceneSnapshotTouch(snapshot, x, y);
+            if((closest == NULL) != (billboard == NULL) || (closest && closest->touchDistance != billboard->touchDistance))
+                wrong++;
+        }
+    }
+    
+    SGAssertTrue(touchable > 0, "Some billboards should be in front of the camera");
+    SGAssertTrue(!wrong, "%i touches found a different billboard than a search of every billboard", wrong);
+    SGAssertTrue(SGSceneSnapshotTouch(snapshot, -10.0f, 10.0f) == NULL, "A touch outside of the viewport should find nothing");
+}
+
+static void testBlips(SGScene* scene, SGSceneInput* input, SGSceneSnapshot* snapshot, SGAnnotationStore* store,
+                      SGAnnotationHandle* handles) {
+    SGScenePrepare(scene, input, snapshot);
+    
+    int missing = 0, visible = 0, captured = 0;
+    const SGSceneBlip* blip;
+    for(int i = 0; i < kAmount; i++) {
+        blip = SGSceneSnapshotBlip(snapshot, handles[i]);
+        if(!blip)
+            missing++;
+        else if(blip->visible) {
+            visible++;
+            if(i % 10 == 0)
+                captured++;
+        }
+    }
+    
+    SGAssertTrue(!missing, "%i entries had no blip", missing);
+    SGAssertTrue(visible > 0, "Some blips should be visible");
+    SGAssertTrue(!captured, "%i captured entries had a visible blip", captured);
+    
+    // A handle of a removed entry does not find the blip of the entry that took its slot
+    SGAnnotationStoreRemove(store, handles[1]);
+    SGAnnotationHandle added = SGAnnotationStoreAdd(store, 37.77, -122.40, 0.0f, NULL);
+    SGSceneInputCopyStore(input, store);
+    input->revision++;
+    SGScenePrepare(scene, input, snapshot);
+    
+    SGAssertTrue(SGSceneSnapshotBlip(snapshot, handles[1]) == NULL, "A removed entry should not have a blip");
+    SGAssertTrue(SGSceneSnapshotBlip(snapshot, added) != NULL, "An added entry should have a blip");
+    SGAssertTrue(SGSceneSnapshotBlip(snapshot, kSGAnnotationHandle_Invalid) == NULL, "An invalid handle should not have a blip");
+}
+
+static void testWorker(SGSceneInput* reference, SGAnnotationStore* store) {
+    SGSceneWorker* worker = SGSceneWorkerNew();
+    SGAssertTrue(worker != NULL, "The worker should start");
+    SGAssertTrue(SGSceneWorkerAcquire(worker) == NULL, "Nothing should be acquired before a frame was prepared");
+    
+    // Frames are submitted faster than they are prepared; the render thread
+    // only ever sees whole frames and never goes back in time.
+    const SGSceneSnapshot* snapshot = NULL;
+    unsigned int last = 0;
+    int backwards = 0, wrong = 0;
+    SGSceneInput* input;
+    for(unsigned int frame = 1; frame <= 300; frame++) {
+        input = SGSceneWorkerBeginInput(worker);
+        fillInput(input, store);
+        input->camera.heading = frame;
+        input->frame = frame;
+        input->decluttering = frame % 2;
+        SGSceneWorkerCommitInput(worker);
+        
+        snapshot = SGSceneWorkerAcquire(worker);
+        if(snapshot) {
+            if(snapshot->frame < last)
+                backwards++;
+            if(snapshot->camera.heading != (float)snapshot->frame)
+                wrong++;
+            last = snapshot->frame;
+        }
+    }
+    
+    while(!snapshot || snapshot->frame != 300)
+        snapshot = SGSceneWorkerAcquire(worker);
+    
+    SGAssertTrue(!backwards, "%i snapshots went back in time", backwards);
+    SGAssertTrue(!wrong, "%i snapshots were prepared from a different input than their frame", wrong);
+    SGAssertTrue(worker->submitted == 300, "300 inputs should be submitted but %u were", worker->submitted);
+    
+    // The last snapshot is the one that would have been prepared expected
+    SGScene* scene = SGSceneNew();
+    SGSceneSnapshot expected;
+    SGSceneSnapshotInit(&expected);
+    fillInput(reference, store);
+    reference->camera.heading = 300;
+    SGScenePrepare(scene, reference, &expected);
+    
+    int same = expected.amountOfBillboards == snapshot->amountOfBillboards;
+    for(int i = 0; same && i < expected.amountOfBillboards; i++)
+        same = expected.billboards[i].handle == snapshot->billboards[i].handle &&
+               expected.billboards[i].touchX == snapshot->billboards[i].touchX;
+    
+    SGAssertTrue(same, "The worker should prepare the same frame as SGScenePrepare");
+    printf("%u inputs submitted, %u replaced before they were prepared, %u snapshots dropped\n",
+           worker->submitted, worker->replaced, worker->buffer.dropped);
+    
+    SGSceneSnapshotDestroy(&expected);
+    SGSceneFree(scene);
+    SGSceneWorkerFree(worker);
+}
+
+static void testTaskPool(SGSceneInput* input) {
+    SGTaskPool* pool = SGTaskPoolNew(4);
+    SGScene* serial = SGSceneNew();
+    SGScene* scene = SGSceneNew();
+    scene->taskPool = pool;
+    SGSceneSnapshot expected, snapshot;
+    SGSceneSnapshotInit(&expected);
+    SGSceneSnapshotInit(&snapshot);
+    
+    // The billboards are projected in parallel but placed in order
+    input->decluttering = 1;
+    SGScenePrepare(serial, input, &expected);
+    SGScenePrepare(scene, input, &snapshot);
+    
+    int same = expected.amountOfBillboards == snapshot.amountOfBillboards &&
+               !memcmp(expected.billboards, snapshot.billboards, sizeof(SGSceneBillboard) * snapshot.amountOfBillboards) &&
+               !memcmp(expected.touchCells, snapshot.touchCells, sizeof(int) * (snapshot.touchColumns * snapshot.touchRows + 1));
+    
+    SGAssertTrue(same, "Preparing the scene on %i threads should match preparing it on one", pool->threadCount);
+    
+    SGSceneSnapshotDestroy(&expected);
+    SGSceneSnapshotDestroy(&snapshot);
+    SGSceneFree(serial);
+    SGSceneFree(scene);
+    SGTaskPoolFree(pool);
+}
+
+int main(int argc, char** argv) {
+    SGAnnotationHandle handles[kAmount];
+    SGAnnotationStore* store = newStore(handles);
+    
+    SGScene* scene = SGSceneNew();
+    SGSceneInput input;
+    SGSceneSnapshot snapshot;
+    SGSceneInputInit(&input);
+    SGSceneSnapshotInit(&snapshot);
+    fillInput(&input, store);
+    
+    testProjection(scene, &input, &snapshot);
+    testLayout(scene, &input, &snapshot);
+    testClusterCapture(scene, &input, &snapshot);
+    testDecluttering(scene, &input, &snapshot);
+    testTouches(scene, &input, &snapshot);
+    testBlips(scene, &input, &snapshot, store, handles);
+    testWorker(&input, store);
+    testTaskPool(&input);
+    
+    SGSceneSnapshotDestroy(&snapshot);
+    SGSceneInputDestroy(&input);
+    SGSceneFree(scene);
+    SGAnnotationStoreFree(store);
+    
+    return SGTestResult();
+}
@@ -0,0 +1,170 @@
+//
+//  SGSensorRingTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import "SGCTest.h"
+#import "SGSensorRing.h"
+
+#import <pthread.h>
+#import <sched.h>
+
+#define kAmountOfSamples        1000000
+
+static SGSensorRing ring;
+
+/* every value of a sample is written from its sequence so a torn sample is detected */
+static void fillSample(SGSensorSample* sample, unsigned int sequence) {
+    sample->timestamp = sequence;
+    for(int i = 0; i < kSGSensorSample_Values; i++)
+        sample->values[i] = sequence * 7.0 + i;
+}
+
+static int isWhole(const SGSensorSample* sample) {
+    for(int i = 0; i < kSGSensorSample_Values; i++)
+        if(sample->values[i] != sample->timestamp * 7.0 + i)
+            return 0;
+    
+    return 1;
+}
+
+/* waits for room so that no sample is lost */
+static void* pushSamples(void* argument) {
+    SGSensorSample sample;
+    for(unsigned int sequence = 1; sequence <= kAmountOfSamples; sequence++) {
+        fillSample(&sample, sequence);
+        while(!SGSensorRingPush(&ring, &sample))
+            sched_yield();
+    }
+    
+    return NULL;
+}
+
+/* like a sensor callback, which never waits for the frame */
+static void* pushSamplesWithoutWaiting(void* argument) {
+    SGSensorSample sample;
+    for(unsigned int sequence = 1; sequence <= kAmountOfSamples; sequence++) {
+        fillSample(&sample, sequence);
+        SGSensorRingPush(&ring, &sample);
+    }
+    
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    SGSensorRingInit(&ring);
+    SGSensorSample sample;
+    
+    SGAssertTrue(!SGSensorRingPeek(&ring) && !SGSensorRingPop(&ring, &sample), "A new ring should be empty");
+    
+    // A full ring drops the new samples and keeps the old ones
+    int pushed = 0;
+    for(unsigned int sequence = 1; sequence <= kSGSensorRing_Capacity + 10; sequence++) {
+        fillSample(&sample, sequence);
+        pushed += SGSensorRingPush(&ring, &sample);
+    }
+    
+    SGAssertTrue(pushed == kSGSensorRing_Capacity && ring.dropped == 10, "%i samples should fit, %i did and %u were dropped",
+                 kSGSensorRing_Capacity, pushed, ring.dropped);
+    SGAssertTrue(SGSensorRingCount(&ring) == kSGSensorRing_Capacity, "%i samples should be waiting", kSGSensorRing_Capacity);
+    SGAssertTrue(SGSensorRingPeek(&ring)->timestamp == 1.0, "The oldest sample should be first");
+    
+    int ordered = 1;
+    for(unsigned int sequence = 1; SGSensorRingPop(&ring, &sample); sequence++)
+        ordered = ordered && sample.timestamp == sequence && isWhole(&sample);
+    SGAssertTrue(ordered, "Samples should be popped in the order that they were pushed");
+    SGAssertTrue(SGSensorRingCount(&ring) == 0, "The ring should be drained");
+    
+    // A producer and a consumer at full speed; the indices wrap many times
+    SGSensorRingInit(&ring);
+    pthread_t producer;
+    pthread_create(&producer, NULL, pushSamples, NULL);
+    
+    unsigned int last = 0;
+    int torn = 0, outOfOrder = 0;
+    while(last < kAmountOfSamples) {
+        if(!SGSensorRingPop(&ring, &sample)) {
+            sched_yield();
+            continue;
+        }
+        
+        if(!isWhole(&sample))
+            torn++;
+        if(sample.timestamp != last + 1)
+            outOfOrder++;
+        
+        last = (unsigned int)sample.timestamp;
+    }
+    
+    pthread_join(producer, NULL);
+    
+    SGAssertTrue(!torn, "%i samples were torn", torn);
+    SGAssertTrue(!outOfOrder, "%i samples were lost or out of order", outOfOrder);
+    SGAssertTrue(ring.pushed == kAmountOfSamples, "%u samples were pushed", ring.pushed);
+    
+    // A producer that never waits drops samples but never reorders them
+    SGSensorRingInit(&ring);
+    pthread_create(&producer, NULL, pushSamplesWithoutWaiting, NULL);
+    
+    int received = 0, finished = 0;
+    last = 0;
+    torn = 0;
+    outOfOrder = 0;
+    while(1) {
+        finished = __sync_fetch_and_add(&ring.pushed, 0) + __sync_fetch_and_add(&ring.dropped, 0) == kAmountOfSamples;
+        while(SGSensorRingPop(&ring, &sample)) {
+            if(!isWhole(&sample))
+                torn++;
+            if(sample.timestamp <= last)
+                outOfOrder++;
+            
+            last = (unsigned int)sample.timestamp;
+            received++;
+        }
+        
+        if(finished)
+            break;
+        sched_yield();
+    }
+    
+    pthread_join(producer, NULL);
+    
+    SGAssertTrue(!torn, "%i samples were torn", torn);
+    SGAssertTrue(!outOfOrder, "%i samples went back in time", outOfOrder);
+    SGAssertTrue(received == ring.pushed && received + ring.dropped == kAmountOfSamples,
+                 "%i samples were received and %u dropped out of %i", received, ring.dropped, kAmountOfSamples);
+    
+    printf("%i samples received, %u dropped while the ring was full\n", received, ring.dropped);
+    
+    return SGTestResult();
+}
@@ -0,0 +1,90 @@
+//
+//  SGStartupProfileTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGStartupProfile.h"
+
+#import <string.h>
+
+int main(int argc, char** argv) {
+    SGStartupProfile profile;
+    SGStartupProfileReset(&profile, 10.0);
+    
+    SGStartupProfileBegin(&profile, kSGStartupPhase_EnvironmentSettings, 10.0);
+    SGStartupProfileEnd(&profile, kSGStartupPhase_EnvironmentSettings, 10.002);
+    SGAssertEqualsWithAccuracy(profile.durations[kSGStartupPhase_EnvironmentSettings], 0.002, 1e-9, "Expected 2 ms of settings");
+    SGAssertEqualsWithAccuracy(profile.ends[kSGStartupPhase_EnvironmentSettings], 0.002, 1e-9, "Settings should end 2 ms after the origin");
+    
+    // Nested beginnings keep the first one and stray ends are ignored
+    SGStartupProfileBegin(&profile, kSGStartupPhase_FirstFrame, 11.0);
+    SGAssertTrue(SGStartupProfileIsRunning(&profile, kSGStartupPhase_FirstFrame), "The first frame should be running");
+    SGStartupProfileBegin(&profile, kSGStartupPhase_FirstFrame, 11.5);
+    SGStartupProfileEnd(&profile, kSGStartupPhase_Radar, 11.6);
+    SGAssertTrue(profile.counts[kSGStartupPhase_Radar] == 0, "A phase that did not begin should not end");
+    
+    // Phases that run more than once accumulate
+    for(int i = 0; i < 3; i++) {
+        SGStartupProfileBegin(&profile, kSGStartupPhase_Framebuffer, 11.0 + i);
+        SGStartupProfileEnd(&profile, kSGStartupPhase_Framebuffer, 11.001 + i);
+    }
+    SGAssertTrue(profile.counts[kSGStartupPhase_Framebuffer] == 3, "The framebuffer should have been made 3 times");
+    SGAssertEqualsWithAccuracy(profile.durations[kSGStartupPhase_Framebuffer], 0.003, 1e-9, "Expected 3 ms of framebuffers");
+    SGAssertEqualsWithAccuracy(profile.ends[kSGStartupPhase_Framebuffer], 3.001, 1e-9, "The last framebuffer should end at 3001 ms");
+    
+    SGStartupProfileEnd(&profile, kSGStartupPhase_FirstFrame, 11.25);
+    SGAssertTrue(!SGStartupProfileIsRunning(&profile, kSGStartupPhase_FirstFrame), "The first frame should have ended");
+    SGAssertEqualsWithAccuracy(profile.durations[kSGStartupPhase_FirstFrame], 0.25, 1e-9, "The first frame should take 250 ms");
+    
+    SGStartupProfileBegin(&profile, kSGStartupPhase_Capture, 12.0);
+    
+    char report[1024];
+    int length = SGStartupProfileReport(&profile, report, sizeof(report));
+    printf("%s", report);
+    SGAssertTrue(length == (int)strlen(report), "The report should fit");
+    SGAssertTrue(strstr(report, "radar                  deferred") != NULL, "The radar should be deferred");
+    SGAssertTrue(strstr(report, "capture session        running") != NULL, "The capture session should be running");
+    SGAssertTrue(strstr(report, "first frame              250.00 ms  x1") != NULL, "The first frame should be reported");
+    
+    // A short buffer is truncated but the whole length is still returned
+    char shortReport[16];
+    SGAssertTrue(SGStartupProfileReport(&profile, shortReport, sizeof(shortReport)) == length, "The length should not depend on the buffer");
+    SGAssertTrue(strlen(shortReport) == sizeof(shortReport) - 1, "The short report should be truncated");
+    SGAssertTrue(SGStartupProfileReport(&profile, NULL, 0) == length, "The report should be measured without a buffer");
+    
+    // Code that is not profiled passes no profile
+    SGStartupProfileBegin(NULL, kSGStartupPhase_Radar, 0.0);
+    SGStartupProfileEnd(NULL, kSGStartupPhase_Radar, 1.0);
+    
+    return SGTestResult();
+}
@@ -0,0 +1,144 @@
+//
+//  SGTaskPoolBenchmark.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import "SGScene.h"
+#import "SGMetrics.h"
+
+#import <stdio.h>
+#import <stdlib.h>
+#import <time.h>
+
+/*
+* Measures how the projection of very large stores scales with the amount
+* of threads in the pool: moving the origin projects every entry, and
+* preparing a frame projects and places every billboard. Each row is
+* compared to the same work without a pool. Pools are only measured up to
+* the amount of cores that are online, on a single core that is the
+* fallback to the calling thread.
+*/
+
+#define kRepeats            10
+#define kSphereRadius       (50000.0f * kSGMeter)
+
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static void fillInput(SGSceneInput* input, const SGAnnotationStore* store) {
+    SGSceneInputCopyStore(input, store);
+    input->camera.pitch = -0.1f;
+    input->camera.heading = 30.0f;
+    input->camera.height = kSGMeter * 1.7018f;
+    input->camera.fovy = 65.0f;
+    input->camera.zNear = 0.5f;
+    input->camera.zFar = kSphereRadius + 10.0f;
+    input->camera.viewport[2] = 320;
+    input->camera.viewport[3] = 480;
+    input->decluttering = 1;
+    input->touchScale = kSphereRadius / 2.0f;
+}
+
+static void report(const char* name, int count, int threads, double seconds, double baseline) {
+    printf("%-16s %7i annotations %2i threads %8.3f ms %6.2fx\n",
+           name, count, threads, seconds * 1000.0 / kRepeats, baseline / seconds);
+}
+
+static void run(int count) {
+    SGAnnotationStore* store = SGAnnotationStoreNew(kSGMeter, 3.0f * kSGMeter, kSphereRadius);
+    SGAnnotationStoreSetOrigin(store, 37.77, -122.40);
+    
+    srand(5);
+    for(int i = 0; i < count; i++) {
+        SGAnnotationHandle handle = SGAnnotationStoreAdd(store, 37.77 + (rand() % 40000 - 20000) / 100000.0,
+                                                         -122.40 + (rand() % 40000 - 20000) / 100000.0, 0.0f, NULL);
+        int index = SGAnnotationStoreIndex(store, handle);
+        store->widths[index] = 120.0f;
+        store->heights[index] = 40.0f;
+    }
+    
+    SGScene* scene = SGSceneNew();
+    SGSceneInput input;
+    SGSceneSnapshot snapshot;
+    SGSceneInputInit(&input);
+    SGSceneSnapshotInit(&snapshot);
+    fillInput(&input, store);
+    
+    double originBaseline = 0.0, sceneBaseline = 0.0, start, spent;
+    int cores = SGTaskPoolCoreCount();
+    for(int threads = 0; threads <= cores; threads = threads ? threads * 2 : 1) {
+        if(threads > cores)
+            threads = cores;
+        
+        // No pool at all is the baseline
+        SGTaskPool* pool = threads ? SGTaskPoolNew(threads) : NULL;
+        store->taskPool = pool;
+        scene->taskPool = pool;
+        
+        start = now();
+        for(int i = 0; i < kRepeats; i++)
+            SGAnnotationStoreSetOrigin(store, 37.77 + i * 0.0001, -122.40);
+        spent = now() - start;
+        if(!pool)
+            originBaseline = spent;
+        report("set origin", count, threads, spent, originBaseline);
+        
+        start = now();
+        for(int i = 0; i < kRepeats; i++)
+            SGScenePrepare(scene, &input, &snapshot);
+        spent = now() - start;
+        if(!pool)
+            sceneBaseline = spent;
+        report("prepare scene", count, threads, spent, sceneBaseline);
+        
+        SGTaskPoolFree(pool);
+        if(threads == cores)
+            break;
+    }
+    
+    SGSceneSnapshotDestroy(&snapshot);
+    SGSceneInputDestroy(&input);
+    SGSceneFree(scene);
+    SGAnnotationStoreFree(store);
+}
+
+int main(int argc, char** argv) {
+    printf("%i cores online\n", SGTaskPoolCoreCount());
+    run(100000);
+    run(200000);
+    
+    return 0;
+}
@@ -0,0 +1,189 @@
+//
+//  SGTaskPoolTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+
+#import "SGCTest.h"
+#import "SGTaskPool.h"
+#import "SGAnnotationStore.h"
+#import "SGMetrics.h"
+
+#import <pthread.h>
+#import <stdlib.h>
+#import <string.h>
+
+#define kAmount         100000
+#define kStoreAmount    20000
+
+static volatile int visits[kAmount];
+
+typedef struct {
+    SGTaskPool* pool;
+    int offset;                 /* added to the indices that are visited */
+    int chunks;
+    int nested;
+} Loop;
+
+static void visit(void* context, int begin, int end) {
+    Loop* loop = (Loop*)context;
+    __sync_fetch_and_add(&loop->chunks, 1);
+    for(int i = begin; i < end; i++)
+        __sync_fetch_and_add(&visits[loop->offset + i], 1);
+}
+
+static void visitNested(void* context, int begin, int end) {
+    Loop* loop = (Loop*)context;
+    
+    // A loop started from a task runs on the thread of the task
+    Loop inner = { NULL, begin, 0, 0 };
+    SGTaskPoolParallelFor(loop->pool, end - begin, 16, visit, &inner);
+    __sync_fetch_and_add(&loop->nested, inner.chunks);
+    visit(context, begin, end);
+}
+
+/* returns the amount of indices that were not visited exactly once */
+static int countWrongVisits(int count) {
+    int wrong = 0;
+    for(int i = 0; i < count; i++)
+        if(visits[i] != 1)
+            wrong++;
+    
+    memset((void*)visits, 0, sizeof(int) * count);
+    return wrong;
+}
+
+static void testVisits(SGTaskPool* pool) {
+    int counts[] = { 0, 1, 7, 1000, 4097, kAmount };
+    int grains[] = { 1, 16, 1000, 5000 };
+    Loop loop;
+    int wrong = 0, chunks = 0;
+    for(int c = 0; c < sizeof(counts) / sizeof(int); c++)
+        for(int g = 0; g < sizeof(grains) / sizeof(int); g++) {
+            if(counts[c] / grains[g] > 10000)
+                continue;
+            
+            memset(&loop, 0, sizeof(Loop));
+            SGTaskPoolParallelFor(pool, counts[c], grains[g], visit, &loop);
+            wrong += countWrongVisits(counts[c]);
+            
+            // Every range holds at most grain elements
+            if(loop.chunks < (counts[c] + grains[g] - 1) / grains[g])
+                chunks++;
+        }
+    
+    SGAssertTrue(!wrong, "%i indices of %i threads were not visited exactly once", wrong, pool ? pool->threadCount : 0);
+    SGAssertTrue(!chunks, "%i loops of %i threads ran ranges larger than the grain", chunks, pool ? pool->threadCount : 0);
+}
+
+static void* runLoops(void* argument) {
+    SGTaskPool* pool = (SGTaskPool*)argument;
+    Loop loop = { pool, 0, 0, 0 };
+    for(int i = 0; i < 50; i++)
+        SGTaskPoolParallelFor(pool, kAmount / 2, 256, visit, &loop);
+    
+    return NULL;
+}
+
+static void testStore(SGTaskPool* pool) {
+    SGAnnotationStore* serial = SGAnnotationStoreNew(kSGMeter, 3.0f * kSGMeter, 5000.0f * kSGMeter);
+    SGAnnotationStore* parallel = SGAnnotationStoreNew(kSGMeter, 3.0f * kSGMeter, 5000.0f * kSGMeter);
+    parallel->taskPool = pool;
+    
+    double latitude, longitude;
+    srand(3);
+    for(int i = 0; i < kStoreAmount; i++) {
+        latitude = 37.77 + (rand() % 20000 - 10000) / 100000.0;
+        longitude = -122.40 + (rand() % 20000 - 10000) / 100000.0;
+        SGAnnotationStoreAdd(serial, latitude, longitude, 0.0f, NULL);
+        SGAnnotationStoreAdd(parallel, latitude, longitude, 0.0f, NULL);
+    }
+    
+    SGAnnotationStoreSetOrigin(serial, 37.78, -122.41);
+    SGAnnotationStoreSetOrigin(parallel, 37.78, -122.41);
+    
+    int same = 1;
+    for(int i = 0; same && i < kStoreAmount; i++)
+        same = serial->x[i] == parallel->x[i] && serial->z[i] == parallel->z[i] &&
+               serial->distances[i] == parallel->distances[i] && serial->order[i] == parallel->order[i];
+    
+    SGAssertTrue(same, "Projecting the store on %i threads should match projecting it on one", pool->threadCount);
+    
+    SGAnnotationStoreFree(serial);
+    SGAnnotationStoreFree(parallel);
+}
+
+int main(int argc, char** argv) {
+    // Without a pool and with a pool that never starts a thread
+    testVisits(NULL);
+    
+    SGTaskPool* pool = SGTaskPoolNew(1);
+    SGAssertTrue(pool->threadCount == 1, "A pool of one thread should not start any, %i threads", pool->threadCount);
+    testVisits(pool);
+    SGAssertTrue(pool->loops == 0, "A pool of one thread should run every loop on the caller");
+    SGTaskPoolFree(pool);
+    
+    int threadCounts[] = { 2, 4, 0 };
+    for(int t = 0; t < sizeof(threadCounts) / sizeof(int); t++) {
+        pool = SGTaskPoolNew(threadCounts[t]);
+        testVisits(pool);
+        
+        // Loops from tasks and from other threads fall back to the calling thread
+        Loop loop = { pool, 0, 0, 0 };
+        SGTaskPoolParallelFor(pool, 4096, 64, visitNested, &loop);
+        int wrong = 0;
+        for(int i = 0; i < 4096; i++)
+            if(visits[i] != 2)
+                wrong++;
+        memset((void*)visits, 0, sizeof(int) * 4096);
+        SGAssertTrue(!wrong && loop.nested > 0, "%i indices of the nested loops were not visited twice", wrong);
+        
+        pthread_t other;
+        pthread_create(&other, NULL, runLoops, pool);
+        runLoops(pool);
+        pthread_join(other, NULL);
+        wrong = 0;
+        for(int i = 0; i < kAmount / 2; i++)
+            if(visits[i] != 100)
+                wrong++;
+        memset((void*)visits, 0, sizeof(int) * kAmount);
+        SGAssertTrue(!wrong, "%i indices of the concurrent loops were not visited 100 times", wrong);
+        
+        testStore(pool);
+        
+        printf("%i threads: %u loops, %u serial, %u chunks, %u stolen\n", pool->threadCount,
+               pool->loops, pool->serialLoops, pool->chunks, pool->steals);
+        SGTaskPoolFree(pool);
+    }
+    
+    return SGTestResult();
+}
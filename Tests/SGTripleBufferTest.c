@@ -0,0 +1,134 @@
+//
+//  SGTripleBufferTest.c
+//  SGAREnvironment
+//
+//  Copyright (c) 2009-2010, SimpleGeo
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without 
+//  modification, are permitted provided that the following conditions are met:
+//
+//  Redistributions of source code must retain the above copyright notice, 
+//  this list of conditions and the following disclaimer. Redistributions 
+//  in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or 
+//  other materials provided with the distribution.
+//  
+//  Neither the name of the SimpleGeo nor the names of its contributors may
+//  be used to endorse or promote products derived from this software 
+//  without specific prior written permission.
+//   
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+//  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+//  GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  Created by Derek Smith.
+//
+
+#import "SGCTest.h"
+#import "SGTripleBuffer.h"
+
+#import <pthread.h>
+#import <string.h>
+
+#define kAmountOfFrames         200000
+#define kFrameLength            64
+
+typedef struct {
+    unsigned int sequence;
+    unsigned int values[kFrameLength];
+} Frame;
+
+static Frame frames[3];
+static SGTripleBuffer buffer;
+
+/* every value of a frame is written from its sequence so a torn frame is detected */
+static void fillFrame(Frame* frame, unsigned int sequence) {
+    frame->sequence = sequence;
+    for(int i = 0; i < kFrameLength; i++)
+        frame->values[i] = sequence * 31 + i;
+}
+
+static int isWhole(const Frame* frame) {
+    for(int i = 0; i < kFrameLength; i++)
+        if(frame->values[i] != frame->sequence * 31 + i)
+            return 0;
+    
+    return 1;
+}
+
+static void* writeFrames(void* argument) {
+    Frame* frame = (Frame*)SGTripleBufferBack(&buffer);
+    for(unsigned int sequence = 1; sequence <= kAmountOfFrames; sequence++) {
+        fillFrame(frame, sequence);
+        frame = (Frame*)SGTripleBufferPublish(&buffer);
+    }
+    
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    SGTripleBufferInit(&buffer, &frames[0], &frames[1], &frames[2]);
+    
+    SGAssertTrue(SGTripleBufferAcquire(&buffer) == NULL, "Nothing should be acquired before a frame was published");
+    
+    // A frame that was not acquired is replaced by the next one
+    fillFrame((Frame*)SGTripleBufferBack(&buffer), 1);
+    fillFrame((Frame*)SGTripleBufferPublish(&buffer), 2);
+    Frame* back = (Frame*)SGTripleBufferPublish(&buffer);
+    Frame* front = (Frame*)SGTripleBufferAcquire(&buffer);
+    SGAssertTrue(front && front->sequence == 2, "The latest frame should be acquired");
+    SGAssertTrue(buffer.published == 2 && buffer.dropped == 1, "One of two frames should be dropped, %u of %u were",
+                 buffer.dropped, buffer.published);
+    SGAssertTrue(back != front, "The writer and the reader should not share a slot");
+    SGAssertTrue(SGTripleBufferAcquire(&buffer) == front, "The frame should be kept until a new one is published");
+    
+    fillFrame(back, 3);
+    back = (Frame*)SGTripleBufferPublish(&buffer);
+    SGAssertTrue(back != front, "The writer should not be handed the slot that is being read");
+    front = (Frame*)SGTripleBufferAcquire(&buffer);
+    SGAssertTrue(front->sequence == 3 && back != front, "The new frame should be acquired");
+    
+    // A writer and a reader at full speed
+    memset(frames, 0, sizeof(frames));
+    SGTripleBufferInit(&buffer, &frames[0], &frames[1], &frames[2]);
+    
+    pthread_t writer;
+    pthread_create(&writer, NULL, writeFrames, NULL);
+    
+    unsigned int last = 0;
+    int acquired = 0, torn = 0, backwards = 0;
+    while(last < kAmountOfFrames) {
+        front = (Frame*)SGTripleBufferAcquire(&buffer);
+        if(!front)
+            continue;
+        
+        if(!isWhole(front))
+            torn++;
+        if(front->sequence < last)
+            backwards++;
+        if(front->sequence != last)
+            acquired++;
+        
+        last = front->sequence;
+    }
+    
+    pthread_join(writer, NULL);
+    
+    SGAssertTrue(!torn, "%i frames were torn", torn);
+    SGAssertTrue(!backwards, "%i frames went back in time", backwards);
+    SGAssertTrue(buffer.published == kAmountOfFrames, "%u frames were published", buffer.published);
+    SGAssertTrue(acquired + buffer.dropped >= kAmountOfFrames, "%i frames were acquired and %u dropped out of %i",
+                 acquired, buffer.dropped, kAmountOfFrames);
+    
+    printf("%i frames acquired, %u dropped\n", acquired, buffer.dropped);
+    
+    return SGTestResult();
+}